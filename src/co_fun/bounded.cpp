@@ -0,0 +1,2 @@
+// bounded.cpp                                                        -*-C++-*-
+#include <co_fun/bounded.h>
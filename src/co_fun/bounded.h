@@ -0,0 +1,199 @@
+// bounded.h                                                          -*-C++-*-
+#ifndef INCLUDED_CO_FUN_BOUNDED
+#define INCLUDED_CO_FUN_BOUNDED
+
+//@PURPOSE: Provide top-k selection and reservoir sampling in bounded memory.
+//
+//@CLASSES:
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: 'topK(stream, k, cmp)' is a 'std::vector' of the 'k'
+// greatest elements of 'stream' by 'cmp', which defaults to 'std::less',
+// greatest first.  It keeps the elements in a heap of 'k', whose least
+// element is the threshold an element must beat to get in, so most of a
+// long stream costs one comparison each.  'topKChunks(chunks, k, cmp)' does
+// the same for a stream of chunks, 'std::vector's of elements: it tests a
+// block of elements against the threshold at a time, with a loop free of
+// branches that the compiler turns into vector compares for numbers, and
+// goes through a block element by element only if something in it beats
+// the threshold, which, once the heap has filled with large elements, is
+// rare.
+//
+// 'reservoirSample(stream, k, rng)' is a uniform random sample of 'k'
+// elements of 'stream', without replacement, drawn with the uniform random
+// bit generator 'rng'.  It uses Li's Algorithm L: rather than drawing a
+// number for every element to decide whether it replaces one in the
+// sample, it draws how many elements to skip before the next replacement,
+// so a stream of 'n' elements costs 'O(k log(n / k))' draws.  A stream of
+// fewer than 'k' elements is its own sample.
+//..
+//  std::mt19937_64 rng(seed);
+//  auto slowest = topK(std::move(latencies), 100);
+//  auto typical = reservoirSample(std::move(requests), 1000, rng);
+//..
+//
+// Each reads its stream to the end, walking it by reassignment, so the
+// cells it has read are freed as it goes, and memory stays bounded by 'k'
+// however long the stream, provided nothing else holds an earlier cell.
+// Move the stream in, and make it before the call: in 'topK(take(iota(0),
+// n), k)' the temporary 'iota(0)' holds the head until the call returns.
+
+#include <co_fun/stream.h>
+#include <co_fun/suspension.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace co_fun {
+
+namespace detail {
+
+// The greatest 'k' elements seen, in a heap with the least of them first.
+template <typename Value, typename Compare>
+class TopKHeap {
+    std::vector<Value> heap_;
+    std::size_t        k_;
+    Compare            cmp_;
+
+    bool after(Value const& a, Value const& b) const { return cmp_(b, a); }
+
+    auto order() const {
+        return [this](Value const& a, Value const& b) { return after(a, b); };
+    }
+
+  public:
+    TopKHeap(std::size_t k, Compare cmp) : k_(k), cmp_(std::move(cmp)) {
+        heap_.reserve(k);
+    }
+
+    bool full() const { return heap_.size() == k_; }
+
+    // The element to beat; only meaningful once the heap is full.
+    Value const& threshold() const { return heap_.front(); }
+
+    void push(Value const& value) {
+        if (!full()) {
+            heap_.push_back(value);
+            std::push_heap(heap_.begin(), heap_.end(), order());
+        } else if (k_ > 0 && cmp_(threshold(), value)) {
+            std::pop_heap(heap_.begin(), heap_.end(), order());
+            heap_.back() = value;
+            std::push_heap(heap_.begin(), heap_.end(), order());
+        }
+    }
+
+    // The elements, greatest first.
+    std::vector<Value> release() {
+        std::sort_heap(heap_.begin(), heap_.end(), order());
+        return std::move(heap_);
+    }
+};
+
+// A uniform draw from '(0, 1)', never 0, so that its logarithm is finite.
+template <typename Generator>
+double uniformOpen(Generator& rng) {
+    std::uniform_real_distribution<double> uniform(
+        std::numeric_limits<double>::min(), 1.0);
+    return uniform(rng);
+}
+
+} // namespace detail
+
+// ============================================================================
+//              INLINE FUNCTION AND FUNCTION TEMPLATE DEFINITIONS
+// ============================================================================
+
+template <typename Value,
+          typename Suspension,
+          typename Compare = std::less<Value>>
+std::vector<Value>
+topK(ConsStream<Value, Suspension> stream, std::size_t k, Compare cmp = {}) {
+    detail::TopKHeap<Value, Compare> heap(k, std::move(cmp));
+    for (; !stream.isEmpty(); stream = stream.tail()) {
+        heap.push(stream.head());
+    }
+    return heap.release();
+}
+
+template <typename Value,
+          typename Suspension,
+          typename Compare = std::less<Value>>
+std::vector<Value>
+topKChunks(ConsStream<std::vector<Value>, Suspension> chunks,
+           std::size_t                                k,
+           Compare                                    cmp = {}) {
+    constexpr std::size_t            block = 16;
+    detail::TopKHeap<Value, Compare> heap(k, cmp);
+    for (; !chunks.isEmpty() && k > 0; chunks = chunks.tail()) {
+        std::vector<Value> chunk = chunks.head();
+        std::size_t        i     = 0;
+        for (; i < chunk.size() && !heap.full(); ++i) {
+            heap.push(chunk[i]);
+        }
+        for (; i + block <= chunk.size(); i += block) {
+            // Copied, since pushing below may replace it.
+            Value threshold = heap.threshold();
+            bool  beaten    = false;
+            for (std::size_t j = 0; j < block; ++j) {
+                beaten |= cmp(threshold, chunk[i + j]);
+            }
+            if (beaten) {
+                for (std::size_t j = 0; j < block; ++j) {
+                    heap.push(chunk[i + j]);
+                }
+            }
+        }
+        for (; i < chunk.size(); ++i) {
+            heap.push(chunk[i]);
+        }
+    }
+    return heap.release();
+}
+
+template <typename Value, typename Suspension, typename Generator>
+std::vector<Value> reservoirSample(ConsStream<Value, Suspension> stream,
+                                   std::size_t                   k,
+                                   Generator&                    rng) {
+    std::vector<Value> sample;
+    if (k == 0) {
+        return sample;
+    }
+    sample.reserve(k);
+    for (; !stream.isEmpty() && sample.size() < k; stream = stream.tail()) {
+        sample.push_back(stream.head());
+    }
+    std::uniform_int_distribution<std::size_t> slot(0, k - 1);
+    double w = std::exp(std::log(detail::uniformOpen(rng)) / double(k));
+    while (!stream.isEmpty()) {
+        double skip = std::floor(std::log(detail::uniformOpen(rng)) /
+                                 std::log1p(-w));
+        // Past any stream that could be walked; also catches infinities.
+        if (!(skip < 1e18)) {
+            skip = 1e18;
+        }
+        for (std::uint64_t n = std::uint64_t(skip);
+             n > 0 && !stream.isEmpty();
+             --n) {
+            stream = stream.tail();
+        }
+        if (stream.isEmpty()) {
+            break;
+        }
+        sample[slot(rng)] = stream.head();
+        stream            = stream.tail();
+        w *= std::exp(std::log(detail::uniformOpen(rng)) / double(k));
+    }
+    return sample;
+}
+
+} // namespace co_fun
+
+#endif
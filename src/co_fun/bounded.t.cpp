@@ -0,0 +1,179 @@
+#include <co_fun/bounded.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace co_fun;
+
+namespace {
+// An int that counts how many of its kind are alive, and the most ever.
+struct Tracked {
+    static int live;
+    static int peak;
+
+    int value;
+
+    explicit Tracked(int v) : value(v) { grow(); }
+    Tracked(Tracked const& other) : value(other.value) { grow(); }
+    Tracked& operator=(Tracked const&) = default;
+    ~Tracked() { --live; }
+
+    static void grow() { peak = std::max(peak, ++live); }
+
+    friend bool operator<(Tracked const& a, Tracked const& b) {
+        return a.value < b.value;
+    }
+};
+
+int Tracked::live = 0;
+int Tracked::peak = 0;
+
+ConsStream<Tracked> tracked(int n, int i = 0) {
+    if (i == n) {
+        return ConsStream<Tracked>();
+    }
+    return ConsStream<Tracked>([n, i]() {
+        return ConsCell<Tracked>(Tracked((i * 7919) % n), tracked(n, i + 1));
+    });
+}
+
+// 0 to 'n - 1', scrambled, in chunks of 'size'.
+ConsStream<std::vector<int>> scrambled(int n, int size, int from = 0) {
+    if (from >= n) {
+        return ConsStream<std::vector<int>>();
+    }
+    return ConsStream<std::vector<int>>([n, size, from]() {
+        std::vector<int> chunk;
+        for (int i = from; i < n && i < from + size; ++i) {
+            chunk.push_back(int((long(i) * 7919) % n));
+        }
+        return ConsCell<std::vector<int>>(chunk,
+                                          scrambled(n, size, from + size));
+    });
+}
+
+struct Counting {
+    int* count;
+
+    bool operator()(int a, int b) const {
+        ++*count;
+        return a < b;
+    }
+};
+} // namespace
+
+TEST(Co_FunBoundedTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunBoundedTest, TopK) {
+    EXPECT_EQ((std::vector<int>{100, 99, 98}), topK(rangeFrom(1, 100), 3));
+    EXPECT_EQ((std::vector<int>{1, 2}),
+              topK(rangeFrom(1, 100), 2, std::greater<int>()));
+    EXPECT_EQ((std::vector<int>{3, 2, 1}), topK(rangeFrom(1, 3), 10));
+    EXPECT_TRUE(topK(rangeFrom(1, 3), 0).empty());
+    EXPECT_TRUE(topK(ConsStream<int>(), 5).empty());
+}
+
+TEST(Co_FunBoundedTest, TopKWithRepeats) {
+    auto s = fmap(rangeFrom(0, 29), [](int x) { return x % 10; });
+    EXPECT_EQ((std::vector<int>{9, 9, 9, 8}), topK(s, 4));
+}
+
+TEST(Co_FunBoundedTest, TopKDoesNotRetainCells) {
+    Tracked::peak = Tracked::live;
+    auto top      = topK(tracked(100000), 5);
+    ASSERT_EQ(5u, top.size());
+    EXPECT_EQ(99999, top[0].value);
+    EXPECT_EQ(99995, top[4].value);
+    EXPECT_GT(100, Tracked::peak);
+}
+
+TEST(Co_FunBoundedTest, TopKChunks) {
+    EXPECT_EQ((std::vector<int>{9999, 9998, 9997, 9996, 9995}),
+              topKChunks(scrambled(10000, 1000), 5));
+    EXPECT_EQ((std::vector<int>{0, 1, 2}),
+              topKChunks(scrambled(10000, 37), 3, std::greater<int>()));
+    EXPECT_EQ(100u, topKChunks(scrambled(100, 7), 1000).size());
+    EXPECT_TRUE(topKChunks(scrambled(100, 7), 0).empty());
+}
+
+TEST(Co_FunBoundedTest, TopKChunksMatchesTopK) {
+    for (int size : {1, 15, 16, 17, 100}) {
+        std::vector<int> all;
+        for (auto s = scrambled(5000, size); !s.isEmpty(); s = s.tail()) {
+            std::vector<int> chunk = s.head();
+            all.insert(all.end(), chunk.begin(), chunk.end());
+        }
+        std::sort(all.begin(), all.end(), std::greater<int>());
+        all.resize(50);
+        EXPECT_EQ(all, topKChunks(scrambled(5000, size), 50)) << size;
+    }
+}
+
+TEST(Co_FunBoundedTest, TopKChunksSkipsBlocks) {
+    // Once the heap holds large elements, most blocks are tested without
+    // being pushed; pushing every element would cost several comparisons
+    // each.
+    int count = 0;
+    topKChunks(scrambled(100000, 4096), 10, Counting{&count});
+    EXPECT_GT(150000, count);
+}
+
+TEST(Co_FunBoundedTest, Reservoir) {
+    std::mt19937_64 rng(42);
+    auto            sample = reservoirSample(rangeFrom(1, 10000), 100, rng);
+    ASSERT_EQ(100u, sample.size());
+    EXPECT_EQ(100u, std::set<int>(sample.begin(), sample.end()).size());
+    for (int x : sample) {
+        EXPECT_LE(1, x);
+        EXPECT_GE(10000, x);
+    }
+}
+
+TEST(Co_FunBoundedTest, ReservoirShortStream) {
+    std::mt19937_64 rng(1);
+    EXPECT_EQ((std::vector<int>{1, 2, 3}),
+              reservoirSample(rangeFrom(1, 3), 10, rng));
+    EXPECT_TRUE(reservoirSample(rangeFrom(1, 3), 0, rng).empty());
+    EXPECT_TRUE(reservoirSample(ConsStream<int>(), 4, rng).empty());
+}
+
+TEST(Co_FunBoundedTest, ReservoirIsUniform) {
+    // Each of 20 elements is in a sample of 5 a quarter of the time.
+    std::mt19937_64    rng(7);
+    std::map<int, int> hits;
+    int const          trials = 20000;
+    for (int t = 0; t < trials; ++t) {
+        for (int x : reservoirSample(rangeFrom(0, 19), 5, rng)) {
+            ++hits[x];
+        }
+    }
+    ASSERT_EQ(20u, hits.size());
+    for (auto const& [x, n] : hits) {
+        EXPECT_NEAR(trials / 4, n, trials / 40) << x;
+    }
+}
+
+TEST(Co_FunBoundedTest, ReservoirDrawsLittle) {
+    // Counts the draws of the generator, far fewer than the elements.
+    struct Counted {
+        using result_type = std::mt19937::result_type;
+        std::mt19937 rng;
+        int          draws = 0;
+
+        static constexpr result_type min() { return std::mt19937::min(); }
+        static constexpr result_type max() { return std::mt19937::max(); }
+        result_type operator()() { return ++draws, rng(); }
+    } rng{std::mt19937(3)};
+    // Made first, so that no temporary holds the head during the call.
+    auto stream = take(iota(0), 1000000);
+    auto sample = reservoirSample(std::move(stream), 10, rng);
+    EXPECT_EQ(10u, sample.size());
+    EXPECT_GT(5000, rng.draws);
+}
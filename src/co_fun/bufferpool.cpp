@@ -0,0 +1,107 @@
+// bufferpool.cpp                                                     -*-C++-*-
+#include <co_fun/bufferpool.h>
+
+#include <cstring>
+#include <new>
+
+namespace co_fun {
+
+Chunk Chunk::copyOf(std::string_view data) {
+    std::shared_ptr<char[]> bytes(new char[data.size() ? data.size() : 1]);
+    std::memcpy(bytes.get(), data.data(), data.size());
+    std::string_view view(bytes.get(), data.size());
+    return Chunk(std::shared_ptr<char const>(bytes, bytes.get()), view);
+}
+
+template <typename T>
+class BufferPool::CountAllocator {
+    template <typename>
+    friend class CountAllocator;
+
+    std::shared_ptr<BufferPool> pool_;
+    char*                       buffer_;
+
+    void* header() const { return buffer_ - pool_->header_; }
+
+  public:
+    using value_type = T;
+
+    CountAllocator(std::shared_ptr<BufferPool> pool, char* buffer)
+        : pool_(std::move(pool)), buffer_(buffer) {}
+
+    template <typename U>
+    CountAllocator(CountAllocator<U> const& other)
+        : pool_(other.pool_), buffer_(other.buffer_) {}
+
+    T* allocate(std::size_t n) {
+        if (n * sizeof(T) <= pool_->header_ &&
+            alignof(T) <= pool_->alignment_) {
+            return static_cast<T*>(header());
+        }
+        return std::allocator<T>().allocate(n);
+    }
+
+    // The count is gone, so the buffer can go back to the pool.
+    void deallocate(T* p, std::size_t n) {
+        if (static_cast<void*>(p) != header()) {
+            std::allocator<T>().deallocate(p, n);
+        }
+        pool_->release(buffer_);
+    }
+
+    friend bool operator==(CountAllocator const& lhs,
+                           CountAllocator const& rhs) {
+        return lhs.buffer_ == rhs.buffer_;
+    }
+};
+
+BufferPool::~BufferPool() {
+    for (char* buffer : free_) {
+        deallocate(buffer);
+    }
+}
+
+void BufferPool::deallocate(char* buffer) {
+    ::operator delete[](buffer - header_, std::align_val_t(alignment_));
+}
+
+void BufferPool::release(char* buffer) {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (free_.size() < maxFree_) {
+            free_.push_back(buffer);
+            return;
+        }
+    }
+    deallocate(buffer);
+}
+
+std::shared_ptr<char> BufferPool::acquire() {
+    char* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (!free_.empty()) {
+            buffer = free_.back();
+            free_.pop_back();
+        }
+    }
+    if (!buffer) {
+        buffer = static_cast<char*>(::operator new[](
+                     header_ + blockSize_, std::align_val_t(alignment_))) +
+                 header_;
+        allocated_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // The buffer is released when its count is deallocated, not by the
+    // deleter, which runs while the count still occupies the header.
+    try {
+        return std::shared_ptr<char>(
+            buffer,
+            [](char*) {},
+            CountAllocator<char>(shared_from_this(), buffer));
+    } catch (...) {
+        release(buffer);
+        throw;
+    }
+}
+
+} // namespace co_fun
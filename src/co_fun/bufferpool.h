@@ -0,0 +1,125 @@
+// bufferpool.h                                                       -*-C++-*-
+#ifndef INCLUDED_CO_FUN_BUFFERPOOL
+#define INCLUDED_CO_FUN_BUFFERPOOL
+
+//@PURPOSE: Provide pooled I/O buffers and shared views of their bytes.
+//
+//@CLASSES:
+//  co_fun::BufferPool: recycler of fixed size byte buffers
+//  co_fun::Chunk: shared, immutable view of bytes in a buffer
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: A 'BufferPool' hands out buffers of one block size.  A
+// buffer goes back to the pool when the last reference to it is dropped,
+// and the next 'acquire' reuses it instead of allocating, so a reader that
+// keeps a bounded number of blocks in flight allocates that many and no
+// more.  The pool allocates when it has nothing free, rather than blocking,
+// since the holder of the buffers it is waiting for may be the thread
+// asking for one.  At most 'maxFree' idle buffers are kept.  Buffers can be
+// given a stricter alignment, such as the page alignment 'O_DIRECT' needs.
+// Each buffer is allocated with room in front of it for the reference
+// count of the 'shared_ptr' that hands it out, so an 'acquire' served from
+// the free buffers allocates nothing at all.
+//
+// A 'Chunk' is a 'string_view' that shares ownership of the bytes it looks
+// at, so it can be an element of a lazy stream and outlive the cell that
+// produced it.  Sub-chunks share the same buffer.  'Chunk::copyOf' makes a
+// chunk that owns a private copy of some bytes, for data that does not sit
+// in one buffer.
+//
+// 'acquire' and the return of buffers may be called from any thread.
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace co_fun {
+
+class Chunk {
+    std::shared_ptr<char const> storage_;
+    std::string_view            data_;
+
+  public:
+    Chunk() = default;
+
+    Chunk(std::shared_ptr<char const> storage, std::string_view data)
+        : storage_(std::move(storage)), data_(data) {}
+
+    static Chunk copyOf(std::string_view data);
+
+    std::string_view view() const { return data_; }
+
+    operator std::string_view() const { return data_; }
+
+    char const* data() const { return data_.data(); }
+
+    std::size_t size() const { return data_.size(); }
+
+    bool empty() const { return data_.empty(); }
+
+    Chunk substr(std::size_t pos,
+                 std::size_t count = std::string_view::npos) const {
+        return Chunk(storage_, data_.substr(pos, count));
+    }
+
+    friend bool operator==(Chunk const& lhs, Chunk const& rhs) {
+        return lhs.data_ == rhs.data_;
+    }
+};
+
+class BufferPool : public std::enable_shared_from_this<BufferPool> {
+    // Places the reference count of a buffer in front of it.
+    template <typename T>
+    class CountAllocator;
+
+    // Room kept in front of each buffer for its reference count.
+    static constexpr std::size_t countRoom = 128;
+
+    std::size_t              blockSize_;
+    std::size_t              maxFree_;
+    std::size_t              alignment_;
+    std::size_t              header_;
+    std::mutex               lock_;
+    std::vector<char*>       free_;
+    std::atomic<std::size_t> allocated_{0};
+
+    void release(char* buffer);
+    void deallocate(char* buffer);
+
+  public:
+    // Pools must be owned by a 'shared_ptr': buffers hold on to their pool.
+    BufferPool(std::size_t blockSize,
+               std::size_t maxFree,
+               std::size_t alignment = alignof(std::max_align_t))
+        : blockSize_(blockSize),
+          maxFree_(maxFree),
+          alignment_(alignment),
+          header_((countRoom + alignment - 1) / alignment * alignment) {}
+
+    ~BufferPool();
+
+    BufferPool(BufferPool const&) = delete;
+    BufferPool& operator=(BufferPool const&) = delete;
+
+    std::size_t blockSize() const { return blockSize_; }
+
+    std::size_t alignment() const { return alignment_; }
+
+    // A buffer of 'blockSize()' bytes, returned to the pool when the last
+    // copy of the pointer is dropped.
+    std::shared_ptr<char> acquire();
+
+    // Buffers allocated over the life of the pool.
+    std::size_t allocated() const {
+        return allocated_.load(std::memory_order_relaxed);
+    }
+};
+
+} // namespace co_fun
+
+#endif
@@ -0,0 +1,124 @@
+#include <co_fun/bufferpool.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace co_fun;
+
+TEST(Co_FunBufferPoolTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunBufferPoolTest, Reuse) {
+    auto  pool  = std::make_shared<BufferPool>(64, 4);
+    char* first = nullptr;
+    {
+        auto buffer = pool->acquire();
+        first       = buffer.get();
+    }
+    auto again = pool->acquire();
+    EXPECT_EQ(first, again.get());
+    EXPECT_EQ(1u, pool->allocated());
+}
+
+TEST(Co_FunBufferPoolTest, AllocatesWhenEmpty) {
+    auto pool = std::make_shared<BufferPool>(64, 2);
+    std::vector<std::shared_ptr<char>> held;
+    for (int i = 0; i < 5; ++i) {
+        held.push_back(pool->acquire());
+    }
+    EXPECT_EQ(5u, pool->allocated());
+    held.clear();
+
+    // Only 'maxFree' are kept; the rest were freed.
+    for (int i = 0; i < 3; ++i) {
+        held.push_back(pool->acquire());
+    }
+    EXPECT_EQ(6u, pool->allocated());
+}
+
+TEST(Co_FunBufferPoolTest, WeakReferenceHoldsBuffer) {
+    auto                pool = std::make_shared<BufferPool>(64, 4);
+    std::weak_ptr<char> weak;
+    char*               first = nullptr;
+    {
+        auto buffer = pool->acquire();
+        first       = buffer.get();
+        weak        = buffer;
+    }
+    // The reference count still sits in front of the buffer.
+    EXPECT_NE(first, pool->acquire().get());
+    EXPECT_EQ(2u, pool->allocated());
+    weak.reset();
+    auto again = pool->acquire();
+    EXPECT_EQ(2u, pool->allocated());
+}
+
+TEST(Co_FunBufferPoolTest, BufferOutlivesPool) {
+    std::shared_ptr<char> buffer;
+    {
+        auto pool = std::make_shared<BufferPool>(16, 1);
+        buffer    = pool->acquire();
+    }
+    buffer.get()[0] = 'x';
+    buffer.reset();
+}
+
+TEST(Co_FunBufferPoolTest, Chunk) {
+    auto                  pool   = std::make_shared<BufferPool>(16, 1);
+    std::shared_ptr<char> buffer = pool->acquire();
+    std::string_view      text("hello world");
+    text.copy(buffer.get(), text.size());
+
+    Chunk chunk(buffer, std::string_view(buffer.get(), text.size()));
+    buffer.reset();
+    EXPECT_EQ("hello world", chunk.view());
+
+    Chunk world = chunk.substr(6);
+    EXPECT_EQ("world", world.view());
+    EXPECT_EQ(chunk.data() + 6, world.data());
+
+    // The buffer is back in the pool only once every chunk is gone.
+    chunk = Chunk();
+    EXPECT_NE(world.data() - 6, pool->acquire().get());
+    EXPECT_EQ(2u, pool->allocated());
+    world = Chunk();
+    EXPECT_EQ(2u, pool->allocated());
+}
+
+TEST(Co_FunBufferPoolTest, Alignment) {
+    auto pool = std::make_shared<BufferPool>(4096, 2, 4096);
+    for (int i = 0; i < 3; ++i) {
+        auto buffer = pool->acquire();
+        EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(buffer.get()) % 4096);
+    }
+}
+
+TEST(Co_FunBufferPoolTest, CopyOf) {
+    std::string text("transient");
+    Chunk       chunk = Chunk::copyOf(text);
+    text.assign("overwritten");
+    EXPECT_EQ("transient", chunk.view());
+    EXPECT_TRUE(Chunk::copyOf("").empty());
+}
+
+TEST(Co_FunBufferPoolTest, ConcurrentRelease) {
+    auto pool = std::make_shared<BufferPool>(32, 8);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([pool]() {
+            for (int i = 0; i < 1000; ++i) {
+                auto buffer     = pool->acquire();
+                buffer.get()[0] = char(i);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    // Each thread holds one buffer at a time.
+    EXPECT_LE(pool->allocated(), 4u);
+}
@@ -0,0 +1,25 @@
+// cancellation.cpp                                                   -*-C++-*-
+#include <co_fun/cancellation.h>
+
+#include <utility>
+
+namespace co_fun {
+
+namespace {
+thread_local std::stop_token currentToken;
+} // namespace
+
+std::stop_token EvaluationContext::stopToken() noexcept {
+    return currentToken;
+}
+
+bool EvaluationContext::stopRequested() noexcept {
+    return currentToken.stop_requested();
+}
+
+EvaluationContext::Scope::Scope(std::stop_token token)
+    : saved_(std::exchange(currentToken, std::move(token))) {}
+
+EvaluationContext::Scope::~Scope() { currentToken = std::move(saved_); }
+
+} // namespace co_fun
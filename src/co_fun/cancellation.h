@@ -0,0 +1,85 @@
+// cancellation.h                                                     -*-C++-*-
+#ifndef INCLUDED_CO_FUN_CANCELLATION
+#define INCLUDED_CO_FUN_CANCELLATION
+
+//@PURPOSE: Provide cooperative cancellation of thunk evaluation.
+//
+//@CLASSES:
+//  co_fun::Cancelled: exception reporting an abandoned evaluation
+//  co_fun::EvaluationContext: per thread stop token for evaluations
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: Speculative evaluation, on pipeline stages or in 'when_any',
+// can outlive any interest in its result.  A thread doing that work
+// installs a 'std::stop_token' with an 'EvaluationContext::Scope', and the
+// code that can wait or run long checks it: the stream sources that block,
+// such as 'followLines', and the pipeline stages between elements.
+//
+// Work that observes cancellation throws 'Cancelled' without recording it
+// as a result.  A thunk or lazy coroutine checks at its suspension points:
+// a stopped thread does not start or resume it, and the body may check
+// with 'co_await cancellationPoint()'.  Once stop has been requested the
+// coroutine gives up there, and the thread forcing it gets 'Cancelled', but
+// the thunk stays unevaluated, and the next force, from any thread not
+// stopped, resumes the body where it stopped.  So a thunk shared by other
+// threads is never poisoned by one thread's cancellation.  The combinators,
+// such as 'transform', and the cells of a stream, give up the same way when
+// forcing what they depend on throws 'Cancelled'.
+//
+// A coroutine body that lets 'Cancelled' escape has unwound its frame, and
+// cannot be resumed.  Its thunk records that it was cancelled, distinct
+// from failing, and forcing it throws 'Cancelled'.
+
+#include <coroutine>
+#include <exception>
+#include <stop_token>
+
+namespace co_fun {
+
+class Cancelled : public std::exception {
+  public:
+    char const* what() const noexcept override {
+        return "co_fun: evaluation cancelled";
+    }
+};
+
+class EvaluationContext {
+  public:
+    // The token installed for this thread, or a token that is never
+    // stopped.
+    static std::stop_token stopToken() noexcept;
+
+    static bool stopRequested() noexcept;
+
+    // Install 'token' for this thread for the lifetime of the scope.
+    class Scope {
+        std::stop_token saved_;
+
+      public:
+        explicit Scope(std::stop_token token);
+        Scope(Scope const&) = delete;
+        Scope& operator=(Scope const&) = delete;
+        ~Scope();
+    };
+};
+
+struct CancellationPoint {
+    bool await_ready() const noexcept {
+        return !EvaluationContext::stopRequested();
+    }
+
+    // Give up the evaluation, leaving the coroutine suspended here.
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) const {
+        handle.promise().abandon(std::make_exception_ptr(Cancelled()));
+    }
+
+    void await_resume() const noexcept {}
+};
+
+inline CancellationPoint cancellationPoint() { return {}; }
+
+} // namespace co_fun
+
+#endif
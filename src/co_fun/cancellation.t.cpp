@@ -0,0 +1,161 @@
+#include <co_fun/cancellation.h>
+#include <co_fun/stream.h>
+#include <co_fun/thunk.h>
+
+#include <gtest/gtest.h>
+
+#include <stop_token>
+#include <thread>
+
+using namespace co_fun;
+
+TEST(Co_FunCancellationTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunCancellationTest, Breathing) {
+    EXPECT_FALSE(EvaluationContext::stopRequested());
+    EXPECT_FALSE(EvaluationContext::stopToken().stop_possible());
+
+    std::stop_source source;
+    {
+        EvaluationContext::Scope scope(source.get_token());
+        EXPECT_TRUE(EvaluationContext::stopToken().stop_possible());
+        EXPECT_FALSE(EvaluationContext::stopRequested());
+        source.request_stop();
+        EXPECT_TRUE(EvaluationContext::stopRequested());
+
+        std::thread other(
+            []() { EXPECT_FALSE(EvaluationContext::stopRequested()); });
+        other.join();
+    }
+    EXPECT_FALSE(EvaluationContext::stopRequested());
+}
+
+TEST(Co_FunCancellationTest, ScopesNest) {
+    std::stop_source outer;
+    std::stop_source inner;
+    outer.request_stop();
+    EvaluationContext::Scope o(outer.get_token());
+    {
+        EvaluationContext::Scope i(inner.get_token());
+        EXPECT_FALSE(EvaluationContext::stopRequested());
+    }
+    EXPECT_TRUE(EvaluationContext::stopRequested());
+}
+
+namespace {
+int forced = 0;
+
+Thunk<int> leaf() {
+    ++forced;
+    co_return 1;
+}
+
+// Counts its steps in 'forced', checking for cancellation before each.
+Thunk<int> stepped(int steps) {
+    for (int i = 0; i < steps; ++i) {
+        co_await cancellationPoint();
+        ++forced;
+    }
+    co_return forced;
+}
+
+Thunk<int> checked() {
+    co_await cancellationPoint();
+    co_return 3;
+}
+
+// Stops 'source' part way through, as a consumer going away would.
+Thunk<int> stopping(std::stop_source& source) {
+    source.request_stop();
+    co_await cancellationPoint();
+    co_return 3;
+}
+
+Thunk<int> escaping(Thunk<int> inner) { co_return evaluate(inner) + 1; }
+} // namespace
+
+TEST(Co_FunCancellationTest, StoppedScopeDoesNotPoison) {
+    forced = 0;
+    Thunk<int>       t = leaf();
+    std::stop_source source;
+    source.request_stop();
+    {
+        EvaluationContext::Scope scope(source.get_token());
+        EXPECT_THROW(evaluate(t), Cancelled);
+    }
+    EXPECT_EQ(0, forced);
+    EXPECT_FALSE(t.evaluated());
+    EXPECT_EQ(1, evaluate(t));
+    EXPECT_EQ(1, forced);
+}
+
+TEST(Co_FunCancellationTest, CancellationPointResumes) {
+    forced = 0;
+    std::stop_source source;
+    Thunk<int>       t = stepped(3);
+    {
+        EvaluationContext::Scope scope(source.get_token());
+        source.request_stop();
+        EXPECT_THROW(evaluate(t), Cancelled);
+    }
+    EXPECT_EQ(0, forced);
+    EXPECT_FALSE(t.evaluated());
+    EXPECT_FALSE(t.isEmpty());
+
+    EXPECT_EQ(3, evaluate(t));
+    EXPECT_EQ(3, forced);
+}
+
+TEST(Co_FunCancellationTest, CancelledCellStaysUnevaluated) {
+    int              calls = 0;
+    std::stop_source source;
+    ConsStream<int>  s([&]() {
+        // The consumer goes away while the first call is running.
+        if (++calls == 1) {
+            source.request_stop();
+        }
+        if (EvaluationContext::stopRequested()) {
+            throw Cancelled();
+        }
+        return ConsCell<int>(7);
+    });
+    {
+        EvaluationContext::Scope scope(source.get_token());
+        EXPECT_THROW(s.head(), Cancelled);
+    }
+    EXPECT_EQ(0, s.countEvaluated());
+    EXPECT_EQ(7, s.head());
+    EXPECT_EQ(2, calls);
+}
+
+TEST(Co_FunCancellationTest, CancellationPoint) {
+    Thunk<int> t = checked();
+    EXPECT_EQ(3, evaluate(t));
+}
+
+TEST(Co_FunCancellationTest, NestedThunkResumes) {
+    std::stop_source source;
+    Thunk<int>       inner = stopping(source);
+    Thunk<int> outer = transform(inner, [](int i) { return i + 1; });
+    {
+        EvaluationContext::Scope scope(source.get_token());
+        EXPECT_THROW(evaluate(outer), Cancelled);
+    }
+    EXPECT_FALSE(outer.evaluated());
+    EXPECT_FALSE(outer.cancelled());
+    EXPECT_EQ(4, evaluate(outer));
+    EXPECT_EQ(3, evaluate(inner));
+}
+
+TEST(Co_FunCancellationTest, EscapingCancelledIsNotAnError) {
+    std::stop_source source;
+    Thunk<int>       inner = stopping(source);
+    Thunk<int>       outer = escaping(inner);
+    {
+        EvaluationContext::Scope scope(source.get_token());
+        EXPECT_THROW(evaluate(outer), Cancelled);
+    }
+    EXPECT_TRUE(outer.cancelled());
+    EXPECT_THROW(evaluate(outer), Cancelled);
+    EXPECT_EQ(3, evaluate(inner));
+}
@@ -0,0 +1,109 @@
+// dataflow.cpp                                                       -*-C++-*-
+#include <co_fun/dataflow.h>
+
+#include <algorithm>
+
+namespace co_fun {
+
+void Dataflow::schedule(std::size_t index) {
+    executor_.post([this, index]() {
+        detail::DataflowNode& node = *nodes_[index];
+        node.start_                = std::chrono::steady_clock::now();
+        node.evaluate();
+        node.finish_ = std::chrono::steady_clock::now();
+        for (std::size_t dependent : node.dependents_) {
+            if (!nodes_[dependent]->done_ &&
+                nodes_[dependent]->pending_.fetch_sub(1) == 1) {
+                schedule(dependent);
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--remaining_ == 0) {
+            finished_.notify_all();
+        }
+    });
+}
+
+GraphStats Dataflow::run() {
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<std::size_t> ready;
+    std::size_t              count = 0;
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+        detail::DataflowNode& node = *nodes_[i];
+        if (node.done_) {
+            continue;
+        }
+        ++count;
+        std::size_t pending = 0;
+        for (std::size_t dependency : node.dependencies_) {
+            if (!nodes_[dependency]->done_) {
+                ++pending;
+            }
+        }
+        node.pending_.store(pending);
+        if (pending == 0) {
+            ready.push_back(i);
+        }
+    }
+
+    GraphStats stats;
+    auto       start = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        remaining_ = count;
+    }
+    for (std::size_t index : ready) {
+        schedule(index);
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        finished_.wait(lock, [this]() { return remaining_ == 0; });
+    }
+    stats.elapsed = Clock::now() - start;
+
+    // Longest chain by running time; insertion order is topological.
+    std::vector<std::chrono::nanoseconds> longest(nodes_.size());
+    std::vector<std::size_t>              via(nodes_.size(), nodes_.size());
+    std::size_t                           end = nodes_.size();
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+        detail::DataflowNode& node = *nodes_[i];
+        if (node.done_) {
+            continue;
+        }
+        NodeTiming timing{node.name_,
+                          node.start_ - start,
+                          node.finish_ - start};
+        stats.work += timing.duration();
+        stats.nodes.push_back(timing);
+
+        for (std::size_t dependency : node.dependencies_) {
+            if (!nodes_[dependency]->done_ &&
+                longest[dependency] >= longest[i]) {
+                longest[i] = longest[dependency];
+                via[i]     = dependency;
+            }
+        }
+        longest[i] += timing.duration();
+        if (end == nodes_.size() || longest[i] > longest[end]) {
+            end = i;
+        }
+    }
+
+    if (end != nodes_.size()) {
+        stats.criticalPathTime = longest[end];
+        for (std::size_t i = end; i != nodes_.size(); i = via[i]) {
+            detail::DataflowNode& node = *nodes_[i];
+            stats.criticalPath.push_back(
+                {node.name_, node.start_ - start, node.finish_ - start});
+        }
+        std::reverse(stats.criticalPath.begin(), stats.criticalPath.end());
+    }
+
+    for (auto& node : nodes_) {
+        node->done_ = true;
+    }
+    return stats;
+}
+
+} // namespace co_fun
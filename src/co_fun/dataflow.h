@@ -0,0 +1,238 @@
+// dataflow.h                                                         -*-C++-*-
+#ifndef INCLUDED_CO_FUN_DATAFLOW
+#define INCLUDED_CO_FUN_DATAFLOW
+
+//@PURPOSE: Evaluate a graph of dependent thunks in parallel.
+//
+//@CLASSES:
+//  co_fun::Dataflow: builder and scheduler for a DAG of thunks
+//  co_fun::Node: typed handle to one thunk of a Dataflow graph
+//  co_fun::GraphStats: timing of a run, including its critical path
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: A 'Dataflow' graph is built by adding nodes, each naming
+// the nodes whose values it consumes.  A node's value is a 'Thunk' that
+// applies the node's function to the values of its dependencies, so nodes
+// can be handed to anything that takes a thunk.  Since a node can only
+// depend on nodes that already exist, the graph is acyclic by construction
+// and insertion order is a topological order.
+//
+//..
+//  Executor executor;
+//  Dataflow graph(executor);
+//  auto orders = graph.node("orders", loadOrders);
+//  auto prices = graph.node("prices", loadPrices);
+//  auto total  = graph.node("total", sumOrders, orders, prices);
+//  auto count  = graph.node("count", countOrders, orders);
+//  GraphStats stats = graph.run();
+//..
+//
+// 'run' evaluates every node not evaluated by an earlier run.  A node is
+// posted to the 'Executor' when the last of its dependencies completes, so
+// independent branches run in parallel, and each node's thunk is forced
+// exactly once however many nodes share it.  If a node throws, the
+// exception is kept with the node and rethrown to each dependent, and from
+// 'get()'.
+//
+// 'run' reports the wall time, the total work, and the critical path: the
+// chain of dependent nodes with the largest summed running time, which
+// bounds how fast the graph can run with any number of workers.
+//
+// The dependencies are named when a node is added, rather than discovered
+// by running it, because a thunk forces its inputs synchronously and has no
+// await point at which an edge could be observed.  Node thunks may also be
+// forced by other threads while 'run' is in progress: a node another thread
+// is already evaluating is waited for, and that wait occupies a worker of
+// the pool until the evaluation finishes.
+
+#include <co_fun/executor.h>
+#include <co_fun/thunk.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace co_fun {
+
+struct NodeTiming {
+    std::string              name;
+    std::chrono::nanoseconds start{};
+    std::chrono::nanoseconds finish{};
+
+    std::chrono::nanoseconds duration() const { return finish - start; }
+};
+
+struct GraphStats {
+    std::chrono::nanoseconds elapsed{};
+    std::chrono::nanoseconds work{};
+    std::chrono::nanoseconds criticalPathTime{};
+    std::vector<NodeTiming>  criticalPath;
+    std::vector<NodeTiming>  nodes;
+};
+
+class Dataflow;
+
+namespace detail {
+
+class DataflowNode {
+  public:
+    std::string                           name_;
+    std::vector<std::size_t>              dependencies_;
+    std::vector<std::size_t>              dependents_;
+    std::atomic<std::size_t>              pending_{0};
+    bool                                  done_ = false;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point finish_;
+
+    explicit DataflowNode(std::string name) : name_(std::move(name)) {}
+
+    virtual ~DataflowNode() = default;
+
+    // Force the node's thunk, keeping any exception it throws.
+    virtual void evaluate() = 0;
+};
+
+template <typename Result>
+class DataflowValue : public DataflowNode {
+    Thunk<Result>      thunk_;
+    std::exception_ptr error_;
+
+  public:
+    DataflowValue(std::string name, Thunk<Result> thunk)
+        : DataflowNode(std::move(name)), thunk_(std::move(thunk)) {}
+
+    void evaluate() override {
+        try {
+            co_fun::evaluate(thunk_);
+        } catch (...) {
+            error_ = std::current_exception();
+        }
+    }
+
+    Thunk<Result> const& thunk() const { return thunk_; }
+
+    Result const& get() const {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        return co_fun::evaluate(thunk_);
+    }
+};
+
+} // namespace detail
+
+template <typename Result>
+class Node {
+    std::shared_ptr<detail::DataflowValue<Result>> state_;
+    std::size_t                                    index_ = 0;
+    Dataflow const*                                graph_ = nullptr;
+
+    friend class Dataflow;
+
+    Node(std::shared_ptr<detail::DataflowValue<Result>> state,
+         std::size_t                                    index,
+         Dataflow const*                                graph)
+        : state_(std::move(state)), index_(index), graph_(graph) {}
+
+  public:
+    Node() = default;
+
+    std::string const& name() const { return state_->name_; }
+
+    Thunk<Result> const& thunk() const { return state_->thunk(); }
+
+    bool evaluated() const { return state_->thunk().evaluated(); }
+
+    // The node's value; forces it, and its dependencies, on this thread if
+    // the graph has not been run.
+    Result const& get() const { return state_->get(); }
+
+    operator Result const &() const { return get(); }
+};
+
+class Dataflow {
+    Executor&                                          executor_;
+    std::vector<std::shared_ptr<detail::DataflowNode>> nodes_;
+    // Nodes of the current run not yet finished.  The last worker signals
+    // 'run' under the lock, so 'run' cannot return, and the graph go away,
+    // while a worker still touches it.
+    std::mutex                                         mutex_;
+    std::condition_variable                            finished_;
+    std::size_t                                        remaining_ = 0;
+
+    void schedule(std::size_t index);
+
+    template <typename Result>
+    Node<Result> add(std::string                     name,
+                     Thunk<Result>                   thunk,
+                     std::vector<std::size_t> const& dependencies) {
+        std::size_t index = nodes_.size();
+        auto        state = std::make_shared<detail::DataflowValue<Result>>(
+            std::move(name), std::move(thunk));
+        state->dependencies_ = dependencies;
+        for (std::size_t dependency : dependencies) {
+            nodes_[dependency]->dependents_.push_back(index);
+        }
+        nodes_.push_back(state);
+        return Node<Result>(state, index, this);
+    }
+
+    template <typename Result, typename Func, typename... Deps>
+    static Thunk<Result> apply(Func f, Node<Deps>... deps) {
+        co_return std::invoke(f, deps.get()...);
+    }
+
+    template <typename Dep>
+    std::size_t indexOf(Node<Dep> const& node) const {
+        if (node.graph_ != this) {
+            throw std::invalid_argument("node from another Dataflow graph");
+        }
+        return node.index_;
+    }
+
+  public:
+    explicit Dataflow(Executor& executor) : executor_(executor) {}
+
+    Dataflow(Dataflow const&) = delete;
+    Dataflow& operator=(Dataflow const&) = delete;
+
+    // Add a node computing 'f' applied to the values of 'deps'.
+    template <typename Func, typename... Deps>
+    auto node(std::string name, Func f, Node<Deps> const&... deps)
+        -> Node<std::decay_t<std::invoke_result_t<Func, Deps const&...>>> {
+        using Result =
+            std::decay_t<std::invoke_result_t<Func, Deps const&...>>;
+        std::vector<std::size_t> dependencies{indexOf(deps)...};
+        return add<Result>(std::move(name),
+                           apply<Result>(std::move(f), deps...),
+                           dependencies);
+    }
+
+    // Add an existing thunk as a node with no dependencies.
+    template <typename Result>
+    Node<Result> node(std::string name, Thunk<Result> thunk) {
+        return add<Result>(std::move(name), std::move(thunk), {});
+    }
+
+    std::size_t size() const { return nodes_.size(); }
+
+    // Evaluate every node not yet evaluated, in parallel on the executor,
+    // and wait for them all to finish.  Must not be called from a worker
+    // of the executor.
+    GraphStats run();
+};
+
+} // namespace co_fun
+
+#endif
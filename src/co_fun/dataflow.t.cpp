@@ -0,0 +1,145 @@
+#include <co_fun/dataflow.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace co_fun;
+
+TEST(Co_FunDataflowTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunDataflowTest, Breathing) {
+    Executor executor(2);
+    Dataflow graph(executor);
+    EXPECT_EQ(0u, graph.size());
+
+    auto one = graph.node("one", []() { return 1; });
+    auto two = graph.node("two", thunk([]() { return 2; }));
+    auto sum = graph.node(
+        "sum", [](int a, int b) { return a + b; }, one, two);
+    EXPECT_EQ(3u, graph.size());
+    EXPECT_EQ("sum", sum.name());
+    EXPECT_FALSE(sum.evaluated());
+
+    GraphStats stats = graph.run();
+    EXPECT_TRUE(one.evaluated());
+    EXPECT_TRUE(sum.evaluated());
+    EXPECT_EQ(3, sum.get());
+    EXPECT_EQ(3, evaluate(sum.thunk()));
+    EXPECT_EQ(3u, stats.nodes.size());
+    EXPECT_FALSE(stats.criticalPath.empty());
+    EXPECT_EQ("sum", stats.criticalPath.back().name);
+}
+
+TEST(Co_FunDataflowTest, SharedNodeComputedOnce) {
+    Executor         executor(4);
+    Dataflow         graph(executor);
+    std::atomic<int> queries{0};
+
+    auto query = graph.node("query", [&queries]() {
+        ++queries;
+        return std::string("rows");
+    });
+    auto a = graph.node(
+        "a", [](std::string const& s) { return s.size(); }, query);
+    auto b = graph.node(
+        "b", [](std::string const& s) { return s + s; }, query);
+    auto c = graph.node(
+        "c", [](std::string const& s) { return s.front(); }, query);
+    auto report = graph.node(
+        "report",
+        [](std::size_t n, std::string const& s, char ch) {
+            return std::to_string(n) + s + ch;
+        },
+        a,
+        b,
+        c);
+
+    graph.run();
+    EXPECT_EQ(1, queries.load());
+    EXPECT_EQ("4rowsrowsr", report.get());
+
+    // Nothing left to do on a second run.
+    GraphStats again = graph.run();
+    EXPECT_TRUE(again.nodes.empty());
+    EXPECT_EQ(1, queries.load());
+}
+
+TEST(Co_FunDataflowTest, IndependentBranchesRunInParallel) {
+    using namespace std::chrono_literals;
+    Executor executor(2);
+    Dataflow graph(executor);
+
+    auto slow = [](int i) {
+        return [i]() {
+            std::this_thread::sleep_for(100ms);
+            return i;
+        };
+    };
+    auto left  = graph.node("left", slow(1));
+    auto right = graph.node("right", slow(2));
+    auto quick = graph.node(
+        "quick", [](int i) { return i; }, left);
+    auto join = graph.node(
+        "join", [](int a, int b) { return a + b; }, quick, right);
+
+    GraphStats stats = graph.run();
+    EXPECT_EQ(3, join.get());
+    EXPECT_LT(stats.elapsed, 190ms);
+    EXPECT_GE(stats.work, 200ms);
+    EXPECT_GE(stats.criticalPathTime, 100ms);
+    EXPECT_LE(stats.criticalPathTime, stats.elapsed);
+    ASSERT_EQ(4u, stats.nodes.size());
+    ASSERT_GE(stats.criticalPath.size(), 2u);
+    EXPECT_EQ("join", stats.criticalPath.back().name);
+}
+
+TEST(Co_FunDataflowTest, CriticalPathFollowsSlowestChain) {
+    using namespace std::chrono_literals;
+    Executor executor(2);
+    Dataflow graph(executor);
+
+    auto fast = graph.node("fast", []() { return 1; });
+    auto slow = graph.node("slow", []() {
+        std::this_thread::sleep_for(50ms);
+        return 2;
+    });
+    auto top = graph.node(
+        "top", [](int a, int b) { return a * b; }, fast, slow);
+    GraphStats stats = graph.run();
+    EXPECT_EQ(2, top.get());
+    ASSERT_EQ(2u, stats.criticalPath.size());
+    EXPECT_EQ("slow", stats.criticalPath[0].name);
+    EXPECT_EQ("top", stats.criticalPath[1].name);
+}
+
+TEST(Co_FunDataflowTest, ExceptionPropagates) {
+    Executor executor(2);
+    Dataflow graph(executor);
+
+    auto bad = graph.node("bad", []() -> int {
+        throw std::runtime_error("bad");
+    });
+    auto good  = graph.node("good", []() { return 1; });
+    auto after = graph.node(
+        "after", [](int a, int b) { return a + b; }, bad, good);
+
+    graph.run();
+    EXPECT_EQ(1, good.get());
+    EXPECT_THROW(bad.get(), std::runtime_error);
+    EXPECT_THROW(after.get(), std::runtime_error);
+}
+
+TEST(Co_FunDataflowTest, ForeignNode) {
+    Executor executor(1);
+    Dataflow graph(executor);
+    Dataflow other(executor);
+    auto     n = other.node("n", []() { return 1; });
+    EXPECT_THROW(graph.node(
+                     "m", [](int i) { return i; }, n),
+                 std::invalid_argument);
+}
@@ -0,0 +1,194 @@
+// dirwalk.cpp                                                        -*-C++-*-
+#include <co_fun/dirwalk.h>
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+
+namespace co_fun {
+
+namespace {
+std::system_error systemError(char const* what) {
+    return std::system_error(errno, std::generic_category(), what);
+}
+
+std::string join(std::string const& directory, char const* name) {
+    std::string path = directory;
+    if (path.empty() || path.back() != '/') {
+        path += '/';
+    }
+    return path + name;
+}
+} // namespace
+
+DirWalker::DirWalker(std::string const& root, WalkOptions options)
+    : options_(std::move(options)), pool_(options_.threads) {
+    if (options_.batchSize == 0) {
+        options_.batchSize = 1;
+    }
+    if (options_.readAhead == 0) {
+        options_.readAhead = 1;
+    }
+    std::shared_ptr<DIR> dir(::opendir(root.c_str()), ::closedir);
+    if (!dir) {
+        throw systemError("opendir");
+    }
+    WalkEntry top;
+    top.path = root;
+    while (top.path.size() > 1 && top.path.back() == '/') {
+        top.path.pop_back();
+    }
+    post([this, top = std::move(top), dir]() { list(top, dir); });
+}
+
+DirWalker::~DirWalker() {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        stopped_.store(true);
+    }
+    spaceReady_.notify_all();
+}
+
+void DirWalker::post(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        ++outstanding_;
+    }
+    pool_.post([this, job = std::move(job)]() {
+        try {
+            if (!stopped_.load()) {
+                job();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+            stopped_.store(true);
+            spaceReady_.notify_all();
+        }
+        std::lock_guard<std::mutex> guard(lock_);
+        if (--outstanding_ == 0 || error_) {
+            dataReady_.notify_all();
+        }
+    });
+}
+
+void DirWalker::list(WalkEntry directory, std::shared_ptr<DIR> dir) {
+    if (directory.depth != 0) {
+        deliver({directory});
+    }
+    if (!dir) {
+        return;
+    }
+    std::vector<std::string> names;
+    while (dirent* entry = ::readdir(dir.get())) {
+        if (std::strcmp(entry->d_name, ".") == 0 ||
+            std::strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        names.emplace_back(entry->d_name);
+        if (names.size() == options_.batchSize) {
+            post([this, path = directory.path, names = std::move(names),
+                  depth = directory.depth + 1]() {
+                statBatch(path, names, depth);
+            });
+            names.clear();
+            if (stopped_.load()) {
+                break;
+            }
+        }
+    }
+    dir.reset();
+    if (!names.empty()) {
+        statBatch(directory.path, names, directory.depth + 1);
+    }
+}
+
+void DirWalker::statBatch(std::string const&              directory,
+                          std::vector<std::string> const& names,
+                          int                             depth) {
+    std::vector<WalkEntry> found;
+    found.reserve(names.size());
+    for (std::string const& name : names) {
+        if (stopped_.load()) {
+            return;
+        }
+        WalkEntry entry;
+        entry.path  = join(directory, name.c_str());
+        entry.depth = depth;
+        statted_.fetch_add(1, std::memory_order_relaxed);
+        if (::statx(AT_FDCWD, entry.path.c_str(), AT_SYMLINK_NOFOLLOW,
+                    STATX_BASIC_STATS, &entry.stat) < 0) {
+            if (errno == ENOENT) {
+                continue;
+            }
+            entry.error = errno;
+        } else if (entry.isDirectory() &&
+                   (!options_.descend || options_.descend(entry))) {
+            // Opened by its own job, which reports it, so that a listing
+            // error can be reported with it.
+            post([this, entry = std::move(entry)]() {
+                std::shared_ptr<DIR> dir(::opendir(entry.path.c_str()),
+                                         ::closedir);
+                if (!dir) {
+                    if (errno == ENOENT) {
+                        return;
+                    }
+                    WalkEntry failed = entry;
+                    failed.error     = errno;
+                    list(std::move(failed), nullptr);
+                    return;
+                }
+                list(entry, std::move(dir));
+            });
+            continue;
+        }
+        found.push_back(std::move(entry));
+    }
+    deliver(std::move(found));
+}
+
+void DirWalker::deliver(std::vector<WalkEntry> entries) {
+    if (entries.empty()) {
+        return;
+    }
+    std::unique_lock<std::mutex> guard(lock_);
+    spaceReady_.wait(guard, [this]() {
+        return stopped_.load() || entries_.size() < options_.readAhead;
+    });
+    if (stopped_.load()) {
+        return;
+    }
+    for (WalkEntry& entry : entries) {
+        entries_.push_back(std::move(entry));
+    }
+    dataReady_.notify_one();
+}
+
+std::optional<WalkEntry> DirWalker::next() {
+    std::unique_lock<std::mutex> guard(lock_);
+    dataReady_.wait(guard, [this]() {
+        return !entries_.empty() || outstanding_ == 0 || error_;
+    });
+    if (entries_.empty()) {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        return std::nullopt;
+    }
+    WalkEntry entry = std::move(entries_.front());
+    entries_.pop_front();
+    if (entries_.size() < options_.readAhead) {
+        spaceReady_.notify_one();
+    }
+    return entry;
+}
+
+std::size_t DirWalker::statted() const {
+    return statted_.load(std::memory_order_relaxed);
+}
+
+} // namespace co_fun
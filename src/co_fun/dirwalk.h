@@ -0,0 +1,176 @@
+// dirwalk.h                                                          -*-C++-*-
+#ifndef INCLUDED_CO_FUN_DIRWALK
+#define INCLUDED_CO_FUN_DIRWALK
+
+//@PURPOSE: Stream the entries of a directory tree, stat'ed in parallel.
+//
+//@CLASSES:
+//  co_fun::DirWalker: pool of threads listing and stat'ing a tree
+//  co_fun::WalkEntry: path, 'statx' result and depth of one entry
+//  co_fun::WalkOptions: threads, batch size, read-ahead and pruning
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: 'walk(root)' is a lazy 'ConsStream<WalkEntry>' of every
+// entry below 'root', in the order they are found.  A 'DirWalker' lists
+// directories and calls 'statx' on their entries from an 'Executor' of
+// 'WalkOptions::threads' threads, in batches of 'WalkOptions::batchSize'
+// names, so the latency of the calls overlaps rather than adding up, which
+// is what a walk of a large tree, or of one on a network file system,
+// spends its time on.  Each directory found is listed by a job of its own.
+//
+//..
+//  auto isLarge = [](WalkEntry const& e) { return e.size() > (1 << 30); };
+//  auto largest = take(filter(isLarge, walk("/data")), 10);
+//..
+//
+// The walker runs at most 'WalkOptions::readAhead' entries, give or take a
+// batch per thread, ahead of the stream, and stops once the stream is
+// dropped, so a consumer that takes a few entries, like the 'take' above,
+// stats a few more than it takes rather than the whole tree.
+//
+// Symbolic links are reported, and not followed.  'WalkOptions::descend',
+// if set, is asked, on a worker thread, whether to list each directory, and
+// can prune the walk.  A directory is reported once it has been opened,
+// just before its entries are stat'ed.  An entry that vanishes between
+// being listed and stat'ed is skipped.  One that cannot be stat'ed, or a
+// directory that cannot be listed, is still reported, with
+// 'WalkEntry::error' set to the 'errno' of the failure.  The root must be
+// a directory that can be opened, or 'std::system_error' is thrown.
+//
+// As with 'chunks(fd)', making a walk stream, or forcing one of its cells,
+// waits for the entry after it.  Cells must be forced in order from one
+// thread at a time.
+
+#include <co_fun/executor.h>
+#include <co_fun/stream.h>
+#include <co_fun/suspension.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace co_fun {
+
+struct WalkEntry {
+    std::string  path;
+    struct statx stat  = {};
+    int          depth = 0; // one for an entry of the root
+    int          error = 0; // 'errno' if this could not be stat'ed or listed
+
+    bool isDirectory() const { return S_ISDIR(stat.stx_mode); }
+
+    bool isRegular() const { return S_ISREG(stat.stx_mode); }
+
+    bool isSymlink() const { return S_ISLNK(stat.stx_mode); }
+
+    std::uint64_t size() const { return stat.stx_size; }
+};
+
+struct WalkOptions {
+    // Threads issuing 'statx' calls.  Latency rather than CPU bound, so
+    // more than the cores can pay.
+    std::size_t threads = 8;
+
+    // Names stat'ed by one job.
+    std::size_t batchSize = 64;
+
+    // Entries found but not yet taken by the stream.
+    std::size_t readAhead = 4096;
+
+    // Whether to list a directory; every directory if empty.
+    std::function<bool(WalkEntry const&)> descend;
+};
+
+class DirWalker {
+    WalkOptions              options_;
+    mutable std::mutex       lock_;
+    std::condition_variable  dataReady_;
+    std::condition_variable  spaceReady_;
+    std::deque<WalkEntry>    entries_;
+    std::size_t              outstanding_ = 0;
+    std::atomic<std::size_t> statted_{0};
+    std::atomic<bool>        stopped_{false};
+    std::exception_ptr       error_;
+
+    // Last, so that the jobs finish before the state they use is gone.
+    Executor pool_;
+
+    void post(std::function<void()> job);
+
+    // Report 'directory', unless it is the root, and list it.
+    void list(WalkEntry directory, std::shared_ptr<DIR> dir);
+
+    void statBatch(std::string const&              directory,
+                   std::vector<std::string> const& names,
+                   int                             depth);
+
+    void deliver(std::vector<WalkEntry> entries);
+
+  public:
+    // Start walking the tree below 'root'.
+    explicit DirWalker(std::string const& root, WalkOptions options = {});
+
+    DirWalker(DirWalker const&) = delete;
+    DirWalker& operator=(DirWalker const&) = delete;
+
+    // Stops the walk and waits for the jobs in flight.
+    ~DirWalker();
+
+    // The next entry, blocking until one is found, or nothing once the
+    // tree is exhausted.  Rethrows an error that stopped the walk.
+    std::optional<WalkEntry> next();
+
+    // Entries stat'ed so far, taken or not.
+    std::size_t statted() const;
+};
+
+namespace detail {
+
+template <typename Suspension>
+ConsStream<WalkEntry, Suspension> walkFrom(std::shared_ptr<DirWalker> walker) {
+    std::optional<WalkEntry> entry = walker->next();
+    if (!entry) {
+        return ConsStream<WalkEntry, Suspension>();
+    }
+    return ConsStream<WalkEntry, Suspension>(
+        [walker = std::move(walker), entry = std::move(*entry)]() {
+            return ConsCell<WalkEntry, Suspension>(
+                entry, walkFrom<Suspension>(walker));
+        });
+}
+
+} // namespace detail
+
+// ============================================================================
+//              INLINE FUNCTION AND FUNCTION TEMPLATE DEFINITIONS
+// ============================================================================
+
+template <typename Suspension = ThunkSuspension>
+ConsStream<WalkEntry, Suspension> walk(std::shared_ptr<DirWalker> walker) {
+    return detail::walkFrom<Suspension>(std::move(walker));
+}
+
+template <typename Suspension = ThunkSuspension>
+ConsStream<WalkEntry, Suspension> walk(std::string const& root,
+                                       WalkOptions        options = {}) {
+    return walk<Suspension>(
+        std::make_shared<DirWalker>(root, std::move(options)));
+}
+
+} // namespace co_fun
+
+#endif
@@ -0,0 +1,150 @@
+#include <co_fun/dirwalk.h>
+#include <co_fun/tempfile.t.h>
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace co_fun;
+
+namespace {
+using test::TempDir;
+
+// 'dirs' directories of 'files' files each, one byte per file index.
+void populate(TempDir const& dir, int dirs, int files) {
+    for (int d = 0; d < dirs; ++d) {
+        std::string sub = "d" + std::to_string(d);
+        dir.mkdir(sub);
+        for (int f = 0; f < files; ++f) {
+            dir.write(sub + "/f" + std::to_string(f), std::string(f, 'x'));
+        }
+    }
+}
+
+template <typename Stream>
+std::set<std::string> paths(Stream stream, std::string const& root) {
+    std::set<std::string> result;
+    for (; !stream.isEmpty(); stream = stream.tail()) {
+        result.insert(stream.head().path.substr(root.size() + 1));
+    }
+    return result;
+}
+} // namespace
+
+TEST(Co_FunDirWalkTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunDirWalkTest, Breathing) {
+    TempDir dir;
+    dir.mkdir("a");
+    dir.mkdir("a/b");
+    dir.write("a/b/deep", "xxx");
+    dir.write("top", "xxxxx");
+    EXPECT_EQ((std::set<std::string>{"a", "a/b", "a/b/deep", "top"}),
+              paths(walk(dir.path()), dir.path()));
+}
+
+TEST(Co_FunDirWalkTest, Entries) {
+    TempDir dir;
+    dir.mkdir("sub");
+    dir.write("sub/data", std::string(1234, 'x'));
+    for (auto s = walk(dir.path() + "/"); !s.isEmpty(); s = s.tail()) {
+        WalkEntry const& entry = s.head();
+        EXPECT_EQ(0, entry.error);
+        if (entry.path == dir.path() + "/sub") {
+            EXPECT_TRUE(entry.isDirectory());
+            EXPECT_EQ(1, entry.depth);
+        } else {
+            EXPECT_EQ(dir.path() + "/sub/data", entry.path);
+            EXPECT_TRUE(entry.isRegular());
+            EXPECT_EQ(1234u, entry.size());
+            EXPECT_EQ(2, entry.depth);
+        }
+    }
+}
+
+TEST(Co_FunDirWalkTest, WholeTree) {
+    TempDir dir;
+    populate(dir, 20, 50);
+    WalkOptions options;
+    options.threads   = 4;
+    options.batchSize = 7;
+    options.readAhead = 16;
+    std::set<std::string> found = paths(walk(dir.path(), options), dir.path());
+    EXPECT_EQ(20u + 20 * 50, found.size());
+    EXPECT_TRUE(found.count("d19/f49"));
+}
+
+TEST(Co_FunDirWalkTest, EmptyRoot) {
+    TempDir dir;
+    EXPECT_TRUE(walk(dir.path()).isEmpty());
+}
+
+TEST(Co_FunDirWalkTest, StopsEarly) {
+    TempDir dir;
+    populate(dir, 40, 100);
+    WalkOptions options;
+    options.threads   = 2;
+    options.batchSize = 16;
+    options.readAhead = 32;
+    auto walker       = std::make_shared<DirWalker>(dir.path(), options);
+
+    auto isLarge = [](WalkEntry const& e) { return e.size() >= 90; };
+    auto largest = take(filter(isLarge, walk(walker)), 10);
+    int  count   = 0;
+    for (auto s = largest; !s.isEmpty(); s = s.tail()) {
+        EXPECT_LE(90u, s.head().size());
+        ++count;
+    }
+    EXPECT_EQ(10, count);
+    EXPECT_GT(4040u / 2, walker->statted());
+}
+
+TEST(Co_FunDirWalkTest, Descend) {
+    TempDir dir;
+    populate(dir, 3, 4);
+    WalkOptions options;
+    options.descend = [](WalkEntry const& e) {
+        return e.path.substr(e.path.size() - 2) != "d1";
+    };
+    std::set<std::string> found = paths(walk(dir.path(), options), dir.path());
+    EXPECT_EQ(3u + 2 * 4, found.size());
+    EXPECT_TRUE(found.count("d1"));
+    EXPECT_FALSE(found.count("d1/f0"));
+}
+
+TEST(Co_FunDirWalkTest, SymlinksNotFollowed) {
+    TempDir dir;
+    dir.mkdir("real");
+    dir.write("real/inside");
+    ASSERT_EQ(0, ::symlink("real", (dir.path() + "/link").c_str()));
+    std::set<std::string> found;
+    for (auto s = walk(dir.path()); !s.isEmpty(); s = s.tail()) {
+        if (s.head().isSymlink()) {
+            found.insert(s.head().path);
+        }
+    }
+    EXPECT_EQ((std::set<std::string>{dir.path() + "/link"}), found);
+    EXPECT_EQ(3u, paths(walk(dir.path()), dir.path()).size());
+}
+
+TEST(Co_FunDirWalkTest, BadRoot) {
+    EXPECT_THROW(walk("/nonexistent/tree"), std::system_error);
+    TempDir dir;
+    EXPECT_THROW(walk(dir.write("plain")), std::system_error);
+}
+
+TEST(Co_FunDirWalkTest, DropMidWalk) {
+    TempDir dir;
+    populate(dir, 10, 100);
+    WalkOptions options;
+    options.readAhead = 8;
+    auto stream       = walk(dir.path(), options);
+    EXPECT_FALSE(stream.isEmpty());
+    stream = stream.tail();
+    // Dropping the stream stops workers blocked on a full queue.
+}
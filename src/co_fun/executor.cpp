@@ -0,0 +1,50 @@
+// executor.cpp                                                       -*-C++-*-
+#include <co_fun/executor.h>
+
+namespace co_fun {
+
+Executor::Executor(std::size_t threads) {
+    if (threads == 0) {
+        threads = 1;
+    }
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this]() { work(); });
+    }
+}
+
+Executor::~Executor() {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void Executor::post(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        queue_.push_back(std::move(job));
+    }
+    wake_.notify_one();
+}
+
+void Executor::work() {
+    std::unique_lock<std::mutex> guard(lock_);
+    for (;;) {
+        wake_.wait(guard, [this]() { return stop_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return;
+        }
+        std::function<void()> job = std::move(queue_.front());
+        queue_.pop_front();
+        guard.unlock();
+        job();
+        guard.lock();
+    }
+}
+
+} // namespace co_fun
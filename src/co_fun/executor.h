@@ -0,0 +1,68 @@
+// executor.h                                                         -*-C++-*-
+#ifndef INCLUDED_CO_FUN_EXECUTOR
+#define INCLUDED_CO_FUN_EXECUTOR
+
+//@PURPOSE: Provide a fixed size thread pool for running work eagerly.
+//
+//@CLASSES:
+//  co_fun::Executor: pool of worker threads draining a shared job queue
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: 'Executor' owns a set of worker threads that run posted jobs
+// in FIFO order.  Coroutines move themselves onto the pool with
+// 'co_await executor.schedule()'.  Destroying an 'Executor' runs every job
+// already posted and then joins the workers.
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace co_fun {
+
+class Executor {
+    std::mutex                        lock_;
+    std::condition_variable           wake_;
+    std::deque<std::function<void()>> queue_;
+    bool                              stop_ = false;
+    std::vector<std::thread>          workers_;
+
+    void work();
+
+  public:
+    explicit Executor(
+        std::size_t threads = std::thread::hardware_concurrency());
+
+    Executor(Executor const&) = delete;
+    Executor& operator=(Executor const&) = delete;
+
+    ~Executor();
+
+    std::size_t size() const { return workers_.size(); }
+
+    void post(std::function<void()> job);
+
+    struct ScheduleAwaiter {
+        Executor& executor_;
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            executor_.post([handle]() { handle.resume(); });
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    // Awaitable that resumes the awaiting coroutine on one of the workers.
+    ScheduleAwaiter schedule() { return ScheduleAwaiter{*this}; }
+};
+
+} // namespace co_fun
+
+#endif
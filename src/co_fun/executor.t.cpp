@@ -0,0 +1,60 @@
+#include <co_fun/executor.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <coroutine>
+#include <thread>
+
+using namespace co_fun;
+
+TEST(Co_FunExecutorTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunExecutorTest, Breathing) {
+    Executor executor(2);
+    EXPECT_EQ(2u, executor.size());
+
+    Executor single(0);
+    EXPECT_EQ(1u, single.size());
+}
+
+TEST(Co_FunExecutorTest, RunsPostedJobsBeforeDestruction) {
+    std::atomic<int> ran{0};
+    {
+        Executor executor(3);
+        for (int i = 0; i < 100; ++i) {
+            executor.post([&ran]() { ++ran; });
+        }
+    }
+    EXPECT_EQ(100, ran.load());
+}
+
+namespace {
+struct Detached {
+    struct promise_type {
+        Detached           get_return_object() { return {}; }
+        std::suspend_never initial_suspend() { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void               return_void() {}
+        void               unhandled_exception() { std::terminate(); }
+    };
+};
+
+Detached hop(Executor&          executor,
+             std::thread::id&   where,
+             std::atomic<bool>& done) {
+    co_await executor.schedule();
+    where = std::this_thread::get_id();
+    done  = true;
+    done.notify_one();
+}
+} // namespace
+
+TEST(Co_FunExecutorTest, ScheduleMovesToWorker) {
+    Executor          executor(1);
+    std::thread::id   where;
+    std::atomic<bool> done{false};
+    hop(executor, where, done);
+    done.wait(false);
+    EXPECT_NE(std::this_thread::get_id(), where);
+}
@@ -0,0 +1,93 @@
+// fdstream.cpp                                                       -*-C++-*-
+#include <co_fun/fdstream.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace co_fun {
+
+FdReader::FdReader(int fd, FdOptions const& options)
+    : fd_(fd),
+      wake_(::eventfd(0, EFD_CLOEXEC)),
+      pool_(std::make_shared<BufferPool>(options.blockSize ? options.blockSize
+                                                           : 1,
+                                         options.readAhead + 2)),
+      ring_(options.readAhead) {
+    if (wake_ < 0) {
+        throw std::system_error(errno, std::generic_category(), "eventfd");
+    }
+    thread_ = std::thread([this]() { run(); });
+}
+
+FdReader::~FdReader() {
+    ring_.cancel();
+    std::uint64_t one = 1;
+    (void)::write(wake_, &one, sizeof one);
+    thread_.join();
+    ::close(wake_);
+}
+
+void FdReader::run() {
+    pollfd polls[2] = {{fd_, POLLIN, 0}, {wake_, POLLIN, 0}};
+    try {
+        while (!ring_.cancelled()) {
+            // Wait for input or for the stream to be dropped, so an idle
+            // pipe does not pin the thread.
+            if (::poll(polls, 2, -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(),
+                                        "poll");
+            }
+            if (polls[1].revents) {
+                break;
+            }
+
+            std::shared_ptr<char> buffer = pool_->acquire();
+            ssize_t n = ::read(fd_, buffer.get(), pool_->blockSize());
+            if (n < 0) {
+                if (errno == EINTR || errno == EAGAIN) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(),
+                                        "read");
+            }
+            if (n == 0) {
+                break;
+            }
+
+            Chunk chunk(std::shared_ptr<char const>(buffer),
+                        std::string_view(buffer.get(), std::size_t(n)));
+            buffer.reset();
+            while (ring_.tryPush(&chunk, 1) == 0) {
+                if (!ring_.waitForSpace()) {
+                    return;
+                }
+            }
+        }
+    } catch (...) {
+        error_ = std::current_exception();
+    }
+    ring_.close();
+}
+
+std::optional<Chunk> FdReader::next() {
+    Chunk chunk;
+    while (ring_.tryPop(&chunk, 1) == 0) {
+        if (!ring_.waitForData()) {
+            if (error_) {
+                std::rethrow_exception(error_);
+            }
+            return std::nullopt;
+        }
+    }
+    return chunk;
+}
+
+} // namespace co_fun
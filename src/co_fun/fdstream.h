@@ -0,0 +1,176 @@
+// fdstream.h                                                         -*-C++-*-
+#ifndef INCLUDED_CO_FUN_FDSTREAM
+#define INCLUDED_CO_FUN_FDSTREAM
+
+//@PURPOSE: Stream the bytes of a file descriptor, read ahead on a thread.
+//
+//@CLASSES:
+//  co_fun::FdReader: background reader of a file descriptor into chunks
+//  co_fun::FdOptions: block size and read-ahead depth of an 'FdReader'
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: 'chunks(fd)' is a lazy 'ConsStream<Chunk>' of the bytes
+// read from 'fd', which may be a file, a pipe, a socket or standard input.
+// An 'FdReader' thread reads blocks of up to 'FdOptions::blockSize' bytes
+// into buffers from a 'BufferPool', and hands them to the stream through a
+// single-producer/single-consumer ring.  It runs at most
+// 'FdOptions::readAhead' blocks ahead of the consumer, so reading the next
+// blocks overlaps with whatever the consumer does with this one.  Buffers
+// return to the pool as the consumer drops its chunks, so a stream walked
+// without holding on to its head allocates a bounded number of blocks.
+//
+// 'delimited(stream, '\n')' splits a chunk stream into records.  A record
+// inside one chunk shares its buffer; one that spans chunks is copied.  A
+// final record with no delimiter is still a record.
+//
+//..
+//  auto records = delimited(chunks(STDIN_FILENO));
+//  auto totals  = fmap(records, parseTotal);
+//..
+//
+// As with 'filter', whether a stream is empty is known when it is made, so
+// making a chunk stream, or forcing one of its cells, waits for the block
+// after it, or for end of file.  A read error is thrown from there, after
+// the chunks read before it.
+//
+// The descriptor is not owned, and must stay open until the stream is
+// exhausted or dropped.  Dropping the last handle to an unfinished stream
+// stops the reader thread, even one blocked waiting on an idle pipe.  Cells
+// must be forced in order from one thread at a time, as with any stream
+// over a ring.
+
+#include <co_fun/bufferpool.h>
+#include <co_fun/ringbuffer.h>
+#include <co_fun/stream.h>
+#include <co_fun/suspension.h>
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+namespace co_fun {
+
+struct FdOptions {
+    // Largest number of bytes read at once.
+    std::size_t blockSize = std::size_t(1) << 20;
+
+    // Blocks read but not yet taken by the stream.  Rounded up to a power
+    // of two, and at least two.
+    std::size_t readAhead = 4;
+};
+
+class FdReader {
+    int                         fd_;
+    int                         wake_;
+    std::shared_ptr<BufferPool> pool_;
+    SpscRing<Chunk>             ring_;
+    std::exception_ptr          error_;
+    std::thread                 thread_;
+
+    void run();
+
+  public:
+    FdReader(int fd, FdOptions const& options);
+
+    FdReader(FdReader const&) = delete;
+    FdReader& operator=(FdReader const&) = delete;
+
+    // Stops the reader thread and waits for it.
+    ~FdReader();
+
+    // The next chunk, blocking until it has been read, or nothing at end of
+    // file.  Rethrows the error that stopped the reader.  Consumer only.
+    std::optional<Chunk> next();
+
+    BufferPool const& pool() const { return *pool_; }
+};
+
+namespace detail {
+
+// A stream of the chunks returned by 'reader->next()', which any reader
+// with that member can supply.
+template <typename Suspension, typename Reader>
+ConsStream<Chunk, Suspension> chunksFrom(std::shared_ptr<Reader> reader) {
+    std::optional<Chunk> chunk = reader->next();
+    if (!chunk) {
+        return ConsStream<Chunk, Suspension>();
+    }
+    return ConsStream<Chunk, Suspension>(
+        [reader = std::move(reader), chunk = std::move(*chunk)]() {
+            return ConsCell<Chunk, Suspension>(chunk,
+                                               chunksFrom<Suspension>(reader));
+        });
+}
+
+template <typename Suspension>
+ConsStream<Chunk, Suspension> delimitedFrom(ConsStream<Chunk, Suspension> in,
+                                            Chunk rest,
+                                            char  delimiter) {
+    while (rest.empty() && !in.isEmpty()) {
+        rest = in.head();
+        in   = in.tail();
+    }
+    Chunk       record;
+    std::size_t pos = rest.view().find(delimiter);
+    if (pos != std::string_view::npos) {
+        record = rest.substr(0, pos);
+        rest   = rest.substr(pos + 1);
+    } else {
+        // The record continues into the chunks that follow.
+        std::string carry(rest.view());
+        bool        found = false;
+        rest              = Chunk();
+        while (!found && !in.isEmpty()) {
+            Chunk next = in.head();
+            in         = in.tail();
+            pos        = next.view().find(delimiter);
+            if (pos != std::string_view::npos) {
+                carry.append(next.view().substr(0, pos));
+                rest  = next.substr(pos + 1);
+                found = true;
+            } else {
+                carry.append(next.view());
+            }
+        }
+        if (!found && carry.empty()) {
+            return ConsStream<Chunk, Suspension>();
+        }
+        record = Chunk::copyOf(carry);
+    }
+    return ConsStream<Chunk, Suspension>([in, record, rest, delimiter]() {
+        return ConsCell<Chunk, Suspension>(
+            record, delimitedFrom(in, rest, delimiter));
+    });
+}
+
+} // namespace detail
+
+// ============================================================================
+//              INLINE FUNCTION AND FUNCTION TEMPLATE DEFINITIONS
+// ============================================================================
+
+template <typename Suspension = ThunkSuspension>
+ConsStream<Chunk, Suspension> chunks(std::shared_ptr<FdReader> reader) {
+    return detail::chunksFrom<Suspension>(std::move(reader));
+}
+
+template <typename Suspension = ThunkSuspension>
+ConsStream<Chunk, Suspension> chunks(int fd, FdOptions const& options = {}) {
+    return chunks<Suspension>(std::make_shared<FdReader>(fd, options));
+}
+
+template <typename Suspension>
+ConsStream<Chunk, Suspension> delimited(ConsStream<Chunk, Suspension> in,
+                                        char delimiter = '\n') {
+    return detail::delimitedFrom(std::move(in), Chunk(), delimiter);
+}
+
+} // namespace co_fun
+
+#endif
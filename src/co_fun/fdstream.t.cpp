@@ -0,0 +1,187 @@
+#include <co_fun/fdstream.h>
+#include <co_fun/stream.t.h>
+#include <co_fun/tempfile.t.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace co_fun;
+
+namespace {
+using test::collect;
+
+// Both ends of a pipe, closed on destruction.
+struct Pipe {
+    int read  = -1;
+    int write = -1;
+
+    Pipe() {
+        int fds[2];
+        EXPECT_EQ(0, ::pipe(fds));
+        read  = fds[0];
+        write = fds[1];
+    }
+
+    void closeWrite() {
+        if (write >= 0) {
+            ::close(write);
+            write = -1;
+        }
+    }
+
+    ~Pipe() {
+        closeWrite();
+        ::close(read);
+    }
+};
+
+void writeAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t n = ::write(fd, data.data(), data.size());
+        ASSERT_LT(0, n);
+        data.remove_prefix(std::size_t(n));
+    }
+}
+
+template <typename Stream>
+std::string concatenate(Stream stream) {
+    std::string result;
+    for (; !stream.isEmpty(); stream = stream.tail()) {
+        result.append(stream.head().view());
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(Co_FunFdStreamTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunFdStreamTest, Pipe) {
+    Pipe        pipe;
+    std::thread writer([&pipe]() {
+        writeAll(pipe.write, "hello, ");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        writeAll(pipe.write, "world");
+        pipe.closeWrite();
+    });
+    EXPECT_EQ("hello, world", concatenate(chunks(pipe.read)));
+    writer.join();
+}
+
+TEST(Co_FunFdStreamTest, Empty) {
+    Pipe pipe;
+    pipe.closeWrite();
+    EXPECT_TRUE(chunks(pipe.read).isEmpty());
+}
+
+TEST(Co_FunFdStreamTest, SmallBlocks) {
+    std::string text;
+    for (int i = 0; i < 1000; ++i) {
+        text += std::to_string(i) + ",";
+    }
+    Pipe        pipe;
+    std::thread writer([&]() {
+        writeAll(pipe.write, text);
+        pipe.closeWrite();
+    });
+
+    FdOptions options;
+    options.blockSize = 7;
+    options.readAhead = 2;
+    auto stream       = chunks<MemoSuspension>(pipe.read, options);
+    for (auto s = stream; !s.isEmpty(); s = s.tail()) {
+        EXPECT_GE(7u, s.head().size());
+    }
+    EXPECT_EQ(text, concatenate(stream));
+    writer.join();
+}
+
+TEST(Co_FunFdStreamTest, BuffersReused) {
+    test::TempFile file(std::string(64 * 1024, 'x'));
+    int            fd = ::open(file.path().c_str(), O_RDONLY);
+    ASSERT_LE(0, fd);
+
+    FdOptions options;
+    options.blockSize = 512;
+    options.readAhead = 2;
+    auto        reader = std::make_shared<FdReader>(fd, options);
+    std::size_t total  = 0;
+    for (auto s = chunks(reader); !s.isEmpty(); s = s.tail()) {
+        total += s.head().size();
+    }
+    EXPECT_EQ(64u * 1024, total);
+
+    // 128 blocks were read through the ring, the stream's lookahead, and
+    // the block being read.
+    EXPECT_GE(6u, reader->pool().allocated());
+    ::close(fd);
+}
+
+TEST(Co_FunFdStreamTest, DropWhileIdle) {
+    // The reader is blocked on a pipe with no data and no end; dropping the
+    // stream must still stop it.
+    Pipe pipe;
+    writeAll(pipe.write, "one block");
+    {
+        auto s = chunks(pipe.read);
+        EXPECT_FALSE(s.isEmpty());
+    }
+    SUCCEED();
+}
+
+TEST(Co_FunFdStreamTest, ReadError) {
+    int dir = ::open("/tmp", O_RDONLY | O_DIRECTORY);
+    ASSERT_LE(0, dir);
+    EXPECT_THROW(chunks(dir), std::system_error);
+    ::close(dir);
+}
+
+TEST(Co_FunFdStreamTest, Delimited) {
+    Pipe        pipe;
+    std::thread writer([&]() {
+        writeAll(pipe.write, "alpha\nbeta\n\ngam");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        writeAll(pipe.write, "ma\ndelta");
+        pipe.closeWrite();
+    });
+    FdOptions options;
+    options.blockSize = 4;
+    EXPECT_EQ(
+        (std::vector<std::string>{"alpha", "beta", "", "gamma", "delta"}),
+        collect<std::string>(delimited(chunks(pipe.read, options))));
+    writer.join();
+}
+
+TEST(Co_FunFdStreamTest, DelimitedSharesBuffer) {
+    Pipe pipe;
+    writeAll(pipe.write, "a,b,c");
+    pipe.closeWrite();
+    auto all     = chunks(pipe.read);
+    auto records = delimited(all, ',');
+    EXPECT_EQ(all.head().data(), records.head().data());
+    EXPECT_EQ(all.head().data() + 2, records.tail().head().data());
+}
+
+TEST(Co_FunFdStreamTest, Combinators) {
+    Pipe pipe;
+    writeAll(pipe.write, "1\n2\n3\n4\n5\n6\n");
+    pipe.closeWrite();
+    auto numbers = fmap(delimited(chunks(pipe.read)), [](Chunk const& c) {
+        return std::stoi(std::string(c.view()));
+    });
+    auto evens   = filter([](int i) { return i % 2 == 0; }, numbers);
+    std::vector<int> result;
+    for (int i : take(evens, 2)) {
+        result.push_back(i);
+    }
+    EXPECT_EQ((std::vector<int>{2, 4}), result);
+}
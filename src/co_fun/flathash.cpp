@@ -0,0 +1,2 @@
+// flathash.cpp                                                       -*-C++-*-
+#include <co_fun/flathash.h>
@@ -0,0 +1,269 @@
+// flathash.h                                                         -*-C++-*-
+#ifndef INCLUDED_CO_FUN_FLATHASH
+#define INCLUDED_CO_FUN_FLATHASH
+
+//@PURPOSE: Provide insert-only open-addressing hash tables.
+//
+//@CLASSES:
+//  co_fun::FlatHashMap: map with entries in one array, indexed by hash
+//  co_fun::FlatHashSet: set of keys over a 'FlatHashMap'
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: A 'FlatHashMap' keeps its entries, in insertion order, in
+// one 'std::vector', and finds them through a power-of-two table of 8-byte
+// slots, probed linearly.  A slot holds the index of an entry and the top
+// half of its key's hash, so a probe compares keys only when the hashes
+// agree, and walks a few adjacent slots in one or two cache lines instead
+// of chasing the node pointers of 'std::unordered_map'.  The full hash of
+// each entry is kept beside it, so growing rebuilds the slot table without
+// hashing any key again, and inserting allocates only when one of the
+// arrays grows.
+//
+// The hash of a key can be computed ahead of the lookup with 'hashOf', and
+// its slot fetched into cache with 'prefetch', so a batch of lookups can
+// issue its memory loads together:
+//..
+//  std::uint64_t hashes[16];
+//  for (int i = 0; i < 16; ++i) {
+//      hashes[i] = table.hashOf(keys[i]);
+//      table.prefetch(hashes[i]);
+//  }
+//  for (int i = 0; i < 16; ++i) {
+//      use(table.findHashed(hashes[i], keys[i]));
+//  }
+//..
+//
+// The tables only grow: there is no 'erase'.  That is what building an
+// index, a set of keys seen or the groups of a stream needs, and it keeps
+// probing free of tombstones.  The result of 'std::hash' is mixed before
+// use, so identity hashes of integers spread over the table.  Pointers to
+// entries are invalidated by inserting, as with 'std::vector'.
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace co_fun {
+
+namespace detail {
+
+// The finalizer of MurmurHash3, spreading every input bit over the result.
+inline std::uint64_t mixHash(std::uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+} // namespace detail
+
+template <typename Key,
+          typename Value,
+          typename Hash  = std::hash<Key>,
+          typename Equal = std::equal_to<Key>>
+class FlatHashMap {
+  public:
+    using value_type = std::pair<Key, Value>;
+    using iterator   = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+  private:
+    struct Slot {
+        std::uint32_t tag;
+        std::uint32_t index;
+    };
+
+    static constexpr std::uint32_t vacant   = ~std::uint32_t(0);
+    static constexpr std::size_t   minSlots = 16;
+
+    std::vector<value_type>    entries_;
+    std::vector<std::uint64_t> hashes_; // of 'entries_', index for index
+    std::vector<Slot>          slots_;
+    std::size_t                mask_ = 0;
+    Hash                       hash_;
+    Equal                      equal_;
+
+    static std::uint32_t tagOf(std::uint64_t hash) {
+        return std::uint32_t(hash >> 32);
+    }
+
+    // Slots for 'count' entries at a load of at most three quarters.
+    static std::size_t slotsFor(std::size_t count) {
+        std::size_t slots = std::bit_ceil(count + count / 3 + 1);
+        return slots < minSlots ? minSlots : slots;
+    }
+
+    // The slot holding 'key', or the vacant slot where it would go.
+    std::size_t probe(Key const& key, std::uint64_t hash) const {
+        std::uint32_t tag = tagOf(hash);
+        for (std::size_t i = hash & mask_;; i = (i + 1) & mask_) {
+            Slot const& slot = slots_[i];
+            if (slot.index == vacant ||
+                (slot.tag == tag && equal_(entries_[slot.index].first, key))) {
+                return i;
+            }
+        }
+    }
+
+    void rehash(std::size_t slots) {
+        slots_.assign(slots, Slot{0, vacant});
+        mask_ = slots - 1;
+        for (std::size_t index = 0; index < entries_.size(); ++index) {
+            std::uint64_t hash = hashes_[index];
+            std::size_t   i    = hash & mask_;
+            while (slots_[i].index != vacant) {
+                i = (i + 1) & mask_;
+            }
+            slots_[i] = Slot{tagOf(hash), std::uint32_t(index)};
+        }
+    }
+
+  public:
+    explicit FlatHashMap(std::size_t  expected = 0,
+                         Hash const&  hash     = Hash(),
+                         Equal const& equal    = Equal())
+        : hash_(hash), equal_(equal) {
+        entries_.reserve(expected);
+        hashes_.reserve(expected);
+        rehash(slotsFor(expected));
+    }
+
+    std::size_t size() const { return entries_.size(); }
+
+    bool empty() const { return entries_.empty(); }
+
+    // Make room for 'count' entries without growing.
+    void reserve(std::size_t count) {
+        entries_.reserve(count);
+        hashes_.reserve(count);
+        if (slotsFor(count) > slots_.size()) {
+            rehash(slotsFor(count));
+        }
+    }
+
+    std::uint64_t hashOf(Key const& key) const {
+        return detail::mixHash(std::uint64_t(hash_(key)));
+    }
+
+    // Start loading the first slot probed for 'hash'.
+    void prefetch(std::uint64_t hash) const {
+        __builtin_prefetch(&slots_[hash & mask_]);
+    }
+
+    // Insert 'key', with a value made from 'args', unless it is present.
+    // Returns the entry for 'key', and whether it was inserted.
+    template <typename... Args>
+    std::pair<value_type*, bool> tryEmplace(Key const& key, Args&&... args) {
+        return tryEmplaceHashed(hashOf(key), key, std::forward<Args>(args)...);
+    }
+
+    // As 'tryEmplace', with the 'hash' of 'key' already computed.
+    template <typename... Args>
+    std::pair<value_type*, bool>
+    tryEmplaceHashed(std::uint64_t hash, Key const& key, Args&&... args) {
+        std::size_t i = probe(key, hash);
+        if (slots_[i].index != vacant) {
+            return {&entries_[slots_[i].index], false};
+        }
+        if (entries_.size() == vacant) {
+            throw std::length_error("FlatHashMap: too many entries");
+        }
+        hashes_.push_back(hash);
+        try {
+            entries_.emplace_back(
+                std::piecewise_construct,
+                std::forward_as_tuple(key),
+                std::forward_as_tuple(std::forward<Args>(args)...));
+        } catch (...) {
+            hashes_.pop_back();
+            throw;
+        }
+        if (slotsFor(entries_.size()) > slots_.size()) {
+            rehash(slots_.size() * 2);
+        } else {
+            slots_[i] = Slot{tagOf(hash), std::uint32_t(entries_.size() - 1)};
+        }
+        return {&entries_.back(), true};
+    }
+
+    // The value for 'key', or null.
+    Value* find(Key const& key) { return findHashed(hashOf(key), key); }
+
+    Value const* find(Key const& key) const {
+        return findHashed(hashOf(key), key);
+    }
+
+    Value* findHashed(std::uint64_t hash, Key const& key) {
+        std::size_t i = probe(key, hash);
+        return slots_[i].index == vacant ? nullptr
+                                         : &entries_[slots_[i].index].second;
+    }
+
+    Value const* findHashed(std::uint64_t hash, Key const& key) const {
+        return const_cast<FlatHashMap*>(this)->findHashed(hash, key);
+    }
+
+    bool contains(Key const& key) const { return find(key) != nullptr; }
+
+    iterator begin() { return entries_.begin(); }
+
+    iterator end() { return entries_.end(); }
+
+    const_iterator begin() const { return entries_.begin(); }
+
+    const_iterator end() const { return entries_.end(); }
+
+    // Take the entries, in insertion order, leaving the map empty.
+    std::vector<value_type> release() {
+        std::vector<value_type> entries = std::move(entries_);
+        entries_.clear();
+        hashes_.clear();
+        rehash(minSlots);
+        return entries;
+    }
+};
+
+template <typename Key,
+          typename Hash  = std::hash<Key>,
+          typename Equal = std::equal_to<Key>>
+class FlatHashSet {
+    struct Nothing {};
+
+    FlatHashMap<Key, Nothing, Hash, Equal> map_;
+
+  public:
+    explicit FlatHashSet(std::size_t  expected = 0,
+                         Hash const&  hash     = Hash(),
+                         Equal const& equal    = Equal())
+        : map_(expected, hash, equal) {}
+
+    std::size_t size() const { return map_.size(); }
+
+    bool empty() const { return map_.empty(); }
+
+    void reserve(std::size_t count) { map_.reserve(count); }
+
+    std::uint64_t hashOf(Key const& key) const { return map_.hashOf(key); }
+
+    void prefetch(std::uint64_t hash) const { map_.prefetch(hash); }
+
+    // Add 'key'; returns false if it was already present.
+    bool insert(Key const& key) { return insertHashed(hashOf(key), key); }
+
+    bool insertHashed(std::uint64_t hash, Key const& key) {
+        return map_.tryEmplaceHashed(hash, key).second;
+    }
+
+    bool contains(Key const& key) const { return map_.contains(key); }
+};
+
+} // namespace co_fun
+
+#endif
@@ -0,0 +1,156 @@
+#include <co_fun/flathash.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace co_fun;
+
+namespace {
+// Every key hashes alike, so lookups rely on comparing keys.
+struct Collide {
+    std::size_t operator()(int) const { return 42; }
+};
+
+// Counts the keys it hashes.
+struct Counted {
+    int* calls;
+
+    std::size_t operator()(int key) const {
+        ++*calls;
+        return std::hash<int>()(key);
+    }
+};
+} // namespace
+
+TEST(Co_FunFlatHashTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunFlatHashTest, Breathing) {
+    FlatHashMap<std::string, int> map;
+    EXPECT_TRUE(map.empty());
+    EXPECT_TRUE(map.tryEmplace("one", 1).second);
+    EXPECT_TRUE(map.tryEmplace("two", 2).second);
+    auto again = map.tryEmplace("one", 10);
+    EXPECT_FALSE(again.second);
+    EXPECT_EQ(1, again.first->second);
+    EXPECT_EQ(2u, map.size());
+    ASSERT_NE(nullptr, map.find("two"));
+    EXPECT_EQ(2, *map.find("two"));
+    EXPECT_EQ(nullptr, map.find("three"));
+}
+
+TEST(Co_FunFlatHashTest, GrowsInInsertionOrder) {
+    FlatHashMap<int, int> map;
+    for (int i = 0; i < 10000; ++i) {
+        map.tryEmplace(i * 7919, i);
+    }
+    EXPECT_EQ(10000u, map.size());
+    int expected = 0;
+    for (auto const& [key, value] : map) {
+        ASSERT_EQ(expected * 7919, key);
+        ASSERT_EQ(expected, value);
+        ++expected;
+    }
+    for (int i = 0; i < 10000; ++i) {
+        ASSERT_NE(nullptr, map.find(i * 7919));
+        ASSERT_EQ(i, *map.find(i * 7919));
+    }
+    EXPECT_FALSE(map.contains(1));
+}
+
+TEST(Co_FunFlatHashTest, Collisions) {
+    FlatHashMap<int, int, Collide> map;
+    for (int i = 0; i < 100; ++i) {
+        map.tryEmplace(i, -i);
+    }
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQ(-i, *map.find(i));
+    }
+    EXPECT_EQ(nullptr, map.find(100));
+}
+
+TEST(Co_FunFlatHashTest, BatchedLookups) {
+    FlatHashMap<std::uint64_t, std::uint64_t> map(1000);
+    for (std::uint64_t i = 0; i < 1000; ++i) {
+        map.tryEmplace(i, i * i);
+    }
+    std::uint64_t keys[16];
+    std::uint64_t hashes[16];
+    for (std::uint64_t base = 0; base < 2000; base += 16) {
+        for (int i = 0; i < 16; ++i) {
+            keys[i]   = base + i;
+            hashes[i] = map.hashOf(keys[i]);
+            map.prefetch(hashes[i]);
+        }
+        for (int i = 0; i < 16; ++i) {
+            std::uint64_t const* found = map.findHashed(hashes[i], keys[i]);
+            if (keys[i] < 1000) {
+                ASSERT_NE(nullptr, found);
+                EXPECT_EQ(keys[i] * keys[i], *found);
+            } else {
+                EXPECT_EQ(nullptr, found);
+            }
+        }
+    }
+}
+
+TEST(Co_FunFlatHashTest, MatchesUnorderedMap) {
+    FlatHashMap<unsigned, int>        flat;
+    std::unordered_map<unsigned, int> reference;
+    unsigned                          x = 12345;
+    for (int i = 0; i < 50000; ++i) {
+        x = x * 1103515245 + 12345;
+        unsigned key = (x >> 8) % 20000;
+        flat.tryEmplace(key, 0).first->second += 1;
+        reference[key] += 1;
+    }
+    EXPECT_EQ(reference.size(), flat.size());
+    for (auto const& [key, count] : reference) {
+        ASSERT_EQ(count, *flat.find(key));
+    }
+}
+
+TEST(Co_FunFlatHashTest, GrowingDoesNotRehash) {
+    int                            calls = 0;
+    FlatHashMap<int, int, Counted> map(0, Counted{&calls});
+    for (int i = 0; i < 10000; ++i) {
+        map.tryEmplace(i, i);
+    }
+    EXPECT_EQ(10000, calls);
+    map.reserve(100000);
+    EXPECT_EQ(10000, calls);
+    for (int i = 0; i < 10000; ++i) {
+        ASSERT_EQ(i, *map.find(i));
+    }
+}
+
+TEST(Co_FunFlatHashTest, Release) {
+    FlatHashMap<int, std::string> map;
+    map.tryEmplace(3, "three");
+    map.tryEmplace(1, "one");
+    auto entries = map.release();
+    ASSERT_EQ(2u, entries.size());
+    EXPECT_EQ(3, entries[0].first);
+    EXPECT_EQ("one", entries[1].second);
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(nullptr, map.find(3));
+    map.tryEmplace(3, "again");
+    EXPECT_EQ("again", *map.find(3));
+}
+
+TEST(Co_FunFlatHashTest, Set) {
+    FlatHashSet<std::string> set;
+    EXPECT_TRUE(set.insert("a"));
+    EXPECT_TRUE(set.insert("b"));
+    EXPECT_FALSE(set.insert("a"));
+    EXPECT_EQ(2u, set.size());
+    EXPECT_TRUE(set.contains("b"));
+    EXPECT_FALSE(set.contains("c"));
+    std::uint64_t hash = set.hashOf("c");
+    set.prefetch(hash);
+    EXPECT_TRUE(set.insertHashed(hash, "c"));
+    EXPECT_TRUE(set.contains("c"));
+}
@@ -1,2 +1,72 @@
 // holder.cpp                                                         -*-C++-*-
 #include <co_fun/holder.h>
+
+#ifdef __linux__
+#include <climits>
+#include <ctime>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+namespace co_fun {
+namespace detail {
+
+#ifdef __linux__
+
+void timedWait(std::atomic<std::uint32_t> const& word,
+               std::uint32_t                     expected,
+               std::chrono::nanoseconds          timeout) noexcept {
+    timespec limit{std::time_t(timeout.count() / 1000000000),
+                   long(timeout.count() % 1000000000)};
+    ::syscall(SYS_futex,
+              &word,
+              FUTEX_WAIT_PRIVATE,
+              expected,
+              &limit,
+              nullptr,
+              0);
+}
+
+void wakeTimedWaiters(std::atomic<std::uint32_t> const& word) noexcept {
+    ::syscall(SYS_futex,
+              &word,
+              FUTEX_WAKE_PRIVATE,
+              INT_MAX,
+              nullptr,
+              nullptr,
+              0);
+}
+
+#else
+
+// Elsewhere timed waiters share one condition variable.  A waker takes the
+// lock after changing the word, so a waiter either sees the change before
+// sleeping, or is asleep when notified.
+namespace {
+std::mutex              timedLock;
+std::condition_variable timedWake;
+} // namespace
+
+void timedWait(std::atomic<std::uint32_t> const& word,
+               std::uint32_t                     expected,
+               std::chrono::nanoseconds          timeout) noexcept {
+    std::unique_lock<std::mutex> guard(timedLock);
+    if (word.load(std::memory_order_acquire) == expected) {
+        timedWake.wait_for(guard, timeout);
+    }
+}
+
+void wakeTimedWaiters(std::atomic<std::uint32_t> const&) noexcept {
+    { std::lock_guard<std::mutex> guard(timedLock); }
+    timedWake.notify_all();
+}
+
+#endif
+
+} // namespace detail
+} // namespace co_fun
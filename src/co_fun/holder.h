@@ -3,11 +3,16 @@
 #define INCLUDED_CO_FUN_HOLDER
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <exception>
+#include <functional>
 #include <utility>
 #include <cassert>
 #include <coroutine>
 
+#include <co_fun/cancellation.h>
+
 //@PURPOSE:
 //
 //@CLASSES:
@@ -18,6 +23,35 @@
 
 namespace co_fun {
 
+namespace detail {
+
+// Sleep while 'word' holds 'expected', until woken by 'wakeTimedWaiters',
+// or until 'timeout' has passed.  May return early.
+void timedWait(std::atomic<std::uint32_t> const& word,
+               std::uint32_t                     expected,
+               std::chrono::nanoseconds          timeout) noexcept;
+
+// Wake every thread sleeping in 'timedWait' on 'word'.
+void wakeTimedWaiters(std::atomic<std::uint32_t> const& word) noexcept;
+
+} // namespace detail
+
+// Suspend a 'Thunk' or 'Lazy' coroutine without a result, giving up the
+// evaluation in progress: the thread that forced it gets 'Cancelled'.  The
+// coroutine stays where it is, unevaluated, and the next force resumes it
+// from there.  A coroutine catching 'Cancelled' from something it forces
+// awaits this after the handler, as it cannot await inside one.
+struct Abandon {
+    bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) const {
+        handle.promise().abandon(std::make_exception_ptr(Cancelled()));
+    }
+
+    void await_resume() const noexcept {}
+};
+
 template <typename T>
 struct Value {
     T   value;
@@ -39,6 +73,10 @@ struct Holder {
 
         void unhandled_exception() { throw; }
 
+        void abandon(std::exception_ptr reason) noexcept {
+            abandoned_ = std::move(reason);
+        }
+
         std::suspend_always initial_suspend() noexcept { return {}; }
 
         std::suspend_never final_suspend() noexcept { return {}; }
@@ -49,10 +87,11 @@ struct Holder {
 
         void setHolder(Holder<R>* holder) { holder_ = holder; }
 
-        Holder<R>* holder_;
+        Holder<R>*         holder_;
+        std::exception_ptr abandoned_;
     };
 
-    enum class result_status { empty, value, error };
+    enum class result_status { empty, value, error, cancelled };
 
     std::atomic<result_status> status{result_status::empty};
 
@@ -66,6 +105,91 @@ struct Holder {
 
     Promise* promise_;
 
+    // Whether a thread is running the coroutine, or it has finished.
+    // Waiters sleep on this word while it is 'running'.
+    enum : std::uint32_t { idle, running, finished };
+
+    std::atomic<std::uint32_t> run_{idle};
+
+    // Threads blocked in 'wait' or 'waitUntil'.
+    mutable std::atomic<std::uint32_t> waiters_{0};
+
+    // Callbacks waiting for a result, pushed lock-free.  Once they have run
+    // the list is swapped for 'closed()' and never grows again.
+    struct Callback {
+        std::function<void()> func;
+        Callback*             next;
+    };
+
+    std::atomic<Callback*> callbacks_{nullptr};
+
+    static Callback* closed() noexcept {
+        static Callback sentinel{{}, nullptr};
+        return &sentinel;
+    }
+
+    // Run the registered callbacks, in the order they were added, unless
+    // another thread already has.  Callbacks are continuations of other
+    // callers, so one that throws must not fail the thread running them, or
+    // stop the rest: its exception is dropped.
+    void runCallbacks() noexcept {
+        Callback* list =
+            callbacks_.exchange(closed(), std::memory_order_acq_rel);
+        if (list == closed()) {
+            return;
+        }
+        Callback* ordered = nullptr;
+        while (list) {
+            Callback* next = list->next;
+            list->next     = ordered;
+            ordered        = list;
+            list           = next;
+        }
+        while (ordered) {
+            Callback* next = ordered->next;
+            try {
+                ordered->func();
+            } catch (...) {
+            }
+            delete ordered;
+            ordered = next;
+        }
+    }
+
+    // Publish the end of a run, 'finished' or given up and back to 'idle'.
+    // Nobody waiting or watching is the common case, and costs one fence: a
+    // waiter or callback registered concurrently either sees the new state
+    // itself, or is seen here.  Callbacks run only once there is a result.
+    void release(std::uint32_t next) {
+        run_.store(next, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) != 0) {
+            run_.notify_all();
+            detail::wakeTimedWaiters(run_);
+        }
+        if (next == finished &&
+            callbacks_.load(std::memory_order_relaxed) != nullptr) {
+            runCallbacks();
+        }
+    }
+
+    // Sleep while another thread runs the coroutine, or until 'timeout'
+    // passes if it is not null.  Returns false if it is still running.
+    bool park(std::chrono::nanoseconds const* timeout) const noexcept {
+        if (run_.load(std::memory_order_acquire) != running) {
+            return true;
+        }
+        waiters_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!timeout) {
+            run_.wait(running, std::memory_order_acquire);
+        } else if (run_.load(std::memory_order_relaxed) == running) {
+            detail::timedWait(run_, running, *timeout);
+        }
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+        return run_.load(std::memory_order_acquire) != running;
+    }
+
     template <typename... Args>
     void set_value(Args&&... args) {
         new (std::addressof(result_.wrapper))
@@ -81,6 +205,15 @@ struct Holder {
         status.store(result_status::error, std::memory_order_release);
     }
 
+    void set_cancelled() noexcept {
+        status.store(result_status::cancelled, std::memory_order_release);
+    }
+
+    bool cancelled() const noexcept {
+        return status.load(std::memory_order_acquire) ==
+               result_status::cancelled;
+    }
+
     bool unevaluated() const noexcept {
         return status.load(std::memory_order_relaxed) == result_status::empty;
     }
@@ -96,15 +229,108 @@ struct Holder {
             return result_.wrapper.get_value();
         }
         case result_status::error: {
-            std::rethrow_exception(std::exchange(result_.error, {}));
+            std::rethrow_exception(result_.error);
             break;
         }
+        case result_status::cancelled: {
+            throw Cancelled();
+        }
         }
         assert(false);
         std::terminate();
     }
 
-    void resume() { return promise_->handle().resume(); }
+    // Run the coroutine, unless this thread's evaluation has been stopped,
+    // in which case it is left where it is and 'Cancelled' is thrown.  If
+    // the coroutine gives up with 'Abandon' it stays suspended and
+    // unevaluated, and the reason is rethrown.  An exception escaping the
+    // coroutine is kept as the result, and rethrown, except 'Cancelled':
+    // the frame it unwound cannot be resumed, so the result is recorded as
+    // cancelled rather than failed.
+    void resume() {
+        if (EvaluationContext::stopRequested()) {
+            release(idle);
+            throw Cancelled();
+        }
+        try {
+            promise_->handle().resume();
+        } catch (Cancelled const&) {
+            std::exchange(promise_, nullptr)->handle().destroy();
+            set_cancelled();
+            release(finished);
+            throw;
+        } catch (...) {
+            // The frame is left suspended at its final suspend point.
+            std::exchange(promise_, nullptr)->handle().destroy();
+            unhandled_exception();
+            release(finished);
+            throw;
+        }
+        if (unevaluated()) {
+            std::exception_ptr reason =
+                std::exchange(promise_->abandoned_, nullptr);
+            assert(reason);
+            release(idle);
+            std::rethrow_exception(reason);
+        }
+        release(finished);
+    }
+
+    // Take the right to run the coroutine.  Returns false if another thread
+    // has it, or has finished it.
+    bool claim() noexcept {
+        std::uint32_t expected = idle;
+        return run_.compare_exchange_strong(expected,
+                                            running,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed);
+    }
+
+    // Block until the thread running the coroutine finishes or gives up.
+    void wait() const noexcept {
+        while (!park(nullptr)) {
+        }
+    }
+
+    // As 'wait', giving up at 'deadline'.  Returns false on timeout.
+    template <typename Clock, typename Duration>
+    bool waitUntil(
+        std::chrono::time_point<Clock, Duration> const& deadline) const {
+        while (run_.load(std::memory_order_acquire) == running) {
+            auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                deadline - Clock::now());
+            if (left <= std::chrono::nanoseconds::zero()) {
+                return false;
+            }
+            park(&left);
+        }
+        return true;
+    }
+
+    // Call 'func()' once a result is available, or now if it already is.
+    void onReady(std::function<void()> func) {
+        if (!unevaluated()) {
+            func();
+            return;
+        }
+        Callback* node = new Callback{std::move(func), nullptr};
+        Callback* head = callbacks_.load(std::memory_order_acquire);
+        do {
+            if (head == closed()) {
+                std::function<void()> now = std::move(node->func);
+                delete node;
+                now();
+                return;
+            }
+            node->next = head;
+        } while (!callbacks_.compare_exchange_weak(
+            head, node, std::memory_order_acq_rel, std::memory_order_acquire));
+        // The result may have been published before the push was seen.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!unevaluated()) {
+            runCallbacks();
+        }
+    }
 
     bool isNil() { return unevaluated() && !promise_; }
 
@@ -122,6 +348,10 @@ struct Holder {
     }
 
     ~Holder() {
+        Callback* list = callbacks_.load(std::memory_order_relaxed);
+        while (list && list != closed()) {
+            delete std::exchange(list, list->next);
+        }
         switch (status.load(std::memory_order_relaxed)) {
         case result_status::empty: {
             if (promise_)
@@ -133,14 +363,32 @@ struct Holder {
             break;
         }
         case result_status::error: {
-            if (result_.error)
-                std::rethrow_exception(result_.error);
             result_.error.~exception_ptr();
         } break;
+        case result_status::cancelled: {
+            break;
+        }
         }
     }
 };
 
+namespace detail {
+
+// 'f()', as a coroutine that gives up rather than finishing if 'f' throws
+// 'Cancelled', to call 'f' again when next forced.
+template <typename Cell, typename F>
+Cell cancellable(F f) {
+    for (;;) {
+        try {
+            co_return std::invoke(f);
+        } catch (Cancelled const&) {
+        }
+        co_await Abandon{};
+    }
+}
+
+} // namespace detail
+
 } // namespace co_fun
 
 #endif
@@ -24,3 +24,13 @@ TEST(Co_FunHolderTest, HolderBreathing) {
     Value<void> vv;
     vv.get_value();
 }
+
+TEST(Co_FunHolderTest, HolderCancelled) {
+    Holder<int> hi;
+    EXPECT_TRUE(hi.unevaluated());
+    EXPECT_FALSE(hi.cancelled());
+    hi.set_cancelled();
+    EXPECT_FALSE(hi.unevaluated());
+    EXPECT_TRUE(hi.cancelled());
+    EXPECT_THROW(hi.get_value(), Cancelled);
+}
@@ -46,6 +46,8 @@ class Lazy {
 
     bool evaluated() const { return result_ && !result_->unevaluated(); }
 
+    bool cancelled() const { return result_ && result_->cancelled(); }
+
     bool isEmpty() const {
         bool empty = false;
         if (!result_) {
@@ -79,14 +81,29 @@ Value&& evaluate(Lazy<Value>&& lazy) {
     return std::move(lazy);
 }
 
+// As for 'Thunk', the combinators give up with 'Abandon' if forcing an
+// argument throws 'Cancelled'.
+
 template <typename F, typename... Args>
 auto lazy(F f, Args... args) -> Lazy<std::invoke_result_t<F, Args...>> {
-    co_return std::invoke(f, args...);
+    for (;;) {
+        try {
+            co_return std::invoke(f, args...);
+        } catch (Cancelled const&) {
+        }
+        co_await Abandon{};
+    }
 }
 
 template <typename Result, typename F>
 auto transform(Lazy<Result> l, F f) -> Lazy<std::invoke_result_t<F, Result>> {
-    co_return f(evaluate(l));
+    for (;;) {
+        try {
+            co_return f(evaluate(l));
+        } catch (Cancelled const&) {
+        }
+        co_await Abandon{};
+    }
 }
 
 template <typename Value>
@@ -101,7 +118,13 @@ auto bind(Lazy<Value>&& l, Func f) -> decltype(f(evaluate(l))) {
 
 template <typename Value, typename Func>
 auto bind2(Lazy<Value>&& l, Func f) -> decltype(f(evaluate(l))) {
-    co_return f(evaluate(l));
+    for (;;) {
+        try {
+            co_return f(evaluate(l));
+        } catch (Cancelled const&) {
+        }
+        co_await Abandon{};
+    }
 }
 
 // ============================================================================
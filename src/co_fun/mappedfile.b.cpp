@@ -0,0 +1,66 @@
+#include <benchmark/benchmark.h>
+
+#include <co_fun/mappedfile.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+using namespace co_fun;
+
+namespace {
+// A log-like file of 'lines' lines, written once and shared by the
+// benchmarks.
+std::string const& logFile() {
+    static std::string const path = []() {
+        char name[] = "/tmp/co_fun_mappedfile_benchXXXXXX";
+        int  fd     = ::mkstemp(name);
+        ::close(fd);
+        std::ofstream out(name);
+        for (int i = 0; i < 200000; ++i) {
+            out << "2024-01-01T00:00:00 host GET /item/" << i << " "
+                << (i % 97 == 0 ? 500 : 200) << " " << i * 7 % 1000 << "\n";
+        }
+        std::atexit([]() { std::remove(path.c_str()); });
+        return std::string(name);
+    }();
+    return path;
+}
+} // namespace
+
+static void BM_GetlineErrors(benchmark::State& state) {
+    std::string const& path = logFile();
+    for (auto _ : state) {
+        std::ifstream in(path);
+        std::string   line;
+        std::size_t   errors = 0;
+        while (std::getline(in, line)) {
+            errors += line.find(" 500 ") != line.npos;
+        }
+        benchmark::DoNotOptimize(errors);
+    }
+}
+BENCHMARK(BM_GetlineErrors)->Unit(benchmark::kMillisecond);
+
+template <typename Suspension>
+static void BM_MappedErrors(benchmark::State& state) {
+    std::string const& path = logFile();
+    for (auto _ : state) {
+        MappedFile  file(path);
+        std::size_t errors = 0;
+        // Walk by reassignment, so cells are freed as they are passed
+        // rather than all at once, recursively, at the end.
+        for (auto s = lines<Suspension>(file); !s.isEmpty(); s = s.tail()) {
+            std::string_view line = s.head();
+            errors += line.find(" 500 ") != line.npos;
+        }
+        benchmark::DoNotOptimize(errors);
+    }
+}
+BENCHMARK_TEMPLATE(BM_MappedErrors, ThunkSuspension)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MappedErrors, MemoSuspension)
+    ->Unit(benchmark::kMillisecond);
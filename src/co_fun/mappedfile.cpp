@@ -0,0 +1,92 @@
+// mappedfile.cpp                                                     -*-C++-*-
+#include <co_fun/mappedfile.h>
+
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace co_fun {
+
+namespace {
+std::system_error systemError(char const* what, std::string const& path) {
+    return std::system_error(
+        errno, std::generic_category(), std::string(what) + " " + path);
+}
+
+int adviceFlag(MappedFile::Advice advice) {
+    switch (advice) {
+    case MappedFile::Advice::sequential:
+        return MADV_SEQUENTIAL;
+    case MappedFile::Advice::random:
+        return MADV_RANDOM;
+    case MappedFile::Advice::willNeed:
+        return MADV_WILLNEED;
+    case MappedFile::Advice::dontNeed:
+        return MADV_DONTNEED;
+    case MappedFile::Advice::normal:
+        break;
+    }
+    return MADV_NORMAL;
+}
+} // namespace
+
+MappedFile::MappedFile(std::string const& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw systemError("open", path);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        auto error = systemError("fstat", path);
+        ::close(fd);
+        throw error;
+    }
+    size_ = static_cast<std::size_t>(info.st_size);
+    if (size_ != 0) {
+        void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            auto error = systemError("mmap", path);
+            ::close(fd);
+            throw error;
+        }
+        data_ = static_cast<char const*>(data);
+    }
+    // The mapping keeps the file open.
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+void MappedFile::advise(Advice      advice,
+                        std::size_t offset,
+                        std::size_t length) const {
+    advise(view(), advice, offset, length);
+}
+
+void MappedFile::advise(std::string_view mapping,
+                        Advice           advice,
+                        std::size_t      offset,
+                        std::size_t      length) {
+    if (!mapping.data() || offset >= mapping.size()) {
+        return;
+    }
+    if (length > mapping.size() - offset) {
+        length = mapping.size() - offset;
+    }
+    // madvise wants a page aligned start; the mapping itself is aligned.
+    static std::size_t const page = ::sysconf(_SC_PAGESIZE);
+    std::size_t              start = offset / page * page;
+    ::madvise(const_cast<char*>(mapping.data()) + start,
+              length + (offset - start),
+              adviceFlag(advice));
+}
+
+} // namespace co_fun
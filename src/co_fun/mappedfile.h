@@ -0,0 +1,204 @@
+// mappedfile.h                                                       -*-C++-*-
+#ifndef INCLUDED_CO_FUN_MAPPEDFILE
+#define INCLUDED_CO_FUN_MAPPEDFILE
+
+//@PURPOSE: Stream the lines or records of a memory-mapped file.
+//
+//@CLASSES:
+//  co_fun::MappedFile: read-only memory mapping of a whole file
+//  co_fun::MapOptions: paging hints given as a mapped stream is consumed
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: A 'MappedFile' maps a file read-only into memory, and
+// 'lines' and 'records' turn the mapping into a lazy 'ConsStream' of
+// 'std::string_view's pointing into it.  No bytes are copied: the views are
+// the file's pages.  As with any 'string_view', the 'MappedFile' must
+// outlive the stream and every view taken from it.  Cells release what they
+// captured once they are forced, so the stream cannot hold the mapping for
+// the views it has already produced.  A stream refers to the mapping, not
+// to the 'MappedFile' object, so the file may be moved while streams over
+// it exist, as long as whichever object owns the mapping outlives them.
+//
+//..
+//  MappedFile file("access.log");
+//  auto errors = filter([](std::string_view line) {
+//                           return line.find(" 500 ") != line.npos;
+//                       },
+//                       lines(file));
+//  for (std::string_view line : take(errors, 10)) { ... }
+//..
+//
+// The whole mapping is advised as sequential when a stream is made, and as
+// the stream is consumed the next 'MapOptions::readAhead' bytes are advised
+// as needed soon, one window ahead of the reader.  With
+// 'MapOptions::dropBehind' the window before the reader is released as it
+// is left; the pages are clean and are read back from the file if a view
+// into them is used again.
+//
+// A line is the bytes up to, not including, a '\n'.  A final line with no
+// '\n' is still a line; an empty file has no lines.  A file whose size is
+// not a multiple of the record size ends with a short record.  A record
+// size of zero throws 'std::invalid_argument'.
+//
+// Errors opening or mapping the file throw 'std::system_error'.  The file
+// must not be truncated while it is mapped.
+
+#include <co_fun/stream.h>
+#include <co_fun/suspension.h>
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace co_fun {
+
+struct MapOptions {
+    // Bytes to advise as needed ahead of the reader.  Zero disables the
+    // hints that follow the reader.
+    std::size_t readAhead = std::size_t(4) << 20;
+
+    // Release the window behind the reader as it moves on.
+    bool dropBehind = false;
+};
+
+class MappedFile {
+    char const* data_ = nullptr;
+    std::size_t size_ = 0;
+
+  public:
+    enum class Advice { normal, sequential, random, willNeed, dontNeed };
+
+    MappedFile() = default;
+
+    explicit MappedFile(std::string const& path);
+
+    MappedFile(MappedFile&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0)) {}
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        MappedFile(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ~MappedFile();
+
+    void swap(MappedFile& other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+    }
+
+    char const* data() const { return data_; }
+
+    std::size_t size() const { return size_; }
+
+    std::string_view view() const { return std::string_view(data_, size_); }
+
+    // Give the kernel a paging hint for the bytes in '[offset, offset +
+    // length)', widened to whole pages and clipped to the file.  Hints are
+    // advisory; failures are ignored.
+    void advise(Advice      advice,
+                std::size_t offset = 0,
+                std::size_t length = std::string_view::npos) const;
+
+    // As above, for the bytes of 'mapping', which must be the 'view()' of a
+    // 'MappedFile'.
+    static void advise(std::string_view mapping,
+                       Advice           advice,
+                       std::size_t      offset = 0,
+                       std::size_t      length = std::string_view::npos);
+};
+
+namespace detail {
+
+// Follow a reader moving from 'from' to 'to' with paging hints, once per
+// window crossed.
+inline void adviseReader(std::string_view  mapping,
+                         MapOptions const& options,
+                         std::size_t       from,
+                         std::size_t       to) {
+    std::size_t window = options.readAhead;
+    if (window == 0 || (from != 0 && from / window == to / window)) {
+        return;
+    }
+    std::size_t current = to / window * window;
+    MappedFile::advise(
+        mapping, MappedFile::Advice::willNeed, current + window, window);
+    if (options.dropBehind && current >= window) {
+        MappedFile::advise(
+            mapping, MappedFile::Advice::dontNeed, current - window, window);
+    }
+}
+
+template <typename Suspension>
+ConsStream<std::string_view, Suspension>
+linesFrom(std::string_view mapping, MapOptions options, std::size_t offset) {
+    if (offset >= mapping.size()) {
+        return ConsStream<std::string_view, Suspension>();
+    }
+    return ConsStream<std::string_view, Suspension>(
+        [mapping, options, offset]() {
+            char const* begin = mapping.data() + offset;
+            std::size_t left  = mapping.size() - offset;
+            auto*       eol =
+                static_cast<char const*>(std::memchr(begin, '\n', left));
+            std::size_t length = eol ? std::size_t(eol - begin) : left;
+            std::size_t next   = offset + length + (eol ? 1 : 0);
+            adviseReader(mapping, options, offset, next);
+            return ConsCell<std::string_view, Suspension>(
+                std::string_view(begin, length),
+                linesFrom<Suspension>(mapping, options, next));
+        });
+}
+
+template <typename Suspension>
+ConsStream<std::string_view, Suspension>
+recordsFrom(std::string_view mapping,
+            std::size_t      size,
+            MapOptions       options,
+            std::size_t      offset) {
+    if (offset >= mapping.size()) {
+        return ConsStream<std::string_view, Suspension>();
+    }
+    return ConsStream<std::string_view, Suspension>(
+        [mapping, size, options, offset]() {
+            std::size_t left   = mapping.size() - offset;
+            std::size_t length = left < size ? left : size;
+            adviseReader(mapping, options, offset, offset + length);
+            return ConsCell<std::string_view, Suspension>(
+                mapping.substr(offset, length),
+                recordsFrom<Suspension>(
+                    mapping, size, options, offset + length));
+        });
+}
+
+} // namespace detail
+
+// ============================================================================
+//              INLINE FUNCTION AND FUNCTION TEMPLATE DEFINITIONS
+// ============================================================================
+
+template <typename Suspension = ThunkSuspension>
+ConsStream<std::string_view, Suspension>
+lines(MappedFile const& file, MapOptions options = {}) {
+    file.advise(MappedFile::Advice::sequential);
+    return detail::linesFrom<Suspension>(file.view(), options, 0);
+}
+
+template <typename Suspension = ThunkSuspension>
+ConsStream<std::string_view, Suspension>
+records(MappedFile const& file, std::size_t size, MapOptions options = {}) {
+    if (size == 0) {
+        throw std::invalid_argument("records of size zero");
+    }
+    file.advise(MappedFile::Advice::sequential);
+    return detail::recordsFrom<Suspension>(file.view(), size, options, 0);
+}
+
+} // namespace co_fun
+
+#endif
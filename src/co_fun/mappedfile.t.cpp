@@ -0,0 +1,124 @@
+#include <co_fun/mappedfile.h>
+#include <co_fun/stream.t.h>
+#include <co_fun/tempfile.t.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+using namespace co_fun;
+
+namespace {
+using test::TempFile;
+using test::collect;
+} // namespace
+
+TEST(Co_FunMappedFileTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunMappedFileTest, Map) {
+    TempFile file("hello, world");
+    MappedFile mapped(file.path());
+    EXPECT_EQ(12u, mapped.size());
+    EXPECT_EQ("hello, world", mapped.view());
+
+    MappedFile moved(std::move(mapped));
+    EXPECT_EQ(0u, mapped.size());
+    EXPECT_EQ("hello, world", moved.view());
+}
+
+TEST(Co_FunMappedFileTest, MissingFile) {
+    EXPECT_THROW(MappedFile("/nonexistent/co_fun/file"), std::system_error);
+}
+
+TEST(Co_FunMappedFileTest, Lines) {
+    TempFile file("one\ntwo\n\nfour\n");
+    MappedFile mapped(file.path());
+    EXPECT_EQ((std::vector<std::string>{"one", "two", "", "four"}),
+              collect<std::string>(lines(mapped)));
+}
+
+TEST(Co_FunMappedFileTest, MovedFile) {
+    TempFile   file("one\ntwo\nthree\n");
+    MappedFile mapped(file.path());
+    auto       all      = lines(mapped);
+    auto       records4 = records(mapped, 4);
+    MappedFile owner(std::move(mapped));
+    EXPECT_EQ((std::vector<std::string>{"one", "two", "three"}),
+              collect<std::string>(all));
+    EXPECT_EQ((std::vector<std::string>{"one\n", "two\n", "thre", "e\n"}),
+              collect<std::string>(records4));
+}
+
+TEST(Co_FunMappedFileTest, LastLineUnterminated) {
+    TempFile   file("one\ntwo");
+    MappedFile mapped(file.path());
+    EXPECT_EQ((std::vector<std::string>{"one", "two"}),
+              collect<std::string>(lines(mapped)));
+}
+
+TEST(Co_FunMappedFileTest, EmptyFile) {
+    TempFile file("");
+    MappedFile mapped(file.path());
+    EXPECT_EQ(0u, mapped.size());
+    EXPECT_TRUE(lines(mapped).isEmpty());
+    EXPECT_TRUE(records(mapped, 4).isEmpty());
+}
+
+TEST(Co_FunMappedFileTest, ZeroCopy) {
+    TempFile file("abc\ndef\n");
+    MappedFile mapped(file.path());
+    auto       s = lines(mapped);
+    EXPECT_EQ(mapped.data(), s.head().data());
+    EXPECT_EQ(mapped.data() + 4, s.tail().head().data());
+}
+
+TEST(Co_FunMappedFileTest, Records) {
+    TempFile   file("aaaabbbbccccdd");
+    MappedFile mapped(file.path());
+    EXPECT_EQ((std::vector<std::string>{"aaaa", "bbbb", "cccc", "dd"}),
+              collect<std::string>(records(mapped, 4)));
+    EXPECT_THROW(records(mapped, 0), std::invalid_argument);
+}
+
+TEST(Co_FunMappedFileTest, Combinators) {
+    TempFile file("GET /a 200\nGET /b 500\nGET /c 200\nGET /d 500\n"
+                  "GET /e 500\n");
+    MappedFile mapped(file.path());
+    auto       errors = filter(
+        [](std::string_view line) {
+            return line.find(" 500") != line.npos;
+        },
+        lines(mapped));
+    auto paths = fmap(take(errors, 2), [](std::string_view line) {
+        return std::string(line.substr(4, 2));
+    });
+    std::vector<std::string> result;
+    for (std::string const& path : paths) {
+        result.push_back(path);
+    }
+    EXPECT_EQ((std::vector<std::string>{"/b", "/d"}), result);
+}
+
+TEST(Co_FunMappedFileTest, ReadAheadHints) {
+    std::string contents;
+    for (int i = 0; i < 10000; ++i) {
+        contents += std::to_string(i) + "\n";
+    }
+    TempFile   file(contents);
+    MapOptions options;
+    options.readAhead  = 4096;
+    options.dropBehind = true;
+
+    MappedFile mapped(file.path());
+    int        count = 0;
+    int        last  = -1;
+    for (std::string_view line : lines<MemoSuspension>(mapped, options)) {
+        last = std::stoi(std::string(line));
+        ++count;
+    }
+    EXPECT_EQ(10000, count);
+    EXPECT_EQ(9999, last);
+}
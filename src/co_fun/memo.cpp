@@ -0,0 +1,2 @@
+// memo.cpp                                                           -*-C++-*-
+#include <co_fun/memo.h>
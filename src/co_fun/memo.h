@@ -0,0 +1,156 @@
+// memo.h                                                             -*-C++-*-
+#ifndef INCLUDED_CO_FUN_MEMO
+#define INCLUDED_CO_FUN_MEMO
+
+//@PURPOSE: Provide an unsynchronized, shared, memoized computation.
+//
+//@CLASSES:
+//  co_fun::Memo: reference counted handle to a once-evaluated function
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: A 'Memo' is the single-threaded counterpart of a 'Thunk'.
+// It holds a function and, once forced, its value, in one allocation with a
+// plain reference count.  Copies share the cell, so the function runs at
+// most once, and the function and its captures are released as soon as the
+// value is computed.  If the function throws, the memo stays unevaluated
+// and the next 'get()' calls it again.
+//
+// Nothing is synchronized: a 'Memo', and every copy of it, must only be
+// used from one thread at a time.  That is what makes it cheap, and what
+// makes it the right suspension for streams that never leave a thread.
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace co_fun {
+
+namespace detail {
+
+template <typename Result>
+class MemoCell {
+    union {
+        Result value_;
+    };
+    bool forced_ = false;
+
+  protected:
+    // Run the function, releasing it if it returns.
+    virtual Result compute() = 0;
+
+  public:
+    std::size_t refs_ = 1;
+
+    MemoCell() {}
+
+    MemoCell(MemoCell const&) = delete;
+    MemoCell& operator=(MemoCell const&) = delete;
+
+    virtual ~MemoCell() {
+        if (forced_) {
+            value_.~Result();
+        }
+    }
+
+    bool forced() const { return forced_; }
+
+    Result const& get() {
+        if (!forced_) {
+            ::new (std::addressof(value_)) Result(compute());
+            forced_ = true;
+        }
+        return value_;
+    }
+};
+
+template <typename Result, typename Func>
+class MemoFunction : public MemoCell<Result> {
+    std::optional<Func> func_;
+
+    Result compute() override {
+        Result result = std::invoke(*func_);
+        func_.reset();
+        return result;
+    }
+
+  public:
+    template <typename F>
+    explicit MemoFunction(F&& f) : func_(std::in_place, std::forward<F>(f)) {}
+};
+
+} // namespace detail
+
+template <typename Result>
+class Memo {
+    detail::MemoCell<Result>* cell_ = nullptr;
+
+    explicit Memo(detail::MemoCell<Result>* cell) : cell_(cell) {}
+
+    void release() {
+        if (cell_ && --cell_->refs_ == 0) {
+            delete cell_;
+        }
+    }
+
+    template <typename R, typename F>
+    friend Memo<R> memo(F&& f);
+
+  public:
+    Memo() = default;
+
+    Memo(Memo const& rhs) : cell_(rhs.cell_) {
+        if (cell_) {
+            ++cell_->refs_;
+        }
+    }
+
+    Memo(Memo&& rhs) noexcept : cell_(std::exchange(rhs.cell_, nullptr)) {}
+
+    Memo& operator=(Memo rhs) noexcept {
+        std::swap(cell_, rhs.cell_);
+        return *this;
+    }
+
+    ~Memo() { release(); }
+
+    bool isEmpty() const { return cell_ == nullptr; }
+
+    bool evaluated() const { return cell_ && cell_->forced(); }
+
+    Result const& get() const { return cell_->get(); }
+
+    operator Result const &() const { return get(); }
+
+    bool operator==(Memo const& rhs) const { return cell_ == rhs.cell_; }
+
+    bool operator!=(Memo const& rhs) const { return cell_ != rhs.cell_; }
+};
+
+// ============================================================================
+//              INLINE FUNCTION AND FUNCTION TEMPLATE DEFINITIONS
+// ============================================================================
+
+template <typename Result, typename F>
+Memo<Result> memo(F&& f) {
+    using Func = std::decay_t<F>;
+    return Memo<Result>(
+        new detail::MemoFunction<Result, Func>(std::forward<F>(f)));
+}
+
+template <typename F>
+auto memo(F&& f) -> Memo<std::invoke_result_t<std::decay_t<F>&>> {
+    return memo<std::invoke_result_t<std::decay_t<F>&>>(std::forward<F>(f));
+}
+
+template <typename Value>
+Value const& evaluate(Memo<Value> const& m) {
+    return m;
+}
+
+} // namespace co_fun
+
+#endif
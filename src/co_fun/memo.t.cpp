@@ -0,0 +1,78 @@
+#include <co_fun/memo.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using namespace co_fun;
+
+TEST(Co_FunMemoTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunMemoTest, Breathing) {
+    int       calls = 0;
+    Memo<int> m     = memo([&calls]() { return ++calls; });
+    EXPECT_FALSE(m.isEmpty());
+    EXPECT_FALSE(m.evaluated());
+    EXPECT_EQ(1, m.get());
+    EXPECT_EQ(1, evaluate(m));
+    EXPECT_TRUE(m.evaluated());
+    EXPECT_EQ(1, calls);
+
+    Memo<int> empty;
+    EXPECT_TRUE(empty.isEmpty());
+    EXPECT_FALSE(empty.evaluated());
+}
+
+TEST(Co_FunMemoTest, Sharing) {
+    int       calls = 0;
+    Memo<int> a     = memo([&calls]() { return ++calls; });
+    Memo<int> b     = a;
+    EXPECT_TRUE(a == b);
+    EXPECT_EQ(1, b.get());
+    EXPECT_TRUE(a.evaluated());
+    EXPECT_EQ(1, a.get());
+    EXPECT_EQ(1, calls);
+
+    Memo<int> c = std::move(b);
+    EXPECT_TRUE(b.isEmpty());
+    EXPECT_TRUE(a == c);
+    EXPECT_TRUE(a != b);
+}
+
+TEST(Co_FunMemoTest, ReleasesFunction) {
+    auto token = std::make_shared<int>(4);
+    {
+        Memo<int> m = memo([token]() { return *token; });
+        EXPECT_EQ(2, token.use_count());
+        EXPECT_EQ(4, m.get());
+        EXPECT_EQ(1, token.use_count());
+    }
+    {
+        Memo<int> m = memo([token]() { return *token; });
+        EXPECT_EQ(2, token.use_count());
+    }
+    EXPECT_EQ(1, token.use_count());
+}
+
+TEST(Co_FunMemoTest, MoveOnly) {
+    auto        p = std::make_unique<std::string>("moved");
+    Memo<std::string> m =
+        memo([p = std::move(p)]() { return *p; });
+    EXPECT_EQ("moved", m.get());
+}
+
+TEST(Co_FunMemoTest, Retry) {
+    int       calls = 0;
+    Memo<int> m     = memo([&calls]() {
+        if (++calls == 1) {
+            throw std::runtime_error("first");
+        }
+        return calls;
+    });
+    EXPECT_THROW(m.get(), std::runtime_error);
+    EXPECT_FALSE(m.evaluated());
+    EXPECT_EQ(2, m.get());
+    EXPECT_EQ(2, m.get());
+}
@@ -0,0 +1,2 @@
+// merge.cpp                                                          -*-C++-*-
+#include <co_fun/merge.h>
@@ -0,0 +1,376 @@
+// merge.h                                                            -*-C++-*-
+#ifndef INCLUDED_CO_FUN_MERGE
+#define INCLUDED_CO_FUN_MERGE
+
+//@PURPOSE: Provide lazy merges of many sorted streams.
+//
+//@CLASSES:
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: 'merge(streams, cmp)' is the sorted stream of the elements
+// of a 'std::vector' of streams each sorted by 'cmp', which defaults to
+// 'std::less'.  Equal elements come in the order of the streams holding
+// them, so the merge is stable.  The heads of the inputs meet in a loser
+// tree: producing an element replays only the matches of the input it came
+// from, 'log2(K)' comparisons for 'K' inputs, half what a binary heap
+// spends.  An input is forced only when its head is needed, so making the
+// merge forces nothing, and producing an element forces the next element of
+// the one input it came from.  'merge(first, second, cmp)' is the two-way
+// case, which compares the two heads directly and, once either input runs
+// out, returns the rest of the other as it is.
+//..
+//  std::vector<ConsStream<LogRecord>> shards;
+//  for (auto const& path : paths) {
+//      shards.push_back(records(path));
+//  }
+//  auto all = merge(shards, [](auto const& a, auto const& b) {
+//      return a.time < b.time;
+//  });
+//..
+//
+// 'mergeChunks(streams, cmp, chunkSize)' merges streams of sorted chunks,
+// 'std::vector's whose concatenation is sorted, into a stream of chunks of
+// up to 'chunkSize' elements.  Rather than moving one element per match,
+// it finds, by binary search, how far the winning chunk runs before the
+// head of the runner-up, and copies that run into the output in bulk, so
+// inputs that overlap little, such as shards covering consecutive times,
+// merge at the speed of copying.  Making a chunk merge reads the first
+// chunk of each input.
+//
+// The cells of one merge share the state of the tournament, and must be
+// forced from one thread at a time.
+
+#include <co_fun/stream.h>
+#include <co_fun/suspension.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace co_fun {
+
+namespace detail {
+
+// A tournament over 'k' inputs, each holding the loser of its match at
+// every internal node, and the overall winner at the root.  Inputs are
+// compared by 'beats(a, b)', which treats an index past the inputs as an
+// input that has run out.
+class LoserTree {
+    std::size_t              leaves_ = 1;
+    std::vector<std::size_t> node_;
+
+  public:
+    template <typename Beats>
+    void build(std::size_t k, Beats const& beats) {
+        leaves_ = std::bit_ceil(k < 1 ? std::size_t(1) : k);
+        node_.assign(leaves_, 0);
+        std::vector<std::size_t> winner(2 * leaves_);
+        for (std::size_t i = 0; i < leaves_; ++i) {
+            winner[leaves_ + i] = i;
+        }
+        for (std::size_t n = leaves_ - 1; n > 0; --n) {
+            std::size_t a     = winner[2 * n];
+            std::size_t b     = winner[2 * n + 1];
+            bool        aWins = beats(a, b);
+            winner[n]         = aWins ? a : b;
+            node_[n]          = aWins ? b : a;
+        }
+        node_[0] = winner[1];
+    }
+
+    std::size_t winner() const { return node_[0]; }
+
+    // Play the winner's matches again, after its head has changed.
+    template <typename Beats>
+    void replay(Beats const& beats) {
+        std::size_t w = node_[0];
+        for (std::size_t n = (leaves_ + w) / 2; n > 0; n /= 2) {
+            if (beats(node_[n], w)) {
+                std::swap(node_[n], w);
+            }
+        }
+        node_[0] = w;
+    }
+
+    // The input that would win without the winner: the best of those it
+    // beat on its way to the root.
+    template <typename Beats>
+    std::size_t runnerUp(Beats const& beats) const {
+        std::size_t best = leaves_;
+        for (std::size_t n = (leaves_ + node_[0]) / 2; n > 0; n /= 2) {
+            if (best == leaves_ || beats(node_[n], best)) {
+                best = node_[n];
+            }
+        }
+        return best;
+    }
+};
+
+template <typename Value, typename Suspension, typename Compare>
+ConsStream<Value, Suspension> mergeTwo(ConsStream<Value, Suspension> first,
+                                       ConsStream<Value, Suspension> second,
+                                       Compare const&                cmp) {
+    if (first.isEmpty()) {
+        return second;
+    }
+    if (second.isEmpty()) {
+        return first;
+    }
+    return ConsStream<Value, Suspension>([first, second, cmp]() {
+        Value a = first.head();
+        Value b = second.head();
+        if (cmp(b, a)) {
+            return ConsCell<Value, Suspension>(
+                b, mergeTwo(first, second.tail(), cmp));
+        }
+        return ConsCell<Value, Suspension>(
+            a, mergeTwo(first.tail(), second, cmp));
+    });
+}
+
+template <typename Value, typename Suspension, typename Compare>
+class KWayMerge {
+    std::vector<ConsStream<Value, Suspension>> inputs_;
+    std::vector<std::optional<Value>>          heads_;
+    Compare                                    cmp_;
+    LoserTree                                  tree_;
+    bool                                       started_ = false;
+
+    // Whether input 'a' comes before input 'b'; ties go to the earlier.
+    bool beats(std::size_t a, std::size_t b) const {
+        if (a >= heads_.size() || !heads_[a]) {
+            return false;
+        }
+        if (b >= heads_.size() || !heads_[b]) {
+            return true;
+        }
+        if (cmp_(*heads_[a], *heads_[b])) {
+            return true;
+        }
+        return !cmp_(*heads_[b], *heads_[a]) && a < b;
+    }
+
+    void start() {
+        heads_.resize(inputs_.size());
+        for (std::size_t i = 0; i < inputs_.size(); ++i) {
+            if (!inputs_[i].isEmpty()) {
+                heads_[i] = inputs_[i].head();
+            }
+        }
+        tree_.build(inputs_.size(), [this](std::size_t a, std::size_t b) {
+            return beats(a, b);
+        });
+        started_ = true;
+    }
+
+  public:
+    KWayMerge(std::vector<ConsStream<Value, Suspension>> inputs,
+              Compare                                    cmp)
+        : inputs_(std::move(inputs)), cmp_(std::move(cmp)) {}
+
+    bool empty() const {
+        if (started_) {
+            std::size_t w = tree_.winner();
+            return w >= heads_.size() || !heads_[w];
+        }
+        return std::all_of(inputs_.begin(),
+                           inputs_.end(),
+                           [](auto const& input) { return input.isEmpty(); });
+    }
+
+    // The least head, replaced by the next element of its input.
+    Value pop() {
+        if (!started_) {
+            start();
+        }
+        std::size_t w      = tree_.winner();
+        Value       result = std::move(*heads_[w]);
+        inputs_[w]         = inputs_[w].tail();
+        if (inputs_[w].isEmpty()) {
+            heads_[w].reset();
+        } else {
+            heads_[w] = inputs_[w].head();
+        }
+        tree_.replay([this](std::size_t a, std::size_t b) {
+            return beats(a, b);
+        });
+        return result;
+    }
+};
+
+template <typename Value, typename Suspension, typename Compare>
+ConsStream<Value, Suspension>
+mergeFrom(std::shared_ptr<KWayMerge<Value, Suspension, Compare>> merge) {
+    if (merge->empty()) {
+        return ConsStream<Value, Suspension>();
+    }
+    return ConsStream<Value, Suspension>([merge]() {
+        Value value = merge->pop();
+        return ConsCell<Value, Suspension>(value, mergeFrom(merge));
+    });
+}
+
+template <typename Value, typename Suspension, typename Compare>
+class ChunkMerge {
+    using Chunk = std::vector<Value>;
+
+    struct Input {
+        ConsStream<Chunk, Suspension> rest;
+        Chunk                         chunk;
+        std::size_t                   pos = 0;
+    };
+
+    std::vector<Input> inputs_;
+    Compare            cmp_;
+    std::size_t        chunkSize_;
+    LoserTree          tree_;
+
+    bool live(std::size_t i) const {
+        return i < inputs_.size() && inputs_[i].pos < inputs_[i].chunk.size();
+    }
+
+    Value const& head(std::size_t i) const {
+        return inputs_[i].chunk[inputs_[i].pos];
+    }
+
+    bool beats(std::size_t a, std::size_t b) const {
+        if (!live(a)) {
+            return false;
+        }
+        if (!live(b)) {
+            return true;
+        }
+        if (cmp_(head(a), head(b))) {
+            return true;
+        }
+        return !cmp_(head(b), head(a)) && a < b;
+    }
+
+    // Move to the next chunk of 'input' with elements in it, if any.
+    static void refill(Input& input) {
+        while (input.pos == input.chunk.size() && !input.rest.isEmpty()) {
+            input.chunk = input.rest.head();
+            input.pos   = 0;
+            input.rest  = input.rest.tail();
+        }
+    }
+
+  public:
+    ChunkMerge(std::vector<ConsStream<Chunk, Suspension>> streams,
+               Compare                                    cmp,
+               std::size_t                                chunkSize)
+        : cmp_(std::move(cmp)), chunkSize_(chunkSize) {
+        inputs_.reserve(streams.size());
+        for (auto& stream : streams) {
+            inputs_.push_back(Input{std::move(stream), Chunk(), 0});
+            refill(inputs_.back());
+        }
+        tree_.build(inputs_.size(), [this](std::size_t a, std::size_t b) {
+            return beats(a, b);
+        });
+    }
+
+    bool empty() const { return !live(tree_.winner()); }
+
+    // Up to 'chunkSize_' of the least elements, copied a run at a time.
+    Chunk pop() {
+        auto  beats = [this](std::size_t a, std::size_t b) {
+            return this->beats(a, b);
+        };
+        Chunk out;
+        out.reserve(chunkSize_);
+        while (out.size() < chunkSize_ && !empty()) {
+            std::size_t w     = tree_.winner();
+            std::size_t r     = tree_.runnerUp(beats);
+            Input&      input = inputs_[w];
+            auto        first = input.chunk.begin() + input.pos;
+            auto        last  = input.chunk.end();
+            if (live(r)) {
+                // Ties with the runner-up go to the earlier input.
+                last = w < r ? std::upper_bound(first, last, head(r), cmp_)
+                             : std::lower_bound(first, last, head(r), cmp_);
+            }
+            std::size_t room = chunkSize_ - out.size();
+            if (std::size_t(last - first) > room) {
+                last = first + room;
+            }
+            out.insert(out.end(), first, last);
+            input.pos += last - first;
+            refill(input);
+            tree_.replay(beats);
+        }
+        return out;
+    }
+};
+
+template <typename Value, typename Suspension, typename Compare>
+ConsStream<std::vector<Value>, Suspension> mergedChunksFrom(
+    std::shared_ptr<ChunkMerge<Value, Suspension, Compare>> merge) {
+    using Chunk = std::vector<Value>;
+    if (merge->empty()) {
+        return ConsStream<Chunk, Suspension>();
+    }
+    return ConsStream<Chunk, Suspension>([merge]() {
+        Chunk chunk = merge->pop();
+        return ConsCell<Chunk, Suspension>(chunk, mergedChunksFrom(merge));
+    });
+}
+
+} // namespace detail
+
+// ============================================================================
+//              INLINE FUNCTION AND FUNCTION TEMPLATE DEFINITIONS
+// ============================================================================
+
+template <typename Value,
+          typename Suspension,
+          typename Compare = std::less<Value>>
+ConsStream<Value, Suspension> merge(ConsStream<Value, Suspension> first,
+                                    ConsStream<Value, Suspension> second,
+                                    Compare                       cmp = {}) {
+    return detail::mergeTwo(std::move(first), std::move(second), cmp);
+}
+
+template <typename Value,
+          typename Suspension,
+          typename Compare = std::less<Value>>
+ConsStream<Value, Suspension>
+merge(std::vector<ConsStream<Value, Suspension>> streams, Compare cmp = {}) {
+    switch (streams.size()) {
+    case 0:
+        return ConsStream<Value, Suspension>();
+    case 1:
+        return streams[0];
+    case 2:
+        return merge(streams[0], streams[1], std::move(cmp));
+    }
+    return detail::mergeFrom(
+        std::make_shared<detail::KWayMerge<Value, Suspension, Compare>>(
+            std::move(streams), std::move(cmp)));
+}
+
+template <typename Value,
+          typename Suspension,
+          typename Compare = std::less<Value>>
+ConsStream<std::vector<Value>, Suspension>
+mergeChunks(std::vector<ConsStream<std::vector<Value>, Suspension>> streams,
+            Compare     cmp       = {},
+            std::size_t chunkSize = 1024) {
+    if (chunkSize == 0) {
+        throw std::invalid_argument("mergeChunks: chunkSize must be positive");
+    }
+    return detail::mergedChunksFrom(
+        std::make_shared<detail::ChunkMerge<Value, Suspension, Compare>>(
+            std::move(streams), std::move(cmp), chunkSize));
+}
+
+} // namespace co_fun
+
+#endif
@@ -0,0 +1,203 @@
+#include <co_fun/merge.h>
+#include <co_fun/stream.t.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace co_fun;
+
+namespace {
+using test::fromVector;
+using test::collect;
+
+// Each element, counting the times one is produced.
+ConsStream<int> counted(int& count, int n, int i, int step) {
+    if (i >= n) {
+        return ConsStream<int>();
+    }
+    return ConsStream<int>([&count, n, i, step]() {
+        ++count;
+        return ConsCell<int>(i, counted(count, n, i + step, step));
+    });
+}
+
+// 'shards' sorted shards of pseudo-random values, and all of them sorted.
+std::vector<std::vector<int>>
+shuffled(int shards, int each, std::vector<int>& all) {
+    std::vector<std::vector<int>> result(shards);
+    unsigned                      x = 2463534242u;
+    for (int s = 0; s < shards; ++s) {
+        for (int i = 0; i < each; ++i) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            result[s].push_back(int(x % 100000));
+        }
+        std::sort(result[s].begin(), result[s].end());
+        all.insert(all.end(), result[s].begin(), result[s].end());
+    }
+    std::sort(all.begin(), all.end());
+    return result;
+}
+
+std::vector<int> flatten(std::vector<std::vector<int>> const& chunks) {
+    std::vector<int> result;
+    for (auto const& chunk : chunks) {
+        result.insert(result.end(), chunk.begin(), chunk.end());
+    }
+    return result;
+}
+} // namespace
+
+TEST(Co_FunMergeTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunMergeTest, TwoWay) {
+    auto odds  = fromVector<int>({1, 3, 5, 7});
+    auto evens = fromVector<int>({2, 4, 6, 8, 10, 12});
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 10, 12}),
+              collect(merge(odds, evens)));
+    EXPECT_EQ((std::vector<int>{1, 3, 5, 7}),
+              collect(merge(odds, ConsStream<int>())));
+}
+
+TEST(Co_FunMergeTest, TwoWayUneven) {
+    auto s = merge(rangeFrom(10, 1000), fromVector<int>({1, 2, 2000}));
+    EXPECT_EQ(994u, collect(s).size());
+    EXPECT_EQ(2000, collect(s).back());
+}
+
+TEST(Co_FunMergeTest, KWay) {
+    std::vector<int>             all;
+    auto                         shards = shuffled(7, 100, all);
+    std::vector<ConsStream<int>> streams;
+    for (auto const& shard : shards) {
+        streams.push_back(fromVector(shard));
+    }
+    EXPECT_EQ(all, collect(merge(streams)));
+}
+
+TEST(Co_FunMergeTest, ManyShards) {
+    std::vector<int>             all;
+    auto                         shards = shuffled(1000, 20, all);
+    std::vector<ConsStream<int>> streams;
+    for (auto const& shard : shards) {
+        streams.push_back(fromVector(shard));
+    }
+    EXPECT_EQ(all, collect(merge(streams)));
+}
+
+TEST(Co_FunMergeTest, Degenerate) {
+    EXPECT_TRUE(merge(std::vector<ConsStream<int>>()).isEmpty());
+    EXPECT_EQ((std::vector<int>{1, 2, 3}),
+              collect(merge(std::vector<ConsStream<int>>{rangeFrom(1, 3)})));
+    EXPECT_TRUE(merge(std::vector<ConsStream<int>>(5)).isEmpty());
+    std::vector<ConsStream<int>> some(5);
+    some[3] = rangeFrom(1, 3);
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), collect(merge(some)));
+}
+
+TEST(Co_FunMergeTest, Stable) {
+    using Tagged = std::pair<int, char>;
+    auto byKey   = [](Tagged const& a, Tagged const& b) {
+        return a.first < b.first;
+    };
+    std::vector<ConsStream<Tagged>> streams{
+        fromVector<Tagged>({{1, 'a'}, {2, 'a'}}),
+        fromVector<Tagged>({{1, 'b'}, {3, 'b'}}),
+        fromVector<Tagged>({{1, 'c'}, {2, 'c'}})};
+    std::string order;
+    for (auto const& [key, tag] : collect(merge(streams, byKey))) {
+        order += tag;
+    }
+    EXPECT_EQ("abcacb", order);
+}
+
+TEST(Co_FunMergeTest, Descending) {
+    std::vector<ConsStream<int>> streams{fromVector<int>({9, 5, 1}),
+                                         fromVector<int>({8, 7, 2}),
+                                         fromVector<int>({6, 4, 3})};
+    EXPECT_EQ((std::vector<int>{9, 8, 7, 6, 5, 4, 3, 2, 1}),
+              collect(merge(streams, std::greater<int>())));
+}
+
+TEST(Co_FunMergeTest, ForcesOnlyWhatIsNeeded) {
+    int                          count = 0;
+    std::vector<ConsStream<int>> streams;
+    for (int i = 0; i < 10; ++i) {
+        streams.push_back(counted(count, 1000000, i, 10));
+    }
+    auto merged = merge(streams);
+    EXPECT_EQ(0, count);
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 4}), collect(take(merged, 5)));
+    // The heads of the 10 inputs, and the next of the 5 taken from.
+    EXPECT_EQ(15, count);
+}
+
+TEST(Co_FunMergeTest, Chunks) {
+    std::vector<ConsStream<std::vector<int>>> streams{
+        fromVector<std::vector<int>>({{1, 4}, {}, {9, 10, 11}}),
+        fromVector<std::vector<int>>({{2, 3, 5}, {6, 7, 8}}),
+        fromVector<std::vector<int>>({})};
+    auto merged = collect(mergeChunks(streams, std::less<int>(), 4));
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}),
+              flatten(merged));
+    for (auto const& chunk : merged) {
+        EXPECT_GE(4u, chunk.size());
+    }
+    EXPECT_THROW(mergeChunks(streams, std::less<int>(), 0),
+                 std::invalid_argument);
+}
+
+TEST(Co_FunMergeTest, ChunksMatchMerge) {
+    std::vector<int>                          all;
+    auto                                      shards = shuffled(50, 200, all);
+    std::vector<ConsStream<std::vector<int>>> streams;
+    for (auto const& shard : shards) {
+        std::vector<std::vector<int>> chunks;
+        for (std::size_t i = 0; i < shard.size(); i += 64) {
+            chunks.emplace_back(
+                shard.begin() + i,
+                shard.begin() + std::min(shard.size(), i + 64));
+        }
+        streams.push_back(fromVector(chunks));
+    }
+    EXPECT_EQ(all, flatten(collect(mergeChunks(streams))));
+}
+
+TEST(Co_FunMergeTest, ChunksCopyRuns) {
+    // Shards covering consecutive ranges merge a whole chunk at a time.
+    std::vector<ConsStream<std::vector<int>>> streams;
+    for (int s = 3; s >= 0; --s) {
+        std::vector<int> chunk;
+        for (int i = 0; i < 100; ++i) {
+            chunk.push_back(s * 100 + i);
+        }
+        streams.push_back(fromVector<std::vector<int>>({chunk}));
+    }
+    auto merged = collect(mergeChunks(streams, std::less<int>(), 1000));
+    ASSERT_EQ(1u, merged.size());
+    ASSERT_EQ(400u, merged[0].size());
+    EXPECT_TRUE(std::is_sorted(merged[0].begin(), merged[0].end()));
+}
+
+TEST(Co_FunMergeTest, ChunksStable) {
+    using Tagged = std::pair<int, char>;
+    auto byKey   = [](Tagged const& a, Tagged const& b) {
+        return a.first < b.first;
+    };
+    std::vector<ConsStream<std::vector<Tagged>>> streams{
+        fromVector<std::vector<Tagged>>({{{1, 'a'}, {1, 'a'}, {2, 'a'}}}),
+        fromVector<std::vector<Tagged>>({{{1, 'b'}, {2, 'b'}}})};
+    std::string order;
+    for (auto const& chunk : collect(mergeChunks(streams, byKey))) {
+        for (auto const& [key, tag] : chunk) {
+            order += tag;
+        }
+    }
+    EXPECT_EQ("aabab", order);
+}
@@ -0,0 +1,2 @@
+// pipeline.cpp                                                       -*-C++-*-
+#include <co_fun/pipeline.h>
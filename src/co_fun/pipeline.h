@@ -0,0 +1,440 @@
+// pipeline.h                                                         -*-C++-*-
+#ifndef INCLUDED_CO_FUN_PIPELINE
+#define INCLUDED_CO_FUN_PIPELINE
+
+//@PURPOSE: Run a chain of stream stages with one thread per stage.
+//
+//@CLASSES:
+//  co_fun::PipelineOptions: queue depth and batch size for a pipeline
+//  co_fun::StageStats: per stage item count, running and stall time
+//  co_fun::Pipeline: builder for a 'filter'/'fmap' chain ending in a sink
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: Evaluating 'fmap(fmap(filter(p, s), f), g)' forces every
+// stage on the consumer's thread, one nested thunk at a time.  A 'Pipeline'
+// takes the same stage functions and runs them concurrently instead: the
+// source stream is walked on its own thread, each stage runs on its own
+// thread, and the sink runs on the calling thread.  Adjacent stages are
+// connected by an 'SpscRing' of 'queueDepth' elements, and elements are
+// handed off 'batchSize' at a time so that the cost of publishing and
+// waking is amortized over the batch.
+//
+//..
+//  auto stats = pipeline(iota(0), {.queueDepth = 4096, .batchSize = 128})
+//                   .filter([](int i) { return i % 3 == 0; })
+//                   .fmap([](int i) { return i * 2; })
+//                   .fmap([](int i) { return std::to_string(i); })
+//                   .sink([&](std::string const& s) { out.push_back(s); });
+//..
+//
+// 'sink' returns one 'StageStats' per stage, source first and sink last,
+// recording the items each stage consumed, the time its thread ran, and how
+// much of that time it spent blocked on an empty input or a full output.
+//
+// Instead of a sink, 'stream' hands the output back as a 'ConsStream'.  The
+// stages then run ahead of the consumer, bounded by the queues.  When the
+// last handle to that stream is dropped the pipeline is stopped and its
+// threads joined.  The stages check for the stop between elements, and as
+// every stage thread runs under an 'EvaluationContext' whose stop token is
+// requested, a source blocked waiting for input, such as 'followLines',
+// gives up too.
+//
+// The source stream is traversed on another thread, so no other thread may
+// force it while the pipeline runs.  An exception thrown by any stage
+// stops the pipeline and is rethrown from 'sink', or from forcing the end
+// of the output stream.
+
+#include <co_fun/cancellation.h>
+#include <co_fun/ringbuffer.h>
+#include <co_fun/stream.h>
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace co_fun {
+
+struct PipelineOptions {
+    std::size_t queueDepth = 1024;
+    std::size_t batchSize  = 64;
+};
+
+struct StageStats {
+    std::string              name;
+    std::size_t              items = 0;
+    std::chrono::nanoseconds elapsed{};
+    std::chrono::nanoseconds stalled{};
+
+    // Items consumed per second of running time.
+    double throughput() const {
+        auto seconds = std::chrono::duration<double>(elapsed).count();
+        return seconds > 0 ? items / seconds : 0.0;
+    }
+};
+
+namespace detail {
+
+class PipelineRun {
+    std::deque<StageStats>             stats_;
+    std::vector<std::shared_ptr<void>> rings_;
+    std::vector<std::function<void()>> stoppers_;
+    std::vector<std::thread>           threads_;
+    std::stop_source                   stop_;
+    std::mutex                         lock_;
+    std::exception_ptr                 error_;
+
+  public:
+    PipelineRun() = default;
+    PipelineRun(PipelineRun const&) = delete;
+    PipelineRun& operator=(PipelineRun const&) = delete;
+
+    ~PipelineRun() { join(); }
+
+    template <typename Value>
+    SpscRing<Value>& makeRing(std::size_t depth) {
+        auto ring = std::make_shared<SpscRing<Value>>(depth);
+        rings_.push_back(ring);
+        stoppers_.push_back([r = ring.get()]() {
+            r->cancel();
+            r->close();
+        });
+        return *ring;
+    }
+
+    StageStats& addStage(std::string name) {
+        StageStats& stats = stats_.emplace_back();
+        stats.name        = std::move(name);
+        return stats;
+    }
+
+    template <typename Func>
+    void spawn(Func&& f) {
+        threads_.emplace_back(std::forward<Func>(f));
+    }
+
+    void fail(std::exception_ptr error) {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (!error_) {
+            error_ = error;
+        }
+    }
+
+    std::stop_token token() const { return stop_.get_token(); }
+
+    bool stopRequested() const { return stop_.stop_requested(); }
+
+    // Abandon the run: cancel in-flight evaluation and release every stage
+    // blocked on a queue.
+    void stop() {
+        stop_.request_stop();
+        for (auto& stopper : stoppers_) {
+            stopper();
+        }
+    }
+
+    void join() {
+        for (auto& thread : threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+
+    void rethrow() {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+    }
+
+    std::vector<StageStats> stats() const {
+        return std::vector<StageStats>(stats_.begin(), stats_.end());
+    }
+};
+
+using Clock = std::chrono::steady_clock;
+
+// Move all of 'batch' into 'out', blocking while the ring is full.  Returns
+// 'false' if the consumer cancelled.
+template <typename Value>
+bool pushBatch(SpscRing<Value>&    out,
+               std::vector<Value>& batch,
+               StageStats&         stats) {
+    std::size_t done = 0;
+    while (done < batch.size()) {
+        done += out.tryPush(batch.begin() + done, batch.size() - done);
+        if (done < batch.size()) {
+            auto start = Clock::now();
+            if (!out.waitForSpace()) {
+                return false;
+            }
+            stats.stalled += Clock::now() - start;
+        }
+    }
+    batch.clear();
+    return true;
+}
+
+// Fill 'batch' with up to 'max' elements, blocking while the ring is
+// empty.  Returns 'false' once the input is closed and drained.
+template <typename Value>
+bool popBatch(SpscRing<Value>&    in,
+              std::vector<Value>& batch,
+              std::size_t         max,
+              StageStats&         stats) {
+    batch.clear();
+    for (;;) {
+        if (in.tryPop(std::back_inserter(batch), max) != 0) {
+            return true;
+        }
+        auto start = Clock::now();
+        bool more  = in.waitForData();
+        stats.stalled += Clock::now() - start;
+        if (!more) {
+            return false;
+        }
+    }
+}
+
+// Run 'body' as a stage within the run's evaluation context, timing it and
+// converting an escaping exception into a failed run that stops the stages
+// on either side.
+template <typename Body, typename Stop>
+void runStage(PipelineRun& run, StageStats& stats, Body body, Stop stop) {
+    EvaluationContext::Scope scope(run.token());
+    auto                     start = Clock::now();
+    try {
+        body();
+    } catch (Cancelled const&) {
+    } catch (...) {
+        run.fail(std::current_exception());
+    }
+    stop();
+    stats.elapsed = Clock::now() - start;
+}
+
+// The consuming end of a pipeline whose output is read as a stream.
+template <typename Value>
+class PipelineOutput {
+    PipelineRun        run_;
+    SpscRing<Value>*   in_ = nullptr;
+    StageStats*        stats_;
+    std::vector<Value> batch_;
+    std::size_t        next_ = 0;
+    std::size_t        batchSize_;
+
+  public:
+    template <typename Launch>
+    PipelineOutput(Launch& launch, std::size_t batchSize)
+        : batchSize_(batchSize) {
+        in_    = &launch(run_);
+        stats_ = &run_.addStage("stream");
+        batch_.reserve(batchSize_);
+    }
+
+    ~PipelineOutput() {
+        run_.stop();
+        run_.join();
+    }
+
+    // Whether there is another value, blocking until one has arrived or
+    // the input has ended.  Rethrows the failure of a stage at the end.
+    bool more() {
+        if (next_ == batch_.size()) {
+            next_ = 0;
+            if (!popBatch(*in_, batch_, batchSize_, *stats_)) {
+                run_.join();
+                run_.rethrow();
+                return false;
+            }
+            stats_->items += batch_.size();
+        }
+        return true;
+    }
+
+    // The next value; 'more()' must have returned true.
+    Value take() { return std::move(batch_[next_++]); }
+};
+
+// Emptiness is decided when a cell is made, as for every finite stream, but
+// the value stays in the output's batch until its own cell is forced.
+template <typename Value>
+ConsStream<Value> outputStream(std::shared_ptr<PipelineOutput<Value>> output) {
+    if (!output->more()) {
+        return ConsStream<Value>();
+    }
+    return ConsStream<Value>([output]() {
+        Value value = output->take();
+        return ConsCell<Value>(value, outputStream(output));
+    });
+}
+
+} // namespace detail
+
+template <typename Value>
+class Pipeline {
+    using Launcher = std::function<SpscRing<Value>&(detail::PipelineRun&)>;
+
+    PipelineOptions options_;
+    Launcher        launch_;
+
+    template <typename>
+    friend class Pipeline;
+
+    Pipeline(PipelineOptions options, Launcher launch)
+        : options_(options), launch_(std::move(launch)) {}
+
+    // Append a stage running 'step(value, batch)' for every input value;
+    // 'step' pushes zero or more results onto 'batch'.
+    template <typename Out, typename Step>
+    Pipeline<Out> stage(char const* name, Step step) && {
+        PipelineOptions options = options_;
+        return Pipeline<Out>(
+            options,
+            [options, name, step, upstream = std::move(launch_)](
+                detail::PipelineRun& run) -> SpscRing<Out>& {
+                SpscRing<Value>& in    = upstream(run);
+                SpscRing<Out>&   out   = run.makeRing<Out>(options.queueDepth);
+                StageStats&      stats = run.addStage(name);
+                run.spawn([&run, &in, &out, &stats, options, step]() {
+                    detail::runStage(
+                        run,
+                        stats,
+                        [&]() {
+                            std::vector<Value> input;
+                            std::vector<Out>   output;
+                            input.reserve(options.batchSize);
+                            output.reserve(options.batchSize);
+                            while (!run.stopRequested() &&
+                                   detail::popBatch(
+                                       in, input, options.batchSize, stats)) {
+                                for (auto& v : input) {
+                                    step(v, output);
+                                }
+                                stats.items += input.size();
+                                if (!output.empty() &&
+                                    !detail::pushBatch(out, output, stats)) {
+                                    return;
+                                }
+                            }
+                        },
+                        [&]() {
+                            in.cancel();
+                            out.close();
+                        });
+                });
+                return out;
+            });
+    }
+
+  public:
+    explicit Pipeline(ConsStream<Value> source, PipelineOptions options = {})
+        : options_(options),
+          launch_([source = std::move(source), options](
+                      detail::PipelineRun& run) mutable -> SpscRing<Value>& {
+              SpscRing<Value>& out   = run.makeRing<Value>(options.queueDepth);
+              StageStats&      stats = run.addStage("source");
+              // The launcher lives as long as the pipeline; only the thread
+              // reading the source may hold its head, or no cell is freed.
+              run.spawn([&run,
+                         &out,
+                         &stats,
+                         source = std::exchange(source, ConsStream<Value>()),
+                         options]() mutable {
+                  detail::runStage(
+                      run,
+                      stats,
+                      [&]() {
+                          ConsStream<Value>  s = std::move(source);
+                          std::vector<Value> batch;
+                          batch.reserve(options.batchSize);
+                          while (!s.isEmpty() && !run.stopRequested()) {
+                              batch.push_back(s.head());
+                              s = s.tail();
+                              ++stats.items;
+                              if (batch.size() == options.batchSize &&
+                                  !detail::pushBatch(out, batch, stats)) {
+                                  return;
+                              }
+                          }
+                          detail::pushBatch(out, batch, stats);
+                      },
+                      [&]() { out.close(); });
+              });
+              return out;
+          }) {}
+
+    template <typename Predicate>
+    Pipeline<Value> filter(Predicate const& p) && {
+        return std::move(*this).template stage<Value>(
+            "filter", [p](Value& v, std::vector<Value>& out) {
+                if (p(v)) {
+                    out.push_back(std::move(v));
+                }
+            });
+    }
+
+    template <typename Func>
+    auto fmap(Func const& f) && {
+        using Mapped = std::decay_t<std::invoke_result_t<Func, Value const&>>;
+        return std::move(*this).template stage<Mapped>(
+            "fmap", [f](Value& v, std::vector<Mapped>& out) {
+                out.push_back(f(std::as_const(v)));
+            });
+    }
+
+    // Run the pipeline, calling 'sink' on this thread for every value that
+    // reaches the end, and return the statistics for each stage.
+    template <typename Sink>
+    std::vector<StageStats> sink(Sink&& sink) && {
+        detail::PipelineRun run;
+        SpscRing<Value>&    in    = launch_(run);
+        StageStats&         stats = run.addStage("sink");
+        detail::runStage(
+            run,
+            stats,
+            [&]() {
+                std::vector<Value> input;
+                input.reserve(options_.batchSize);
+                while (detail::popBatch(
+                    in, input, options_.batchSize, stats)) {
+                    for (auto& v : input) {
+                        sink(std::as_const(v));
+                    }
+                    stats.items += input.size();
+                }
+            },
+            [&]() { in.cancel(); });
+        run.join();
+        run.rethrow();
+        return run.stats();
+    }
+
+    // Start the pipeline and return its output as a lazy stream.  Dropping
+    // the stream stops the pipeline.
+    ConsStream<Value> stream() && {
+        return detail::outputStream(
+            std::make_shared<detail::PipelineOutput<Value>>(
+                launch_, options_.batchSize));
+    }
+};
+
+template <typename Value>
+Pipeline<Value> pipeline(ConsStream<Value> source,
+                         PipelineOptions   options = {}) {
+    return Pipeline<Value>(std::move(source), options);
+}
+
+} // namespace co_fun
+
+#endif
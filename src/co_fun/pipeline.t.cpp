@@ -0,0 +1,211 @@
+#include <co_fun/pipeline.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace co_fun;
+
+TEST(Co_FunPipelineTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunPipelineTest, Breathing) {
+    std::vector<int> out;
+    auto             stats = pipeline(rangeFrom(1, 5)).sink([&](int i) {
+        out.push_back(i);
+    });
+
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 4, 5}), out);
+    ASSERT_EQ(2u, stats.size());
+    EXPECT_EQ("source", stats[0].name);
+    EXPECT_EQ(5u, stats[0].items);
+    EXPECT_EQ("sink", stats[1].name);
+    EXPECT_EQ(5u, stats[1].items);
+}
+
+TEST(Co_FunPipelineTest, MatchesStream) {
+    auto isEven = [](int i) { return i % 2 == 0; };
+    auto square = [](int i) { return i * i; };
+    auto show   = [](int i) { return std::to_string(i); };
+
+    std::vector<std::string> expected;
+    for (auto const& s : fmap(fmap(filter(isEven, take(iota(0), 1000)),
+                                   square),
+                              show)) {
+        expected.push_back(s);
+    }
+
+    std::vector<std::string> out;
+    auto stats = pipeline(take(iota(0), 1000),
+                          {.queueDepth = 8, .batchSize = 3})
+                     .filter(isEven)
+                     .fmap(square)
+                     .fmap(show)
+                     .sink([&](std::string const& s) { out.push_back(s); });
+
+    EXPECT_EQ(expected, out);
+    ASSERT_EQ(5u, stats.size());
+    EXPECT_EQ("source", stats[0].name);
+    EXPECT_EQ("filter", stats[1].name);
+    EXPECT_EQ("fmap", stats[2].name);
+    EXPECT_EQ("fmap", stats[3].name);
+    EXPECT_EQ("sink", stats[4].name);
+    EXPECT_EQ(1000u, stats[0].items);
+    EXPECT_EQ(1000u, stats[1].items);
+    EXPECT_EQ(500u, stats[2].items);
+    EXPECT_EQ(500u, stats[3].items);
+    EXPECT_EQ(500u, stats[4].items);
+    for (auto const& stage : stats) {
+        EXPECT_LE(stage.stalled, stage.elapsed);
+        EXPECT_GE(stage.throughput(), 0.0);
+    }
+}
+
+TEST(Co_FunPipelineTest, EmptySource) {
+    int  calls = 0;
+    auto stats = pipeline(ConsStream<int>())
+                     .fmap([](int i) { return i + 1; })
+                     .sink([&](int) { ++calls; });
+    EXPECT_EQ(0, calls);
+    EXPECT_EQ(0u, stats[0].items);
+}
+
+TEST(Co_FunPipelineTest, StageExceptionPropagates) {
+    auto p = pipeline(iota(0), {.queueDepth = 4, .batchSize = 2})
+                 .fmap([](int i) {
+                     if (i == 100) {
+                         throw std::runtime_error("boom");
+                     }
+                     return i;
+                 });
+    int seen = 0;
+    EXPECT_THROW(std::move(p).sink([&](int) { ++seen; }),
+                 std::runtime_error);
+    EXPECT_LE(seen, 100);
+}
+
+TEST(Co_FunPipelineTest, SinkExceptionStopsUpstream) {
+    int  seen = 0;
+    auto p    = pipeline(iota(0), {.queueDepth = 4, .batchSize = 2})
+                 .filter([](int) { return true; });
+    EXPECT_THROW(std::move(p).sink([&](int i) {
+        ++seen;
+        if (i == 10) {
+            throw std::logic_error("enough");
+        }
+    }),
+                 std::logic_error);
+    EXPECT_EQ(11, seen);
+}
+
+TEST(Co_FunPipelineTest, Stream) {
+    ConsStream<int> s = pipeline(rangeFrom(1, 100), {.queueDepth = 4})
+                            .filter([](int i) { return i % 10 == 0; })
+                            .fmap([](int i) { return i / 10; })
+                            .stream();
+    std::vector<int> out;
+    for (int i : s) {
+        out.push_back(i);
+    }
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10}), out);
+
+    EXPECT_TRUE(pipeline(ConsStream<int>()).stream().isEmpty());
+}
+
+TEST(Co_FunPipelineTest, StreamException) {
+    auto p = pipeline(rangeFrom(1, 10), {.batchSize = 1}).fmap([](int i) {
+        if (i == 10) {
+            throw std::runtime_error("last");
+        }
+        return i;
+    });
+    EXPECT_THROW(
+        {
+            ConsStream<int> s = std::move(p).stream();
+            drop(s, 9);
+        },
+        std::runtime_error);
+}
+
+namespace {
+std::atomic<int> generated;
+
+ConsStream<int> counting(int n) {
+    return ConsStream<int>([n]() {
+        ++generated;
+        return ConsCell<int>(n, counting(n + 1));
+    });
+}
+} // namespace
+
+TEST(Co_FunPipelineTest, DroppingStreamStopsPipeline) {
+    generated = 0;
+    {
+        ConsStream<int> s =
+            pipeline(counting(0), {.queueDepth = 16, .batchSize = 4})
+                .fmap([](int i) { return i * 2; })
+                .stream();
+        EXPECT_EQ(18, last(take(s, 10)));
+    }
+    int stopped = generated.load();
+    EXPECT_LT(stopped, 1000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(stopped, generated.load());
+}
+
+namespace {
+// An int that counts how many of its kind are alive, and the most ever.
+struct Tracked {
+    static std::atomic<int> live;
+    static std::atomic<int> peak;
+
+    int value;
+
+    explicit Tracked(int v) : value(v) { grow(); }
+    Tracked(Tracked const& other) : value(other.value) { grow(); }
+    Tracked& operator=(Tracked const&) = default;
+    ~Tracked() { --live; }
+
+    static void grow() {
+        int now  = ++live;
+        int seen = peak.load();
+        while (seen < now && !peak.compare_exchange_weak(seen, now)) {
+        }
+    }
+};
+
+std::atomic<int> Tracked::live = 0;
+std::atomic<int> Tracked::peak = 0;
+
+ConsStream<Tracked> tracked(int n, int i = 0) {
+    if (i == n) {
+        return ConsStream<Tracked>();
+    }
+    return ConsStream<Tracked>([n, i]() {
+        return ConsCell<Tracked>(Tracked(i), tracked(n, i + 1));
+    });
+}
+} // namespace
+
+TEST(Co_FunPipelineTest, SourceCellsAreFreed) {
+    Tracked::peak = Tracked::live.load();
+    long sum      = 0;
+    pipeline(tracked(100000), {.queueDepth = 8, .batchSize = 4})
+        .sink([&](Tracked const& t) { sum += t.value; });
+    EXPECT_EQ(99999L * 100000 / 2, sum);
+    EXPECT_GT(200, Tracked::peak);
+
+    Tracked::peak = Tracked::live.load();
+    int  count    = 0;
+    auto s = pipeline(tracked(100000), {.queueDepth = 8, .batchSize = 4})
+                 .stream();
+    for (; !s.isEmpty(); s = s.tail()) {
+        ++count;
+    }
+    EXPECT_EQ(100000, count);
+    EXPECT_GT(200, Tracked::peak);
+}
@@ -0,0 +1,301 @@
+// reactor.cpp                                                        -*-C++-*-
+#include <co_fun/reactor.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace co_fun {
+
+namespace {
+std::system_error systemError(char const* what) {
+    return std::system_error(errno, std::generic_category(), what);
+}
+
+constexpr int maxEvents = 64;
+} // namespace
+
+Reactor::Reactor() : epoll_(::epoll_create1(EPOLL_CLOEXEC)) {
+    if (epoll_ < 0) {
+        throw systemError("epoll_create1");
+    }
+}
+
+Reactor::~Reactor() { ::close(epoll_); }
+
+void Reactor::await(int fd, std::coroutine_handle<> handle) {
+    auto onFd = [fd](Waiter const& waiter) { return waiter.first == fd; };
+    if (waiting_.count(fd) ||
+        std::any_of(ready_.begin(), ready_.end(), onFd)) {
+        throw std::invalid_argument("Reactor: descriptor already awaited");
+    }
+
+    // One shot, so that an event is delivered once per wait, and the
+    // descriptor stays registered, to be re-armed by the next wait.
+    epoll_event event{};
+    event.events  = EPOLLIN | EPOLLONESHOT;
+    event.data.fd = fd;
+    bool known    = registered_.count(fd) != 0;
+    int  rc = ::epoll_ctl(epoll_, known ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd,
+                         &event);
+    if (rc < 0 && errno == (known ? ENOENT : EEXIST)) {
+        // Closed and reopened behind our back, or registered by a reader
+        // that has since gone.
+        rc = ::epoll_ctl(epoll_, known ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd,
+                         &event);
+    }
+    if (rc < 0) {
+        if (errno == EPERM) {
+            // A regular file, which never blocks.
+            ready_.emplace_back(fd, handle);
+            return;
+        }
+        throw systemError("epoll_ctl");
+    }
+    registered_.insert(fd);
+    waiting_.emplace(fd, handle);
+}
+
+std::size_t Reactor::runOnce(int timeoutMs) {
+    std::vector<Waiter> ready;
+    ready.swap(ready_);
+    if (waiting_.empty() && ready.empty()) {
+        return 0;
+    }
+
+    std::size_t resumed = 0;
+    epoll_event events[maxEvents];
+    int         count = 0;
+    if (!waiting_.empty()) {
+        count = ::epoll_wait(epoll_, events, maxEvents,
+                             ready.empty() ? timeoutMs : 0);
+        if (count < 0) {
+            if (errno != EINTR) {
+                ready_.insert(ready_.end(), ready.begin(), ready.end());
+                throw systemError("epoll_wait");
+            }
+            count = 0;
+        }
+    }
+    for (Waiter const& waiter : ready) {
+        ++resumed;
+        waiter.second.resume();
+    }
+    for (int i = 0; i < count; ++i) {
+        // A coroutine resumed earlier may have dropped this waiter.
+        auto it = waiting_.find(events[i].data.fd);
+        if (it == waiting_.end()) {
+            continue;
+        }
+        std::coroutine_handle<> handle = it->second;
+        waiting_.erase(it);
+        ++resumed;
+        handle.resume();
+    }
+    return resumed;
+}
+
+void Reactor::run() {
+    while (waiting() != 0) {
+        runOnce();
+    }
+}
+
+void Reactor::forget(int fd) {
+    auto onFd = [fd](Waiter const& waiter) { return waiter.first == fd; };
+    waiting_.erase(fd);
+    ready_.erase(std::remove_if(ready_.begin(), ready_.end(), onFd),
+                 ready_.end());
+    if (registered_.erase(fd)) {
+        // Fails harmlessly if the descriptor has already been closed.
+        (void)::epoll_ctl(epoll_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+}
+
+std::shared_ptr<ReactorReader> Reactor::watch(int                   fd,
+                                              ReactorOptions const& options) {
+    return std::make_shared<ReactorReader>(*this, fd, options);
+}
+
+ReactorReader::ReactorReader(Reactor&              reactor,
+                             int                   fd,
+                             ReactorOptions const& options)
+    : reactor_(reactor),
+      fd_(fd),
+      flags_(::fcntl(fd, F_GETFL)),
+      readAhead_(options.readAhead ? options.readAhead : 1),
+      pool_(std::make_shared<BufferPool>(options.blockSize ? options.blockSize
+                                                           : 1,
+                                         readAhead_ + 2)) {
+    if (flags_ < 0 || ::fcntl(fd_, F_SETFL, flags_ | O_NONBLOCK) < 0) {
+        throw systemError("fcntl");
+    }
+    pump_ = pump();
+}
+
+ReactorReader::~ReactorReader() {
+    reactor_.forget(fd_);
+    pump_.handle_.destroy();
+    (void)::fcntl(fd_, F_SETFL, flags_);
+}
+
+detail::ReactorPump ReactorReader::pump() {
+    try {
+        for (;;) {
+            if (queue_.size() >= readAhead_) {
+                co_await SpaceAwaiter{this};
+                continue;
+            }
+            std::shared_ptr<char> buffer = pool_->acquire();
+            ssize_t n = ::read(fd_, buffer.get(), pool_->blockSize());
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    buffer.reset();
+                    co_await reactor_.readable(fd_);
+                    continue;
+                }
+                throw systemError("read");
+            }
+            if (n == 0) {
+                break;
+            }
+            std::string_view bytes(buffer.get(), std::size_t(n));
+            queue_.emplace_back(std::shared_ptr<char const>(std::move(buffer)),
+                                bytes);
+        }
+    } catch (...) {
+        error_ = std::current_exception();
+    }
+    done_ = true;
+}
+
+std::optional<Chunk> ReactorReader::next() {
+    while (queue_.empty() && !done_) {
+        reactor_.runOnce();
+    }
+    if (queue_.empty()) {
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        return std::nullopt;
+    }
+    Chunk chunk = std::move(queue_.front());
+    queue_.pop_front();
+    if (spaceWaiter_) {
+        std::exchange(spaceWaiter_, nullptr).resume();
+    }
+    return chunk;
+}
+
+Subprocess::Subprocess(std::vector<std::string> const& argv) {
+    if (argv.empty()) {
+        throw std::invalid_argument("Subprocess: empty command");
+    }
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC) < 0) {
+        throw systemError("pipe2");
+    }
+
+    std::vector<char*> args;
+    for (std::string const& arg : argv) {
+        args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+
+    // 'dup2' clears close-on-exec on the child's copy of the write end.
+    posix_spawn_file_actions_t actions;
+    ::posix_spawn_file_actions_init(&actions);
+    ::posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    int rc = ::posix_spawnp(
+        &pid_, args[0], &actions, nullptr, args.data(), ::environ);
+    ::posix_spawn_file_actions_destroy(&actions);
+    ::close(fds[1]);
+    if (rc != 0) {
+        ::close(fds[0]);
+        throw std::system_error(rc, std::generic_category(), "posix_spawnp");
+    }
+    out_ = fds[0];
+}
+
+Subprocess::Subprocess(Subprocess&& other) noexcept
+    : pid_(std::exchange(other.pid_, -1)),
+      out_(std::exchange(other.out_, -1)),
+      status_(std::exchange(other.status_, std::nullopt)) {}
+
+Subprocess::~Subprocess() {
+    if (out_ >= 0) {
+        ::close(out_);
+    }
+    if (pid_ > 0 && !status_) {
+        int status;
+        if (::waitpid(pid_, &status, WNOHANG) == 0) {
+            ::kill(pid_, SIGKILL);
+            while (::waitpid(pid_, &status, 0) < 0 && errno == EINTR) {
+            }
+        }
+    }
+}
+
+int Subprocess::wait() {
+    if (!status_) {
+        int status;
+        while (::waitpid(pid_, &status, 0) < 0) {
+            if (errno != EINTR) {
+                throw systemError("waitpid");
+            }
+        }
+        status_ = WIFEXITED(status) ? WEXITSTATUS(status)
+                                    : 128 + WTERMSIG(status);
+    }
+    return *status_;
+}
+
+namespace detail {
+
+ReactorArrivals::ReactorArrivals(
+    std::vector<std::shared_ptr<ReactorReader>> readers)
+    : readers_(std::move(readers)) {}
+
+std::optional<std::pair<std::size_t, Chunk>> ReactorArrivals::next() {
+    for (;;) {
+        // Take from the readers in turn, so a fast one cannot starve the
+        // others, dropping those that have finished.
+        Reactor*    reactor = nullptr;
+        std::size_t live    = 0;
+        for (std::size_t k = 0; k < readers_.size(); ++k) {
+            std::size_t i = (next_ + k) % readers_.size();
+            if (!readers_[i]) {
+                continue;
+            }
+            if (readers_[i]->ready()) {
+                if (std::optional<Chunk> chunk = readers_[i]->next()) {
+                    next_ = i + 1;
+                    return std::make_pair(i, std::move(*chunk));
+                }
+                readers_[i].reset();
+                continue;
+            }
+            reactor = &readers_[i]->reactor();
+            ++live;
+        }
+        if (live == 0) {
+            return std::nullopt;
+        }
+        reactor->runOnce();
+    }
+}
+
+} // namespace detail
+
+} // namespace co_fun
@@ -0,0 +1,297 @@
+// reactor.h                                                          -*-C++-*-
+#ifndef INCLUDED_CO_FUN_REACTOR
+#define INCLUDED_CO_FUN_REACTOR
+
+//@PURPOSE: Multiplex many descriptor streams on one thread with epoll.
+//
+//@CLASSES:
+//  co_fun::Reactor: single-threaded epoll loop resuming coroutines on input
+//  co_fun::ReactorReader: descriptor read into chunks by a reactor coroutine
+//  co_fun::ReactorOptions: block size and read-ahead depth of a reader
+//  co_fun::Subprocess: child process whose standard output is a pipe
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: 'FdReader' reads a descriptor on a thread of its own, which
+// is the right cost for a file and the wrong one for hundreds of pipes that
+// each produce a line a second.  A 'Reactor' reads any number of them on
+// the thread that consumes them.  'co_await reactor.readable(fd)' suspends
+// a coroutine until 'fd' has input; 'runOnce' waits in 'epoll_wait' and
+// resumes the coroutines whose descriptors became readable.
+//
+// 'reactor.watch(fd)' starts a coroutine that reads 'fd', without blocking,
+// into chunks of up to 'ReactorOptions::blockSize' bytes, and suspends on
+// 'readable(fd)' whenever the descriptor runs dry, or until the consumer
+// takes a chunk once 'ReactorOptions::readAhead' are waiting.
+// 'chunks(reader)' is the lazy 'ConsStream<Chunk>' of what it reads.
+// Forcing a cell whose chunk has not arrived runs the reactor until it
+// does, and every reader the reactor drives makes progress meanwhile, so
+// walking one stream never starves the others.  'arrivals(readers)' merges
+// several readers into one stream of '(index, chunk)' pairs, in the order
+// the chunks arrive.
+//
+//..
+//  Reactor                                     reactor;
+//  std::vector<Subprocess>                     workers;
+//  std::vector<std::shared_ptr<ReactorReader>> readers;
+//  for (auto const& job : jobs) {
+//      workers.emplace_back(std::vector<std::string>{"./worker", job});
+//      readers.push_back(reactor.watch(workers.back().output()));
+//  }
+//  for (auto s = arrivals(readers); !s.isEmpty(); s = s.tail()) {
+//      report(s.head().first, s.head().second);
+//  }
+//..
+//
+// Pipes, sockets, terminals and eventfds are polled; regular files, which
+// epoll does not accept, are always readable.  Reading an eventfd yields
+// its 8-byte counter.  A reader puts its descriptor in non-blocking mode,
+// and restores its flags when dropped.  The descriptor is not owned, and
+// must stay open until the reader is dropped.  As with 'chunks(fd)',
+// making a stream, or forcing one of its cells, waits for the chunk after
+// it, and a read error is thrown after the chunks read before it.
+//
+// A 'Subprocess' is spawned with its standard output on a pipe, whose read
+// end 'output()' can be watched.  Dropping one that has not been waited
+// for kills the child, so that an idle child cannot hang its parent.
+//
+// A 'Reactor' and its readers and streams belong to one thread, and the
+// reactor must outlive its readers.
+
+#include <co_fun/bufferpool.h>
+#include <co_fun/fdstream.h>
+#include <co_fun/stream.h>
+#include <co_fun/suspension.h>
+
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace co_fun {
+
+struct ReactorOptions {
+    // Largest number of bytes read at once.
+    std::size_t blockSize = std::size_t(64) << 10;
+
+    // Chunks read but not yet taken by the stream.  At least one.
+    std::size_t readAhead = 4;
+};
+
+class ReactorReader;
+
+class Reactor {
+    using Waiter = std::pair<int, std::coroutine_handle<>>;
+
+    int                                              epoll_;
+    std::unordered_map<int, std::coroutine_handle<>> waiting_;
+    std::unordered_set<int>                          registered_;
+    std::vector<Waiter>                              ready_;
+
+    void await(int fd, std::coroutine_handle<> handle);
+
+  public:
+    Reactor();
+
+    Reactor(Reactor const&) = delete;
+    Reactor& operator=(Reactor const&) = delete;
+
+    ~Reactor();
+
+    struct ReadableAwaiter {
+        Reactor* reactor_;
+        int      fd_;
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            reactor_->await(fd_, handle);
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    // Suspend the awaiting coroutine until 'fd' is readable, at end of
+    // file, or in error.  One coroutine at a time may wait on a descriptor.
+    ReadableAwaiter readable(int fd) { return ReadableAwaiter{this, fd}; }
+
+    // Wait up to 'timeoutMs' milliseconds, or without limit if negative,
+    // for waiting descriptors to become readable, and resume their
+    // coroutines.  Returns the number resumed; returns at once if nothing
+    // is waiting.
+    std::size_t runOnce(int timeoutMs = -1);
+
+    // Run until no coroutine is waiting.
+    void run();
+
+    // Coroutines waiting on a descriptor.
+    std::size_t waiting() const { return waiting_.size() + ready_.size(); }
+
+    // Stop watching 'fd', dropping the coroutine waiting on it, if any,
+    // without resuming it.
+    void forget(int fd);
+
+    // Read 'fd' into chunks as it becomes readable.
+    std::shared_ptr<ReactorReader> watch(int                   fd,
+                                         ReactorOptions const& options = {});
+};
+
+namespace detail {
+
+// The coroutine type of a reader's read loop, which its reader destroys.
+struct ReactorPump {
+    struct promise_type {
+        ReactorPump get_return_object() {
+            return ReactorPump{
+                std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_never initial_suspend() noexcept { return {}; }
+
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        void return_void() noexcept {}
+
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+} // namespace detail
+
+class ReactorReader {
+    Reactor&                    reactor_;
+    int                         fd_;
+    int                         flags_;
+    std::size_t                 readAhead_;
+    std::shared_ptr<BufferPool> pool_;
+    std::deque<Chunk>           queue_;
+    bool                        done_ = false;
+    std::exception_ptr          error_;
+    std::coroutine_handle<>     spaceWaiter_;
+    detail::ReactorPump         pump_;
+
+    struct SpaceAwaiter {
+        ReactorReader* reader_;
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle) noexcept {
+            reader_->spaceWaiter_ = handle;
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    detail::ReactorPump pump();
+
+  public:
+    // Start reading 'fd'.  Use 'Reactor::watch'.
+    ReactorReader(Reactor& reactor, int fd, ReactorOptions const& options);
+
+    ReactorReader(ReactorReader const&) = delete;
+    ReactorReader& operator=(ReactorReader const&) = delete;
+
+    ~ReactorReader();
+
+    // The next chunk, running the reactor until it has been read, or
+    // nothing at end of file.  Rethrows the error that stopped the reader.
+    std::optional<Chunk> next();
+
+    // Whether 'next()' can return without running the reactor.
+    bool ready() const { return !queue_.empty() || done_; }
+
+    Reactor& reactor() const { return reactor_; }
+
+    BufferPool const& pool() const { return *pool_; }
+};
+
+class Subprocess {
+    pid_t              pid_ = -1;
+    int                out_ = -1;
+    std::optional<int> status_;
+
+  public:
+    // Run 'argv', searching 'PATH' for 'argv[0]', with its standard output
+    // on a pipe.  Throws 'std::system_error' if it cannot be started.
+    explicit Subprocess(std::vector<std::string> const& argv);
+
+    Subprocess(Subprocess&& other) noexcept;
+
+    Subprocess(Subprocess const&) = delete;
+    Subprocess& operator=(Subprocess const&) = delete;
+
+    // Closes the pipe, then kills and reaps the child if it has not been
+    // waited for.
+    ~Subprocess();
+
+    pid_t pid() const { return pid_; }
+
+    // The read end of the child's standard output.
+    int output() const { return out_; }
+
+    // Wait for the child to exit.  Returns its exit status, or 128 plus the
+    // signal that killed it.
+    int wait();
+};
+
+namespace detail {
+
+class ReactorArrivals {
+    std::vector<std::shared_ptr<ReactorReader>> readers_;
+    std::size_t                                 next_ = 0;
+
+  public:
+    explicit ReactorArrivals(
+        std::vector<std::shared_ptr<ReactorReader>> readers);
+
+    // The next chunk to arrive from any reader, with the reader's index.
+    std::optional<std::pair<std::size_t, Chunk>> next();
+};
+
+template <typename Suspension>
+ConsStream<std::pair<std::size_t, Chunk>, Suspension>
+arrivalsFrom(std::shared_ptr<ReactorArrivals> merge) {
+    using Arrival = std::pair<std::size_t, Chunk>;
+    std::optional<Arrival> arrival = merge->next();
+    if (!arrival) {
+        return ConsStream<Arrival, Suspension>();
+    }
+    return ConsStream<Arrival, Suspension>(
+        [merge = std::move(merge), arrival = std::move(*arrival)]() {
+            return ConsCell<Arrival, Suspension>(
+                arrival, arrivalsFrom<Suspension>(merge));
+        });
+}
+
+} // namespace detail
+
+// ============================================================================
+//              INLINE FUNCTION AND FUNCTION TEMPLATE DEFINITIONS
+// ============================================================================
+
+template <typename Suspension = ThunkSuspension>
+ConsStream<Chunk, Suspension> chunks(std::shared_ptr<ReactorReader> reader) {
+    return detail::chunksFrom<Suspension>(std::move(reader));
+}
+
+template <typename Suspension = ThunkSuspension>
+ConsStream<std::pair<std::size_t, Chunk>, Suspension>
+arrivals(std::vector<std::shared_ptr<ReactorReader>> readers) {
+    return detail::arrivalsFrom<Suspension>(
+        std::make_shared<detail::ReactorArrivals>(std::move(readers)));
+}
+
+} // namespace co_fun
+
+#endif
@@ -0,0 +1,299 @@
+#include <co_fun/reactor.h>
+#include <co_fun/tempfile.t.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace co_fun;
+
+namespace {
+// Both ends of a pipe, closed on destruction.
+struct Pipe {
+    int read  = -1;
+    int write = -1;
+
+    Pipe() {
+        int fds[2];
+        EXPECT_EQ(0, ::pipe(fds));
+        read  = fds[0];
+        write = fds[1];
+    }
+
+    void closeWrite() {
+        if (write >= 0) {
+            ::close(write);
+            write = -1;
+        }
+    }
+
+    ~Pipe() {
+        closeWrite();
+        ::close(read);
+    }
+};
+
+void writeAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        ssize_t n = ::write(fd, data.data(), data.size());
+        ASSERT_LT(0, n);
+        data.remove_prefix(std::size_t(n));
+    }
+}
+
+void settle() { std::this_thread::sleep_for(std::chrono::milliseconds(20)); }
+
+template <typename Stream>
+std::string concatenate(Stream stream) {
+    std::string result;
+    for (; !stream.isEmpty(); stream = stream.tail()) {
+        result.append(stream.head().view());
+    }
+    return result;
+}
+} // namespace
+
+TEST(Co_FunReactorTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunReactorTest, Breathing) {
+    Reactor reactor;
+    Pipe    pipe;
+    writeAll(pipe.write, "hello, world");
+    pipe.closeWrite();
+    EXPECT_EQ("hello, world", concatenate(chunks(reactor.watch(pipe.read))));
+    EXPECT_EQ(0u, reactor.waiting());
+}
+
+TEST(Co_FunReactorTest, WaitsForSlowWriter) {
+    Reactor     reactor;
+    Pipe        pipe;
+    auto        reader = reactor.watch(pipe.read);
+    std::thread writer([&]() {
+        settle();
+        writeAll(pipe.write, "one\n");
+        settle();
+        writeAll(pipe.write, "two\n");
+        pipe.closeWrite();
+    });
+    auto lines = delimited(chunks(reader));
+    EXPECT_EQ("one", lines.head().view());
+    lines = lines.tail();
+    EXPECT_EQ("two", lines.head().view());
+    EXPECT_TRUE(lines.tail().isEmpty());
+    writer.join();
+}
+
+TEST(Co_FunReactorTest, ManyPipesOneThread) {
+    constexpr std::size_t                       count = 200;
+    Reactor                                     reactor;
+    std::vector<Pipe>                           pipes(count);
+    std::vector<std::shared_ptr<ReactorReader>> readers;
+    for (Pipe& pipe : pipes) {
+        readers.push_back(reactor.watch(pipe.read));
+    }
+
+    // The last pipe is written first, and the rest only after a pause, so
+    // the first arrival cannot come from any other.
+    std::thread writer([&]() {
+        for (std::size_t i = count; i-- > 0;) {
+            writeAll(pipes[i].write, std::to_string(i) + "\n");
+            if (i == count - 1) {
+                settle();
+            }
+            pipes[i].closeWrite();
+        }
+    });
+
+    std::map<std::size_t, std::string> received;
+    std::size_t                        first = count;
+    for (auto s = arrivals(readers); !s.isEmpty(); s = s.tail()) {
+        if (first == count) {
+            first = s.head().first;
+        }
+        received[s.head().first].append(s.head().second.view());
+    }
+    writer.join();
+
+    EXPECT_EQ(count - 1, first);
+    ASSERT_EQ(count, received.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(std::to_string(i) + "\n", received[i]);
+    }
+}
+
+TEST(Co_FunReactorTest, OtherReadersProgress) {
+    Reactor reactor;
+    Pipe    fast;
+    Pipe    slow;
+    auto    fastReader = reactor.watch(fast.read);
+    auto    slowReader = reactor.watch(slow.read);
+
+    std::thread writer([&]() {
+        writeAll(fast.write, "fast");
+        fast.closeWrite();
+        settle();
+        writeAll(slow.write, "slow");
+        slow.closeWrite();
+    });
+    // Waiting on the slow pipe reads the fast one meanwhile.
+    EXPECT_EQ("slow", concatenate(chunks(slowReader)));
+    EXPECT_TRUE(fastReader->ready());
+    EXPECT_EQ("fast", concatenate(chunks(fastReader)));
+    writer.join();
+}
+
+TEST(Co_FunReactorTest, ReadAheadIsBounded) {
+    Reactor        reactor;
+    Pipe           pipe;
+    ReactorOptions options{.blockSize = 4096, .readAhead = 2};
+    auto           reader = reactor.watch(pipe.read, options);
+
+    std::string data(1 << 20, '\0');
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = char('a' + i % 23);
+    }
+    std::thread writer([&]() {
+        writeAll(pipe.write, data);
+        pipe.closeWrite();
+    });
+    EXPECT_EQ(data, concatenate(chunks(reader)));
+    writer.join();
+    EXPECT_GE(options.readAhead + 3, reader->pool().allocated());
+}
+
+TEST(Co_FunReactorTest, EventFd) {
+    Reactor reactor;
+    int     event = ::eventfd(0, EFD_CLOEXEC);
+    ASSERT_LE(0, event);
+    // An eventfd never ends, and forcing a cell reads the one after it, so
+    // there are two signals.
+    std::thread signaller([&]() {
+        for (std::uint64_t value : {5, 7}) {
+            settle();
+            EXPECT_EQ(ssize_t(sizeof value),
+                      ::write(event, &value, sizeof value));
+        }
+    });
+    {
+        auto counts = chunks(reactor.watch(event));
+        ASSERT_EQ(sizeof(std::uint64_t), counts.head().size());
+        std::uint64_t value;
+        std::memcpy(&value, counts.head().data(), sizeof value);
+        EXPECT_EQ(5u, value);
+    }
+    signaller.join();
+    EXPECT_EQ(0u, reactor.waiting());
+    ::close(event);
+}
+
+TEST(Co_FunReactorTest, Socket) {
+    Reactor reactor;
+    int     fds[2];
+    ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds));
+    std::thread peer([&]() {
+        settle();
+        writeAll(fds[1], "over a socket");
+        ::close(fds[1]);
+    });
+    EXPECT_EQ("over a socket", concatenate(chunks(reactor.watch(fds[0]))));
+    peer.join();
+    ::close(fds[0]);
+}
+
+TEST(Co_FunReactorTest, RegularFile) {
+    test::TempFile file("from a file");
+    int            fd = ::open(file.path().c_str(), O_RDONLY);
+    ASSERT_LE(0, fd);
+
+    Reactor reactor;
+    EXPECT_EQ("from a file", concatenate(chunks(reactor.watch(fd))));
+    ::close(fd);
+}
+
+TEST(Co_FunReactorTest, RestoresFlags) {
+    Reactor reactor;
+    Pipe    pipe;
+    {
+        auto reader = reactor.watch(pipe.read);
+        EXPECT_NE(0, ::fcntl(pipe.read, F_GETFL) & O_NONBLOCK);
+        EXPECT_EQ(1u, reactor.waiting());
+    }
+    EXPECT_EQ(0, ::fcntl(pipe.read, F_GETFL) & O_NONBLOCK);
+    EXPECT_EQ(0u, reactor.waiting());
+    EXPECT_EQ(0u, reactor.runOnce());
+}
+
+TEST(Co_FunReactorTest, Subprocess) {
+    Reactor    reactor;
+    Subprocess child({"sh", "-c", "echo one; echo two; exit 3"});
+    auto       lines = delimited(chunks(reactor.watch(child.output())));
+    std::vector<std::string> result;
+    for (; !lines.isEmpty(); lines = lines.tail()) {
+        result.emplace_back(lines.head().view());
+    }
+    EXPECT_EQ((std::vector<std::string>{"one", "two"}), result);
+    EXPECT_EQ(3, child.wait());
+}
+
+TEST(Co_FunReactorTest, ManySubprocesses) {
+    constexpr int                               count = 32;
+    Reactor                                     reactor;
+    std::vector<Subprocess>                     children;
+    std::vector<std::shared_ptr<ReactorReader>> readers;
+    for (int i = 0; i < count; ++i) {
+        std::string script =
+            "sleep 0.0" + std::to_string(i % 5) + "; echo " +
+            std::to_string(i);
+        children.emplace_back(std::vector<std::string>{"sh", "-c", script});
+    }
+    for (Subprocess const& child : children) {
+        readers.push_back(reactor.watch(child.output()));
+    }
+
+    std::map<std::size_t, std::string> received;
+    for (auto s = arrivals(readers); !s.isEmpty(); s = s.tail()) {
+        received[s.head().first].append(s.head().second.view());
+    }
+    for (int i = 0; i < count; ++i) {
+        EXPECT_EQ(std::to_string(i) + "\n", received[std::size_t(i)]);
+        EXPECT_EQ(0, children[std::size_t(i)].wait());
+    }
+}
+
+TEST(Co_FunReactorTest, KillsUnwaitedChild) {
+    pid_t pid;
+    {
+        Subprocess child({"sleep", "60"});
+        pid = child.pid();
+    }
+    EXPECT_NE(0, ::kill(pid, 0));
+}
+
+TEST(Co_FunReactorTest, SpawnFailure) {
+    EXPECT_THROW(Subprocess({"/nonexistent/command"}), std::system_error);
+    EXPECT_THROW(Subprocess({}), std::invalid_argument);
+}
+
+TEST(Co_FunReactorTest, RunOnceTimesOut) {
+    Reactor reactor;
+    Pipe    pipe;
+    auto    reader = reactor.watch(pipe.read);
+    EXPECT_EQ(0u, reactor.runOnce(10));
+    EXPECT_FALSE(reader->ready());
+    writeAll(pipe.write, "x");
+    EXPECT_EQ(1u, reactor.runOnce(0));
+    EXPECT_TRUE(reader->ready());
+}
@@ -0,0 +1,2 @@
+// relational.cpp                                                     -*-C++-*-
+#include <co_fun/relational.h>
@@ -0,0 +1,359 @@
+// relational.h                                                       -*-C++-*-
+#ifndef INCLUDED_CO_FUN_RELATIONAL
+#define INCLUDED_CO_FUN_RELATIONAL
+
+//@PURPOSE: Provide hash-based distinct, grouping and join over streams.
+//
+//@CLASSES:
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: 'distinct(stream)' is the stream of the elements of 'stream'
+// seen for the first time, in order, and 'distinctBy(stream, keyOf)' those
+// whose 'keyOf' has not been seen.  The keys seen are kept in a
+// 'FlatHashSet', which grows with the number of distinct keys, not with the
+// length of the stream.
+//
+// 'groupBy(stream, keyOf)' is the stream of 'std::pair<Key,
+// std::vector<Value>>' groups of the elements with equal keys, in the
+// order each key first appears.  A group is complete only once the input
+// is, so forcing the first group reads the whole stream; making the group
+// stream reads nothing.  For input already ordered by key,
+// 'groupBySorted(stream, keyOf)' groups runs of equal keys instead,
+// producing each group as soon as the next key appears, in constant memory
+// beyond the group.
+//
+// 'hashJoin(build, probe, keyOf)' is the inner equi-join of two streams:
+// the stream of 'std::pair<Build, Probe>' for each element of 'probe' and
+// each element of 'build' with an equal key, in the order of 'probe', then
+// of 'build'.  'hashJoin(build, probe, buildKey, probeKey)' takes a key
+// function for each side.  The 'build' stream, which should be the
+// smaller, is read into a 'FlatHashMap' from each key to the range of its
+// elements, laid out contiguously by key; the 'probe' stream is read
+// lazily, a batch at a time, hashing the batch and prefetching its slots
+// before looking any of it up, so that the cache misses of a large table
+// overlap rather than follow one another:
+//..
+//  auto placed = hashJoin(customers, orders, [](auto const& r) {
+//      return r.customerId;
+//  });
+//..
+//
+// As with 'filter', whether 'distinct', 'groupBySorted' or 'hashJoin' is
+// empty is known when the stream is made, so making it, or forcing a cell,
+// reads input up to the element after.  'hashJoin' reads all of 'build',
+// and the first batch of 'probe', when it is made.  The cells of one of
+// these streams share a table, and must be forced from one thread at a
+// time.
+
+#include <co_fun/flathash.h>
+#include <co_fun/stream.h>
+#include <co_fun/suspension.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace co_fun {
+
+namespace detail {
+
+template <typename Value, typename KeyOf>
+using KeyOfResult =
+    std::decay_t<std::invoke_result_t<KeyOf const&, Value const&>>;
+
+template <typename Value, typename Suspension, typename KeyOf>
+struct Distinct {
+    using Key = KeyOfResult<Value, KeyOf>;
+
+    KeyOf                             keyOf;
+    std::shared_ptr<FlatHashSet<Key>> seen;
+};
+
+template <typename Value, typename Suspension, typename KeyOf>
+ConsStream<Value, Suspension>
+distinctFrom(Distinct<Value, Suspension, KeyOf> const& distinct,
+             ConsStream<Value, Suspension>             in) {
+    while (!in.isEmpty() &&
+           !distinct.seen->insert(distinct.keyOf(in.head()))) {
+        in = in.tail();
+    }
+    if (in.isEmpty()) {
+        return ConsStream<Value, Suspension>();
+    }
+    return ConsStream<Value, Suspension>([distinct, in]() {
+        return ConsCell<Value, Suspension>(in.head(),
+                                           distinctFrom(distinct, in.tail()));
+    });
+}
+
+template <typename Value, typename Suspension>
+ConsStream<Value, Suspension>
+cellsFrom(std::shared_ptr<std::vector<Value> const> values, std::size_t i) {
+    if (i == values->size()) {
+        return ConsStream<Value, Suspension>();
+    }
+    return ConsStream<Value, Suspension>([values, i]() {
+        return ConsCell<Value, Suspension>((*values)[i],
+                                           cellsFrom<Value, Suspension>(
+                                               values, i + 1));
+    });
+}
+
+template <typename Value, typename Suspension, typename KeyOf>
+auto sortedGroupsFrom(ConsStream<Value, Suspension> in, KeyOf const& keyOf)
+    -> ConsStream<std::pair<KeyOfResult<Value, KeyOf>, std::vector<Value>>,
+                  Suspension> {
+    using Key   = KeyOfResult<Value, KeyOf>;
+    using Group = std::pair<Key, std::vector<Value>>;
+    if (in.isEmpty()) {
+        return ConsStream<Group, Suspension>();
+    }
+    Group group(keyOf(in.head()), std::vector<Value>());
+    while (!in.isEmpty() && keyOf(in.head()) == group.first) {
+        group.second.push_back(in.head());
+        in = in.tail();
+    }
+    return ConsStream<Group, Suspension>([group, in, keyOf]() {
+        return ConsCell<Group, Suspension>(group,
+                                           sortedGroupsFrom(in, keyOf));
+    });
+}
+
+// The build side of a hash join: its elements, ordered by key, and for
+// each key the range of them it matches.
+template <typename Key, typename Build>
+class JoinTable {
+    struct Range {
+        std::size_t begin = 0;
+        std::size_t count = 0;
+    };
+
+    FlatHashMap<Key, Range> index_;
+    std::vector<Build>      rows_;
+
+  public:
+    template <typename Suspension, typename KeyOf>
+    JoinTable(ConsStream<Build, Suspension> build, KeyOf const& keyOf) {
+        std::vector<Build>       rows;
+        std::vector<std::size_t> entry;
+        for (; !build.isEmpty(); build = build.tail()) {
+            rows.push_back(build.head());
+            auto found = index_.tryEmplace(keyOf(rows.back()));
+            ++found.first->second.count;
+            entry.push_back(found.first - &*index_.begin());
+        }
+        std::size_t begin = 0;
+        for (auto& [key, range] : index_) {
+            range.begin = begin;
+            begin += range.count;
+            range.count = 0;
+        }
+        std::vector<std::size_t> order(rows.size());
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            Range& range = (index_.begin() + entry[i])->second;
+            order[range.begin + range.count++] = i;
+        }
+        rows_.reserve(rows.size());
+        for (std::size_t i : order) {
+            rows_.push_back(std::move(rows[i]));
+        }
+    }
+
+    bool empty() const { return rows_.empty(); }
+
+    std::uint64_t hashOf(Key const& key) const { return index_.hashOf(key); }
+
+    void prefetch(std::uint64_t hash) const { index_.prefetch(hash); }
+
+    // Call 'f' with each element matching 'key'.
+    template <typename Func>
+    void forEach(std::uint64_t hash, Key const& key, Func&& f) const {
+        if (Range const* range = index_.findHashed(hash, key)) {
+            for (std::size_t i = 0; i < range->count; ++i) {
+                f(rows_[range->begin + i]);
+            }
+        }
+    }
+};
+
+template <typename Build,
+          typename Probe,
+          typename Suspension,
+          typename BuildKey,
+          typename ProbeKey>
+class HashJoin {
+  public:
+    using Key    = KeyOfResult<Build, BuildKey>;
+    using Result = std::pair<Build, Probe>;
+
+    static constexpr std::size_t batchSize = 16;
+
+  private:
+    JoinTable<Key, Build>         table_;
+    ProbeKey                      probeKey_;
+    ConsStream<Probe, Suspension> probe_;
+    std::deque<Result>            pending_;
+
+    // Look up the next batch of 'probe_', issuing every slot load of the
+    // batch before waiting on any.
+    void probeBatch() {
+        std::vector<Probe> batch;
+        std::vector<Key>   keys;
+        std::uint64_t      hashes[batchSize];
+        batch.reserve(batchSize);
+        keys.reserve(batchSize);
+        while (batch.size() < batchSize && !probe_.isEmpty()) {
+            batch.push_back(probe_.head());
+            probe_ = probe_.tail();
+            keys.push_back(probeKey_(batch.back()));
+            hashes[keys.size() - 1] = table_.hashOf(keys.back());
+            table_.prefetch(hashes[keys.size() - 1]);
+        }
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            table_.forEach(hashes[i], keys[i], [&](Build const& row) {
+                pending_.emplace_back(row, batch[i]);
+            });
+        }
+    }
+
+  public:
+    HashJoin(ConsStream<Build, Suspension> build,
+             BuildKey const&               buildKey,
+             ConsStream<Probe, Suspension> probe,
+             ProbeKey                      probeKey)
+        : table_(std::move(build), buildKey),
+          probeKey_(std::move(probeKey)),
+          probe_(table_.empty() ? ConsStream<Probe, Suspension>()
+                                : std::move(probe)) {}
+
+    // The next match, if there is one.
+    std::optional<Result> next() {
+        while (pending_.empty() && !probe_.isEmpty()) {
+            probeBatch();
+        }
+        if (pending_.empty()) {
+            return std::nullopt;
+        }
+        Result result = std::move(pending_.front());
+        pending_.pop_front();
+        return result;
+    }
+};
+
+template <typename Build,
+          typename Probe,
+          typename Suspension,
+          typename BuildKey,
+          typename ProbeKey>
+ConsStream<std::pair<Build, Probe>, Suspension> joinFrom(
+    std::shared_ptr<HashJoin<Build, Probe, Suspension, BuildKey, ProbeKey>>
+        join) {
+    using Result = std::pair<Build, Probe>;
+    std::optional<Result> result = join->next();
+    if (!result) {
+        return ConsStream<Result, Suspension>();
+    }
+    return ConsStream<Result, Suspension>([join, result = *result]() {
+        return ConsCell<Result, Suspension>(result, joinFrom(join));
+    });
+}
+
+} // namespace detail
+
+// ============================================================================
+//              INLINE FUNCTION AND FUNCTION TEMPLATE DEFINITIONS
+// ============================================================================
+
+template <typename Value, typename Suspension, typename KeyOf>
+ConsStream<Value, Suspension> distinctBy(ConsStream<Value, Suspension> stream,
+                                         KeyOf                         keyOf) {
+    using Distinct = detail::Distinct<Value, Suspension, KeyOf>;
+    Distinct distinct{
+        std::move(keyOf),
+        std::make_shared<FlatHashSet<typename Distinct::Key>>()};
+    return detail::distinctFrom(distinct, std::move(stream));
+}
+
+template <typename Value, typename Suspension>
+ConsStream<Value, Suspension> distinct(ConsStream<Value, Suspension> stream) {
+    return distinctBy(std::move(stream),
+                      [](Value const& v) -> Value const& { return v; });
+}
+
+template <typename Value, typename Suspension, typename KeyOf>
+auto groupBy(ConsStream<Value, Suspension> stream, KeyOf keyOf)
+    -> ConsStream<
+        std::pair<detail::KeyOfResult<Value, KeyOf>, std::vector<Value>>,
+        Suspension> {
+    using Key    = detail::KeyOfResult<Value, KeyOf>;
+    using Group  = std::pair<Key, std::vector<Value>>;
+    using Groups = std::vector<Group>;
+    if (stream.isEmpty()) {
+        return ConsStream<Group, Suspension>();
+    }
+    // Not empty, since the input is not; reading the input waits for the
+    // first group to be forced.  The cell walks the input by reassignment,
+    // freeing what it has read, and keeps its table.  Under a suspension
+    // that leaves a cell unevaluated when its function throws, such as
+    // 'MemoSuspension', a cell interrupted by an element that throws carries
+    // on from that element when forced again.  'ThunkSuspension' does so
+    // only for 'Cancelled', and keeps any other exception as the result.
+    return ConsStream<Group, Suspension>(
+        [stream = std::move(stream),
+         keyOf,
+         table = FlatHashMap<Key, std::vector<Value>>()]() mutable {
+            for (; !stream.isEmpty(); stream = stream.tail()) {
+                Value value = stream.head();
+                table.tryEmplace(keyOf(value)).first->second.push_back(
+                    std::move(value));
+            }
+            auto groups = std::make_shared<Groups const>(table.release());
+            return ConsCell<Group, Suspension>(
+                groups->front(),
+                detail::cellsFrom<Group, Suspension>(groups, 1));
+        });
+}
+
+template <typename Value, typename Suspension, typename KeyOf>
+auto groupBySorted(ConsStream<Value, Suspension> stream, KeyOf keyOf) {
+    return detail::sortedGroupsFrom(std::move(stream), keyOf);
+}
+
+template <typename Build,
+          typename Probe,
+          typename Suspension,
+          typename BuildKey,
+          typename ProbeKey>
+ConsStream<std::pair<Build, Probe>, Suspension>
+hashJoin(ConsStream<Build, Suspension> build,
+         ConsStream<Probe, Suspension> probe,
+         BuildKey                      buildKey,
+         ProbeKey                      probeKey) {
+    using Join =
+        detail::HashJoin<Build, Probe, Suspension, BuildKey, ProbeKey>;
+    static_assert(
+        std::is_same_v<typename Join::Key,
+                       detail::KeyOfResult<Probe, ProbeKey>>,
+        "hashJoin: both sides must have the same key type");
+    auto join = std::make_shared<Join>(
+        std::move(build), buildKey, std::move(probe), std::move(probeKey));
+    return detail::joinFrom(std::move(join));
+}
+
+template <typename Build, typename Probe, typename Suspension, typename KeyOf>
+ConsStream<std::pair<Build, Probe>, Suspension>
+hashJoin(ConsStream<Build, Suspension> build,
+         ConsStream<Probe, Suspension> probe,
+         KeyOf                         keyOf) {
+    return hashJoin(std::move(build), std::move(probe), keyOf, keyOf);
+}
+
+} // namespace co_fun
+
+#endif
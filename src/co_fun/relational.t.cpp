@@ -0,0 +1,178 @@
+#include <co_fun/relational.h>
+#include <co_fun/stream.t.h>
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace co_fun;
+
+namespace {
+using test::fromVector;
+using test::collect;
+
+struct Customer {
+    int         id;
+    std::string name;
+};
+
+struct Order {
+    int customer;
+    int amount;
+};
+
+int mod10(int x) { return x % 10; }
+
+// Each element, counting the times it is produced.
+ConsStream<int> counted(int& count, int n, int i = 0) {
+    if (i == n) {
+        return ConsStream<int>();
+    }
+    return ConsStream<int>([&count, n, i]() {
+        ++count;
+        return ConsCell<int>(i, counted(count, n, i + 1));
+    });
+}
+
+// 0 to 'n - 1' in memo cells, of which element 'bad' throws the first
+// 'failures' times it is forced.
+ConsStream<int, MemoSuspension>
+flaky(int& failures, int bad, int n, int i = 0) {
+    if (i == n) {
+        return ConsStream<int, MemoSuspension>();
+    }
+    return ConsStream<int, MemoSuspension>([&failures, bad, n, i]() {
+        if (i == bad && failures > 0) {
+            --failures;
+            throw std::runtime_error("flaky");
+        }
+        return ConsCell<int, MemoSuspension>(i,
+                                             flaky(failures, bad, n, i + 1));
+    });
+}
+} // namespace
+
+TEST(Co_FunRelationalTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunRelationalTest, Distinct) {
+    auto s = fromVector<int>({3, 1, 3, 2, 1, 4, 4, 3});
+    EXPECT_EQ((std::vector<int>{3, 1, 2, 4}), collect(distinct(s)));
+    EXPECT_TRUE(distinct(ConsStream<int>()).isEmpty());
+}
+
+TEST(Co_FunRelationalTest, DistinctBy) {
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10}),
+              collect(distinctBy(rangeFrom(1, 100), mod10)));
+}
+
+TEST(Co_FunRelationalTest, DistinctIsLazy) {
+    int  count = 0;
+    auto first = take(distinct(counted(count, 1000000)), 3);
+    EXPECT_EQ((std::vector<int>{0, 1, 2}), collect(first));
+    EXPECT_GE(4, count);
+}
+
+TEST(Co_FunRelationalTest, GroupBy) {
+    auto groups = collect(groupBy(rangeFrom(1, 25), mod10));
+    ASSERT_EQ(10u, groups.size());
+    EXPECT_EQ(1, groups[0].first);
+    EXPECT_EQ((std::vector<int>{1, 11, 21}), groups[0].second);
+    EXPECT_EQ(0, groups[9].first);
+    EXPECT_EQ((std::vector<int>{10, 20}), groups[9].second);
+    EXPECT_TRUE(groupBy(ConsStream<int>(), mod10).isEmpty());
+}
+
+TEST(Co_FunRelationalTest, GroupByWaitsToBeForced) {
+    int  count  = 0;
+    auto groups = groupBy(counted(count, 100), mod10);
+    EXPECT_FALSE(groups.isEmpty());
+    EXPECT_EQ(0, count);
+    EXPECT_EQ(0, groups.head().first);
+    EXPECT_EQ(100, count);
+}
+
+TEST(Co_FunRelationalTest, GroupByResumesAfterThrow) {
+    int  failures = 1;
+    auto groups   = groupBy(flaky(failures, 15, 30), mod10);
+    EXPECT_THROW(groups.head(), std::runtime_error);
+    auto result = collect(groups);
+    ASSERT_EQ(10u, result.size());
+    EXPECT_EQ(0, result[0].first);
+    EXPECT_EQ((std::vector<int>{0, 10, 20}), result[0].second);
+    EXPECT_EQ((std::vector<int>{5, 15, 25}), result[5].second);
+}
+
+TEST(Co_FunRelationalTest, GroupBySorted) {
+    auto s = fromVector<std::string>({"apple", "avocado", "banana", "cherry",
+                                      "citron", "clementine"});
+    auto groups =
+        collect(groupBySorted(s, [](std::string const& w) { return w[0]; }));
+    ASSERT_EQ(3u, groups.size());
+    EXPECT_EQ('a', groups[0].first);
+    EXPECT_EQ(2u, groups[0].second.size());
+    EXPECT_EQ('b', groups[1].first);
+    EXPECT_EQ((std::vector<std::string>{"cherry", "citron", "clementine"}),
+              groups[2].second);
+}
+
+TEST(Co_FunRelationalTest, GroupBySortedIsIncremental) {
+    int  count = 0;
+    auto first = groupBySorted(counted(count, 1000000),
+                               [](int x) { return x / 10; });
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}),
+              first.head().second);
+    // The first group, and the one after it, up to the key that ends it.
+    EXPECT_EQ(21, count);
+}
+
+TEST(Co_FunRelationalTest, HashJoin) {
+    auto customers = fromVector<Customer>({{1, "ann"}, {2, "bob"}, {3, "cy"}});
+    auto orders    = fromVector<Order>({{2, 10}, {4, 99}, {1, 20}, {2, 30}});
+    auto joined    = collect(hashJoin(
+        customers,
+        orders,
+        [](Customer const& c) { return c.id; },
+        [](Order const& o) { return o.customer; }));
+    ASSERT_EQ(3u, joined.size());
+    EXPECT_EQ("bob", joined[0].first.name);
+    EXPECT_EQ(10, joined[0].second.amount);
+    EXPECT_EQ("ann", joined[1].first.name);
+    EXPECT_EQ("bob", joined[2].first.name);
+    EXPECT_EQ(30, joined[2].second.amount);
+}
+
+TEST(Co_FunRelationalTest, HashJoinManyToMany) {
+    // Each key of 0..9 is on 5 build rows; probes of 0..99 match by mod 10.
+    auto joined = collect(hashJoin(rangeFrom(0, 49), rangeFrom(0, 99), mod10));
+    ASSERT_EQ(500u, joined.size());
+    std::map<int, std::vector<int>> matches;
+    for (auto const& [build, probe] : joined) {
+        ASSERT_EQ(build % 10, probe % 10);
+        matches[probe].push_back(build);
+    }
+    EXPECT_EQ(100u, matches.size());
+    // Build rows come in build order for each probe.
+    EXPECT_EQ((std::vector<int>{7, 17, 27, 37, 47}), matches[57]);
+    EXPECT_EQ(0, joined.front().second);
+    EXPECT_EQ(99, joined.back().second);
+}
+
+TEST(Co_FunRelationalTest, HashJoinEmpty) {
+    EXPECT_TRUE(hashJoin(ConsStream<int>(), rangeFrom(0, 9), mod10).isEmpty());
+    EXPECT_TRUE(hashJoin(rangeFrom(0, 9), ConsStream<int>(), mod10).isEmpty());
+    EXPECT_TRUE(hashJoin(rangeFrom(0, 9),
+                         rangeFrom(10, 19),
+                         [](int x) { return x; })
+                    .isEmpty());
+}
+
+TEST(Co_FunRelationalTest, HashJoinProbesLazily) {
+    int  count  = 0;
+    auto joined = hashJoin(rangeFrom(0, 9), counted(count, 1000000), mod10);
+    EXPECT_EQ(3u, collect(take(joined, 3)).size());
+    EXPECT_GE(32, count);
+}
@@ -0,0 +1,2 @@
+// ringbuffer.cpp                                                     -*-C++-*-
+#include <co_fun/ringbuffer.h>
@@ -0,0 +1,189 @@
+// ringbuffer.h                                                       -*-C++-*-
+#ifndef INCLUDED_CO_FUN_RINGBUFFER
+#define INCLUDED_CO_FUN_RINGBUFFER
+
+//@PURPOSE: Provide a bounded single-producer/single-consumer queue.
+//
+//@CLASSES:
+//  co_fun::SpscRing: lock-free SPSC ring buffer with batch push and pop
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: 'SpscRing' connects exactly one producer thread to exactly
+// one consumer thread.  Elements are moved in and out in batches; the two
+// indices live on separate cache lines and each side keeps a cached copy of
+// the other side's index, so the shared lines are only touched when the
+// cached view runs out.  The fast path takes no locks and makes no system
+// calls.  When a side has to wait it blocks on an event counter with
+// 'std::atomic::wait' rather than spinning, and is woken once per batch.
+//
+// The producer calls 'close()' when it is done; the consumer calls
+// 'cancel()' when it will not read any more, which releases a producer
+// blocked on a full ring.
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace co_fun {
+
+template <typename T>
+class SpscRing {
+    static constexpr std::size_t cacheLine = 64;
+
+    struct Slot {
+        alignas(T) std::byte bytes[sizeof(T)];
+
+        T* get() { return std::launder(reinterpret_cast<T*>(bytes)); }
+    };
+
+    std::size_t             mask_;
+    std::unique_ptr<Slot[]> slots_;
+
+    // Consumer owned.
+    alignas(cacheLine) std::atomic<std::size_t> head_{0};
+    std::size_t cachedTail_{0};
+
+    // Producer owned.
+    alignas(cacheLine) std::atomic<std::size_t> tail_{0};
+    std::size_t cachedHead_{0};
+
+    // Wakeups; bumped after publishing so waiters observe a changed value.
+    alignas(cacheLine) std::atomic<std::uint32_t> dataEvent_{0};
+    alignas(cacheLine) std::atomic<std::uint32_t> spaceEvent_{0};
+
+    std::atomic<bool> closed_{false};
+    std::atomic<bool> cancelled_{false};
+
+    static void signal(std::atomic<std::uint32_t>& event) {
+        event.fetch_add(1, std::memory_order_release);
+        event.notify_one();
+    }
+
+  public:
+    explicit SpscRing(std::size_t capacity)
+        : mask_(std::bit_ceil(capacity < 2 ? std::size_t(2) : capacity) - 1),
+          slots_(new Slot[mask_ + 1]) {}
+
+    SpscRing(SpscRing const&) = delete;
+    SpscRing& operator=(SpscRing const&) = delete;
+
+    ~SpscRing() {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        for (std::size_t i = head_.load(std::memory_order_relaxed); i != tail;
+             ++i) {
+            slots_[i & mask_].get()->~T();
+        }
+    }
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+    // Producer side.
+
+    // Move up to 'n' elements from 'first' into the ring, returning the
+    // number moved.
+    template <typename It>
+    std::size_t tryPush(It first, std::size_t n) {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t free = capacity() - (tail - cachedHead_);
+        if (free < n) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            free        = capacity() - (tail - cachedHead_);
+        }
+        if (n > free) {
+            n = free;
+        }
+        if (n == 0) {
+            return 0;
+        }
+        for (std::size_t i = 0; i < n; ++i, ++first) {
+            ::new (slots_[(tail + i) & mask_].bytes) T(std::move(*first));
+        }
+        tail_.store(tail + n, std::memory_order_release);
+        signal(dataEvent_);
+        return n;
+    }
+
+    // Block until there is room for at least one element.  Returns 'false'
+    // if the consumer has cancelled.
+    bool waitForSpace() {
+        for (;;) {
+            std::uint32_t event = spaceEvent_.load(std::memory_order_acquire);
+            if (cancelled_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail_.load(std::memory_order_relaxed) - cachedHead_ <
+                capacity()) {
+                return true;
+            }
+            spaceEvent_.wait(event, std::memory_order_acquire);
+        }
+    }
+
+    void close() {
+        closed_.store(true, std::memory_order_release);
+        signal(dataEvent_);
+    }
+
+    bool cancelled() const {
+        return cancelled_.load(std::memory_order_acquire);
+    }
+
+    // Consumer side.
+
+    // Move up to 'max' elements out of the ring into 'out', returning the
+    // number moved.
+    template <typename OutputIt>
+    std::size_t tryPop(OutputIt out, std::size_t max) {
+        std::size_t head  = head_.load(std::memory_order_relaxed);
+        std::size_t avail = cachedTail_ - head;
+        if (avail < max) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            avail       = cachedTail_ - head;
+        }
+        std::size_t n = avail < max ? avail : max;
+        if (n == 0) {
+            return 0;
+        }
+        for (std::size_t i = 0; i < n; ++i, ++out) {
+            T* slot = slots_[(head + i) & mask_].get();
+            *out    = std::move(*slot);
+            slot->~T();
+        }
+        head_.store(head + n, std::memory_order_release);
+        signal(spaceEvent_);
+        return n;
+    }
+
+    // Block until there is at least one element to pop.  Returns 'false'
+    // once the producer has closed the ring and it has been drained.
+    bool waitForData() {
+        for (;;) {
+            std::uint32_t event = dataEvent_.load(std::memory_order_acquire);
+            bool          closed = closed_.load(std::memory_order_acquire);
+            cachedTail_          = tail_.load(std::memory_order_acquire);
+            if (cachedTail_ != head_.load(std::memory_order_relaxed)) {
+                return true;
+            }
+            if (closed) {
+                return false;
+            }
+            dataEvent_.wait(event, std::memory_order_acquire);
+        }
+    }
+
+    void cancel() {
+        cancelled_.store(true, std::memory_order_release);
+        signal(spaceEvent_);
+    }
+};
+
+} // namespace co_fun
+
+#endif
@@ -0,0 +1,99 @@
+#include <co_fun/ringbuffer.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace co_fun;
+
+TEST(Co_FunRingBufferTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunRingBufferTest, Breathing) {
+    SpscRing<int> ring(3);
+    EXPECT_EQ(4u, ring.capacity());
+
+    std::vector<int> in{1, 2, 3, 4, 5};
+    EXPECT_EQ(4u, ring.tryPush(in.begin(), in.size()));
+    EXPECT_EQ(0u, ring.tryPush(in.begin() + 4, 1));
+
+    std::vector<int> out;
+    EXPECT_EQ(2u, ring.tryPop(std::back_inserter(out), 2));
+    EXPECT_EQ(1u, ring.tryPush(in.begin() + 4, 1));
+    EXPECT_EQ(3u, ring.tryPop(std::back_inserter(out), 8));
+    EXPECT_EQ(in, out);
+    EXPECT_EQ(0u, ring.tryPop(std::back_inserter(out), 8));
+}
+
+TEST(Co_FunRingBufferTest, CloseDrains) {
+    SpscRing<std::string>    ring(8);
+    std::vector<std::string> in{"a", "b"};
+    ring.tryPush(in.begin(), in.size());
+    ring.close();
+
+    EXPECT_TRUE(ring.waitForData());
+    std::vector<std::string> out;
+    ring.tryPop(std::back_inserter(out), 8);
+    EXPECT_EQ((std::vector<std::string>{"a", "b"}), out);
+    EXPECT_FALSE(ring.waitForData());
+}
+
+TEST(Co_FunRingBufferTest, CancelReleasesProducer) {
+    SpscRing<int>    ring(2);
+    std::vector<int> in{1, 2};
+    ring.tryPush(in.begin(), in.size());
+
+    std::thread consumer([&ring]() { ring.cancel(); });
+    EXPECT_FALSE(ring.waitForSpace());
+    consumer.join();
+    EXPECT_TRUE(ring.cancelled());
+}
+
+TEST(Co_FunRingBufferTest, DestroysUnreadElements) {
+    auto p = std::make_shared<int>(7);
+    {
+        SpscRing<std::shared_ptr<int>> ring(4);
+        std::vector<std::shared_ptr<int>> in{p, p};
+        ring.tryPush(in.begin(), in.size());
+        in.clear();
+        EXPECT_EQ(3, p.use_count());
+    }
+    EXPECT_EQ(1, p.use_count());
+}
+
+TEST(Co_FunRingBufferTest, ProducerConsumer) {
+    constexpr int count = 100000;
+    SpscRing<int> ring(64);
+
+    std::thread producer([&ring]() {
+        std::vector<int> batch;
+        for (int i = 0; i < count; i += 16) {
+            batch.clear();
+            for (int j = i; j < i + 16 && j < count; ++j) {
+                batch.push_back(j);
+            }
+            std::size_t done = 0;
+            while (done < batch.size()) {
+                done += ring.tryPush(batch.begin() + done,
+                                     batch.size() - done);
+                if (done < batch.size()) {
+                    ASSERT_TRUE(ring.waitForSpace());
+                }
+            }
+        }
+        ring.close();
+    });
+
+    std::vector<int> out;
+    while (ring.waitForData()) {
+        ring.tryPop(std::back_inserter(out), 32);
+    }
+    producer.join();
+
+    ASSERT_EQ(static_cast<std::size_t>(count), out.size());
+    for (int i = 0; i < count; ++i) {
+        ASSERT_EQ(i, out[i]);
+    }
+}
@@ -0,0 +1,2 @@
+// serialize.cpp                                                      -*-C++-*-
+#include <co_fun/serialize.h>
@@ -0,0 +1,96 @@
+// serialize.h                                                        -*-C++-*-
+#ifndef INCLUDED_CO_FUN_SERIALIZE
+#define INCLUDED_CO_FUN_SERIALIZE
+
+//@PURPOSE: Provide a trait for writing stream elements as byte records.
+//
+//@CLASSES:
+//  co_fun::Serialize: size, write and read of one element as a record
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: Components that move elements out of the process's heap,
+// into shared memory or onto disk, go through 'Serialize<T>'.  It gives
+// the size of the record an element needs, writes the element into that
+// many bytes, and reads it back from exactly those bytes.  The reader is
+// given the record's length, so a record need not describe its own size.
+//
+// Trivially copyable types are their own representation: they are copied
+// in and out with no encoding.  'std::string' and 'Chunk' are written as
+// their bytes.  Other types need a specialization:
+//
+//..
+//  template <>
+//  struct co_fun::Serialize<Order> {
+//      static std::size_t size(Order const& order);
+//      static void        write(Order const& order, char* out);
+//      static Order       read(std::string_view record);
+//  };
+//..
+//
+// A record is only read back by the same program that wrote it, so the
+// representation need not be portable.
+
+#include <co_fun/bufferpool.h>
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace co_fun {
+
+template <typename T, typename = void>
+struct Serialize;
+
+template <typename T>
+struct Serialize<T,
+                 typename std::enable_if<
+                     std::is_trivially_copyable<T>::value>::type> {
+    static std::size_t size(T const&) { return sizeof(T); }
+
+    static void write(T const& value, char* out) {
+        std::memcpy(out, &value, sizeof(T));
+    }
+
+    static T read(std::string_view record) {
+        std::array<char, sizeof(T)> bytes;
+        std::memcpy(bytes.data(), record.data(), sizeof(T));
+        return std::bit_cast<T>(bytes);
+    }
+};
+
+template <>
+struct Serialize<std::string> {
+    static std::size_t size(std::string const& value) {
+        return value.size();
+    }
+
+    static void write(std::string const& value, char* out) {
+        std::memcpy(out, value.data(), value.size());
+    }
+
+    static std::string read(std::string_view record) {
+        return std::string(record);
+    }
+};
+
+template <>
+struct Serialize<Chunk> {
+    static std::size_t size(Chunk const& value) { return value.size(); }
+
+    static void write(Chunk const& value, char* out) {
+        std::memcpy(out, value.data(), value.size());
+    }
+
+    static Chunk read(std::string_view record) {
+        return Chunk::copyOf(record);
+    }
+};
+
+} // namespace co_fun
+
+#endif
@@ -0,0 +1,40 @@
+#include <co_fun/serialize.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace co_fun;
+
+namespace {
+template <typename Value>
+Value roundTrip(Value const& value) {
+    std::vector<char> record(Serialize<Value>::size(value));
+    Serialize<Value>::write(value, record.data());
+    return Serialize<Value>::read(
+        std::string_view(record.data(), record.size()));
+}
+
+struct Pair {
+    int    first;
+    double second;
+
+    friend bool operator==(Pair const&, Pair const&) = default;
+};
+} // namespace
+
+TEST(Co_FunSerializeTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunSerializeTest, TriviallyCopyable) {
+    EXPECT_EQ(sizeof(Pair), Serialize<Pair>::size(Pair{1, 2.0}));
+    EXPECT_EQ((Pair{1, 2.0}), roundTrip(Pair{1, 2.0}));
+    EXPECT_EQ(-7, roundTrip(-7));
+}
+
+TEST(Co_FunSerializeTest, Strings) {
+    EXPECT_EQ(5u, Serialize<std::string>::size("hello"));
+    EXPECT_EQ("hello", roundTrip(std::string("hello")));
+    EXPECT_EQ("", roundTrip(std::string()));
+    EXPECT_EQ("bytes", roundTrip(Chunk::copyOf("bytes")).view());
+}
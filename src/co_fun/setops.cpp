@@ -0,0 +1,2 @@
+// setops.cpp                                                         -*-C++-*-
+#include <co_fun/setops.h>
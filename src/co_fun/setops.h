@@ -0,0 +1,499 @@
+// setops.h                                                           -*-C++-*-
+#ifndef INCLUDED_CO_FUN_SETOPS
+#define INCLUDED_CO_FUN_SETOPS
+
+//@PURPOSE: Provide lazy set operations and merge join over sorted streams.
+//
+//@CLASSES:
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: 'setUnion(first, second, cmp)', 'setIntersection(first,
+// second, cmp)' and 'setDifference(first, second, cmp)' are the lazy
+// counterparts of 'std::set_union', 'std::set_intersection' and
+// 'std::set_difference' over streams sorted by 'cmp', which defaults to
+// 'std::less'.  As with the standard algorithms, the inputs may hold
+// repeated elements: an element 'n' times in 'first' and 'm' times in
+// 'second' is in the union 'max(n, m)' times, in the intersection 'min(n,
+// m)' times and in the difference 'max(n - m, 0)' times, and elements that
+// are in both are taken from 'first'.
+//
+// 'mergeJoin(left, right, keyOf)' is the inner equi-join of two streams
+// sorted by key: the stream of 'std::pair<Left, Right>' for every pair of
+// elements with equal keys, in the order of 'left', then of 'right'.  It
+// holds only the elements of 'right' with the current key, where
+// 'hashJoin', in 'co_fun/relational.h', holds the whole of its build side.
+// 'mergeJoin(left, right, leftKey, rightKey)' takes a key function for
+// each side.
+//
+// 'setUnionChunks', 'setIntersectionChunks' and 'setDifferenceChunks' do
+// the same for streams of sorted chunks, 'std::vector's whose
+// concatenation is sorted, as 'mergeChunks' in 'co_fun/merge.h' takes,
+// producing chunks of up to 'chunkSize' elements.  Where one input is
+// behind the other, they gallop: probe 1, 2, 4, 8, ... elements ahead for
+// the first that is not behind, then binary search the last step, and pass
+// over a chunk whose last element is behind without looking inside it.
+// Skipping 'n' elements costs 'O(log n)' comparisons, so intersecting a
+// short posting list with a long one costs little more than reading the
+// short one, and the runs that pass into a union or difference are copied
+// in bulk.
+//..
+//  auto both = setIntersectionChunks(postings("coroutine"),
+//                                    postings("the"));
+//..
+//
+// As with 'filter', whether the intersection, difference, join or a chunk
+// operation is empty is known when it is made, so making it, or forcing a
+// cell, reads the inputs up to the result after.  The cells of a chunk
+// operation share its position in the inputs, and must be forced from one
+// thread at a time.
+
+#include <co_fun/stream.h>
+#include <co_fun/suspension.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace co_fun {
+
+namespace detail {
+
+// The first position in the sorted range '[first, last)' not less than
+// 'target', found by probing at distances 1, 2, 4, ... from 'first', so
+// that the cost grows with the distance to the answer, not with the range.
+template <typename Iterator, typename Value, typename Compare>
+Iterator gallop(Iterator       first,
+                Iterator       last,
+                Value const&   target,
+                Compare const& cmp) {
+    std::size_t step = 1;
+    Iterator    low  = first;
+    while (step <= std::size_t(last - low) && cmp(low[step - 1], target)) {
+        low += step;
+        step *= 2;
+    }
+    Iterator high = step <= std::size_t(last - low) ? low + step : last;
+    return std::lower_bound(low, high, target, cmp);
+}
+
+template <typename Value, typename Suspension, typename Compare>
+ConsStream<Value, Suspension> unionFrom(ConsStream<Value, Suspension> first,
+                                        ConsStream<Value, Suspension> second,
+                                        Compare const&                cmp) {
+    if (first.isEmpty()) {
+        return second;
+    }
+    if (second.isEmpty()) {
+        return first;
+    }
+    return ConsStream<Value, Suspension>([first, second, cmp]() {
+        Value a = first.head();
+        Value b = second.head();
+        if (cmp(b, a)) {
+            return ConsCell<Value, Suspension>(
+                b, unionFrom(first, second.tail(), cmp));
+        }
+        return ConsCell<Value, Suspension>(
+            a,
+            unionFrom(first.tail(),
+                      cmp(a, b) ? second : second.tail(),
+                      cmp));
+    });
+}
+
+template <typename Value, typename Suspension, typename Compare>
+ConsStream<Value, Suspension>
+intersectionFrom(ConsStream<Value, Suspension> first,
+                 ConsStream<Value, Suspension> second,
+                 Compare const&                cmp) {
+    while (!first.isEmpty() && !second.isEmpty()) {
+        Value a = first.head();
+        Value b = second.head();
+        if (cmp(a, b)) {
+            first = first.tail();
+        } else if (cmp(b, a)) {
+            second = second.tail();
+        } else {
+            return ConsStream<Value, Suspension>([first, second, cmp]() {
+                return ConsCell<Value, Suspension>(
+                    first.head(),
+                    intersectionFrom(first.tail(), second.tail(), cmp));
+            });
+        }
+    }
+    return ConsStream<Value, Suspension>();
+}
+
+template <typename Value, typename Suspension, typename Compare>
+ConsStream<Value, Suspension>
+differenceFrom(ConsStream<Value, Suspension> first,
+               ConsStream<Value, Suspension> second,
+               Compare const&                cmp) {
+    while (!first.isEmpty() && !second.isEmpty()) {
+        Value a = first.head();
+        Value b = second.head();
+        if (cmp(a, b)) {
+            break;
+        }
+        if (!cmp(b, a)) {
+            first = first.tail();
+        }
+        second = second.tail();
+    }
+    if (first.isEmpty() || second.isEmpty()) {
+        return first;
+    }
+    return ConsStream<Value, Suspension>([first, second, cmp]() {
+        return ConsCell<Value, Suspension>(
+            first.head(), differenceFrom(first.tail(), second, cmp));
+    });
+}
+
+template <typename LeftKey, typename RightKey>
+struct MergeJoin {
+    LeftKey  leftKey;
+    RightKey rightKey;
+};
+
+template <typename Join, typename Left, typename Right, typename Suspension>
+ConsStream<std::pair<Left, Right>, Suspension>
+mergeJoinFrom(Join const&                   join,
+              ConsStream<Left, Suspension>  left,
+              ConsStream<Right, Suspension> right);
+
+// The pairs of the elements of 'left' with the key of 'run', from 'row' of
+// 'run' on, then the join of the rest.
+template <typename Join, typename Left, typename Right, typename Suspension>
+ConsStream<std::pair<Left, Right>, Suspension>
+runFrom(Join const&                               join,
+        ConsStream<Left, Suspension>              left,
+        std::shared_ptr<std::vector<Right> const> run,
+        std::size_t                               row,
+        ConsStream<Right, Suspension>             right) {
+    using Result = std::pair<Left, Right>;
+    if (row == run->size()) {
+        left = left.tail();
+        if (left.isEmpty()) {
+            return ConsStream<Result, Suspension>();
+        }
+        auto l = join.leftKey(left.head());
+        auto r = join.rightKey(run->front());
+        if (l < r || r < l) {
+            return mergeJoinFrom(join, left, right);
+        }
+        row = 0;
+    }
+    return ConsStream<Result, Suspension>([join, left, run, row, right]() {
+        return ConsCell<Result, Suspension>(
+            Result(left.head(), (*run)[row]),
+            runFrom(join, left, run, row + 1, right));
+    });
+}
+
+template <typename Join, typename Left, typename Right, typename Suspension>
+ConsStream<std::pair<Left, Right>, Suspension>
+mergeJoinFrom(Join const&                   join,
+              ConsStream<Left, Suspension>  left,
+              ConsStream<Right, Suspension> right) {
+    while (!left.isEmpty() && !right.isEmpty()) {
+        auto l = join.leftKey(left.head());
+        auto r = join.rightKey(right.head());
+        if (l < r) {
+            left = left.tail();
+        } else if (r < l) {
+            right = right.tail();
+        } else {
+            auto run = std::make_shared<std::vector<Right>>();
+            while (!right.isEmpty() && !(l < join.rightKey(right.head()))) {
+                run->push_back(right.head());
+                right = right.tail();
+            }
+            return runFrom(join,
+                           left,
+                           std::shared_ptr<std::vector<Right> const>(run),
+                           0,
+                           right);
+        }
+    }
+    return ConsStream<std::pair<Left, Right>, Suspension>();
+}
+
+// A position in a stream of sorted chunks.
+template <typename Value, typename Suspension>
+struct ChunkCursor {
+    using Chunk = std::vector<Value>;
+
+    ConsStream<Chunk, Suspension> rest;
+    Chunk                         chunk;
+    std::size_t                   pos = 0;
+
+    explicit ChunkCursor(ConsStream<Chunk, Suspension> stream)
+        : rest(std::move(stream)) {
+        refill();
+    }
+
+    // Move to the next chunk with elements in it, if this one is used up.
+    void refill() {
+        while (pos == chunk.size() && !rest.isEmpty()) {
+            chunk = rest.head();
+            pos   = 0;
+            rest  = rest.tail();
+        }
+    }
+
+    bool done() const { return pos == chunk.size(); }
+
+    Value const& head() const { return chunk[pos]; }
+
+    void advance() {
+        ++pos;
+        refill();
+    }
+
+    // The end of the elements of this chunk less than 'target'.
+    template <typename Compare>
+    std::size_t before(Value const& target, Compare const& cmp) const {
+        return gallop(chunk.begin() + pos, chunk.end(), target, cmp) -
+               chunk.begin();
+    }
+
+    // Pass over the elements less than 'target', a chunk at a time while
+    // whole chunks are.
+    template <typename Compare>
+    void seek(Value const& target, Compare const& cmp) {
+        while (!done() && cmp(chunk.back(), target)) {
+            pos = chunk.size();
+            refill();
+        }
+        if (!done()) {
+            pos = before(target, cmp);
+        }
+    }
+
+    // Copy up to 'room' elements, ending before 'end', to 'out'.
+    void copy(std::size_t end, std::size_t room, Chunk& out) {
+        if (end - pos > room) {
+            end = pos + room;
+        }
+        out.insert(out.end(), chunk.begin() + pos, chunk.begin() + end);
+        pos = end;
+        refill();
+    }
+};
+
+enum class SetOp { setUnion, setIntersection, setDifference };
+
+template <typename Value, typename Suspension, typename Compare>
+class ChunkSetOp {
+    using Chunk = std::vector<Value>;
+
+    SetOp                          op_;
+    ChunkCursor<Value, Suspension> first_;
+    ChunkCursor<Value, Suspension> second_;
+    Compare                        cmp_;
+    std::size_t                    chunkSize_;
+
+    // Add to 'out' up to 'chunkSize_' elements; returns false if the
+    // result is finished.
+    bool step(Chunk& out) {
+        std::size_t room = chunkSize_ - out.size();
+        if (first_.done() || second_.done()) {
+            ChunkCursor<Value, Suspension>& left =
+                first_.done() ? second_ : first_;
+            bool keep = op_ == SetOp::setUnion ||
+                        (op_ == SetOp::setDifference && !first_.done());
+            if (left.done() || !keep) {
+                return false;
+            }
+            left.copy(left.chunk.size(), room, out);
+            return true;
+        }
+        Value const& a = first_.head();
+        Value const& b = second_.head();
+        if (cmp_(a, b)) {
+            if (op_ == SetOp::setIntersection) {
+                first_.seek(b, cmp_);
+            } else {
+                first_.copy(first_.before(b, cmp_), room, out);
+            }
+        } else if (cmp_(b, a)) {
+            if (op_ == SetOp::setUnion) {
+                second_.copy(second_.before(a, cmp_), room, out);
+            } else {
+                second_.seek(a, cmp_);
+            }
+        } else {
+            if (op_ != SetOp::setDifference) {
+                out.push_back(a);
+            }
+            first_.advance();
+            second_.advance();
+        }
+        return true;
+    }
+
+  public:
+    ChunkSetOp(SetOp                         op,
+               ConsStream<Chunk, Suspension> first,
+               ConsStream<Chunk, Suspension> second,
+               Compare                       cmp,
+               std::size_t                   chunkSize)
+        : op_(op),
+          first_(std::move(first)),
+          second_(std::move(second)),
+          cmp_(std::move(cmp)),
+          chunkSize_(chunkSize) {}
+
+    // The next chunk of the result, empty once it is finished.
+    Chunk pop() {
+        Chunk out;
+        out.reserve(chunkSize_);
+        while (out.size() < chunkSize_ && step(out)) {
+        }
+        return out;
+    }
+};
+
+template <typename Value, typename Suspension, typename Compare>
+ConsStream<std::vector<Value>, Suspension>
+setOpFrom(std::shared_ptr<ChunkSetOp<Value, Suspension, Compare>> op) {
+    using Chunk = std::vector<Value>;
+    Chunk chunk = op->pop();
+    if (chunk.empty()) {
+        return ConsStream<Chunk, Suspension>();
+    }
+    return ConsStream<Chunk, Suspension>([op, chunk]() {
+        return ConsCell<Chunk, Suspension>(chunk, setOpFrom(op));
+    });
+}
+
+template <typename Value, typename Suspension, typename Compare>
+ConsStream<std::vector<Value>, Suspension>
+chunkSetOp(SetOp                                      op,
+           ConsStream<std::vector<Value>, Suspension> first,
+           ConsStream<std::vector<Value>, Suspension> second,
+           Compare                                    cmp,
+           std::size_t                                chunkSize) {
+    if (chunkSize == 0) {
+        throw std::invalid_argument("chunkSize must be positive");
+    }
+    return setOpFrom(
+        std::make_shared<ChunkSetOp<Value, Suspension, Compare>>(
+            op,
+            std::move(first),
+            std::move(second),
+            std::move(cmp),
+            chunkSize));
+}
+
+} // namespace detail
+
+// ============================================================================
+//              INLINE FUNCTION AND FUNCTION TEMPLATE DEFINITIONS
+// ============================================================================
+
+template <typename Value,
+          typename Suspension,
+          typename Compare = std::less<Value>>
+ConsStream<Value, Suspension> setUnion(ConsStream<Value, Suspension> first,
+                                       ConsStream<Value, Suspension> second,
+                                       Compare cmp = {}) {
+    return detail::unionFrom(std::move(first), std::move(second), cmp);
+}
+
+template <typename Value,
+          typename Suspension,
+          typename Compare = std::less<Value>>
+ConsStream<Value, Suspension>
+setIntersection(ConsStream<Value, Suspension> first,
+                ConsStream<Value, Suspension> second,
+                Compare                       cmp = {}) {
+    return detail::intersectionFrom(std::move(first), std::move(second), cmp);
+}
+
+template <typename Value,
+          typename Suspension,
+          typename Compare = std::less<Value>>
+ConsStream<Value, Suspension>
+setDifference(ConsStream<Value, Suspension> first,
+              ConsStream<Value, Suspension> second,
+              Compare                       cmp = {}) {
+    return detail::differenceFrom(std::move(first), std::move(second), cmp);
+}
+
+template <typename Left,
+          typename Right,
+          typename Suspension,
+          typename LeftKey,
+          typename RightKey>
+ConsStream<std::pair<Left, Right>, Suspension>
+mergeJoin(ConsStream<Left, Suspension>  left,
+          ConsStream<Right, Suspension> right,
+          LeftKey                       leftKey,
+          RightKey                      rightKey) {
+    detail::MergeJoin<LeftKey, RightKey> join{std::move(leftKey),
+                                              std::move(rightKey)};
+    return detail::mergeJoinFrom(join, std::move(left), std::move(right));
+}
+
+template <typename Left, typename Right, typename Suspension, typename KeyOf>
+ConsStream<std::pair<Left, Right>, Suspension>
+mergeJoin(ConsStream<Left, Suspension>  left,
+          ConsStream<Right, Suspension> right,
+          KeyOf                         keyOf) {
+    return mergeJoin(std::move(left), std::move(right), keyOf, keyOf);
+}
+
+template <typename Value,
+          typename Suspension,
+          typename Compare = std::less<Value>>
+ConsStream<std::vector<Value>, Suspension>
+setUnionChunks(ConsStream<std::vector<Value>, Suspension> first,
+               ConsStream<std::vector<Value>, Suspension> second,
+               Compare                                    cmp       = {},
+               std::size_t                                chunkSize = 1024) {
+    return detail::chunkSetOp(detail::SetOp::setUnion,
+                              std::move(first),
+                              std::move(second),
+                              std::move(cmp),
+                              chunkSize);
+}
+
+template <typename Value,
+          typename Suspension,
+          typename Compare = std::less<Value>>
+ConsStream<std::vector<Value>, Suspension>
+setIntersectionChunks(ConsStream<std::vector<Value>, Suspension> first,
+                      ConsStream<std::vector<Value>, Suspension> second,
+                      Compare                                    cmp = {},
+                      std::size_t chunkSize = 1024) {
+    return detail::chunkSetOp(detail::SetOp::setIntersection,
+                              std::move(first),
+                              std::move(second),
+                              std::move(cmp),
+                              chunkSize);
+}
+
+template <typename Value,
+          typename Suspension,
+          typename Compare = std::less<Value>>
+ConsStream<std::vector<Value>, Suspension>
+setDifferenceChunks(ConsStream<std::vector<Value>, Suspension> first,
+                    ConsStream<std::vector<Value>, Suspension> second,
+                    Compare                                    cmp = {},
+                    std::size_t chunkSize = 1024) {
+    return detail::chunkSetOp(detail::SetOp::setDifference,
+                              std::move(first),
+                              std::move(second),
+                              std::move(cmp),
+                              chunkSize);
+}
+
+} // namespace co_fun
+
+#endif
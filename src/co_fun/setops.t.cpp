@@ -0,0 +1,228 @@
+#include <co_fun/setops.h>
+#include <co_fun/stream.t.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace co_fun;
+
+namespace {
+using test::fromVector;
+using test::collect;
+
+std::vector<int> flatten(ConsStream<std::vector<int>> chunks) {
+    std::vector<int> result;
+    for (; !chunks.isEmpty(); chunks = chunks.tail()) {
+        std::vector<int> chunk = chunks.head();
+        result.insert(result.end(), chunk.begin(), chunk.end());
+    }
+    return result;
+}
+
+// The sorted 'values', in chunks of 'size'.
+ConsStream<std::vector<int>> chunked(std::vector<int> const& values,
+                                     std::size_t             size) {
+    std::vector<std::vector<int>> chunks;
+    for (std::size_t i = 0; i < values.size(); i += size) {
+        std::size_t end = std::min(values.size(), i + size);
+        chunks.emplace_back(values.begin() + i, values.begin() + end);
+    }
+    return fromVector(chunks);
+}
+
+// The multiples of 'step' below 'end', from 'from', in chunks of 'size'.
+ConsStream<std::vector<int>> multiples(int step, int end, int size, int from) {
+    if (from >= end) {
+        return ConsStream<std::vector<int>>();
+    }
+    return ConsStream<std::vector<int>>([step, end, size, from]() {
+        std::vector<int> chunk;
+        int              i = from;
+        for (; i < end && int(chunk.size()) < size; i += step) {
+            chunk.push_back(i);
+        }
+        return ConsCell<std::vector<int>>(chunk,
+                                          multiples(step, end, size, i));
+    });
+}
+
+// Sorted values in '[0, range)', with repeats.
+std::vector<int> sortedRandom(unsigned seed, int count, int range) {
+    std::vector<int> result;
+    for (int i = 0; i < count; ++i) {
+        seed = seed * 1103515245 + 12345;
+        result.push_back(int((seed >> 8) % unsigned(range)));
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+struct Counting {
+    int* count;
+
+    bool operator()(int a, int b) const {
+        ++*count;
+        return a < b;
+    }
+};
+} // namespace
+
+TEST(Co_FunSetOpsTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunSetOpsTest, Breathing) {
+    auto a = fromVector<int>({1, 2, 2, 4, 6, 8});
+    auto b = fromVector<int>({2, 3, 4, 4, 8, 9});
+    EXPECT_EQ((std::vector<int>{1, 2, 2, 3, 4, 4, 6, 8, 9}),
+              collect(setUnion(a, b)));
+    EXPECT_EQ((std::vector<int>{2, 4, 8}), collect(setIntersection(a, b)));
+    EXPECT_EQ((std::vector<int>{1, 2, 6}), collect(setDifference(a, b)));
+    EXPECT_EQ((std::vector<int>{3, 4, 9}), collect(setDifference(b, a)));
+}
+
+TEST(Co_FunSetOpsTest, Empty) {
+    auto a = fromVector<int>({1, 2});
+    auto e = ConsStream<int>();
+    EXPECT_EQ((std::vector<int>{1, 2}), collect(setUnion(e, a)));
+    EXPECT_TRUE(setIntersection(a, e).isEmpty());
+    EXPECT_TRUE(setIntersection(a, fromVector<int>({0, 3})).isEmpty());
+    EXPECT_EQ((std::vector<int>{1, 2}), collect(setDifference(a, e)));
+    EXPECT_TRUE(setDifference(e, a).isEmpty());
+    EXPECT_TRUE(setDifference(a, a).isEmpty());
+}
+
+TEST(Co_FunSetOpsTest, MatchesStandard) {
+    for (unsigned seed : {1u, 2u, 3u}) {
+        auto x = sortedRandom(seed, 300, 200);
+        auto y = sortedRandom(seed + 10, 200, 300);
+        std::vector<int> expected;
+        std::set_union(x.begin(), x.end(), y.begin(), y.end(),
+                       std::back_inserter(expected));
+        EXPECT_EQ(expected, collect(setUnion(fromVector(x), fromVector(y))));
+        expected.clear();
+        std::set_intersection(x.begin(), x.end(), y.begin(), y.end(),
+                              std::back_inserter(expected));
+        EXPECT_EQ(expected,
+                  collect(setIntersection(fromVector(x), fromVector(y))));
+        expected.clear();
+        std::set_difference(x.begin(), x.end(), y.begin(), y.end(),
+                            std::back_inserter(expected));
+        EXPECT_EQ(expected,
+                  collect(setDifference(fromVector(x), fromVector(y))));
+    }
+}
+
+TEST(Co_FunSetOpsTest, InfiniteInputs) {
+    auto evens  = filter([](int x) { return x % 2 == 0; }, iota(0));
+    auto threes = filter([](int x) { return x % 3 == 0; }, iota(0));
+    EXPECT_EQ((std::vector<int>{0, 6, 12, 18}),
+              collect(take(setIntersection(evens, threes), 4)));
+    EXPECT_EQ((std::vector<int>{0, 2, 3, 4, 6, 8}),
+              collect(take(setUnion(evens, threes), 6)));
+    EXPECT_EQ((std::vector<int>{2, 4, 8, 10}),
+              collect(take(setDifference(evens, threes), 4)));
+}
+
+TEST(Co_FunSetOpsTest, MergeJoin) {
+    using Row   = std::pair<int, std::string>;
+    auto left   = fromVector<Row>({{1, "a"}, {2, "b"}, {2, "c"}, {5, "d"}});
+    auto right  = fromVector<int>({0, 2, 2, 3, 5, 5});
+    auto joined = collect(mergeJoin(
+        left,
+        right,
+        [](Row const& r) { return r.first; },
+        [](int x) { return x; }));
+    ASSERT_EQ(6u, joined.size());
+    std::string names;
+    for (auto const& [row, key] : joined) {
+        EXPECT_EQ(row.first, key);
+        names += row.second;
+    }
+    EXPECT_EQ("bbccdd", names);
+}
+
+TEST(Co_FunSetOpsTest, MergeJoinOneKey) {
+    auto joined = collect(mergeJoin(
+        rangeFrom(1, 20), rangeFrom(5, 30), [](int x) { return x / 10; }));
+    // Keys 0, 1 and 2 pair 9 * 5, 10 * 10 and 1 * 10 elements.
+    EXPECT_EQ(155u, joined.size());
+    EXPECT_EQ(std::make_pair(1, 5), joined.front());
+    EXPECT_EQ(std::make_pair(20, 29), joined.back());
+    EXPECT_TRUE(mergeJoin(rangeFrom(1, 5), rangeFrom(6, 9), [](int x) {
+                    return x;
+                }).isEmpty());
+}
+
+TEST(Co_FunSetOpsTest, Gallop) {
+    std::vector<int> v{1, 3, 5, 7, 9, 11, 13, 15, 17};
+    for (int target = 0; target < 20; ++target) {
+        EXPECT_EQ(std::lower_bound(v.begin(), v.end(), target),
+                  detail::gallop(v.begin(), v.end(), target, std::less<>()))
+            << target;
+    }
+}
+
+TEST(Co_FunSetOpsTest, ChunksMatchStandard) {
+    for (std::size_t size : {1, 3, 64}) {
+        auto x = sortedRandom(7, 500, 400);
+        auto y = sortedRandom(8, 300, 600);
+        std::vector<int> expected;
+        std::set_union(x.begin(), x.end(), y.begin(), y.end(),
+                       std::back_inserter(expected));
+        EXPECT_EQ(expected,
+                  flatten(setUnionChunks(chunked(x, size),
+                                         chunked(y, size),
+                                         std::less<int>(),
+                                         size)));
+        expected.clear();
+        std::set_intersection(x.begin(), x.end(), y.begin(), y.end(),
+                              std::back_inserter(expected));
+        EXPECT_EQ(expected,
+                  flatten(setIntersectionChunks(chunked(x, size),
+                                                chunked(y, size))));
+        expected.clear();
+        std::set_difference(x.begin(), x.end(), y.begin(), y.end(),
+                            std::back_inserter(expected));
+        EXPECT_EQ(expected,
+                  flatten(setDifferenceChunks(chunked(x, size),
+                                              chunked(y, size))));
+    }
+}
+
+TEST(Co_FunSetOpsTest, ChunkSizes) {
+    auto all = setUnionChunks(multiples(2, 1000, 7, 0),
+                              multiples(3, 1000, 11, 0),
+                              std::less<int>(),
+                              100);
+    for (auto s = all; !s.isEmpty(); s = s.tail()) {
+        EXPECT_GE(100u, s.head().size());
+        EXPECT_FALSE(s.head().empty());
+    }
+    EXPECT_EQ(667u, flatten(all).size());
+    EXPECT_THROW(setUnionChunks(all, all, std::less<int>(), 0),
+                 std::invalid_argument);
+}
+
+TEST(Co_FunSetOpsTest, GallopingSkipsRuns) {
+    // A short list against a million elements takes few comparisons.
+    int              count = 0;
+    std::vector<int> rare{5, 250000, 250001, 600000, 999998};
+    auto             both = setIntersectionChunks(
+        chunked(rare, 2), multiples(2, 1000000, 4096, 0), Counting{&count});
+    EXPECT_EQ((std::vector<int>{250000, 600000, 999998}), flatten(both));
+    EXPECT_GT(2000, count);
+}
+
+TEST(Co_FunSetOpsTest, DifferenceCopiesRuns) {
+    int  count = 0;
+    auto rest  = setDifferenceChunks(multiples(1, 100000, 1000, 0),
+                                     chunked({10, 50000}, 1),
+                                     Counting{&count},
+                                     100000);
+    EXPECT_EQ(99998u, flatten(rest).size());
+    EXPECT_GT(1000, count);
+}
@@ -0,0 +1,333 @@
+// shmring.cpp                                                        -*-C++-*-
+#include <co_fun/shmring.h>
+
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <climits>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace co_fun {
+
+namespace {
+std::system_error systemError(char const* what) {
+    return std::system_error(errno, std::generic_category(), what);
+}
+
+constexpr std::uint64_t magic        = 0x636f5f66756e5247; // "co_funRG"
+constexpr std::size_t   headerSize   = 4096;
+constexpr std::size_t   cacheLine    = 64;
+constexpr std::uint64_t recordHeader = sizeof(std::uint64_t);
+constexpr std::uint64_t wrapMarker   = ~std::uint64_t(0);
+
+constexpr int producerSide = 0;
+constexpr int consumerSide = 1;
+
+std::uint64_t roundUp(std::uint64_t size) {
+    return (size + recordHeader - 1) & ~(recordHeader - 1);
+}
+
+// Returns 'false' if the wait timed out.
+bool futexWait(std::atomic<std::uint32_t>& word,
+               std::uint32_t               expected,
+               std::chrono::milliseconds   interval) {
+    timespec timeout{time_t(interval.count() / 1000),
+                     long(interval.count() % 1000) * 1000000};
+    long     result = ::syscall(SYS_futex,
+                            reinterpret_cast<std::uint32_t*>(&word),
+                            FUTEX_WAIT,
+                            expected,
+                            &timeout,
+                            nullptr,
+                            0);
+    return result == 0 || errno != ETIMEDOUT;
+}
+
+void futexWake(std::atomic<std::uint32_t>& word) {
+    word.fetch_add(1, std::memory_order_seq_cst);
+    ::syscall(SYS_futex,
+              reinterpret_cast<std::uint32_t*>(&word),
+              FUTEX_WAKE,
+              INT_MAX,
+              nullptr,
+              nullptr,
+              0);
+}
+} // namespace
+
+// Shared by both processes; everything here must be address free.
+struct ShmRing::Header {
+    std::uint64_t magic;
+    std::uint64_t capacity;
+
+    alignas(cacheLine) std::atomic<std::uint64_t> head;
+    std::atomic<std::uint32_t> consumerWaiting;
+    std::atomic<std::uint32_t> spaceEvent;
+    std::atomic<std::int32_t>  consumerPid;
+    std::atomic<std::uint32_t> cancelled;
+
+    alignas(cacheLine) std::atomic<std::uint64_t> tail;
+    std::atomic<std::uint32_t> producerWaiting;
+    std::atomic<std::uint32_t> dataEvent;
+    std::atomic<std::int32_t>  producerPid;
+    std::atomic<std::uint32_t> closed;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free &&
+                  std::atomic<std::uint32_t>::is_always_lock_free,
+              "shared memory atomics must be lock free");
+
+ShmRing::ShmRing(int                       fd,
+                 std::size_t               capacity,
+                 bool                      initialize,
+                 std::chrono::milliseconds livenessInterval)
+    : fd_(fd),
+      capacity_(capacity),
+      mapSize_(headerSize + capacity),
+      livenessInterval_(livenessInterval) {
+    static_assert(sizeof(Header) <= headerSize);
+    void* map = ::mmap(
+        nullptr, mapSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        auto error = systemError("mmap");
+        ::close(fd_);
+        throw error;
+    }
+    header_ = static_cast<Header*>(map);
+    data_   = static_cast<char*>(map) + headerSize;
+    if (initialize) {
+        // A new memfd is zero filled, which is every index and flag at its
+        // starting value.
+        header_->capacity = capacity_;
+        header_->magic    = magic;
+    } else if (header_->magic != magic || header_->capacity != capacity_) {
+        ::munmap(map, mapSize_);
+        ::close(fd_);
+        throw std::invalid_argument("not a ShmRing");
+    }
+    tail_ = pendingTail_ = cachedTail_ = header_->tail.load();
+    head_ = pendingHead_ = cachedHead_ = header_->head.load();
+}
+
+std::shared_ptr<ShmRing>
+ShmRing::create(std::size_t               capacity,
+                std::chrono::milliseconds livenessInterval) {
+    capacity = std::bit_ceil(capacity < headerSize ? headerSize : capacity);
+    int fd   = ::memfd_create("co_fun::ShmRing", MFD_CLOEXEC);
+    if (fd < 0) {
+        throw systemError("memfd_create");
+    }
+    if (::ftruncate(fd, off_t(headerSize + capacity)) != 0) {
+        auto error = systemError("ftruncate");
+        ::close(fd);
+        throw error;
+    }
+    return std::shared_ptr<ShmRing>(
+        new ShmRing(fd, capacity, true, livenessInterval));
+}
+
+std::shared_ptr<ShmRing>
+ShmRing::attach(int fd, std::chrono::milliseconds livenessInterval) {
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+        auto error = systemError("fstat");
+        ::close(fd);
+        throw error;
+    }
+    std::size_t size = std::size_t(status.st_size);
+    if (size <= headerSize || !std::has_single_bit(size - headerSize)) {
+        ::close(fd);
+        throw std::invalid_argument("not a ShmRing");
+    }
+    return std::shared_ptr<ShmRing>(
+        new ShmRing(fd, size - headerSize, false, livenessInterval));
+}
+
+ShmRing::~ShmRing() {
+    ::munmap(header_, mapSize_);
+    ::close(fd_);
+}
+
+// Each side holds a record lock on its own byte of the descriptor.  The
+// kernel drops it when the process exits, even before it is reaped, which
+// is how the other side can tell a peer that has gone from one that is
+// slow.
+void ShmRing::claim(int side) {
+    flock lock{};
+    lock.l_type   = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    lock.l_start  = side;
+    lock.l_len    = 1;
+    ::fcntl(fd_, F_SETLK, &lock);
+    auto& pid = side == producerSide ? header_->producerPid
+                                     : header_->consumerPid;
+    pid.store(::getpid(), std::memory_order_seq_cst);
+}
+
+bool ShmRing::peerGone(int side) const {
+    auto const& pidOf = side == producerSide ? header_->producerPid
+                                             : header_->consumerPid;
+    pid_t pid = pidOf.load(std::memory_order_seq_cst);
+    if (pid == 0 || pid == ::getpid()) {
+        // Not started yet, or a thread of this process; record locks do
+        // not conflict within a process.
+        return false;
+    }
+    flock lock{};
+    lock.l_type   = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    lock.l_start  = side;
+    lock.l_len    = 1;
+    return ::fcntl(fd_, F_GETLK, &lock) == 0 && lock.l_type == F_UNLCK;
+}
+
+bool ShmRing::waitForSpace(std::uint64_t need) {
+    for (;;) {
+        if (tail_ + need - cachedHead_ <= capacity_) {
+            return true;
+        }
+        cachedHead_ = header_->head.load(std::memory_order_acquire);
+        if (tail_ + need - cachedHead_ <= capacity_) {
+            return true;
+        }
+        if (cancelled()) {
+            return false;
+        }
+
+        // Raise the flag before looking again, so that either the consumer
+        // sees it after releasing space, or we see the space.
+        header_->producerWaiting.store(1, std::memory_order_seq_cst);
+        std::uint32_t event =
+            header_->spaceEvent.load(std::memory_order_seq_cst);
+        cachedHead_ = header_->head.load(std::memory_order_seq_cst);
+        bool ready  = tail_ + need - cachedHead_ <= capacity_ || cancelled();
+        bool woken  = ready || futexWait(header_->spaceEvent,
+                                        event,
+                                        livenessInterval_);
+        header_->producerWaiting.store(0, std::memory_order_relaxed);
+        if (!woken && peerGone(consumerSide)) {
+            return false;
+        }
+    }
+}
+
+char* ShmRing::reserve(std::size_t size) {
+    std::uint64_t need = recordHeader + roundUp(size);
+    if (need > capacity_ / 2) {
+        throw std::invalid_argument("record larger than half the ring");
+    }
+    if (!producing_) {
+        claim(producerSide);
+        producing_ = true;
+    }
+    // A record never wraps; the end of the ring is skipped if it is too
+    // short, which the offsets being multiples of the record header always
+    // leave room to mark.
+    std::uint64_t offset = tail_ & (capacity_ - 1);
+    std::uint64_t skip   = offset + need > capacity_ ? capacity_ - offset : 0;
+    if (!waitForSpace(skip + need)) {
+        return nullptr;
+    }
+    if (skip != 0) {
+        std::memcpy(data_ + offset, &wrapMarker, recordHeader);
+        tail_ += skip;
+        offset = 0;
+    }
+    std::uint64_t length = size;
+    std::memcpy(data_ + offset, &length, recordHeader);
+    pendingTail_ = tail_ + need;
+    return data_ + offset + recordHeader;
+}
+
+void ShmRing::commit() {
+    tail_ = pendingTail_;
+    header_->tail.store(tail_, std::memory_order_seq_cst);
+    if (header_->consumerWaiting.load(std::memory_order_seq_cst)) {
+        futexWake(header_->dataEvent);
+    }
+}
+
+void ShmRing::close() {
+    header_->closed.store(1, std::memory_order_seq_cst);
+    futexWake(header_->dataEvent);
+}
+
+bool ShmRing::cancelled() const {
+    return header_->cancelled.load(std::memory_order_acquire) != 0;
+}
+
+bool ShmRing::waitForData() {
+    for (;;) {
+        header_->consumerWaiting.store(1, std::memory_order_seq_cst);
+        std::uint32_t event =
+            header_->dataEvent.load(std::memory_order_seq_cst);
+        bool closed = header_->closed.load(std::memory_order_seq_cst) != 0;
+        cachedTail_ = header_->tail.load(std::memory_order_seq_cst);
+        bool ready  = cachedTail_ != head_;
+        bool woken  = ready || closed ||
+                     futexWait(header_->dataEvent, event, livenessInterval_);
+        header_->consumerWaiting.store(0, std::memory_order_relaxed);
+        if (ready) {
+            return true;
+        }
+        if (closed) {
+            return false;
+        }
+        if (!woken && peerGone(producerSide)) {
+            throw std::system_error(EPIPE,
+                                    std::generic_category(),
+                                    "shared ring producer exited");
+        }
+    }
+}
+
+std::optional<std::string_view> ShmRing::peek() {
+    if (!consuming_) {
+        claim(consumerSide);
+        consuming_ = true;
+    }
+    for (;;) {
+        if (head_ == cachedTail_) {
+            cachedTail_ = header_->tail.load(std::memory_order_acquire);
+        }
+        if (head_ == cachedTail_) {
+            if (!waitForData()) {
+                return std::nullopt;
+            }
+            continue;
+        }
+        std::uint64_t offset = head_ & (capacity_ - 1);
+        std::uint64_t length;
+        std::memcpy(&length, data_ + offset, recordHeader);
+        if (length == wrapMarker) {
+            head_ += capacity_ - offset;
+            continue;
+        }
+        pendingHead_ = head_ + recordHeader + roundUp(length);
+        return std::string_view(data_ + offset + recordHeader, length);
+    }
+}
+
+void ShmRing::release() {
+    head_ = pendingHead_;
+    header_->head.store(head_, std::memory_order_seq_cst);
+    if (header_->producerWaiting.load(std::memory_order_seq_cst)) {
+        futexWake(header_->spaceEvent);
+    }
+}
+
+void ShmRing::cancel() {
+    header_->cancelled.store(1, std::memory_order_seq_cst);
+    futexWake(header_->spaceEvent);
+}
+
+} // namespace co_fun
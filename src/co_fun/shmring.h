@@ -0,0 +1,236 @@
+// shmring.h                                                          -*-C++-*-
+#ifndef INCLUDED_CO_FUN_SHMRING
+#define INCLUDED_CO_FUN_SHMRING
+
+//@PURPOSE: Connect a stream in one process to a stream in another.
+//
+//@CLASSES:
+//  co_fun::ShmRing: single-producer/single-consumer record ring in a memfd
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: A 'ShmRing' is a lock-free ring of variable length records
+// in shared memory, for one producer and one consumer that may be in
+// different processes.  'ShmRing::create' makes the ring in a new 'memfd';
+// a child made with 'fork' shares it as it is, and another process can map
+// it with 'ShmRing::attach' given the descriptor, passed by inheritance or
+// over a Unix socket.  The descriptor is created close-on-exec.
+//
+// 'drain(stream, ring)' pushes every element of a stream into the ring and
+// closes it, and 'receive<T>(ring)' is the lazy stream of the elements at
+// the other end.
+//
+//..
+//  auto ring = ShmRing::create(1 << 20);
+//  if (::fork() == 0) {
+//      drain(fmap(lines(file), parse), *ring);
+//      ::_exit(0);
+//  }
+//  for (Trade const& trade : receive<Trade>(ring)) { ... }
+//..
+//
+// As in 'SpscRing', the indices live on separate cache lines, each side
+// keeps a cached copy of the other's index, and the fast path makes no
+// system calls.  A side that must wait raises a flag and sleeps on a
+// process-shared futex, and its peer makes the 'FUTEX_WAKE' call only when
+// it sees the flag.  'std::atomic::wait' is not used, since it may wait on
+// a process-private futex.
+//
+// Elements go through 'Serialize<T>'.  A trivially copyable type is
+// copied into the ring byte for byte, and 'pop' copies each record back
+// out with 'memcpy' into a new value, so an element is never read in
+// place.  Other types are written as their specialization of the trait
+// directs.
+//
+// A record may be at most half the ring; a larger one throws
+// 'std::invalid_argument'.  If the consumer cancels, or exits, the
+// producer's pushes return 'false' and 'drain' stops.  If the producer
+// exits without closing the ring, the consumer throws 'std::system_error'
+// with 'EPIPE' once the ring is empty.  A side only looks for its peer
+// while waiting for it: it sleeps on the futex for at most the liveness
+// interval, 'ShmRing::defaultLivenessInterval' (100ms) unless another is
+// given to 'create' or 'attach', then tests the peer's record lock with
+// one 'F_GETLK' call.  So a peer's exit is noticed up to one interval
+// late, and a side that waits long makes one system call per interval.
+
+#include <co_fun/serialize.h>
+#include <co_fun/stream.h>
+#include <co_fun/suspension.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace co_fun {
+
+class ShmRing {
+    struct Header;
+
+    int         fd_;
+    std::size_t capacity_;
+    std::size_t mapSize_;
+    Header*     header_;
+    char*       data_;
+
+    // Producer owned.
+    std::uint64_t tail_        = 0;
+    std::uint64_t pendingTail_ = 0;
+    std::uint64_t cachedHead_  = 0;
+    bool          producing_   = false;
+
+    // Consumer owned.
+    std::uint64_t head_        = 0;
+    std::uint64_t pendingHead_ = 0;
+    std::uint64_t cachedTail_  = 0;
+    bool          consuming_   = false;
+
+    std::chrono::milliseconds livenessInterval_;
+
+    ShmRing(int                       fd,
+            std::size_t               capacity,
+            bool                      initialize,
+            std::chrono::milliseconds livenessInterval);
+
+    void claim(int side);
+    bool peerGone(int side) const;
+    bool waitForSpace(std::uint64_t need);
+    bool waitForData();
+
+  public:
+    // How long a side waits on a futex, unless told otherwise, before
+    // checking that its peer is still alive.
+    static constexpr std::chrono::milliseconds defaultLivenessInterval{100};
+
+    // A ring of at least 'capacity' bytes in a new 'memfd', whose side in
+    // this process checks on its peer every 'livenessInterval' it waits.
+    static std::shared_ptr<ShmRing> create(
+        std::size_t               capacity,
+        std::chrono::milliseconds livenessInterval = defaultLivenessInterval);
+
+    // Map the ring in 'fd', made by 'create' in this or another process.
+    // The ring takes ownership of 'fd'.
+    static std::shared_ptr<ShmRing> attach(
+        int                       fd,
+        std::chrono::milliseconds livenessInterval = defaultLivenessInterval);
+
+    ShmRing(ShmRing const&) = delete;
+    ShmRing& operator=(ShmRing const&) = delete;
+
+    ~ShmRing();
+
+    int fd() const { return fd_; }
+
+    std::size_t capacity() const { return capacity_; }
+
+    std::chrono::milliseconds livenessInterval() const {
+        return livenessInterval_;
+    }
+
+    // Producer side.
+
+    // Room for a record of 'size' bytes, blocking until there is space, or
+    // null if the consumer has cancelled or gone.  The record is published
+    // by 'commit()'.
+    char* reserve(std::size_t size);
+
+    void commit();
+
+    // Reserve, serialize and commit 'value'.  Returns 'false' if the
+    // consumer has cancelled or gone.
+    template <typename Value>
+    bool push(Value const& value);
+
+    // No more records will be pushed.
+    void close();
+
+    bool cancelled() const;
+
+    // Consumer side.
+
+    // The next record, blocking until there is one, or 'nullopt' once the
+    // ring is closed and empty.  The bytes stay valid until 'release()'.
+    std::optional<std::string_view> peek();
+
+    void release();
+
+    template <typename Value>
+    std::optional<Value> pop();
+
+    // No more records will be read; a blocked producer is released.
+    void cancel();
+};
+
+namespace detail {
+
+template <typename Value, typename Suspension>
+ConsStream<Value, Suspension> receiveFrom(std::shared_ptr<ShmRing> ring) {
+    std::optional<Value> value = ring->template pop<Value>();
+    if (!value) {
+        return ConsStream<Value, Suspension>();
+    }
+    return ConsStream<Value, Suspension>(
+        [ring = std::move(ring), value = std::move(*value)]() {
+            return ConsCell<Value, Suspension>(
+                value, receiveFrom<Value, Suspension>(ring));
+        });
+}
+
+} // namespace detail
+
+// ============================================================================
+//              INLINE FUNCTION AND FUNCTION TEMPLATE DEFINITIONS
+// ============================================================================
+
+template <typename Value>
+bool ShmRing::push(Value const& value) {
+    std::size_t size = Serialize<Value>::size(value);
+    char*       out  = reserve(size);
+    if (out == nullptr) {
+        return false;
+    }
+    Serialize<Value>::write(value, out);
+    commit();
+    return true;
+}
+
+template <typename Value>
+std::optional<Value> ShmRing::pop() {
+    std::optional<std::string_view> record = peek();
+    if (!record) {
+        return std::nullopt;
+    }
+    std::optional<Value> value(Serialize<Value>::read(*record));
+    release();
+    return value;
+}
+
+// Push every element of 'stream' into 'ring', then close it.  Returns the
+// number of elements pushed, which is fewer than the stream holds if the
+// consumer cancelled.
+template <typename Value, typename Suspension>
+std::size_t drain(ConsStream<Value, Suspension> stream, ShmRing& ring) {
+    std::size_t count = 0;
+    for (; !stream.isEmpty(); stream = stream.tail(), ++count) {
+        if (!ring.push(stream.head())) {
+            break;
+        }
+    }
+    ring.close();
+    return count;
+}
+
+// The elements pushed into 'ring' by its producer.  Like a finite stream
+// read from a descriptor, a cell's emptiness is known when it is made, so
+// making one waits for the element after it.
+template <typename Value, typename Suspension = ThunkSuspension>
+ConsStream<Value, Suspension> receive(std::shared_ptr<ShmRing> ring) {
+    return detail::receiveFrom<Value, Suspension>(std::move(ring));
+}
+
+} // namespace co_fun
+
+#endif
@@ -0,0 +1,193 @@
+#include <co_fun/shmring.h>
+
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace co_fun;
+
+namespace {
+struct Point {
+    double x;
+    double y;
+
+    friend bool operator==(Point const&, Point const&) = default;
+};
+
+// Not trivially copyable, so it needs its own 'Serialize'.
+struct Named {
+    std::string name;
+    int         value;
+
+    friend bool operator==(Named const&, Named const&) = default;
+};
+
+// Wait for a forked child and return its exit status.
+int reap(pid_t child) {
+    int status = 0;
+    EXPECT_EQ(child, ::waitpid(child, &status, 0));
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+} // namespace
+
+template <>
+struct co_fun::Serialize<Named> {
+    static std::size_t size(Named const& named) {
+        return sizeof(int) + named.name.size();
+    }
+
+    static void write(Named const& named, char* out) {
+        std::memcpy(out, &named.value, sizeof(int));
+        std::memcpy(out + sizeof(int), named.name.data(), named.name.size());
+    }
+
+    static Named read(std::string_view record) {
+        Named named;
+        std::memcpy(&named.value, record.data(), sizeof(int));
+        named.name = std::string(record.substr(sizeof(int)));
+        return named;
+    }
+};
+
+TEST(Co_FunShmRingTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunShmRingTest, Breathing) {
+    auto ring = ShmRing::create(100);
+    EXPECT_EQ(4096u, ring->capacity());
+
+    EXPECT_TRUE(ring->push(1));
+    EXPECT_TRUE(ring->push(Point{2.0, 3.0}));
+    EXPECT_TRUE(ring->push(std::string("four")));
+    ring->close();
+
+    EXPECT_EQ(1, ring->pop<int>());
+    EXPECT_EQ((Point{2.0, 3.0}), ring->pop<Point>());
+    EXPECT_EQ("four", ring->pop<std::string>());
+    EXPECT_FALSE(ring->pop<int>());
+}
+
+TEST(Co_FunShmRingTest, SerializeHook) {
+    auto ring = ShmRing::create(4096);
+    EXPECT_TRUE(ring->push(Named{"answer", 42}));
+    ring->close();
+    EXPECT_EQ((Named{"answer", 42}), ring->pop<Named>());
+}
+
+TEST(Co_FunShmRingTest, RecordTooLarge) {
+    auto ring = ShmRing::create(4096);
+    EXPECT_THROW(ring->push(std::string(2048, 'x')), std::invalid_argument);
+    EXPECT_TRUE(ring->push(std::string(2000, 'x')));
+}
+
+TEST(Co_FunShmRingTest, WrapsBetweenThreads) {
+    auto                     ring = ShmRing::create(4096);
+    std::vector<std::string> sent;
+    for (int i = 0; i < 5000; ++i) {
+        sent.push_back(std::string(std::size_t(i % 300), char('a' + i % 26)));
+    }
+    std::thread producer([&]() {
+        std::vector<std::string> copy = sent;
+        for (std::string const& s : copy) {
+            ring->push(s);
+        }
+        ring->close();
+    });
+
+    std::vector<std::string> received;
+    for (std::string const& s : receive<std::string>(ring)) {
+        received.push_back(s);
+    }
+    producer.join();
+    EXPECT_EQ(sent, received);
+}
+
+TEST(Co_FunShmRingTest, Attach) {
+    auto ring     = ShmRing::create(4096);
+    auto attached = ShmRing::attach(::dup(ring->fd()));
+    EXPECT_EQ(ring->capacity(), attached->capacity());
+
+    std::thread producer([&]() { drain(rangeFrom(1, 1000), *ring); });
+    long sum = 0;
+    for (int i : receive<int>(attached)) {
+        sum += i;
+    }
+    producer.join();
+    EXPECT_EQ(500500, sum);
+}
+
+TEST(Co_FunShmRingTest, AttachRejectsOtherFiles) {
+    int fds[2];
+    ASSERT_EQ(0, ::pipe(fds));
+    ::close(fds[1]);
+    EXPECT_THROW(ShmRing::attach(fds[0]), std::invalid_argument);
+}
+
+TEST(Co_FunShmRingTest, AcrossProcesses) {
+    auto  ring  = ShmRing::create(1 << 16);
+    pid_t child = ::fork();
+    ASSERT_LE(0, child);
+    if (child == 0) {
+        std::size_t count = drain(rangeFrom<std::int64_t>(1, 200000), *ring);
+        ::_exit(count == 200000 ? 0 : 1);
+    }
+
+    std::int64_t sum   = 0;
+    std::size_t  count = 0;
+    for (auto s = receive<std::int64_t>(ring); !s.isEmpty(); s = s.tail()) {
+        sum += s.head();
+        ++count;
+    }
+    EXPECT_EQ(0, reap(child));
+    EXPECT_EQ(200000u, count);
+    EXPECT_EQ(std::int64_t(200000) * 200001 / 2, sum);
+}
+
+TEST(Co_FunShmRingTest, ConsumerCancels) {
+    auto  ring  = ShmRing::create(4096);
+    pid_t child = ::fork();
+    ASSERT_LE(0, child);
+    if (child == 0) {
+        std::size_t count = drain(iota(0), *ring);
+        ::_exit(count > 0 ? 0 : 1);
+    }
+
+    auto stream = receive<int>(ring);
+    EXPECT_EQ((std::vector<int>{0, 1, 2}),
+              (std::vector<int>{stream.head(),
+                                stream.tail().head(),
+                                stream.tail().tail().head()}));
+    ring->cancel();
+    EXPECT_EQ(0, reap(child));
+}
+
+TEST(Co_FunShmRingTest, ProducerExits) {
+    auto ring = ShmRing::create(4096, std::chrono::milliseconds(5));
+    EXPECT_EQ(std::chrono::milliseconds(5), ring->livenessInterval());
+    pid_t child = ::fork();
+    ASSERT_LE(0, child);
+    if (child == 0) {
+        ring->push(1);
+        ring->push(2);
+        ::_exit(0);
+    }
+
+    EXPECT_EQ(1, ring->pop<int>());
+    EXPECT_EQ(2, ring->pop<int>());
+    try {
+        ring->pop<int>();
+        FAIL() << "expected the exit to be seen";
+    } catch (std::system_error const& error) {
+        EXPECT_EQ(EPIPE, error.code().value());
+    }
+    EXPECT_EQ(0, reap(child));
+}
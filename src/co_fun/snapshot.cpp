@@ -0,0 +1,141 @@
+// snapshot.cpp                                                       -*-C++-*-
+#include <co_fun/snapshot.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace co_fun {
+
+namespace {
+std::system_error systemError(char const* what) {
+    return std::system_error(errno, std::generic_category(), what);
+}
+
+std::invalid_argument notASnapshot(std::string const& path) {
+    return std::invalid_argument(path + ": not a snapshot of this stream");
+}
+} // namespace
+
+SnapshotFile::SnapshotFile(std::string const& path,
+                           std::size_t        valueSize,
+                           std::size_t        stateSize,
+                           std::size_t        recordSize)
+    : file_(path) {
+    std::uint64_t size = file_.size();
+    if (size < sizeof header_) {
+        throw notASnapshot(path);
+    }
+    std::memcpy(&header_, file_.data(), sizeof header_);
+    if (header_.magic != magic || header_.version != version ||
+        header_.valueSize != valueSize || header_.stateSize != stateSize ||
+        header_.recordSize != recordSize) {
+        throw notASnapshot(path);
+    }
+
+    // Check the sizes the header claims against the file before trusting
+    // any offset in it.
+    std::uint64_t body  = size - sizeof header_;
+    std::uint64_t count = header_.count;
+    std::uint64_t records;
+    if (header_.recordSize != 0) {
+        if (count > body / header_.recordSize) {
+            throw notASnapshot(path);
+        }
+        records  = count * header_.recordSize;
+        records_ = file_.data() + sizeof header_;
+    } else {
+        if (count >= body / sizeof(std::uint64_t)) {
+            throw notASnapshot(path);
+        }
+        std::uint64_t indexSize = (count + 1) * sizeof(std::uint64_t);
+        index_   = reinterpret_cast<std::uint64_t const*>(file_.data() +
+                                                        sizeof header_);
+        records  = index_[count];
+        records_ = file_.data() + sizeof header_ + indexSize;
+        body -= indexSize;
+        for (std::uint64_t i = 0; i < count; ++i) {
+            if (index_[i] > index_[i + 1]) {
+                throw notASnapshot(path);
+            }
+        }
+    }
+    if (records > body || body - records != header_.stateLength) {
+        throw notASnapshot(path);
+    }
+}
+
+std::string_view SnapshotFile::record(std::size_t i) const {
+    if (index_ == nullptr) {
+        return std::string_view(records_ + i * header_.recordSize,
+                                header_.recordSize);
+    }
+    return std::string_view(records_ + index_[i], index_[i + 1] - index_[i]);
+}
+
+std::string_view SnapshotFile::state() const {
+    return std::string_view(file_.data() + file_.size() - header_.stateLength,
+                            header_.stateLength);
+}
+
+void SnapshotFile::write(std::string const&                     path,
+                         Header const&                          header,
+                         std::function<void(WriteSink&)> const& body) {
+    std::string temporary = path + ".tmp";
+    int         fd        = ::open(temporary.c_str(),
+                        O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                        0666);
+    if (fd < 0) {
+        throw systemError("open");
+    }
+    try {
+        {
+            WriteSink out(fd);
+            out.write(std::string_view(
+                reinterpret_cast<char const*>(&header), sizeof header));
+            body(out);
+            out.close();
+        }
+        if (::fsync(fd) != 0) {
+            throw systemError("fsync");
+        }
+        if (::close(fd) != 0) {
+            fd = -1;
+            throw systemError("close");
+        }
+        fd = -1;
+        if (::rename(temporary.c_str(), path.c_str()) != 0) {
+            throw systemError("rename");
+        }
+    } catch (...) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        ::unlink(temporary.c_str());
+        throw;
+    }
+
+    // The rename is durable only once the directory holding it is.
+    std::string directory = std::filesystem::path(path).parent_path();
+    if (directory.empty()) {
+        directory = ".";
+    }
+    int dir = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir < 0) {
+        throw systemError("open");
+    }
+    if (::fsync(dir) != 0) {
+        std::system_error error = systemError("fsync");
+        ::close(dir);
+        throw error;
+    }
+    ::close(dir);
+}
+
+} // namespace co_fun
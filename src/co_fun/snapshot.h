@@ -0,0 +1,286 @@
+// snapshot.h                                                         -*-C++-*-
+#ifndef INCLUDED_CO_FUN_SNAPSHOT
+#define INCLUDED_CO_FUN_SNAPSHOT
+
+//@PURPOSE: Save the evaluated prefix of a generated stream for a warm start.
+//
+//@CLASSES:
+//  co_fun::Resumable: endless stream from a step function, able to snapshot
+//  co_fun::SnapshotFile: validated, memory-mapped snapshot of a prefix
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: A 'Resumable' is an endless stream generated by a step
+// function from an explicit state: 'step(state)' returns the next element
+// and the state after it.  Because the state is a value, the stream can be
+// saved part way and picked up again.  'snapshot(path)' writes the prefix
+// evaluated so far, and the state at its end, to a compact binary file;
+// 'Resumable::restore(path, step)' makes a stream whose prefix is read from
+// the file and whose tail resumes generating from the saved state.
+//
+//..
+//  auto primes = Resumable<long, Sieve>::restore("primes.snap", sieveStep);
+//  use(primes.stream());
+//  primes.snapshot("primes.snap");
+//..
+//
+// Restoring does no work in proportion to the prefix: the file is mapped,
+// and a prefix cell is a suspended read of its record, so what a restarted
+// service touches costs a page fault and a copy rather than the original
+// computation, and what it does not touch costs nothing.  Forcing the
+// cells of either kind advances the point the next snapshot saves up to.
+//
+// A 'Resumable' holds its stream's head, so the evaluated prefix stays in
+// memory, as the table it is meant to be.  Copies share one stream.  The
+// stream may be forced from any thread, and a snapshot may be taken while
+// it is.
+//
+// Elements and the state are written with 'Serialize'; trivially copyable
+// elements are stored back to back with no index.  The file is written
+// under a temporary name, synced and renamed over 'path', so a crash
+// leaves the old snapshot or the new one.  A snapshot is read by the
+// program that wrote it; the element and state sizes are checked, and a
+// file that is not a snapshot of matching types throws
+// 'std::invalid_argument'.  I/O errors throw 'std::system_error'.
+
+#include <co_fun/mappedfile.h>
+#include <co_fun/serialize.h>
+#include <co_fun/stream.h>
+#include <co_fun/suspension.h>
+#include <co_fun/writesink.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace co_fun {
+
+class SnapshotFile {
+  public:
+    struct Header {
+        std::uint64_t magic;
+        std::uint64_t version;
+        std::uint64_t valueSize;
+        std::uint64_t stateSize;
+        std::uint64_t count;
+        std::uint64_t recordSize; // zero if the records are indexed
+        std::uint64_t stateLength;
+        std::uint64_t reserved;
+    };
+
+    static constexpr std::uint64_t magic   = 0x636f5f66756e534e; // "co_funSN"
+    static constexpr std::uint64_t version = 1;
+
+  private:
+    MappedFile           file_;
+    Header               header_;
+    std::uint64_t const* index_   = nullptr;
+    char const*          records_ = nullptr;
+
+  public:
+    // Map the snapshot at 'path', checking it holds elements and a state
+    // of the given sizes, in records of 'recordSize' bytes, or indexed if
+    // 'recordSize' is zero.
+    SnapshotFile(std::string const& path,
+                 std::size_t        valueSize,
+                 std::size_t        stateSize,
+                 std::size_t        recordSize);
+
+    std::size_t count() const { return header_.count; }
+
+    std::string_view record(std::size_t i) const;
+
+    std::string_view state() const;
+
+    // Write 'header', then what 'body' writes, to 'path' atomically, and
+    // sync the file and the directory holding it.
+    static void write(std::string const&                     path,
+                      Header const&                          header,
+                      std::function<void(WriteSink&)> const& body);
+};
+
+namespace detail {
+
+template <typename Value, typename State, typename Suspension>
+struct ResumableShared {
+    using Step = std::function<std::pair<Value, State>(State const&)>;
+
+    Step                          step;
+    std::optional<SnapshotFile>   file;
+    std::mutex                    lock;
+    std::size_t                   evaluated = 0;
+    State                         state;
+
+    ResumableShared(Step s, State initial)
+        : step(std::move(s)), state(std::move(initial)) {}
+
+    // Record that the elements before 'index' are evaluated, leaving
+    // 'next'.  Cells of a shared stream may be forced out of order.
+    void advance(std::size_t index, State const& next) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (index > evaluated) {
+            evaluated = index;
+            state     = next;
+        }
+    }
+};
+
+template <typename Value, typename State, typename Suspension>
+using ResumablePtr =
+    std::shared_ptr<ResumableShared<Value, State, Suspension>>;
+
+template <typename Value, typename State, typename Suspension>
+ConsStream<Value, Suspension>
+generateFrom(ResumablePtr<Value, State, Suspension> shared,
+             State                                  state,
+             std::size_t                            index) {
+    return ConsStream<Value, Suspension>([shared, state, index]() {
+        std::pair<Value, State> next = shared->step(state);
+        shared->advance(index + 1, next.second);
+        return ConsCell<Value, Suspension>(
+            next.first,
+            generateFrom(shared, std::move(next.second), index + 1));
+    });
+}
+
+template <typename Value, typename State, typename Suspension>
+ConsStream<Value, Suspension>
+restoreFrom(ResumablePtr<Value, State, Suspension> shared,
+            std::size_t                            index) {
+    std::size_t count = shared->file->count();
+    if (index == count) {
+        return generateFrom(
+            shared,
+            Serialize<State>::read(shared->file->state()),
+            index);
+    }
+    return ConsStream<Value, Suspension>([shared, index]() {
+        return ConsCell<Value, Suspension>(
+            Serialize<Value>::read(shared->file->record(index)),
+            restoreFrom(shared, index + 1));
+    });
+}
+
+} // namespace detail
+
+template <typename Value,
+          typename State,
+          typename Suspension = ThunkSuspension>
+class Resumable {
+    using Shared = detail::ResumableShared<Value, State, Suspension>;
+
+    // The cells hold the shared state, so it must not hold the head.
+    std::shared_ptr<Shared>       shared_;
+    ConsStream<Value, Suspension> head_;
+
+    Resumable(std::shared_ptr<Shared>       shared,
+              ConsStream<Value, Suspension> head)
+        : shared_(std::move(shared)), head_(std::move(head)) {}
+
+  public:
+    using Step = typename Shared::Step;
+
+    // The stream 'step' generates from 'seed'.
+    Resumable(State seed, Step step)
+        : shared_(std::make_shared<Shared>(std::move(step), seed)),
+          head_(detail::generateFrom(shared_, std::move(seed), 0)) {}
+
+    // The stream saved at 'path', continued by 'step'.
+    static Resumable restore(std::string const& path, Step step);
+
+    ConsStream<Value, Suspension> stream() const { return head_; }
+
+    // Elements evaluated, which is how many a snapshot would save.
+    std::size_t evaluated() const {
+        std::lock_guard<std::mutex> guard(shared_->lock);
+        return shared_->evaluated;
+    }
+
+    // Save the evaluated prefix and the state at its end to 'path'.
+    // Returns the number of elements saved.
+    std::size_t snapshot(std::string const& path) const;
+};
+
+// ============================================================================
+//              INLINE FUNCTION AND FUNCTION TEMPLATE DEFINITIONS
+// ============================================================================
+
+template <typename Value, typename State, typename Suspension>
+Resumable<Value, State, Suspension>
+Resumable<Value, State, Suspension>::restore(std::string const& path,
+                                             Step               step) {
+    constexpr bool fixed = std::is_trivially_copyable<Value>::value;
+    SnapshotFile   file(
+        path, sizeof(Value), sizeof(State), fixed ? sizeof(Value) : 0);
+    State        state = Serialize<State>::read(file.state());
+    auto         shared =
+        std::make_shared<Shared>(std::move(step), std::move(state));
+    shared->evaluated = file.count();
+    shared->file.emplace(std::move(file));
+    ConsStream<Value, Suspension> head = detail::restoreFrom(shared, 0);
+    return Resumable(std::move(shared), std::move(head));
+}
+
+template <typename Value, typename State, typename Suspension>
+std::size_t
+Resumable<Value, State, Suspension>::snapshot(std::string const& path) const {
+    std::size_t count = 0;
+    State       state = [&]() {
+        std::lock_guard<std::mutex> guard(shared_->lock);
+        count = shared_->evaluated;
+        return shared_->state;
+    }();
+
+    constexpr bool fixed = std::is_trivially_copyable<Value>::value;
+    SnapshotFile::Header header{};
+    header.magic       = SnapshotFile::magic;
+    header.version     = SnapshotFile::version;
+    header.valueSize   = sizeof(Value);
+    header.stateSize   = sizeof(State);
+    header.count       = count;
+    header.recordSize  = fixed ? sizeof(Value) : 0;
+    header.stateLength = Serialize<State>::size(state);
+
+    // Every element before 'count' has been computed, so walking the
+    // prefix, once for the index and once for the records, calls no step.
+    SnapshotFile::write(path, header, [&](WriteSink& out) {
+        auto put = [&out](std::uint64_t word) {
+            out.write(std::string_view(reinterpret_cast<char const*>(&word),
+                                       sizeof word));
+        };
+        ConsStream<Value, Suspension> cells;
+        if (!fixed) {
+            std::uint64_t offset = 0;
+            put(offset);
+            cells = head_;
+            for (std::size_t i = 0; i < count; ++i, cells = cells.tail()) {
+                offset += Serialize<Value>::size(cells.head());
+                put(offset);
+            }
+        }
+        std::string record;
+        cells = head_;
+        for (std::size_t i = 0; i < count; ++i, cells = cells.tail()) {
+            Value value = cells.head();
+            record.resize(Serialize<Value>::size(value));
+            Serialize<Value>::write(value, record.data());
+            out.write(record);
+        }
+        record.resize(header.stateLength);
+        Serialize<State>::write(state, record.data());
+        out.write(record);
+    });
+    return count;
+}
+
+} // namespace co_fun
+
+#endif
@@ -0,0 +1,172 @@
+#include <co_fun/snapshot.h>
+#include <co_fun/tempfile.t.h>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+using namespace co_fun;
+
+namespace {
+using test::TempFile;
+
+int steps = 0;
+
+// The next prime after 'n', as the element and the state.
+std::pair<long, long> nextPrime(long const& n) {
+    ++steps;
+    for (long candidate = n + 1;; ++candidate) {
+        bool prime = candidate > 1;
+        for (long d = 2; prime && d * d <= candidate; ++d) {
+            prime = candidate % d != 0;
+        }
+        if (prime) {
+            return {candidate, candidate};
+        }
+    }
+}
+
+std::pair<std::string, int> word(int const& n) {
+    ++steps;
+    return {std::string(std::size_t(n % 7), char('a' + n % 26)), n + 1};
+}
+
+template <typename Stream>
+auto first(Stream stream, std::size_t n) {
+    std::vector<std::decay_t<decltype(stream.head())>> result;
+    for (std::size_t i = 0; i < n; ++i, stream = stream.tail()) {
+        result.push_back(stream.head());
+    }
+    return result;
+}
+} // namespace
+
+TEST(Co_FunSnapshotTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunSnapshotTest, Breathing) {
+    Resumable<long, long> primes(1, nextPrime);
+    EXPECT_EQ(0u, primes.evaluated());
+    EXPECT_EQ((std::vector<long>{2, 3, 5, 7, 11}), first(primes.stream(), 5));
+    EXPECT_EQ(5u, primes.evaluated());
+}
+
+TEST(Co_FunSnapshotTest, WarmStart) {
+    TempFile          file;
+    std::vector<long> expected;
+    {
+        Resumable<long, long> primes(1, nextPrime);
+        expected = first(primes.stream(), 2000);
+        EXPECT_EQ(2000u, primes.snapshot(file.path()));
+    }
+    std::ifstream in(file.path(), std::ios::binary | std::ios::ate);
+    EXPECT_EQ(std::streamoff(64 + 2000 * sizeof(long) + sizeof(long)),
+              std::streamoff(in.tellg()));
+
+    steps       = 0;
+    auto primes = Resumable<long, long>::restore(file.path(), nextPrime);
+    EXPECT_EQ(2000u, primes.evaluated());
+    EXPECT_EQ(expected, first(primes.stream(), 2000));
+    EXPECT_EQ(0, steps);
+
+    // The tail resumes from the saved state.
+    std::vector<long> more = first(primes.stream(), 2003);
+    EXPECT_EQ(3, steps);
+    EXPECT_EQ((std::vector<long>{17393, 17401, 17417}),
+              std::vector<long>(more.begin() + 2000, more.end()));
+    EXPECT_EQ(2003u, primes.evaluated());
+}
+
+TEST(Co_FunSnapshotTest, SnapshotOfRestored) {
+    TempFile saved;
+    TempFile resaved;
+    {
+        Resumable<long, long> primes(1, nextPrime);
+        first(primes.stream(), 10);
+        primes.snapshot(saved.path());
+    }
+    {
+        auto primes = Resumable<long, long>::restore(saved.path(), nextPrime);
+        first(primes.stream(), 20);
+        EXPECT_EQ(20u, primes.snapshot(resaved.path()));
+    }
+    auto primes = Resumable<long, long>::restore(resaved.path(), nextPrime);
+    EXPECT_EQ(20u, primes.evaluated());
+    EXPECT_EQ(71, first(primes.stream(), 20).back());
+}
+
+TEST(Co_FunSnapshotTest, IndexedRecords) {
+    TempFile                 file;
+    std::vector<std::string> expected;
+    {
+        Resumable<std::string, int> words(0, word);
+        expected = first(words.stream(), 500);
+        words.snapshot(file.path());
+    }
+    steps      = 0;
+    auto words = Resumable<std::string, int>::restore(file.path(), word);
+    EXPECT_EQ(expected, first(words.stream(), 500));
+    EXPECT_EQ(0, steps);
+    EXPECT_EQ(std::string(500 % 7, char('a' + 500 % 26)),
+              first(words.stream(), 501).back());
+}
+
+TEST(Co_FunSnapshotTest, EmptyPrefix) {
+    TempFile file;
+    {
+        Resumable<long, long> primes(1, nextPrime);
+        EXPECT_EQ(0u, primes.snapshot(file.path()));
+    }
+    auto primes = Resumable<long, long>::restore(file.path(), nextPrime);
+    EXPECT_EQ((std::vector<long>{2, 3}), first(primes.stream(), 2));
+}
+
+TEST(Co_FunSnapshotTest, Rejects) {
+    TempFile file;
+    {
+        Resumable<long, long> primes(1, nextPrime);
+        first(primes.stream(), 3);
+        primes.snapshot(file.path());
+    }
+    EXPECT_THROW((Resumable<std::string, int>::restore(file.path(), word)),
+                 std::invalid_argument);
+
+    // Two records of 12 bytes fill the same space as three of 8, so only
+    // the record size gives the header away.
+    {
+        std::fstream  out(file.path(),
+                         std::ios::in | std::ios::out | std::ios::binary);
+        std::uint64_t fields[] = {2, 12};
+        out.seekp(offsetof(SnapshotFile::Header, count));
+        out.write(reinterpret_cast<char const*>(fields), sizeof fields);
+    }
+    EXPECT_THROW((Resumable<long, long>::restore(file.path(), nextPrime)),
+                 std::invalid_argument);
+
+    std::ofstream(file.path(), std::ios::trunc) << "not a snapshot";
+    EXPECT_THROW((Resumable<long, long>::restore(file.path(), nextPrime)),
+                 std::invalid_argument);
+
+    EXPECT_THROW((Resumable<long, long>::restore("/nonexistent/snap",
+                                                 nextPrime)),
+                 std::system_error);
+}
+
+TEST(Co_FunSnapshotTest, ReplacesAtomically) {
+    TempFile              file;
+    Resumable<long, long> primes(1, nextPrime);
+    first(primes.stream(), 5);
+    primes.snapshot(file.path());
+    first(primes.stream(), 50);
+    primes.snapshot(file.path());
+    EXPECT_NE(0, ::access((file.path() + ".tmp").c_str(), F_OK));
+    EXPECT_EQ(50u,
+              (Resumable<long, long>::restore(file.path(), nextPrime))
+                  .evaluated());
+}
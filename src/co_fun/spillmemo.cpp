@@ -0,0 +1,77 @@
+// spillmemo.cpp                                                      -*-C++-*-
+#include <co_fun/spillmemo.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace co_fun {
+
+namespace {
+std::system_error systemError(char const* what) {
+    return std::system_error(errno, std::generic_category(), what);
+}
+} // namespace
+
+SpillFile::SpillFile(std::string const& directory) {
+    std::string where = directory;
+    if (where.empty()) {
+        char const* tmpdir = std::getenv("TMPDIR");
+        where              = tmpdir && *tmpdir ? tmpdir : "/tmp";
+    }
+    fd_ = ::open(where.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    if (fd_ < 0 && (errno == EOPNOTSUPP || errno == EISDIR)) {
+        // No O_TMPFILE on this filesystem; make a name and unlink it.
+        std::string name = where + "/co_fun_spillXXXXXX";
+        fd_              = ::mkostemp(name.data(), O_CLOEXEC);
+        if (fd_ >= 0) {
+            ::unlink(name.c_str());
+        }
+    }
+    if (fd_ < 0) {
+        throw systemError("spill file");
+    }
+}
+
+SpillFile::~SpillFile() { ::close(fd_); }
+
+std::uint64_t SpillFile::append(std::string_view bytes) {
+    std::uint64_t offset = size_;
+    while (!bytes.empty()) {
+        ssize_t n = ::pwrite(fd_, bytes.data(), bytes.size(), off_t(size_));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw systemError("pwrite");
+        }
+        size_ += std::uint64_t(n);
+        bytes.remove_prefix(std::size_t(n));
+    }
+    return offset;
+}
+
+void SpillFile::read(std::uint64_t offset,
+                     char*         out,
+                     std::size_t   length) const {
+    while (length != 0) {
+        ssize_t n = ::pread(fd_, out, length, off_t(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            if (n == 0) {
+                errno = EIO;
+            }
+            throw systemError("pread");
+        }
+        offset += std::uint64_t(n);
+        out += n;
+        length -= std::size_t(n);
+    }
+}
+
+} // namespace co_fun
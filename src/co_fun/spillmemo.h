@@ -0,0 +1,318 @@
+// spillmemo.h                                                        -*-C++-*-
+#ifndef INCLUDED_CO_FUN_SPILLMEMO
+#define INCLUDED_CO_FUN_SPILLMEMO
+
+//@PURPOSE: Memoize a stream for replay within a memory budget.
+//
+//@CLASSES:
+//  co_fun::SpillMemo: replayable memo of a stream, spilling to a file
+//  co_fun::SpillOptions: memory budget, page size and spill directory
+//  co_fun::SpillFile: unlinked, append-only temporary file
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: A 'ConsStream' that is traversed twice keeps every cell it
+// has evaluated for as long as its head is held, since each cell memoizes
+// the one after it.  A 'SpillMemo' evaluates its source stream once, as
+// far as it is asked to, and keeps the elements in pages of
+// 'SpillOptions::pageSize' elements, instead of in cells.  Each call to
+// 'stream()' is a fresh traversal from the first element, in which each
+// element is computed at most once however many traversals ask for it.
+//
+//..
+//  SpillMemo trades(fmap(lines(file), parse), {.memoryBudget = 256 << 20});
+//  std::size_t count  = length(trades.stream());
+//  Trade       latest = last(trades.stream());
+//..
+//
+// When the pages in memory pass 'SpillOptions::memoryBudget' bytes, the
+// oldest are written to a 'SpillFile' and dropped, and a traversal that
+// reaches one reads it back, which may spill another.  A page is written
+// once; dropping it again costs nothing.  The page being filled, and the
+// one being read, are never spilled, so a budget smaller than two pages
+// holds two pages.  An element's cost is its 'sizeof' plus, for types that
+// are not trivially copyable, its 'Serialize' record, which stands in for
+// what it owns on the heap.
+//
+// Elements are written with 'Serialize<Value>', so types that are not
+// trivially copyable, 'std::string' and 'Chunk' aside, need a
+// specialization.
+//
+// The budget bounds the memo, not the traversals.  A traversal's cells are
+// ordinary stream cells, so one walked by reassignment holds one element,
+// while a held 'stream()' keeps what it has evaluated, as any stream does.
+// The source stream is walked by reassignment, and is released once
+// exhausted.
+//
+// A 'SpillMemo' is a shared handle; copies share one memo.  Its traversals
+// may be forced from any thread.  An exception from the source propagates
+// out of the cell that asked for the element, and out of every later ask,
+// as the source's own cell does.  Errors writing or reading the spill file
+// throw 'std::system_error'.
+
+#include <co_fun/serialize.h>
+#include <co_fun/stream.h>
+#include <co_fun/suspension.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace co_fun {
+
+struct SpillOptions {
+    // Bytes of elements kept in memory before the oldest pages are spilled.
+    std::size_t memoryBudget = std::size_t(64) << 20;
+
+    // Elements per page, the unit that is spilled and read back.
+    std::size_t pageSize = 4096;
+
+    // Where the spill file is made; empty means '$TMPDIR', or '/tmp'.
+    std::string directory = {};
+};
+
+class SpillFile {
+    int           fd_   = -1;
+    std::uint64_t size_ = 0;
+
+  public:
+    // An anonymous file in 'directory', which is gone once it is closed.
+    explicit SpillFile(std::string const& directory);
+
+    SpillFile(SpillFile const&) = delete;
+    SpillFile& operator=(SpillFile const&) = delete;
+
+    ~SpillFile();
+
+    // Write 'bytes' at the end of the file, returning where they start.
+    std::uint64_t append(std::string_view bytes);
+
+    // Read 'length' bytes at 'offset' into 'out'.
+    void read(std::uint64_t offset, char* out, std::size_t length) const;
+
+    std::uint64_t size() const { return size_; }
+};
+
+namespace detail {
+
+template <typename Value, typename Suspension>
+class SpillState {
+    struct Page {
+        std::vector<Value> values;
+        std::size_t        cost     = 0;
+        bool               resident = true;
+        bool               spilled  = false;
+        std::uint64_t      offset   = 0;
+        std::uint64_t      length   = 0;
+    };
+
+    mutable std::mutex            lock_;
+    SpillOptions                  options_;
+    ConsStream<Value, Suspension> source_;
+    bool                          exhausted_ = false;
+    std::size_t                   evaluated_ = 0;
+    std::vector<Page>             pages_;
+    std::set<std::size_t>         resident_;
+    std::size_t                   residentBytes_ = 0;
+    std::size_t                   pageIns_       = 0;
+    std::optional<SpillFile>      file_;
+
+    static std::size_t cost(Value const& value) {
+        if constexpr (std::is_trivially_copyable<Value>::value) {
+            return sizeof(Value);
+        } else {
+            return sizeof(Value) + Serialize<Value>::size(value);
+        }
+    }
+
+    void evaluateNext() {
+        if (source_.isEmpty()) {
+            exhausted_ = true;
+            return;
+        }
+        Value                         value = source_.head();
+        ConsStream<Value, Suspension> next  = source_.tail();
+        if (pages_.empty() ||
+            pages_.back().values.size() == options_.pageSize) {
+            resident_.insert(pages_.size());
+            pages_.emplace_back();
+            pages_.back().values.reserve(options_.pageSize);
+        }
+        Page& page = pages_.back();
+        page.cost += cost(value);
+        residentBytes_ += cost(value);
+        page.values.push_back(std::move(value));
+        ++evaluated_;
+        source_ = std::move(next);
+        if (source_.isEmpty()) {
+            exhausted_ = true;
+            source_    = ConsStream<Value, Suspension>();
+        }
+        fitBudget(pages_.size() - 1);
+    }
+
+    // Drop the oldest pages until the budget is met, sparing 'keep' and the
+    // page being filled.
+    void fitBudget(std::size_t keep) {
+        std::size_t filling = exhausted_ ? pages_.size() : pages_.size() - 1;
+        auto it = resident_.begin();
+        while (residentBytes_ > options_.memoryBudget &&
+               it != resident_.end()) {
+            if (*it == keep || *it == filling) {
+                ++it;
+                continue;
+            }
+            spill(pages_[*it]);
+            it = resident_.erase(it);
+        }
+    }
+
+    void spill(Page& page) {
+        if (!page.spilled) {
+            std::string bytes;
+            for (Value const& value : page.values) {
+                std::uint64_t size   = Serialize<Value>::size(value);
+                std::size_t   record = bytes.size();
+                bytes.resize(record + sizeof size + size);
+                std::memcpy(bytes.data() + record, &size, sizeof size);
+                Serialize<Value>::write(value,
+                                        bytes.data() + record + sizeof size);
+            }
+            if (!file_) {
+                file_.emplace(options_.directory);
+            }
+            page.offset  = file_->append(bytes);
+            page.length  = bytes.size();
+            page.spilled = true;
+        }
+        std::vector<Value>().swap(page.values);
+        page.resident = false;
+        residentBytes_ -= page.cost;
+    }
+
+    void pageIn(std::size_t index) {
+        Page&       page = pages_[index];
+        std::string bytes(page.length, '\0');
+        file_->read(page.offset, bytes.data(), bytes.size());
+        page.values.reserve(options_.pageSize);
+        std::string_view rest(bytes);
+        while (!rest.empty()) {
+            std::uint64_t size;
+            std::memcpy(&size, rest.data(), sizeof size);
+            page.values.push_back(
+                Serialize<Value>::read(rest.substr(sizeof size, size)));
+            rest.remove_prefix(sizeof size + size);
+        }
+        page.resident = true;
+        residentBytes_ += page.cost;
+        resident_.insert(index);
+        ++pageIns_;
+        fitBudget(index);
+    }
+
+  public:
+    SpillState(ConsStream<Value, Suspension> source,
+               SpillOptions const&           options)
+        : options_(options), source_(std::move(source)) {
+        if (options_.pageSize == 0) {
+            options_.pageSize = 1;
+        }
+    }
+
+    std::optional<Value> at(std::size_t index) {
+        std::lock_guard<std::mutex> guard(lock_);
+        while (index >= evaluated_ && !exhausted_) {
+            evaluateNext();
+        }
+        if (index >= evaluated_) {
+            return std::nullopt;
+        }
+        std::size_t pageIndex = index / options_.pageSize;
+        if (!pages_[pageIndex].resident) {
+            pageIn(pageIndex);
+        }
+        return pages_[pageIndex].values[index % options_.pageSize];
+    }
+
+    std::size_t evaluated() const {
+        std::lock_guard<std::mutex> guard(lock_);
+        return evaluated_;
+    }
+
+    std::size_t residentBytes() const {
+        std::lock_guard<std::mutex> guard(lock_);
+        return residentBytes_;
+    }
+
+    std::size_t spilledPages() const {
+        std::lock_guard<std::mutex> guard(lock_);
+        std::size_t                 count = 0;
+        for (Page const& page : pages_) {
+            count += page.spilled;
+        }
+        return count;
+    }
+
+    std::size_t pageIns() const {
+        std::lock_guard<std::mutex> guard(lock_);
+        return pageIns_;
+    }
+};
+
+template <typename Value, typename Suspension>
+ConsStream<Value, Suspension>
+replayFrom(std::shared_ptr<SpillState<Value, Suspension>> state,
+           std::size_t                                    index) {
+    std::optional<Value> value = state->at(index);
+    if (!value) {
+        return ConsStream<Value, Suspension>();
+    }
+    return ConsStream<Value, Suspension>(
+        [state = std::move(state), index, value = std::move(*value)]() {
+            return ConsCell<Value, Suspension>(value,
+                                               replayFrom(state, index + 1));
+        });
+}
+
+} // namespace detail
+
+template <typename Value, typename Suspension = ThunkSuspension>
+class SpillMemo {
+    std::shared_ptr<detail::SpillState<Value, Suspension>> state_;
+
+  public:
+    explicit SpillMemo(ConsStream<Value, Suspension> source,
+                       SpillOptions const&           options = {})
+        : state_(std::make_shared<detail::SpillState<Value, Suspension>>(
+              std::move(source), options)) {}
+
+    // A traversal from the first element.
+    ConsStream<Value, Suspension> stream() const {
+        return detail::replayFrom(state_, 0);
+    }
+
+    // Elements taken from the source so far.
+    std::size_t evaluated() const { return state_->evaluated(); }
+
+    // Cost of the elements held in memory.
+    std::size_t residentBytes() const { return state_->residentBytes(); }
+
+    // Pages written to the spill file.
+    std::size_t spilledPages() const { return state_->spilledPages(); }
+
+    // Pages read back from the spill file.
+    std::size_t pageIns() const { return state_->pageIns(); }
+};
+
+} // namespace co_fun
+
+#endif
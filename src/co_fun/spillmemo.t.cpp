@@ -0,0 +1,146 @@
+#include <co_fun/spillmemo.h>
+#include <co_fun/stream.t.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace co_fun;
+
+namespace {
+using test::collect;
+
+template <typename Stream>
+std::int64_t sum(Stream stream) {
+    std::int64_t total = 0;
+    for (; !stream.isEmpty(); stream = stream.tail()) {
+        total += stream.head();
+    }
+    return total;
+}
+
+} // namespace
+
+TEST(Co_FunSpillMemoTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunSpillMemoTest, Breathing) {
+    SpillMemo memo(rangeFrom(1, 10));
+    EXPECT_EQ(0u, memo.evaluated());
+    EXPECT_EQ(55, sum(memo.stream()));
+    EXPECT_EQ(55, sum(memo.stream()));
+    EXPECT_EQ(10u, memo.evaluated());
+    EXPECT_EQ(0u, memo.spilledPages());
+    EXPECT_EQ(10 * sizeof(int), memo.residentBytes());
+}
+
+TEST(Co_FunSpillMemoTest, EvaluatesSourceOnce) {
+    int  calls  = 0;
+    auto source = fmap(rangeFrom(1, 1000), [&calls](int i) {
+        ++calls;
+        return i * 2;
+    });
+    SpillMemo memo(source, {.memoryBudget = 1024, .pageSize = 64});
+    source = decltype(source)();
+    EXPECT_EQ(1001000, sum(memo.stream()));
+    EXPECT_EQ(1001000, sum(memo.stream()));
+    EXPECT_EQ(1000, calls);
+}
+
+TEST(Co_FunSpillMemoTest, Lazy) {
+    SpillMemo memo(iota(0), {.pageSize = 16});
+    auto      stream = memo.stream();
+    EXPECT_EQ(1u, memo.evaluated());
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 4}), collect(take(stream, 5)));
+    // Forcing a cell looks one element ahead.
+    EXPECT_EQ(6u, memo.evaluated());
+}
+
+TEST(Co_FunSpillMemoTest, SpillsOverBudget) {
+    SpillOptions options{.memoryBudget = 64 * 1024, .pageSize = 1024};
+    SpillMemo    memo(rangeFrom<std::int64_t>(1, 200000), options);
+
+    std::int64_t expected = std::int64_t(200000) * 200001 / 2;
+    EXPECT_EQ(expected, sum(memo.stream()));
+    EXPECT_LT(0u, memo.spilledPages());
+    EXPECT_GE(options.memoryBudget, memo.residentBytes());
+
+    EXPECT_EQ(expected, sum(memo.stream()));
+    EXPECT_LT(0u, memo.pageIns());
+    EXPECT_GE(options.memoryBudget, memo.residentBytes());
+
+    // Pages already in the file are not written again.
+    std::size_t spilled = memo.spilledPages();
+    EXPECT_EQ(expected, sum(memo.stream()));
+    EXPECT_EQ(spilled, memo.spilledPages());
+}
+
+TEST(Co_FunSpillMemoTest, TinyBudgetKeepsTwoPages) {
+    SpillMemo memo(rangeFrom(1, 1000), {.memoryBudget = 1, .pageSize = 10});
+    EXPECT_EQ(500500, sum(memo.stream()));
+    EXPECT_GE(20 * sizeof(int), memo.residentBytes());
+    EXPECT_EQ(500500, sum(memo.stream()));
+    EXPECT_GE(20 * sizeof(int), memo.residentBytes());
+}
+
+TEST(Co_FunSpillMemoTest, Strings) {
+    auto source = fmap(rangeFrom(1, 5000), [](int i) {
+        return std::string(std::size_t(i % 50), char('a' + i % 26));
+    });
+    SpillMemo memo(source, {.memoryBudget = 16 * 1024, .pageSize = 100});
+    std::vector<std::string> expected = collect(source);
+    source                            = decltype(source)();
+
+    EXPECT_EQ(expected, collect(memo.stream()));
+    EXPECT_LT(0u, memo.spilledPages());
+    EXPECT_EQ(expected, collect(memo.stream()));
+    EXPECT_LT(0u, memo.pageIns());
+}
+
+TEST(Co_FunSpillMemoTest, InterleavedTraversals) {
+    SpillMemo memo(rangeFrom(0, 9999), {.memoryBudget = 512, .pageSize = 32});
+    auto      ahead  = memo.stream();
+    auto      behind = memo.stream();
+    for (int i = 0; i < 5000; ++i) {
+        ahead = ahead.tail();
+    }
+    for (int i = 0; i < 5000; ++i) {
+        ASSERT_EQ(i, behind.head());
+        ASSERT_EQ(i + 5000, ahead.head());
+        behind = behind.tail();
+        ahead  = ahead.tail();
+    }
+    EXPECT_TRUE(ahead.isEmpty());
+}
+
+TEST(Co_FunSpillMemoTest, Threads) {
+    SpillMemo memo(rangeFrom<std::int64_t>(1, 50000),
+                   {.memoryBudget = 8 * 1024, .pageSize = 256});
+    std::int64_t first  = 0;
+    std::int64_t second = 0;
+    std::thread  a([&]() { first = sum(memo.stream()); });
+    std::thread  b([&]() { second = sum(memo.stream()); });
+    a.join();
+    b.join();
+    EXPECT_EQ(std::int64_t(50000) * 50001 / 2, first);
+    EXPECT_EQ(first, second);
+}
+
+TEST(Co_FunSpillMemoTest, SourceThrows) {
+    auto source = fmap(rangeFrom(1, 3), [](int i) {
+        if (i == 2) {
+            throw std::runtime_error("two");
+        }
+        return i;
+    });
+    SpillMemo memo(source);
+    source = decltype(source)();
+
+    // Forcing the first cell looks ahead to the second.
+    EXPECT_THROW(memo.stream().head(), std::runtime_error);
+    EXPECT_THROW(memo.stream().head(), std::runtime_error);
+    EXPECT_EQ(1u, memo.evaluated());
+}
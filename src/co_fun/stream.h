@@ -1,96 +1,126 @@
 // stream.h                                                           -*-C++-*-
-#ifndef INCLUDED_STREAMASYNC
-#define INCLUDED_STREAMASYNC
-
+#ifndef INCLUDED_CO_FUN_STREAM
+#define INCLUDED_CO_FUN_STREAM
+
+//@PURPOSE: Provide lazy cons streams over a pluggable suspension.
+//
+//@CLASSES:
+//  co_fun::ConsStream: a lazily evaluated list
+//  co_fun::ConsCell: a value and the stream of values after it
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: A 'ConsStream<Value, Suspension>' is a shared handle to a
+// suspended 'ConsCell'.  The 'Suspension' policy, described in
+// 'co_fun/suspension.h', decides what a cell is: a coroutine 'Thunk' by
+// default, an unsynchronized 'Memo', or, from the delay library, a 'Delay'
+// or 'DelayAsync'.  Every combinator here is written once against the
+// policy, and produces streams with the policy of its argument.
+
+#include <co_fun/suspension.h>
 #include <co_fun/thunk.h>
-#include <optional>
+
+#include <cstddef>
+#include <iostream>
 #include <iterator>
 #include <memory>
-#include <tuple>
 #include <optional>
-#include <iostream>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 namespace co_fun {
-template <typename Value>
+template <typename Value, typename Suspension = ThunkSuspension>
 class ConsStream;
 
-template <typename Value>
+template <typename Value, typename Suspension = ThunkSuspension>
 class ConsStreamIterator;
 
-template <typename Value>
+template <typename Value, typename Suspension = ThunkSuspension>
 class ConsCell {
-    Value             head_;
-    ConsStream<Value> tail_;
+    Value                         head_;
+    ConsStream<Value, Suspension> tail_;
 
-    friend class ConsStreamIterator<Value>;
+    friend class ConsStreamIterator<Value, Suspension>;
 
   public:
-    ConsCell(Value const& v, ConsStream<Value> const& stream)
+    ConsCell(Value const& v, ConsStream<Value, Suspension> const& stream)
         : head_(v), tail_(stream) {}
 
+    // Most tails are made for the cell, and are moved in rather than
+    // copied, which for a counted cell is a pair of atomic updates saved.
+    ConsCell(Value const& v, ConsStream<Value, Suspension>&& stream)
+        : head_(v), tail_(std::move(stream)) {}
+
     explicit ConsCell(Value const& v) : head_(v), tail_() {}
 
     Value const& head() const { return head_; }
 
-    ConsStream<Value> const& tail() const { return tail_; }
+    ConsStream<Value, Suspension> const& tail() const { return tail_; }
 };
 
-template <typename Value>
+template <typename Value, typename Suspension>
 class ConsStream {
-    Thunk<ConsCell<Value>> thunked_cell_;
+    using Cell = ConsCell<Value, Suspension>;
+
+    typename Suspension::template Cell<Cell> cell_;
 
-    friend class ConsStreamIterator<Value>;
+    friend class ConsStreamIterator<Value, Suspension>;
 
   public:
     typedef Value value;
+    using suspension = Suspension;
+    using cell_type  = Cell;
 
     ConsStream() = default;
 
     ConsStream(Value const& value)
-        : thunked_cell_(Thunk<ConsCell<Value>>(
-              thunk([value]() { return ConsCell<Value>(value); }))) {}
+        : cell_(Suspension::template suspend<Cell>(
+              [value]() { return Cell(value); })) {}
 
     ConsStream(Value&& value)
-        : thunked_cell_(
-              Thunk<ConsCell<Value>>(thunk([v = std::forward<Value>(value)]() {
-                  return ConsCell<Value>(v);
-              }))) {}
+        : cell_(Suspension::template suspend<Cell>(
+              [v = std::forward<Value>(value)]() { return Cell(v); })) {}
 
     template <typename Func,
               typename = typename std::enable_if<
                   !std::is_convertible<Func, ConsStream>::value>::type>
-    ConsStream(Func&& f) : thunked_cell_(Thunk<ConsCell<Value>>(thunk(f))) {}
+    ConsStream(Func&& f)
+        : cell_(Suspension::template suspend<Cell>(std::forward<Func>(f))) {}
 
-    bool isEmpty() const { return thunked_cell_.isEmpty(); }
+    bool isEmpty() const { return Suspension::isEmpty(cell_); }
 
-    Value head() const { return evaluate(thunked_cell_).head(); }
+    Value head() const { return Suspension::force(cell_).head(); }
 
-    ConsStream<Value> tail() const { return evaluate(thunked_cell_).tail(); }
+    ConsStream tail() const { return Suspension::force(cell_).tail(); }
 
-    using iterator = ConsStreamIterator<Value>;
+    using iterator = ConsStreamIterator<Value, Suspension>;
 
-    iterator begin() { return iterator(thunked_cell_); };
+    iterator begin() { return iterator(cell_); };
 
     iterator end() { return iterator(); }
 
     int countEvaluated() {
-        if (thunked_cell_.isEmpty()) {
+        if (Suspension::isEmpty(cell_)) {
             return 0;
         }
 
-        auto cell      = thunked_cell_;
+        auto cell      = cell_;
         int  evaluated = 0;
-        while (!cell.isEmpty() && cell.evaluated()) {
+        while (!Suspension::isEmpty(cell) && Suspension::isForced(cell)) {
             ++evaluated;
-            cell = cell.get().tail().thunked_cell_;
+            cell = Suspension::force(cell).tail().cell_;
         }
         return evaluated;
     }
+
+    int countForced() { return countEvaluated(); }
 };
 
-template <typename Value>
-ConsStream<Value> make_stream(Value v) {
-    return ConsStream<Value>([v]() { return ConsCell<Value>(v); });
+template <typename Value, typename Suspension = ThunkSuspension>
+ConsStream<Value, Suspension> make_stream(Value v) {
+    return ConsStream<Value, Suspension>(
+        [v]() { return ConsCell<Value, Suspension>(v); });
 }
 
 template <template <typename> typename Applicative, typename Value>
@@ -118,136 +148,151 @@ Applicative<typename std::decay<Value>::type> make(Value&& v) {
     return m(v);
 }
 
-template <typename Value>
+template <typename Value, typename Suspension>
 class ConsStreamIterator : public std::iterator<std::forward_iterator_tag,
                                                 std::remove_cv_t<Value>,
                                                 std::ptrdiff_t,
                                                 Value*,
                                                 Value&> {
-    Thunk<ConsCell<Value>> thunked_cell_;
+    using Cell =
+        typename Suspension::template Cell<ConsCell<Value, Suspension>>;
+
+    Cell cell_;
 
-    explicit ConsStreamIterator(Thunk<ConsCell<Value>> cell)
-        : thunked_cell_(cell) {}
+    explicit ConsStreamIterator(Cell cell) : cell_(cell) {}
 
-    friend class ConsStream<Value>;
+    friend class ConsStream<Value, Suspension>;
 
   public:
     ConsStreamIterator() = default; // Default construct gives end.
 
     void swap(ConsStreamIterator& other) noexcept {
         using std::swap;
-        swap(thunked_cell_, other.thunked_cell_);
+        swap(cell_, other.cell_);
     }
 
     ConsStreamIterator& operator++() // Pre-increment
     {
-        thunked_cell_ = evaluate(thunked_cell_).tail().thunked_cell_;
+        cell_ = Suspension::force(cell_).tail().cell_;
         return *this;
     }
 
     ConsStreamIterator operator++(int) // Post-increment
     {
         ConsStreamIterator tmp(*this);
-        thunked_cell_ = evaluate(thunked_cell_).tail().thunked_cell_;
+        cell_ = Suspension::force(cell_).tail().cell_;
         return tmp;
     }
 
     // two-way comparison: v.begin() == v.cbegin() and vice versa
     template <class OtherType>
-    bool operator==(const ConsStreamIterator<OtherType>& rhs) const {
-        return thunked_cell_ == rhs.thunked_cell_;
+    bool
+    operator==(const ConsStreamIterator<OtherType, Suspension>& rhs) const {
+        return cell_ == rhs.cell_;
     }
 
     template <class OtherType>
-    bool operator!=(const ConsStreamIterator<OtherType>& rhs) const {
-        return thunked_cell_ != rhs.thunked_cell_;
+    bool
+    operator!=(const ConsStreamIterator<OtherType, Suspension>& rhs) const {
+        return cell_ != rhs.cell_;
     }
 
-    Value const& operator*() const { return evaluate(thunked_cell_).head_; }
+    Value const& operator*() const { return Suspension::force(cell_).head_; }
 
-    Value const* operator->() const { return &evaluate(thunked_cell_).head_; }
+    Value const* operator->() const {
+        return &Suspension::force(cell_).head_;
+    }
 };
 
-template <typename Value>
-ConsStream<Value> cons(Value n, ConsStream<Value> stream) {
-    return ConsStream<Value>(
-        [n, stream]() { return ConsCell<Value>(n, stream); });
+template <typename Value, typename Suspension>
+ConsStream<Value, Suspension> cons(Value                         n,
+                                   ConsStream<Value, Suspension> stream) {
+    return ConsStream<Value, Suspension>(
+        [n, stream]() { return ConsCell<Value, Suspension>(n, stream); });
 }
 
-template <typename Value>
-Value last(ConsStream<Value> const& stream) {
-    ConsStream<Value> s = stream;
+template <typename Value, typename Suspension>
+Value last(ConsStream<Value, Suspension> const& stream) {
+    ConsStream<Value, Suspension> s = stream;
     while (!s.tail().isEmpty()) {
         s = s.tail();
     }
     return s.head();
 }
 
-template <typename Value>
-ConsStream<Value> init(ConsStream<Value> const& stream) {
+template <typename Value, typename Suspension>
+ConsStream<Value, Suspension>
+init(ConsStream<Value, Suspension> const& stream) {
     if (stream.tail().isEmpty()) {
-        return ConsStream<Value>();
+        return ConsStream<Value, Suspension>();
     }
     return cons(stream.head(), init(stream.tail()));
 }
 
-template <typename Value>
-size_t lengthAcc(ConsStream<Value> const& stream, size_t n) {
+template <typename Value, typename Suspension>
+size_t lengthAcc(ConsStream<Value, Suspension> const& stream, size_t n) {
     if (stream.isEmpty()) {
         return n;
     }
     return lengthAcc(stream.tail(), n + 1);
 }
 
-template <typename Value>
-size_t length(ConsStream<Value> const& stream) {
+template <typename Value, typename Suspension>
+size_t length(ConsStream<Value, Suspension> const& stream) {
     return lengthAcc(stream, 0);
 }
 
-template <typename Value, typename Predicate>
-ConsStream<Value> filter(Predicate const& p, ConsStream<Value> stream) {
+template <typename Value, typename Suspension, typename Predicate>
+ConsStream<Value, Suspension> filter(Predicate const&              p,
+                                     ConsStream<Value, Suspension> stream) {
     while (!stream.isEmpty() && !p(stream.head())) {
         stream = stream.tail();
     }
 
     if (stream.isEmpty()) {
-        return ConsStream<Value>();
+        return ConsStream<Value, Suspension>();
     }
 
-    return ConsStream<Value>([p, stream]() {
-        return ConsCell<Value>(stream.head(), filter(p, stream.tail()));
+    return ConsStream<Value, Suspension>([p, stream = std::move(stream)]() {
+        return ConsCell<Value, Suspension>(stream.head(),
+                                           filter(p, stream.tail()));
     });
 }
 
-template <typename Value>
-ConsStream<Value> rangeFrom(Value n, Value m) {
+template <typename Value, typename Suspension = ThunkSuspension>
+ConsStream<Value, Suspension> rangeFrom(Value n, Value m) {
     if (n > m) {
-        return ConsStream<Value>();
+        return ConsStream<Value, Suspension>();
     }
-    return ConsStream<Value>(
-        [n, m]() { return ConsCell<Value>(n, rangeFrom(n + 1, m)); });
+    return ConsStream<Value, Suspension>([n, m]() {
+        return ConsCell<Value, Suspension>(
+            n, rangeFrom<Value, Suspension>(n + 1, m));
+    });
 }
 
-template <typename Value>
-ConsStream<Value> iota(Value n = Value()) {
-    return ConsStream<Value>(
-        [n]() { return ConsCell<Value>(n, iota(n + 1)); });
+template <typename Value, typename Suspension = ThunkSuspension>
+ConsStream<Value, Suspension> iota(Value n = Value()) {
+    return ConsStream<Value, Suspension>([n]() {
+        return ConsCell<Value, Suspension>(n, iota<Value, Suspension>(n + 1));
+    });
 }
 
-template <typename Value>
-ConsStream<Value> take(ConsStream<Value> const& strm, int n) {
+template <typename Value, typename Suspension>
+ConsStream<Value, Suspension> take(ConsStream<Value, Suspension> strm, int n) {
     if (n == 0 || strm.isEmpty()) {
-        return ConsStream<Value>();
+        return ConsStream<Value, Suspension>();
     }
-    return ConsStream<Value>([strm, n]() {
-        return ConsCell<Value>(strm.head(), take(strm.tail(), n - 1));
+    return ConsStream<Value, Suspension>([strm = std::move(strm), n]() {
+        return ConsCell<Value, Suspension>(strm.head(),
+                                           take(strm.tail(), n - 1));
     });
 }
 
-template <typename Value>
-ConsStream<Value> drop(ConsStream<Value> const& strm, int n) {
+template <typename Value, typename Suspension>
+ConsStream<Value, Suspension> drop(ConsStream<Value, Suspension> const& strm,
+                                   int                                  n) {
     if (strm.isEmpty()) {
-        return ConsStream<Value>();
+        return ConsStream<Value, Suspension>();
     }
 
     if (n == 0) {
@@ -257,38 +302,51 @@ ConsStream<Value> drop(ConsStream<Value> const& strm, int n) {
     return drop(strm.tail(), n - 1);
 }
 
-template <typename Value>
-ConsStream<Value> append(ConsStream<Value> const& first,
-                         ConsStream<Value> const& second) {
+template <typename Value, typename Suspension>
+ConsStream<Value, Suspension> append(ConsStream<Value, Suspension> first,
+                                     ConsStream<Value, Suspension> second) {
     if (first.isEmpty()) {
         return second;
     }
-    return ConsStream<Value>([first, second]() {
-        return ConsCell<Value>(first.head(), append(first.tail(), second));
-    });
+    return ConsStream<Value, Suspension>(
+        [first = std::move(first), second = std::move(second)]() {
+            return ConsCell<Value, Suspension>(first.head(),
+                                               append(first.tail(), second));
+        });
 }
 
-template <typename Value>
-ConsStream<Value> append(ConsStream<Value> const&        first,
-                         Thunk<ConsStream<Value>> const& second) {
+// Append a stream that has not been computed yet.  'second' is a suspended
+// stream, of any policy, forced only when 'first' runs out.
+template <typename Value,
+          typename Suspension,
+          typename Deferred,
+          typename = typename std::enable_if<
+              !std::is_same<Deferred, ConsStream<Value, Suspension>>::value &&
+              std::is_convertible<Deferred const&,
+                                  ConsStream<Value, Suspension> const&>::
+                  value>::type>
+ConsStream<Value, Suspension> append(ConsStream<Value, Suspension> first,
+                                     Deferred const&               second) {
     if (first.isEmpty()) {
-        return evaluate(second);
+        return static_cast<ConsStream<Value, Suspension> const&>(second);
     }
-    return ConsStream<Value>([first, second]() {
-        return ConsCell<Value>(first.head(), append(first.tail(), second));
+    return ConsStream<Value, Suspension>([first = std::move(first), second]() {
+        return ConsCell<Value, Suspension>(first.head(),
+                                           append(first.tail(), second));
     });
 }
 
-template <typename Value, typename Func>
-auto fmap(ConsStream<Value> const& stream, Func const& f)
-    -> ConsStream<decltype(f(stream.head()))> {
+template <typename Value, typename Suspension, typename Func>
+auto fmap(ConsStream<Value, Suspension> stream, Func const& f)
+    -> ConsStream<decltype(f(stream.head())), Suspension> {
     using Mapped = decltype(f(stream.head()));
     if (stream.isEmpty()) {
-        return ConsStream<Mapped>();
+        return ConsStream<Mapped, Suspension>();
     }
 
-    return ConsStream<Mapped>([stream, f]() {
-        return ConsCell<Mapped>(f(stream.head()), fmap(stream.tail(), f));
+    return ConsStream<Mapped, Suspension>([stream = std::move(stream), f]() {
+        return ConsCell<Mapped, Suspension>(f(stream.head()),
+                                            fmap(stream.tail(), f));
     });
 }
 
@@ -296,14 +354,21 @@ auto fmap(ConsStream<Value> const& stream, Func const& f)
   foldr            :: (a -> b -> b) -> b -> [a] -> b
   foldr f z []     =  z
   foldr f z (x:xs) =  f x (foldr f z xs)
+
+  The fold of the rest is passed to 'op' suspended, as a
+  'Suspension::Cell<Result>', which converts to 'Result const&'.
 */
-template <typename Value, typename Result, typename Op>
-Result foldr(Op op, Result const& init, ConsStream<Value> const& stream) {
+template <typename Value, typename Suspension, typename Result, typename Op>
+Result
+foldr(Op op, Result const& init, ConsStream<Value, Suspension> const& stream) {
     if (stream.isEmpty()) {
         return init;
     }
     return op(stream.head(),
-              thunk(foldr<Value, Result, Op>, op, init, stream.tail()));
+              Suspension::template suspend<Result>(
+                  [op, init, rest = stream.tail()]() {
+                      return foldr(op, init, rest);
+                  }));
 }
 
 /*
@@ -311,56 +376,61 @@ Result foldr(Op op, Result const& init, ConsStream<Value> const& stream) {
   concat xss = foldr (++) [] xss
 */
 // Note - copy streams, because we're going to reassign to it
-template <typename Value>
-ConsStream<Value> concat(ConsStream<ConsStream<Value>> streams) {
+template <typename Value, typename Inner, typename Suspension>
+ConsStream<Value, Inner>
+concat(ConsStream<ConsStream<Value, Inner>, Suspension> streams) {
+    using Stream = ConsStream<Value, Inner>;
     while (!streams.isEmpty() && streams.head().isEmpty()) {
         streams = streams.tail();
     }
 
     if (streams.isEmpty()) {
-        return ConsStream<Value>();
+        return Stream();
     }
 
     return foldr(
-        static_cast<ConsStream<Value> (&)(ConsStream<Value> const&,
-                                          Thunk<ConsStream<Value>> const&)>(
-            append),
-        ConsStream<Value>(),
+        [](Stream const&                                         first,
+           typename Suspension::template Cell<Stream> const& second) {
+            return append(first, second);
+        },
+        Stream(),
         streams);
 }
 
 // Note - copy streams, because we're going to reassign to it
-template <typename Value>
-ConsStream<Value> join(ConsStream<ConsStream<Value>> streams) {
+template <typename Value, typename Inner, typename Suspension>
+ConsStream<Value, Inner>
+join(ConsStream<ConsStream<Value, Inner>, Suspension> streams) {
     while (!streams.isEmpty() && streams.head().isEmpty()) {
         streams = streams.tail();
     }
 
     if (streams.isEmpty()) {
-        return ConsStream<Value>();
+        return ConsStream<Value, Inner>();
     }
 
-    return ConsStream<Value>([streams]() {
-        return ConsCell<Value>(
-            streams.head().head(),
-            append(streams.head().tail(), join(streams.tail())));
+    return ConsStream<Value, Inner>([streams = std::move(streams)]() {
+        ConsStream<Value, Inner> first = streams.head();
+        return ConsCell<Value, Inner>(
+            first.head(), append(first.tail(), join(streams.tail())));
     });
 }
 
-template <typename Value, typename Func>
-auto bind(ConsStream<Value> const& stream, Func const& f)
+template <typename Value, typename Suspension, typename Func>
+auto bind(ConsStream<Value, Suspension> const& stream, Func const& f)
     -> decltype(f(stream.head())) {
     return join(fmap(stream, f));
 }
 
-template <typename Value, typename Func>
-auto then(ConsStream<Value> const& stream, Func const& f) -> decltype(f()) {
+template <typename Value, typename Suspension, typename Func>
+auto then(ConsStream<Value, Suspension> const& stream, Func const& f)
+    -> decltype(f()) {
     return join(fmap(stream, [f](Value const&) { return f(); }));
 }
 
 // Note - copy streams, because we're going to reassign to itx
-template <typename Value, typename Func>
-auto bind2(ConsStream<Value> stream, Func const& f)
+template <typename Value, typename Suspension, typename Func>
+auto bind2(ConsStream<Value, Suspension> stream, Func const& f)
     -> decltype(f(stream.head())) {
     using M = decltype(bind2(stream, f));
 
@@ -380,31 +450,33 @@ auto bind2(ConsStream<Value> stream, Func const& f)
         return M();
     }
 
-    return M([y, stream, f]() {
-        using T = decltype(y.head());
-        return ConsCell<T>(y.head(),
-                           append(y.tail(), bind2(stream.tail(), f)));
+    return M([y = std::move(y), stream = std::move(stream), f]() {
+        return typename M::cell_type(
+            y.head(), append(y.tail(), bind2(stream.tail(), f)));
     });
 }
 
-template <typename Value, typename Func>
-auto then2(ConsStream<Value> const& stream, Func const& f) -> decltype(f()) {
+template <typename Value, typename Suspension, typename Func>
+auto then2(ConsStream<Value, Suspension> const& stream, Func const& f)
+    -> decltype(f()) {
     return bind2(stream, [f](Value const&) { return f(); });
 }
 
-template <typename Value>
-ConsStream<Value> join2(ConsStream<ConsStream<Value>> streams) {
+template <typename Value, typename Inner, typename Suspension>
+ConsStream<Value, Inner>
+join2(ConsStream<ConsStream<Value, Inner>, Suspension> streams) {
     return bind2(streams,
                  [](auto&& v) { return std::forward<decltype(v)>(v); });
 }
 
 using Unit = std::tuple<>;
 
-ConsStream<Unit> guard(bool b) {
+template <typename Suspension = ThunkSuspension>
+ConsStream<Unit, Suspension> guard(bool b) {
     if (b) {
-        return ConsStream<Unit>(Unit());
+        return ConsStream<Unit, Suspension>(Unit());
     } else {
-        return ConsStream<Unit>();
+        return ConsStream<Unit, Suspension>();
     }
 }
 
@@ -421,15 +493,16 @@ auto dot(FuncF&& f, FuncG&& g) {
 // concatMap               :: (a -> [b]) -> [a] -> [b]
 // concatMap f             =  foldr ((++) . f) []
 
-template <typename Func, typename Value>
-auto concatMap(Func&& f, ConsStream<Value> const& stream) {
+template <typename Func, typename Value, typename Suspension>
+auto concatMap(Func&& f, ConsStream<Value, Suspension> const& stream) {
     //  -> ConsStream<decltype(f(stream.head())::value)> {
-    using ResultOf = std::result_of_t<Func(Value)>;
+    using ResultOf = std::invoke_result_t<Func, Value>;
 
-    auto appendF = [f_ = std::forward<Func>(f)](Value                  v,
-                                                Thunk<ResultOf> const& s) {
-        return append(f_(v), s);
-    };
+    auto appendF =
+        [f_ = std::forward<Func>(f)](
+            Value v, typename Suspension::template Cell<ResultOf> const& s) {
+            return append(f_(v), s);
+        };
 
     return foldr(appendF, ResultOf(), stream);
 }
@@ -445,25 +518,33 @@ auto concatMap(Func&& f, ConsStream<Value> const& stream) {
 // == concatMap (\f -> concatMap (\x -> [f x]) xs) fs
 // == fs >>= (\f ->  xs >>= \x -> return (f x))
 
-template <typename Value, typename Func>
-auto app2(ConsStream<Func> const& funcs, ConsStream<Value> const& values)
+template <typename Value, typename Func, typename Suspension>
+auto app2(ConsStream<Func, Suspension> const&  funcs,
+          ConsStream<Value, Suspension> const& values)
 //  -> decltype(funcs.head()(values.head())) {
 {
     return concatMap(
         [values](Func const& f) {
-            return concatMap([f](Value v) { return make<ConsStream>(f(v)); },
-                             values);
+            return concatMap(
+                [f](Value v) {
+                    using Result = std::decay_t<decltype(f(v))>;
+                    return ConsStream<Result, Suspension>(f(v));
+                },
+                values);
         },
         funcs);
     //  return funcs.head()(values.head());
 }
-template <typename Value, typename Func>
-auto app(ConsStream<Func> const& funcs, ConsStream<Value> const& values)
+template <typename Value, typename Func, typename Suspension>
+auto app(ConsStream<Func, Suspension> const&  funcs,
+         ConsStream<Value, Suspension> const& values)
 //  -> decltype(funcs.head()(values.head())) {
 {
     return bind2(funcs, [values](Func const& f) {
-        return bind2(values,
-                     [f](Value const& v) { return make<ConsStream>(f(v)); });
+        return bind2(values, [f](Value const& v) {
+            using Result = std::decay_t<decltype(f(v))>;
+            return ConsStream<Result, Suspension>(f(v));
+        });
     });
 }
 } // namespace co_fun
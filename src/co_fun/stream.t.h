@@ -0,0 +1,55 @@
+// stream.t.h                                                         -*-C++-*-
+#ifndef INCLUDED_CO_FUN_STREAM_T
+#define INCLUDED_CO_FUN_STREAM_T
+
+//@PURPOSE: Provide streams from, and into, vectors for the test drivers.
+//
+//@CLASSES:
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: 'fromVector' makes a lazy stream of the values of a vector,
+// and 'collect' forces every element of a finite stream into a vector, of
+// the stream's own element type or of another it converts to.
+//..
+//  auto s = test::fromVector<int>({3, 1, 2});
+//  EXPECT_EQ((std::vector<int>{3, 1, 2}), test::collect(s));
+//  EXPECT_EQ(expected, test::collect<std::string>(lines(mapped)));
+//..
+
+#include <co_fun/stream.h>
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace co_fun {
+namespace test {
+
+template <typename Value>
+ConsStream<Value> fromVector(std::vector<Value> const& values,
+                             std::size_t               i = 0) {
+    if (i == values.size()) {
+        return ConsStream<Value>();
+    }
+    return ConsStream<Value>([values, i]() {
+        return ConsCell<Value>(values[i], fromVector(values, i + 1));
+    });
+}
+
+// The elements of 'stream', as 'Element's if given.
+template <typename Element = void, typename Stream>
+auto collect(Stream stream) {
+    using Head = std::decay_t<decltype(stream.head())>;
+    std::vector<std::conditional_t<std::is_void_v<Element>, Head, Element>>
+        result;
+    for (; !stream.isEmpty(); stream = stream.tail()) {
+        result.emplace_back(stream.head());
+    }
+    return result;
+}
+
+} // namespace test
+} // namespace co_fun
+
+#endif
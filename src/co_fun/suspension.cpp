@@ -0,0 +1,2 @@
+// suspension.cpp                                                     -*-C++-*-
+#include <co_fun/suspension.h>
@@ -0,0 +1,100 @@
+// suspension.h                                                       -*-C++-*-
+#ifndef INCLUDED_CO_FUN_SUSPENSION
+#define INCLUDED_CO_FUN_SUSPENSION
+
+//@PURPOSE: Provide the suspension policies for co_fun::ConsStream.
+//
+//@CLASSES:
+//  co_fun::ThunkSuspension: cells are coroutine Thunks
+//  co_fun::MemoSuspension: cells are unsynchronized Memos
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: A 'ConsStream' is parameterized on how its cells are
+// suspended.  A suspension policy is a type providing:
+//
+//..
+//  template <typename T> using Cell = ...;
+//      // A shared handle to a suspended 'T'.  Default constructed it is
+//      // empty; copies share one evaluation; equality is identity; and it
+//      // converts to 'T const&', forcing it.
+//
+//  template <typename T, typename F> static Cell<T> suspend(F&& f);
+//      // A cell whose value is 'f()', not yet evaluated.
+//
+//  template <typename T> static T const& force(Cell<T> const&);
+//  template <typename T> static bool isEmpty(Cell<T> const&);
+//  template <typename T> static bool isForced(Cell<T> const&);
+//..
+//
+// 'ThunkSuspension', the default, suspends cells as 'Thunk' coroutines,
+// which may be forced from any thread.  'MemoSuspension' is the cheapest
+// policy, for streams that are only ever used from one thread.  Under
+// either, a cell whose function throws 'Cancelled' stays unevaluated, and
+// forcing it again calls the function again.  The delay library
+// adds policies over 'Delay' and 'DelayAsync'.
+
+#include <co_fun/cancellation.h>
+#include <co_fun/memo.h>
+#include <co_fun/thunk.h>
+
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace co_fun {
+
+struct ThunkSuspension {
+    template <typename T>
+    using Cell = Thunk<T>;
+
+    template <typename T, typename F>
+    static Cell<T> suspend(F&& f) {
+        return detail::cancellable<Cell<T>, std::decay_t<F>>(
+            std::forward<F>(f));
+    }
+
+    template <typename T>
+    static T const& force(Cell<T> const& cell) {
+        return evaluate(cell);
+    }
+
+    template <typename T>
+    static bool isEmpty(Cell<T> const& cell) {
+        return cell.isEmpty();
+    }
+
+    template <typename T>
+    static bool isForced(Cell<T> const& cell) {
+        return cell.evaluated();
+    }
+};
+
+struct MemoSuspension {
+    template <typename T>
+    using Cell = Memo<T>;
+
+    template <typename T, typename F>
+    static Cell<T> suspend(F&& f) {
+        return memo<T>(std::forward<F>(f));
+    }
+
+    template <typename T>
+    static T const& force(Cell<T> const& cell) {
+        return cell.get();
+    }
+
+    template <typename T>
+    static bool isEmpty(Cell<T> const& cell) {
+        return cell.isEmpty();
+    }
+
+    template <typename T>
+    static bool isForced(Cell<T> const& cell) {
+        return cell.evaluated();
+    }
+};
+
+} // namespace co_fun
+
+#endif
@@ -0,0 +1,86 @@
+#include <co_fun/suspension.h>
+
+#include <co_fun/stream.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace co_fun;
+
+namespace {
+template <typename Suspension>
+class Co_FunSuspensionTest : public ::testing::Test {};
+
+using Policies = ::testing::Types<ThunkSuspension, MemoSuspension>;
+} // namespace
+
+TYPED_TEST_SUITE(Co_FunSuspensionTest, Policies);
+
+TYPED_TEST(Co_FunSuspensionTest, Cell) {
+    using S   = TypeParam;
+    int  calls = 0;
+    auto cell  = S::template suspend<int>([&calls]() { return ++calls; });
+    EXPECT_FALSE(S::isEmpty(cell));
+    EXPECT_FALSE(S::isForced(cell));
+    auto copy = cell;
+    EXPECT_TRUE(copy == cell);
+    EXPECT_EQ(1, S::force(copy));
+    EXPECT_TRUE(S::isForced(cell));
+    int const& converted = cell;
+    EXPECT_EQ(1, converted);
+    EXPECT_EQ(1, calls);
+
+    typename S::template Cell<int> empty;
+    EXPECT_TRUE(S::isEmpty(empty));
+}
+
+TYPED_TEST(Co_FunSuspensionTest, Stream) {
+    using S = TypeParam;
+    ConsStream<int, S> inf   = iota<int, S>(0);
+    ConsStream<int, S> first = take(inf, 5);
+    EXPECT_EQ(0, inf.countForced());
+
+    std::vector<int> v;
+    for (int i : first) {
+        v.push_back(i);
+    }
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 4}), v);
+    EXPECT_EQ(5, inf.countForced());
+
+    auto evens = filter([](int i) { return i % 2 == 0; }, inf);
+    auto sq    = fmap(take(evens, 4), [](int i) { return i * i; });
+    EXPECT_EQ(36, last(sq));
+    EXPECT_EQ(4u, length(sq));
+    EXPECT_EQ(5, drop(inf, 5).head());
+
+    auto nested = fmap(rangeFrom<int, S>(1, 3),
+                       [](int i) { return rangeFrom<int, S>(1, i); });
+    EXPECT_EQ(6u, length(concat(nested)));
+    EXPECT_EQ(6u, length(join(nested)));
+    EXPECT_EQ(6u, length(join2(nested)));
+    EXPECT_EQ(
+        6u,
+        length(concatMap([](int i) { return rangeFrom<int, S>(1, i); },
+                         rangeFrom<int, S>(1, 3))));
+    EXPECT_EQ(30, foldr([](int i, int j) { return i + j; },
+                        0,
+                        fmap(take(inf, 5), [](int i) { return 2 * i + 2; })));
+}
+
+TYPED_TEST(Co_FunSuspensionTest, Triples) {
+    using S      = TypeParam;
+    auto triples = bind2(iota<int, S>(1), [](int z) {
+        return bind2(rangeFrom<int, S>(1, z), [z](int x) {
+            return bind2(rangeFrom<int, S>(x, z), [x, z](int y) {
+                return then2(guard<S>(x * x + y * y == z * z), [x, y, z]() {
+                    return ConsStream<std::tuple<int, int, int>, S>(
+                        std::make_tuple(x, y, z));
+                });
+            });
+        });
+    });
+    EXPECT_EQ(std::make_tuple(5, 12, 13), last(take(triples, 3)));
+}
@@ -0,0 +1,203 @@
+// tailstream.cpp                                                     -*-C++-*-
+#include <co_fun/tailstream.h>
+
+#include <cerrno>
+#include <stop_token>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace co_fun {
+
+namespace {
+std::system_error systemError(char const* what) {
+    return std::system_error(errno, std::generic_category(), what);
+}
+
+std::string directoryOf(std::string const& path) {
+    std::size_t slash = path.rfind('/');
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+void closeIfOpen(int fd) {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+} // namespace
+
+TailReader::TailReader(std::string path, TailOptions const& options)
+    : path_(std::move(path)),
+      buffer_(options.blockSize ? options.blockSize : 1) {
+    inotify_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    epoll_   = ::epoll_create1(EPOLL_CLOEXEC);
+    wake_    = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inotify_ < 0 || epoll_ < 0 || wake_ < 0) {
+        auto error = systemError("tail setup");
+        closeIfOpen(inotify_);
+        closeIfOpen(epoll_);
+        closeIfOpen(wake_);
+        throw error;
+    }
+    for (int fd : {inotify_, wake_}) {
+        epoll_event event{};
+        event.events  = EPOLLIN;
+        event.data.fd = fd;
+        ::epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    // The directory tells us when a file appears at, or leaves, the path.
+    if (::inotify_add_watch(inotify_,
+                            directoryOf(path_).c_str(),
+                            IN_CREATE | IN_MOVED_TO | IN_MOVED_FROM |
+                                IN_DELETE) < 0) {
+        auto error = systemError("inotify_add_watch");
+        closeIfOpen(inotify_);
+        closeIfOpen(epoll_);
+        closeIfOpen(wake_);
+        throw error;
+    }
+    open(options.fromStart);
+}
+
+TailReader::~TailReader() {
+    closeIfOpen(fd_);
+    closeIfOpen(wake_);
+    closeIfOpen(epoll_);
+    closeIfOpen(inotify_);
+}
+
+void TailReader::open(bool fromStart) {
+    fd_ = ::open(path_.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd_ < 0) {
+        return;
+    }
+    position_ = 0;
+    if (!fromStart) {
+        off_t end = ::lseek(fd_, 0, SEEK_END);
+        position_ = end > 0 ? std::uint64_t(end) : 0;
+    }
+    if (fileWatch_ >= 0) {
+        ::inotify_rm_watch(inotify_, fileWatch_);
+    }
+    fileWatch_ = ::inotify_add_watch(inotify_,
+                                     path_.c_str(),
+                                     IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF |
+                                         IN_DELETE_SELF);
+}
+
+void TailReader::readAvailable() {
+    if (fd_ < 0) {
+        return;
+    }
+    for (;;) {
+        ssize_t n = ::read(fd_, buffer_.data(), buffer_.size());
+        if (n > 0) {
+            pending_.append(buffer_.data(), std::size_t(n));
+            position_ += std::uint64_t(n);
+        } else if (n == 0 || errno == EAGAIN) {
+            return;
+        } else if (errno != EINTR) {
+            throw systemError("read");
+        }
+    }
+}
+
+void TailReader::endPartialLine() {
+    if (!pending_.empty() && pending_.back() != '\n') {
+        pending_.push_back('\n');
+    }
+}
+
+void TailReader::checkRotation() {
+    if (fd_ < 0) {
+        open(true);
+        readAvailable();
+        return;
+    }
+    struct stat current;
+    struct stat atPath;
+    if (::fstat(fd_, &current) != 0) {
+        throw systemError("fstat");
+    }
+    if (::stat(path_.c_str(), &atPath) != 0) {
+        // Moved away or removed; keep reading the old file until a new one
+        // takes its place.
+        return;
+    }
+    if (current.st_ino != atPath.st_ino || current.st_dev != atPath.st_dev) {
+        readAvailable();
+        endPartialLine();
+        ::close(fd_);
+        open(true);
+        readAvailable();
+    } else if (std::uint64_t(current.st_size) < position_) {
+        endPartialLine();
+        ::lseek(fd_, 0, SEEK_SET);
+        position_ = 0;
+        readAvailable();
+    }
+}
+
+void TailReader::wait() {
+    epoll_event events[2];
+    int         n = ::epoll_wait(epoll_, events, 2, -1);
+    if (n < 0 && errno != EINTR) {
+        throw systemError("epoll_wait");
+    }
+    // The events only say that something changed; drain them and look.
+    alignas(inotify_event) char drain[4096];
+    while (::read(inotify_, drain, sizeof drain) > 0) {
+    }
+    std::uint64_t count;
+    (void)::read(wake_, &count, sizeof count);
+}
+
+std::optional<Chunk> TailReader::takeLines() {
+    std::size_t last = pending_.rfind('\n');
+    if (last == std::string::npos) {
+        return std::nullopt;
+    }
+    Chunk batch =
+        Chunk::copyOf(std::string_view(pending_).substr(0, last + 1));
+    pending_.erase(0, last + 1);
+    return batch;
+}
+
+Chunk TailReader::next() {
+    // Only this force gives up on the thread's stop; the reader carries on.
+    std::stop_callback cancel(EvaluationContext::stopToken(),
+                              [this]() { wakeUp(); });
+    for (;;) {
+        if (stopped_.load(std::memory_order_acquire) ||
+            EvaluationContext::stopRequested()) {
+            throw Cancelled();
+        }
+        readAvailable();
+        checkRotation();
+        if (std::optional<Chunk> batch = takeLines()) {
+            return *std::move(batch);
+        }
+        wait();
+    }
+}
+
+void TailReader::wakeUp() {
+    std::uint64_t one = 1;
+    (void)::write(wake_, &one, sizeof one);
+}
+
+void TailReader::stop() {
+    stopped_.store(true, std::memory_order_release);
+    wakeUp();
+}
+
+} // namespace co_fun
@@ -0,0 +1,162 @@
+// tailstream.h                                                       -*-C++-*-
+#ifndef INCLUDED_CO_FUN_TAILSTREAM
+#define INCLUDED_CO_FUN_TAILSTREAM
+
+//@PURPOSE: Follow a growing file as an endless stream, like 'tail -F'.
+//
+//@CLASSES:
+//  co_fun::TailReader: follower of a file path across rotation
+//  co_fun::TailOptions: where following starts, and the read size
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: 'follow(path)' is an endless lazy 'ConsStream<Chunk>' of
+// the lines appended to the file at 'path'.  Each element is a batch: every
+// complete line that became available by one wakeup, each ending in '\n'.
+// 'followLines(path)' is the same lines one at a time, each a sub-chunk of
+// its batch with the '\n' removed.  A line is not produced until its '\n'
+// has been written.
+//
+//..
+//  auto errors = filter([](Chunk const& line) {
+//                           return line.view().starts_with("ERROR");
+//                       },
+//                       followLines("/var/log/app.log"));
+//  for (Chunk const& line : errors) { alert(line.view()); }
+//..
+//
+// A 'TailReader' blocks in 'epoll' on an inotify descriptor watching the
+// file and its directory, so a follower waiting for data uses no CPU, and
+// wakes as soon as the file is written.  Like 'tail -F', it follows the
+// path rather than the open file:
+//: o When the file is renamed or removed and a new one created at the path,
+//:   the rest of the old file is read, then the new one from its start.
+//: o When the file is truncated in place, reading restarts at its start.
+//: o When the file does not exist yet, the reader waits for it.
+// A partial last line of a file that is rotated away or truncated is ended
+// with a '\n' rather than joined to the next file's first line.
+//
+// Unlike a finite stream, an endless one needs no lookahead, so forcing a
+// cell waits only for its own batch.  It is stopped for good by
+// 'TailReader::stop': the wait in progress, and every later one, throws
+// 'Cancelled'.  A stop of the evaluating thread's 'EvaluationContext' gives
+// up only that thread's wait, leaving the cell to be forced again.
+
+#include <co_fun/bufferpool.h>
+#include <co_fun/cancellation.h>
+#include <co_fun/stream.h>
+#include <co_fun/suspension.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace co_fun {
+
+struct TailOptions {
+    // Start with the lines already in the file, rather than at its end.
+    // Files that appear later are always read from their start.
+    bool fromStart = false;
+
+    // Largest number of bytes read at once.
+    std::size_t blockSize = std::size_t(64) << 10;
+};
+
+class TailReader {
+    std::string       path_;
+    int               inotify_   = -1;
+    int               epoll_     = -1;
+    int               wake_      = -1;
+    int               fd_        = -1;
+    int               fileWatch_ = -1;
+    std::uint64_t     position_  = 0;
+    std::string       pending_;
+    std::vector<char> buffer_;
+    std::atomic<bool> stopped_{false};
+
+    void open(bool fromStart);
+    void readAvailable();
+    void endPartialLine();
+    void checkRotation();
+    void wait();
+    void wakeUp();
+    std::optional<Chunk> takeLines();
+
+  public:
+    explicit TailReader(std::string path, TailOptions const& options = {});
+
+    TailReader(TailReader const&) = delete;
+    TailReader& operator=(TailReader const&) = delete;
+
+    ~TailReader();
+
+    // The complete lines written since the last batch, blocking until there
+    // is at least one.  Throws 'Cancelled' once stopped, or if this thread's
+    // evaluation is.
+    Chunk next();
+
+    // Stop following; may be called from any thread.
+    void stop();
+};
+
+namespace detail {
+
+template <typename Suspension>
+ConsStream<Chunk, Suspension> followFrom(std::shared_ptr<TailReader> reader) {
+    return ConsStream<Chunk, Suspension>([reader]() {
+        Chunk batch = reader->next();
+        return ConsCell<Chunk, Suspension>(batch,
+                                           followFrom<Suspension>(reader));
+    });
+}
+
+template <typename Suspension>
+ConsStream<Chunk, Suspension>
+followLinesFrom(std::shared_ptr<TailReader> reader, Chunk rest) {
+    return ConsStream<Chunk, Suspension>([reader, rest]() {
+        Chunk       batch = rest.empty() ? reader->next() : rest;
+        std::size_t eol   = batch.view().find('\n');
+        return ConsCell<Chunk, Suspension>(
+            batch.substr(0, eol),
+            followLinesFrom<Suspension>(reader, batch.substr(eol + 1)));
+    });
+}
+
+} // namespace detail
+
+// ============================================================================
+//              INLINE FUNCTION AND FUNCTION TEMPLATE DEFINITIONS
+// ============================================================================
+
+template <typename Suspension = ThunkSuspension>
+ConsStream<Chunk, Suspension> follow(std::shared_ptr<TailReader> reader) {
+    return detail::followFrom<Suspension>(std::move(reader));
+}
+
+template <typename Suspension = ThunkSuspension>
+ConsStream<Chunk, Suspension> follow(std::string const& path,
+                                     TailOptions const& options = {}) {
+    return follow<Suspension>(std::make_shared<TailReader>(path, options));
+}
+
+template <typename Suspension = ThunkSuspension>
+ConsStream<Chunk, Suspension> followLines(std::shared_ptr<TailReader> reader) {
+    return detail::followLinesFrom<Suspension>(std::move(reader), Chunk());
+}
+
+template <typename Suspension = ThunkSuspension>
+ConsStream<Chunk, Suspension> followLines(std::string const& path,
+                                          TailOptions const& options = {}) {
+    return followLines<Suspension>(
+        std::make_shared<TailReader>(path, options));
+}
+
+} // namespace co_fun
+
+#endif
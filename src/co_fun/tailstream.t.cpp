@@ -0,0 +1,194 @@
+#include <co_fun/tailstream.h>
+#include <co_fun/tempfile.t.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace co_fun;
+
+namespace {
+using test::TempDir;
+
+void append(std::string const& path, std::string const& text) {
+    std::ofstream out(path, std::ios::app);
+    out << text;
+}
+
+void settle() { std::this_thread::sleep_for(std::chrono::milliseconds(20)); }
+
+template <typename Stream>
+std::vector<std::string> first(Stream stream, int n) {
+    std::vector<std::string> result;
+    for (int i = 0; i < n; ++i, stream = stream.tail()) {
+        result.emplace_back(stream.head().view());
+    }
+    return result;
+}
+} // namespace
+
+TEST(Co_FunTailStreamTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunTailStreamTest, FollowsAppends) {
+    TempDir     dir;
+    std::string log = dir.file("app.log");
+    append(log, "");
+
+    // Made first, so that the reader is at the end before the writes.
+    auto        lines = followLines(log);
+    std::thread writer([&]() {
+        settle();
+        append(log, "one\n");
+        settle();
+        append(log, "two\nthree\n");
+    });
+    EXPECT_EQ((std::vector<std::string>{"one", "two", "three"}),
+              first(lines, 3));
+    writer.join();
+}
+
+TEST(Co_FunTailStreamTest, Batches) {
+    TempDir     dir;
+    std::string log = dir.file("app.log");
+    append(log, "a\nb\n");
+
+    TailOptions options;
+    options.fromStart = true;
+    auto batches      = follow(log, options);
+    EXPECT_EQ("a\nb\n", batches.head().view());
+}
+
+TEST(Co_FunTailStreamTest, StartsAtEnd) {
+    TempDir     dir;
+    std::string log = dir.file("app.log");
+    append(log, "old\n");
+
+    auto        lines = followLines(log);
+    std::thread writer([&]() {
+        settle();
+        append(log, "new\n");
+    });
+    EXPECT_EQ("new", lines.head().view());
+    writer.join();
+}
+
+TEST(Co_FunTailStreamTest, PartialLine) {
+    TempDir     dir;
+    std::string log = dir.file("app.log");
+    append(log, "");
+
+    auto        lines = followLines(log);
+    std::thread writer([&]() {
+        append(log, "par");
+        settle();
+        append(log, "tial\nnext\n");
+    });
+    EXPECT_EQ((std::vector<std::string>{"partial", "next"}), first(lines, 2));
+    writer.join();
+}
+
+TEST(Co_FunTailStreamTest, Rotation) {
+    TempDir     dir;
+    std::string log = dir.file("app.log");
+    append(log, "");
+
+    auto        lines = followLines(log);
+    std::thread writer([&]() {
+        append(log, "before\nunfinished");
+        settle();
+        std::rename(log.c_str(), dir.file("app.log.1").c_str());
+        append(log, "after\n");
+    });
+    EXPECT_EQ((std::vector<std::string>{"before", "unfinished", "after"}),
+              first(lines, 3));
+    writer.join();
+}
+
+TEST(Co_FunTailStreamTest, Truncation) {
+    TempDir     dir;
+    std::string log = dir.file("app.log");
+    append(log, "");
+
+    auto        lines = followLines(log);
+    std::thread writer([&]() {
+        append(log, "a long first line\n");
+        settle();
+        std::ofstream(log, std::ios::trunc) << "b\n";
+    });
+    EXPECT_EQ((std::vector<std::string>{"a long first line", "b"}),
+              first(lines, 2));
+    writer.join();
+}
+
+TEST(Co_FunTailStreamTest, CreatedLater) {
+    TempDir     dir;
+    std::string log = dir.file("later.log");
+
+    auto        lines = followLines(log);
+    std::thread writer([&]() {
+        settle();
+        append(log, "hello\n");
+    });
+    EXPECT_EQ("hello", lines.head().view());
+    writer.join();
+}
+
+TEST(Co_FunTailStreamTest, Stop) {
+    TempDir     dir;
+    std::string log = dir.file("app.log");
+    append(log, "");
+
+    auto        reader = std::make_shared<TailReader>(log);
+    auto        lines  = followLines<MemoSuspension>(reader);
+    std::thread stopper([&]() {
+        settle();
+        reader->stop();
+    });
+    EXPECT_THROW(lines.head(), Cancelled);
+    stopper.join();
+}
+
+TEST(Co_FunTailStreamTest, StopToken) {
+    TempDir     dir;
+    std::string log = dir.file("app.log");
+    append(log, "");
+
+    auto             lines = followLines<MemoSuspension>(log);
+    std::stop_source stop;
+    std::thread      stopper([&]() {
+        settle();
+        stop.request_stop();
+    });
+    EvaluationContext::Scope scope(stop.get_token());
+    EXPECT_THROW(lines.head(), Cancelled);
+    stopper.join();
+}
+
+TEST(Co_FunTailStreamTest, StopTokenResumes) {
+    TempDir     dir;
+    std::string log = dir.file("app.log");
+    append(log, "");
+
+    auto lines = followLines(log);
+    {
+        std::stop_source stop;
+        std::thread      stopper([&]() {
+            settle();
+            stop.request_stop();
+        });
+        EvaluationContext::Scope scope(stop.get_token());
+        EXPECT_THROW(lines.head(), Cancelled);
+        stopper.join();
+    }
+    std::thread writer([&]() {
+        settle();
+        append(log, "one\n");
+    });
+    EXPECT_EQ("one", lines.head().view());
+    writer.join();
+}
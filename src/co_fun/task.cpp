@@ -0,0 +1,2 @@
+// task.cpp                                                           -*-C++-*-
+#include <co_fun/task.h>
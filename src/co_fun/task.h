@@ -0,0 +1,278 @@
+// task.h                                                             -*-C++-*-
+#ifndef INCLUDED_CO_FUN_TASK
+#define INCLUDED_CO_FUN_TASK
+
+//@PURPOSE: Provide an eager, executor scheduled coroutine result.
+//
+//@CLASSES:
+//  co_fun::Task: shareable handle to a computation running on an Executor
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: Where a 'Thunk' runs when somebody asks for its value, a
+// 'Task' starts running as soon as it is created, on a worker of the
+// 'Executor' passed as the coroutine's first parameter.  The value is
+// collected with the blocking 'get()', or with 'co_await' from another
+// 'Task', which suspends instead of blocking a worker.
+//
+// 'spawn' forces a 'Thunk' on the pool.  'when_all' forces several
+// independent thunks in parallel and collects their values into a tuple or
+// vector.  'when_any' forces a set of thunks in parallel and yields the
+// index and value of the first to finish.  The rest are cancelled: those
+// that have not started are never forced, and those in flight run under a
+// stopped 'EvaluationContext', so they give up at their next cancellation
+// point, unevaluated.  The thunks may also be forced by other threads: one
+// that another thread is already evaluating is waited for, and one that
+// gave up is left for the next force to resume.  Waiting for another
+// thread's evaluation is not cancelled, so a loser doing so keeps its
+// worker busy until that evaluation finishes.
+//
+// Calling 'get()' from a worker of the same pool can deadlock a pool that
+// is too small; inside the pool, 'co_await' the task instead.
+
+#include <co_fun/cancellation.h>
+#include <co_fun/executor.h>
+#include <co_fun/thunk.h>
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <stop_token>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace co_fun {
+
+namespace detail {
+
+template <typename Result>
+class TaskState {
+    std::atomic<bool>                    ready_{false};
+    std::mutex                           lock_;
+    std::vector<std::coroutine_handle<>> continuations_;
+    std::optional<Result>                value_;
+    std::exception_ptr                   error_;
+
+    void complete() {
+        std::vector<std::coroutine_handle<>> continuations;
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            ready_.store(true, std::memory_order_release);
+            continuations.swap(continuations_);
+        }
+        ready_.notify_all();
+        for (auto handle : continuations) {
+            handle.resume();
+        }
+    }
+
+  public:
+    template <typename... Args>
+    void setValue(Args&&... args) {
+        value_.emplace(std::forward<Args>(args)...);
+        complete();
+    }
+
+    void setError(std::exception_ptr error) {
+        error_ = error;
+        complete();
+    }
+
+    bool ready() const { return ready_.load(std::memory_order_acquire); }
+
+    void wait() const {
+        while (!ready_.load(std::memory_order_acquire)) {
+            ready_.wait(false, std::memory_order_acquire);
+        }
+    }
+
+    // Arrange for 'handle' to be resumed on completion.  Returns 'false',
+    // without registering, if the state is already complete.
+    bool addContinuation(std::coroutine_handle<> handle) {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (ready_.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        continuations_.push_back(handle);
+        return true;
+    }
+
+    Result const& get() const {
+        wait();
+        if (error_) {
+            std::rethrow_exception(error_);
+        }
+        return *value_;
+    }
+};
+
+} // namespace detail
+
+template <typename Result>
+class Task {
+    using State = detail::TaskState<Result>;
+
+    struct Promise {
+        std::shared_ptr<State> state_;
+        Executor&              executor_;
+
+        template <typename... Args>
+        Promise(Executor& executor, Args&&...)
+            : state_(std::make_shared<State>()), executor_(executor) {}
+
+        Task get_return_object() { return Task(state_); }
+
+        Executor::ScheduleAwaiter initial_suspend() {
+            return executor_.schedule();
+        }
+
+        std::suspend_never final_suspend() noexcept { return {}; }
+
+        void return_value(Result v) { state_->setValue(std::move(v)); }
+
+        void unhandled_exception() {
+            state_->setError(std::current_exception());
+        }
+    };
+
+    std::shared_ptr<State> state_;
+
+  public:
+    using promise_type = Promise;
+
+    Task() = default;
+
+    explicit Task(std::shared_ptr<State> state) : state_(std::move(state)) {}
+
+    bool valid() const { return static_cast<bool>(state_); }
+
+    bool ready() const { return state_ && state_->ready(); }
+
+    void wait() const { state_->wait(); }
+
+    Result const& get() const { return state_->get(); }
+
+    struct Awaiter {
+        std::shared_ptr<State> state_;
+
+        bool await_ready() const { return state_->ready(); }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            return state_->addContinuation(handle);
+        }
+
+        Result const& await_resume() const { return state_->get(); }
+    };
+
+    Awaiter operator co_await() const { return Awaiter{state_}; }
+};
+
+// ============================================================================
+//              INLINE FUNCTION AND FUNCTION TEMPLATE DEFINITIONS
+// ============================================================================
+
+template <typename Result>
+Task<Result> spawn(Executor&, Thunk<Result> thunk) {
+    co_return evaluate(thunk);
+}
+
+template <typename F, typename... Args>
+auto spawn(Executor&, F f, Args... args)
+    -> Task<std::invoke_result_t<F, Args...>> {
+    co_return std::invoke(f, args...);
+}
+
+namespace detail {
+template <typename... Results, std::size_t... Is>
+Task<std::tuple<Results...>> whenAll(Executor&,
+                                     std::tuple<Task<Results>...> tasks,
+                                     std::index_sequence<Is...>) {
+    co_return std::tuple<Results...>{co_await std::get<Is>(tasks)...};
+}
+} // namespace detail
+
+template <typename... Results>
+Task<std::tuple<Results...>> when_all(Executor& executor,
+                                      Thunk<Results>... thunks) {
+    return detail::whenAll(executor,
+                           std::tuple<Task<Results>...>(
+                               spawn(executor, std::move(thunks))...),
+                           std::index_sequence_for<Results...>());
+}
+
+namespace detail {
+template <typename Result>
+Task<std::vector<Result>> whenAll(Executor&, std::vector<Task<Result>> tasks) {
+    std::vector<Result> results;
+    results.reserve(tasks.size());
+    for (auto const& task : tasks) {
+        results.push_back(co_await task);
+    }
+    co_return results;
+}
+} // namespace detail
+
+template <typename Result>
+Task<std::vector<Result>> when_all(Executor&                  executor,
+                                   std::vector<Thunk<Result>> thunks) {
+    std::vector<Task<Result>> tasks;
+    tasks.reserve(thunks.size());
+    for (auto& thunk : thunks) {
+        tasks.push_back(spawn(executor, std::move(thunk)));
+    }
+    return detail::whenAll(executor, std::move(tasks));
+}
+
+template <typename Result>
+Task<std::pair<std::size_t, Result>>
+when_any(Executor& executor, std::vector<Thunk<Result>> thunks) {
+    using Winner = std::pair<std::size_t, Result>;
+    if (thunks.empty()) {
+        throw std::invalid_argument("when_any of no thunks");
+    }
+
+    struct Race {
+        std::shared_ptr<detail::TaskState<Winner>> result =
+            std::make_shared<detail::TaskState<Winner>>();
+        std::stop_source         stop;
+        std::atomic<bool>        decided{false};
+        std::atomic<std::size_t> remaining;
+    };
+    auto race = std::make_shared<Race>();
+    race->remaining.store(thunks.size());
+
+    for (std::size_t i = 0; i < thunks.size(); ++i) {
+        executor.post([race, i, thunk = std::move(thunks[i])]() {
+            EvaluationContext::Scope scope(race->stop.get_token());
+            std::exception_ptr       error;
+            if (!race->stop.stop_requested()) {
+                try {
+                    Result const& value = evaluate(thunk);
+                    if (!race->decided.exchange(true)) {
+                        race->stop.request_stop();
+                        race->result->setValue(i, value);
+                    }
+                } catch (...) {
+                    error = std::current_exception();
+                }
+            }
+            // Only if every thunk failed is the last failure the result.
+            if (race->remaining.fetch_sub(1) == 1 && error &&
+                !race->decided.exchange(true)) {
+                race->result->setError(error);
+            }
+        });
+    }
+    return Task<Winner>(race->result);
+}
+
+} // namespace co_fun
+
+#endif
@@ -0,0 +1,217 @@
+#include <co_fun/task.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace co_fun;
+
+TEST(Co_FunTaskTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+namespace {
+Task<int> answer(Executor&) { co_return 42; }
+
+Task<int> doubled(Executor& executor) {
+    int i = co_await answer(executor);
+    co_return 2 * i;
+}
+
+Task<int> failing(Executor&) {
+    throw std::runtime_error("failed");
+    co_return 0;
+}
+
+Thunk<int> slow(int i, std::chrono::milliseconds delay) {
+    std::this_thread::sleep_for(delay);
+    co_return i;
+}
+} // namespace
+
+TEST(Co_FunTaskTest, Breathing) {
+    Executor  executor(2);
+    Task<int> task = answer(executor);
+    EXPECT_TRUE(task.valid());
+    EXPECT_EQ(42, task.get());
+    EXPECT_TRUE(task.ready());
+
+    Task<int> copy = task;
+    EXPECT_EQ(42, copy.get());
+
+    Task<int> empty;
+    EXPECT_FALSE(empty.valid());
+    EXPECT_FALSE(empty.ready());
+}
+
+TEST(Co_FunTaskTest, IsEager) {
+    Executor          executor(1);
+    std::atomic<bool> ran{false};
+    Task<int>         task = spawn(executor, [&ran]() {
+        ran = true;
+        ran.notify_one();
+        return 1;
+    });
+    ran.wait(false);
+    EXPECT_TRUE(ran.load());
+    EXPECT_EQ(1, task.get());
+}
+
+TEST(Co_FunTaskTest, Await) {
+    Executor executor(1);
+    EXPECT_EQ(84, doubled(executor).get());
+}
+
+TEST(Co_FunTaskTest, Exception) {
+    Executor  executor(1);
+    Task<int> task = failing(executor);
+    EXPECT_THROW(task.get(), std::runtime_error);
+    EXPECT_THROW(task.get(), std::runtime_error);
+}
+
+TEST(Co_FunTaskTest, SpawnThunk) {
+    Executor    executor(2);
+    Thunk<int>  t = thunk([]() { return 7; });
+    Task<int>   task = spawn(executor, t);
+    EXPECT_EQ(7, task.get());
+    EXPECT_TRUE(t.evaluated());
+
+    auto str = spawn(executor, [](std::string s) { return s + s; }, "ab");
+    EXPECT_EQ("abab", str.get());
+}
+
+TEST(Co_FunTaskTest, WhenAllTuple) {
+    Executor executor(3);
+    auto     all = when_all(executor,
+                        thunk([]() { return 1; }),
+                        thunk([]() { return std::string("two"); }),
+                        thunk([]() { return 3.0; }));
+    auto [i, s, d] = all.get();
+    EXPECT_EQ(1, i);
+    EXPECT_EQ("two", s);
+    EXPECT_EQ(3.0, d);
+}
+
+TEST(Co_FunTaskTest, WhenAllVector) {
+    Executor                executor(4);
+    std::vector<Thunk<int>> thunks;
+    for (int i = 0; i < 50; ++i) {
+        thunks.push_back(thunk([i]() { return i * i; }));
+    }
+    std::vector<int> results = when_all(executor, thunks).get();
+    ASSERT_EQ(50u, results.size());
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_EQ(i * i, results[i]);
+    }
+
+    EXPECT_TRUE(when_all(executor, std::vector<Thunk<int>>()).get().empty());
+}
+
+TEST(Co_FunTaskTest, WhenAllRunsInParallel) {
+    Executor                executor(4);
+    std::vector<Thunk<int>> thunks;
+    for (int i = 0; i < 4; ++i) {
+        thunks.push_back(slow(i, std::chrono::milliseconds(100)));
+    }
+    auto start = std::chrono::steady_clock::now();
+    when_all(executor, thunks).get();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_LT(elapsed, std::chrono::milliseconds(390));
+}
+
+TEST(Co_FunTaskTest, WhenAllException) {
+    Executor executor(2);
+    auto     all = when_all(executor,
+                        thunk([]() { return 1; }),
+                        thunk([]() -> int { throw std::logic_error("no"); }));
+    EXPECT_THROW(all.get(), std::logic_error);
+}
+
+TEST(Co_FunTaskTest, WhenAny) {
+    Executor                executor(1);
+    std::vector<Thunk<int>> thunks;
+    thunks.push_back(thunk([]() { return 10; }));
+    for (int i = 1; i < 5; ++i) {
+        thunks.push_back(thunk([i]() { return 10 + i; }));
+    }
+    auto [index, value] = when_any(executor, thunks).get();
+    EXPECT_EQ(0u, index);
+    EXPECT_EQ(10, value);
+}
+
+TEST(Co_FunTaskTest, WhenAnySkipsLosers) {
+    std::vector<Thunk<int>> thunks;
+    for (int i = 0; i < 5; ++i) {
+        thunks.push_back(thunk([i]() { return i; }));
+    }
+    {
+        // With one worker the winner finishes before the rest start, so
+        // they are never forced.
+        Executor executor(1);
+        EXPECT_EQ(0u, when_any(executor, thunks).get().first);
+    }
+    EXPECT_TRUE(thunks[0].evaluated());
+    for (std::size_t i = 1; i < thunks.size(); ++i) {
+        EXPECT_FALSE(thunks[i].evaluated());
+    }
+}
+
+TEST(Co_FunTaskTest, WhenAnyIgnoresFailures) {
+    Executor                executor(2);
+    std::vector<Thunk<int>> thunks;
+    thunks.push_back(thunk([]() -> int { throw std::runtime_error("x"); }));
+    thunks.push_back(thunk([]() { return 5; }));
+    auto [index, value] = when_any(executor, thunks).get();
+    EXPECT_EQ(1u, index);
+    EXPECT_EQ(5, value);
+}
+
+TEST(Co_FunTaskTest, WhenAnyAllFail) {
+    Executor                executor(2);
+    std::vector<Thunk<int>> thunks;
+    for (int i = 0; i < 3; ++i) {
+        thunks.push_back(
+            thunk([]() -> int { throw std::runtime_error("x"); }));
+    }
+    EXPECT_THROW(when_any(executor, thunks).get(), std::runtime_error);
+    EXPECT_THROW(when_any(executor, std::vector<Thunk<int>>()),
+                 std::invalid_argument);
+}
+
+namespace {
+Thunk<int> step(int i) { co_return i; }
+
+Thunk<int> chain(std::atomic<bool>& started, int n) {
+    started = true;
+    started.notify_one();
+    int total = 0;
+    for (int i = 0; i < n; ++i) {
+        co_await cancellationPoint();
+        total += evaluate(step(i));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    co_return total;
+}
+} // namespace
+
+TEST(Co_FunTaskTest, WhenAnyCancelsInFlight) {
+    std::atomic<bool>       started{false};
+    std::vector<Thunk<int>> thunks;
+    thunks.push_back(chain(started, 200));
+    thunks.push_back(thunk([&started]() {
+        started.wait(false);
+        return -1;
+    }));
+    {
+        Executor executor(2);
+        auto [index, value] = when_any(executor, thunks).get();
+        EXPECT_EQ(1u, index);
+        EXPECT_EQ(-1, value);
+    }
+
+    // The loser gave up at a cancellation point, and picks up from there.
+    EXPECT_FALSE(thunks[0].evaluated());
+    EXPECT_EQ(199 * 200 / 2, evaluate(thunks[0]));
+}
@@ -0,0 +1,106 @@
+// tempfile.t.h                                                       -*-C++-*-
+#ifndef INCLUDED_CO_FUN_TEMPFILE_T
+#define INCLUDED_CO_FUN_TEMPFILE_T
+
+//@PURPOSE: Provide temporary files and directories for the test drivers.
+//
+//@CLASSES:
+//  co_fun::test::TempDir: fresh directory, removed with its contents
+//  co_fun::test::TempFile: file in a fresh directory, removed with it
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: A 'TempDir' is a directory, made with a unique name under
+// the system temporary directory, that is removed with everything in it
+// when the 'TempDir' is destroyed.  A 'TempFile' is a file, holding the
+// contents it was made with, in a 'TempDir' of its own, so a test may also
+// rename or replace it without leaving anything behind.
+//..
+//  test::TempDir dir("co_fun_walk");
+//  dir.mkdir("sub");
+//  dir.write("sub/data", "1234");
+//  auto entries = walk(dir.path());
+//..
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace co_fun {
+namespace test {
+
+class TempDir {
+    std::string path_;
+
+  public:
+    explicit TempDir(std::string const& prefix = "co_fun") {
+        std::string name =
+            (std::filesystem::temp_directory_path() / (prefix + "XXXXXX"))
+                .string();
+        EXPECT_NE(nullptr, ::mkdtemp(name.data()));
+        path_ = name;
+    }
+
+    TempDir(TempDir const&)            = delete;
+    TempDir& operator=(TempDir const&) = delete;
+
+    ~TempDir() {
+        std::error_code error;
+        std::filesystem::remove_all(path_, error);
+        EXPECT_FALSE(error) << error.message();
+    }
+
+    std::string const& path() const { return path_; }
+
+    // The path of 'name' in the directory, which need not exist.
+    std::string file(std::string const& name) const {
+        return path_ + "/" + name;
+    }
+
+    // Make the directory 'name', returning its path.
+    std::string mkdir(std::string const& name) const {
+        std::string path = file(name);
+        EXPECT_TRUE(std::filesystem::create_directory(path));
+        return path;
+    }
+
+    // Make the file 'name' holding 'contents', returning its path.
+    std::string write(std::string const& name,
+                      std::string_view   contents = {}) const {
+        std::string   path = file(name);
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(contents.data(), std::streamsize(contents.size()));
+        EXPECT_TRUE(out.good());
+        return path;
+    }
+};
+
+class TempFile {
+    TempDir     dir_;
+    std::string path_;
+
+  public:
+    explicit TempFile(std::string_view   contents = {},
+                      std::string const& prefix   = "co_fun")
+        : dir_(prefix), path_(dir_.write("file", contents)) {}
+
+    std::string const& path() const { return path_; }
+
+    std::string contents() const {
+        std::ifstream      in(path_, std::ios::binary);
+        std::ostringstream out;
+        out << in.rdbuf();
+        return out.str();
+    }
+};
+
+} // namespace test
+} // namespace co_fun
+
+#endif
@@ -11,9 +11,11 @@
 //@DESCRIPTION:
 
 #include <cassert>
+#include <chrono>
 #include <coroutine>
 #include <memory>
 #include <functional>
+#include <optional>
 
 #include <co_fun/holder.h>
 #include <utility>
@@ -68,6 +70,8 @@ class Thunk {
 
     bool evaluated() const { return result_ && !result_->unevaluated(); }
 
+    bool cancelled() const { return result_ && result_->cancelled(); }
+
     bool isEmpty() const {
         bool empty = false;
         if (!result_) {
@@ -78,15 +82,65 @@ class Thunk {
         return empty;
     }
 
+    // The value, evaluating it on this thread if nobody has started to, or
+    // waiting for the thread that has.  The coroutine runs on one thread at
+    // a time, and once to completion; if the thread running it gives up, a
+    // waiting thread takes over.
     Result const& get() const& {
-        if (!evaluated()) {
-            result_->resume();
+        while (!evaluated()) {
+            if (result_->claim()) {
+                result_->resume();
+            } else {
+                result_->wait();
+            }
         }
         return result_->get_value();
     }
 
     operator Result const &() const { return get(); }
 
+    // The value if it is already available, without evaluating or waiting.
+    std::optional<Result> try_get() const {
+        if (!evaluated()) {
+            return std::nullopt;
+        }
+        // Copied, as the value stays memoized for every other handle.
+        Result const& value = result_->get_value();
+        return value;
+    }
+
+    // The value, waiting no later than 'deadline' for an evaluation running
+    // on another thread.  If nobody has started the evaluation it runs here,
+    // without a time limit.
+    template <typename Clock, typename Duration>
+    std::optional<Result>
+    get_until(std::chrono::time_point<Clock, Duration> const& deadline) const {
+        while (!evaluated()) {
+            if (result_->claim()) {
+                result_->resume();
+            } else if (!result_->waitUntil(deadline)) {
+                return std::nullopt;
+            }
+        }
+        Result const& value = result_->get_value();
+        return value;
+    }
+
+    template <typename Rep, typename Period>
+    std::optional<Result>
+    get_for(std::chrono::duration<Rep, Period> const& timeout) const {
+        return get_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    // Call 'callback()' once the value or exception is available, on the
+    // thread that completes the evaluation, or now if it already has
+    // completed.  An exception thrown by a callback run on completion is
+    // dropped rather than failing the thread that completed it.
+    template <typename Callback>
+    void onReady(Callback&& callback) const {
+        result_->onReady(std::forward<Callback>(callback));
+    }
+
   private:
     std::shared_ptr<co_fun::Holder<Result>> result_;
 };
@@ -105,15 +159,31 @@ Value evaluate(Thunk<Value>&& thunk) {
     return std::move(thunk);
 }
 
+// The combinators below give up with 'Abandon' if forcing an argument
+// throws 'Cancelled', so the result stays unevaluated, and forces the
+// argument again when it is next forced.
+
 template <typename F, typename... Args>
 auto thunk(F f, Args... args) -> Thunk<std::invoke_result_t<F, Args...>> {
-    co_return std::invoke(f, args...);
+    for (;;) {
+        try {
+            co_return std::invoke(f, args...);
+        } catch (Cancelled const&) {
+        }
+        co_await Abandon{};
+    }
 }
 
 template <typename Result, typename F>
 auto transform(Thunk<Result> l, F f)
     -> Thunk<std::invoke_result_t<F, Result>> {
-    co_return f(evaluate(l));
+    for (;;) {
+        try {
+            co_return f(evaluate(l));
+        } catch (Cancelled const&) {
+        }
+        co_await Abandon{};
+    }
 }
 
 template <typename Value>
@@ -128,7 +198,13 @@ auto bind(Thunk<Value> l, Func f) -> decltype(f(evaluate(l))) {
 
 template <typename Value, typename Func>
 auto bind2(Thunk<Value> l, Func f) -> decltype(f(evaluate(l))) {
-    co_return f(evaluate(l));
+    for (;;) {
+        try {
+            co_return f(evaluate(l));
+        } catch (Cancelled const&) {
+        }
+        co_await Abandon{};
+    }
 }
 
 
@@ -2,6 +2,13 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
 using namespace co_fun;
 
 TEST(Co_FunThunkTest, TestGTest) { ASSERT_EQ(1, 1); }
@@ -208,5 +215,114 @@ TEST(Co_FunThunkTest, Bind2TestRvalue) {
     EXPECT_EQ(true, b.evaluated());
 }
 
+TEST(Co_FunThunkTest, TryGetTest) {
+    int        calls = 0;
+    Thunk<int> l     = thunk([&calls]() { return ++calls; });
+    EXPECT_FALSE(l.try_get());
+    EXPECT_EQ(0, calls);
+    EXPECT_EQ(1, l.get());
+    EXPECT_EQ(1, l.try_get());
+    EXPECT_EQ(1, calls);
+}
+
+TEST(Co_FunThunkTest, EvaluateOnceTest) {
+    std::atomic<int> calls{0};
+    Thunk<int>       l = thunk([&calls]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return ++calls;
+    });
+
+    std::vector<std::thread> threads;
+    std::atomic<int>         sum{0};
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&]() { sum += l.get(); });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(1, calls);
+    EXPECT_EQ(8, sum);
+}
+
+TEST(Co_FunThunkTest, GetForTest) {
+    std::atomic<bool> started{false};
+    std::atomic<bool> release{false};
+    Thunk<int>        l = thunk([&]() {
+        started = true;
+        started.notify_all();
+        release.wait(false);
+        return 7;
+    });
+
+    std::thread evaluator([&]() { l.get(); });
+    started.wait(false);
+
+    EXPECT_FALSE(l.get_for(std::chrono::milliseconds(5)));
+    EXPECT_FALSE(l.evaluated());
+
+    release = true;
+    release.notify_all();
+    EXPECT_EQ(7, l.get_for(std::chrono::seconds(10)));
+    evaluator.join();
+}
+
+TEST(Co_FunThunkTest, GetUntilEvaluatesTest) {
+    Thunk<int> l = thunk([]() { return 5; });
+    auto past    = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+    EXPECT_EQ(5, l.get_until(past));
+}
+
+TEST(Co_FunThunkTest, OnReadyTest) {
+    Thunk<int>       l = thunk([]() { return 5; });
+    std::vector<int> seen;
+    l.onReady([&]() { seen.push_back(1); });
+    l.onReady([&]() { seen.push_back(2); });
+    EXPECT_TRUE(seen.empty());
+
+    l.get();
+    EXPECT_EQ((std::vector<int>{1, 2}), seen);
+
+    l.onReady([&]() { seen.push_back(3); });
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), seen);
+}
+
+TEST(Co_FunThunkTest, ThrowingCallbackTest) {
+    Thunk<int>       l = thunk([]() { return 5; });
+    std::vector<int> seen;
+    l.onReady([&]() { seen.push_back(1); });
+    l.onReady([]() { throw std::runtime_error("callback"); });
+    l.onReady([&]() { seen.push_back(3); });
+
+    EXPECT_EQ(5, l.get());
+    EXPECT_EQ((std::vector<int>{1, 3}), seen);
+}
+
+TEST(Co_FunThunkTest, ExceptionTest) {
+    Thunk<int> l =
+        thunk([]() -> int { throw std::runtime_error("fail"); });
+    bool ready = false;
+    l.onReady([&]() { ready = true; });
+
+    EXPECT_THROW(l.get(), std::runtime_error);
+    EXPECT_TRUE(ready);
+    EXPECT_TRUE(l.evaluated());
+    EXPECT_THROW(l.try_get(), std::runtime_error);
+    EXPECT_THROW(l.get(), std::runtime_error);
+}
+
+TEST(Co_FunThunkTest, TryGetCopiesTest) {
+    std::string const text(100, 'x');
+    Thunk<std::string> l = thunk([&]() { return text; });
+    EXPECT_EQ(text, l.get_for(std::chrono::seconds(1)));
+    EXPECT_EQ(text, l.get());
+    EXPECT_EQ(text, l.try_get());
+    EXPECT_EQ(text, l.get_until(std::chrono::steady_clock::now()));
+    EXPECT_EQ(text, l.get());
+}
+
+TEST(Co_FunThunkTest, UnforcedCallbacksFreedTest) {
+    Thunk<int> l = thunk([]() { return 5; });
+    l.onReady([]() {});
+}
 
 } // namespace testing
@@ -0,0 +1,100 @@
+#include <benchmark/benchmark.h>
+
+#include <co_fun/fdstream.h>
+#include <co_fun/uringstream.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace co_fun;
+
+namespace {
+std::size_t const fileSize  = std::size_t(64) << 20;
+std::size_t const blockSize = std::size_t(256) << 10;
+
+// A file of 'fileSize' bytes, written once and shared by the benchmarks.
+std::string const& dataFile() {
+    static std::string const path = []() {
+        char name[] = "/tmp/co_fun_uringstream_benchXXXXXX";
+        int  fd     = ::mkstemp(name);
+        std::vector<char> block(blockSize, 'x');
+        for (std::size_t n = 0; n < fileSize; n += block.size()) {
+            if (::write(fd, block.data(), block.size()) < 0) {
+                break;
+            }
+        }
+        ::close(fd);
+        std::atexit([]() { std::remove(path.c_str()); });
+        return std::string(name);
+    }();
+    return path;
+}
+
+// Stand in for the per-block work of a downstream stage.
+std::size_t checksum(std::string_view block) {
+    std::size_t sum = 0;
+    for (char c : block) {
+        sum += static_cast<unsigned char>(c);
+    }
+    return sum;
+}
+
+template <typename Stream>
+std::size_t drain(Stream s) {
+    std::size_t sum = 0;
+    for (; !s.isEmpty(); s = s.tail()) {
+        sum += checksum(s.head().view());
+    }
+    return sum;
+}
+} // namespace
+
+static void BM_ReadLoop(benchmark::State& state) {
+    std::vector<char> buffer(blockSize);
+    for (auto _ : state) {
+        int         fd  = ::open(dataFile().c_str(), O_RDONLY);
+        std::size_t sum = 0;
+        ssize_t     n;
+        while ((n = ::read(fd, buffer.data(), buffer.size())) > 0) {
+            sum += checksum(std::string_view(buffer.data(), std::size_t(n)));
+        }
+        ::close(fd);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(state.iterations() * fileSize);
+}
+BENCHMARK(BM_ReadLoop)->Unit(benchmark::kMillisecond);
+
+static void BM_FdChunks(benchmark::State& state) {
+    FdOptions options;
+    options.blockSize = blockSize;
+    for (auto _ : state) {
+        int fd = ::open(dataFile().c_str(), O_RDONLY);
+        benchmark::DoNotOptimize(drain(chunks(fd, options)));
+        ::close(fd);
+    }
+    state.SetBytesProcessed(state.iterations() * fileSize);
+}
+BENCHMARK(BM_FdChunks)->Unit(benchmark::kMillisecond);
+
+static void BM_UringChunks(benchmark::State& state) {
+    UringOptions options;
+    options.blockSize  = blockSize;
+    options.queueDepth = unsigned(state.range(0));
+    for (auto _ : state) {
+        int fd = ::open(dataFile().c_str(), O_RDONLY);
+        benchmark::DoNotOptimize(drain(fileChunks(fd, options)));
+        ::close(fd);
+    }
+    state.SetBytesProcessed(state.iterations() * fileSize);
+}
+BENCHMARK(BM_UringChunks)
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(32)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,402 @@
+// uringstream.cpp                                                    -*-C++-*-
+#include <co_fun/uringstream.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace co_fun {
+
+namespace {
+std::system_error systemError(int error, char const* what) {
+    return std::system_error(error, std::generic_category(), what);
+}
+
+int uringSetup(unsigned entries, io_uring_params* params) {
+    return int(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int uringEnter(int      fd,
+               unsigned toSubmit,
+               unsigned minComplete,
+               unsigned flags) {
+    return int(::syscall(
+        __NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int uringRegister(int fd, unsigned opcode, void const* arg, unsigned count) {
+    return int(::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+unsigned loadAcquire(unsigned* p) {
+    return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire);
+}
+
+void storeRelease(unsigned* p, unsigned value) {
+    std::atomic_ref<unsigned>(*p).store(value, std::memory_order_release);
+}
+
+constexpr std::size_t pageSize = 4096;
+} // namespace
+
+// The submission and completion queues shared with the kernel.
+struct UringReader::Ring {
+    int           fd        = -1;
+    void*         sqMap     = MAP_FAILED;
+    std::size_t   sqMapSize = 0;
+    void*         cqMap     = MAP_FAILED;
+    std::size_t   cqMapSize = 0;
+    io_uring_sqe* sqes      = static_cast<io_uring_sqe*>(MAP_FAILED);
+    std::size_t   sqesSize  = 0;
+
+    unsigned*     sqTail  = nullptr;
+    unsigned*     sqMask  = nullptr;
+    unsigned*     sqArray = nullptr;
+    unsigned*     cqHead  = nullptr;
+    unsigned*     cqTail  = nullptr;
+    unsigned*     cqMask  = nullptr;
+    io_uring_cqe* cqes    = nullptr;
+
+    unsigned queued  = 0; // written, but not yet published to the kernel
+    unsigned pending = 0; // published, but not yet consumed by the kernel
+
+    explicit Ring(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof params);
+        fd = uringSetup(entries, &params);
+        if (fd < 0) {
+            throw systemError(errno, "io_uring_setup");
+        }
+
+        sqMapSize =
+            params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqMapSize =
+            params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single && cqMapSize > sqMapSize) {
+            sqMapSize = cqMapSize;
+        }
+        sqMap = ::mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqMap == MAP_FAILED) {
+            int error = errno;
+            release();
+            throw systemError(error, "mmap io_uring");
+        }
+        if (single) {
+            cqMap = sqMap;
+        } else {
+            cqMap = ::mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes     = static_cast<io_uring_sqe*>(
+            ::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (cqMap == MAP_FAILED || sqes == MAP_FAILED) {
+            int error = errno;
+            release();
+            throw systemError(error, "mmap io_uring");
+        }
+
+        char* sq = static_cast<char*>(sqMap);
+        char* cq = static_cast<char*>(cqMap);
+        sqTail   = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask   = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray  = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead   = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail   = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask   = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes     = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    void release() {
+        if (sqes != MAP_FAILED) {
+            ::munmap(sqes, sqesSize);
+        }
+        if (cqMap != MAP_FAILED && cqMap != sqMap) {
+            ::munmap(cqMap, cqMapSize);
+        }
+        if (sqMap != MAP_FAILED) {
+            ::munmap(sqMap, sqMapSize);
+        }
+        ::close(fd);
+    }
+
+    ~Ring() { release(); }
+
+    // The next submission entry, cleared.  There is always one free, since
+    // no more reads are queued than the ring has entries.
+    io_uring_sqe* next() {
+        unsigned      tail  = *sqTail + queued;
+        unsigned      index = tail & *sqMask;
+        io_uring_sqe* sqe   = &sqes[index];
+        std::memset(sqe, 0, sizeof *sqe);
+        sqArray[index] = index;
+        ++queued;
+        return sqe;
+    }
+
+    // Submit what has been queued, and wait for at least 'minComplete'
+    // completions.
+    void enter(unsigned minComplete) {
+        storeRelease(sqTail, *sqTail + queued);
+        pending += std::exchange(queued, 0);
+        while (pending || minComplete) {
+            unsigned flags = minComplete ? IORING_ENTER_GETEVENTS : 0;
+            int      n     = uringEnter(fd, pending, minComplete, flags);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw systemError(errno, "io_uring_enter");
+            }
+            pending -= unsigned(n);
+            minComplete = 0;
+        }
+    }
+
+    template <typename Func>
+    void completions(Func f) {
+        unsigned head = *cqHead;
+        unsigned tail = loadAcquire(cqTail);
+        for (; head != tail; ++head) {
+            io_uring_cqe const& cqe = cqes[head & *cqMask];
+            storeRelease(cqHead, head + 1);
+            f(cqe.user_data, cqe.res);
+        }
+    }
+};
+
+// Page aligned read buffers, registered with the ring if it allows.  They
+// outlive the reader while the consumer holds chunks of them.
+struct UringReader::Slots {
+    char*            memory;
+    std::size_t      stride;
+    std::mutex       lock;
+    std::vector<int> free;
+    bool             registered = false;
+
+    Slots(std::size_t blockSize, unsigned count)
+        : memory(nullptr),
+          stride((blockSize + pageSize - 1) / pageSize * pageSize) {
+        memory =
+            static_cast<char*>(std::aligned_alloc(pageSize, stride * count));
+        if (!memory) {
+            throw std::bad_alloc();
+        }
+        for (int i = int(count) - 1; i >= 0; --i) {
+            free.push_back(i);
+        }
+    }
+
+    ~Slots() { std::free(memory); }
+
+    int take() {
+        std::lock_guard<std::mutex> guard(lock);
+        if (free.empty()) {
+            return -1;
+        }
+        int slot = free.back();
+        free.pop_back();
+        return slot;
+    }
+
+    void give(int slot) {
+        std::lock_guard<std::mutex> guard(lock);
+        free.push_back(slot);
+    }
+};
+
+UringReader::UringReader(int fd, UringOptions const& options)
+    : fd_(fd), options_(options) {
+    if (options_.blockSize == 0) {
+        options_.blockSize = 1;
+    }
+    if (options_.queueDepth == 0) {
+        options_.queueDepth = 1;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        throw systemError(errno, "fstat");
+    }
+    if (!S_ISREG(info.st_mode)) {
+        throw systemError(EINVAL, "io_uring reader needs a regular file");
+    }
+    off_t start = ::lseek(fd, 0, SEEK_CUR);
+    if (start < 0) {
+        throw systemError(errno, "lseek");
+    }
+    nextOffset_ = std::uint64_t(start);
+    end_        = std::uint64_t(info.st_size);
+
+    // Besides the reads in flight, a stream walking the reader holds the
+    // block being consumed and the one after it.
+    unsigned count = options_.queueDepth + 2;
+    ring_          = std::make_unique<Ring>(options_.queueDepth);
+    slots_         = std::make_shared<Slots>(options_.blockSize, count);
+    if (options_.registerBuffers) {
+        std::vector<iovec> iovecs(count);
+        for (unsigned i = 0; i < count; ++i) {
+            iovecs[i].iov_base = slots_->memory + i * slots_->stride;
+            iovecs[i].iov_len  = options_.blockSize;
+        }
+        // Registration is limited by RLIMIT_MEMLOCK; without it reads
+        // still go into the slots, only unregistered.
+        slots_->registered =
+            uringRegister(ring_->fd, IORING_REGISTER_BUFFERS, iovecs.data(),
+                          count) == 0;
+    }
+}
+
+UringReader::~UringReader() {
+    // The kernel may still write into buffers of reads in flight, so keep
+    // waiting for every one of them, whatever goes wrong.
+    while (inFlight_ > 0) {
+        try {
+            reap(true);
+        } catch (...) {
+        }
+    }
+}
+
+bool UringReader::buffersRegistered() const { return slots_->registered; }
+
+bool UringReader::available() {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof params);
+    int fd = uringSetup(2, &params);
+    if (fd < 0) {
+        return false;
+    }
+    ::close(fd);
+    return true;
+}
+
+void UringReader::submit(std::size_t index) {
+    Request& request = requests_[index - firstIndex_];
+    if (!request.data) {
+        request.slot = slots_->take();
+        if (request.slot >= 0) {
+            request.data = slots_->memory + request.slot * slots_->stride;
+        } else {
+            if (!pool_) {
+                pool_ = std::make_shared<BufferPool>(options_.blockSize,
+                                                     options_.queueDepth);
+            }
+            request.buffer = pool_->acquire();
+            request.data   = request.buffer.get();
+        }
+    }
+
+    io_uring_sqe* sqe = ring_->next();
+    bool fixed        = request.slot >= 0 && slots_->registered;
+    sqe->opcode       = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    sqe->fd           = fd_;
+    sqe->off          = request.offset + request.filled;
+    sqe->addr         = reinterpret_cast<std::uint64_t>(request.data +
+                                                request.filled);
+    sqe->len          = request.length - request.filled;
+    sqe->buf_index    = fixed ? std::uint16_t(request.slot) : 0;
+    sqe->user_data    = index;
+    ++inFlight_;
+}
+
+void UringReader::fill() {
+    while (requests_.size() < options_.queueDepth && nextOffset_ < end_) {
+        Request request;
+        request.offset = nextOffset_;
+        request.length = std::uint32_t(
+            end_ - nextOffset_ < options_.blockSize ? end_ - nextOffset_
+                                                    : options_.blockSize);
+        nextOffset_ += request.length;
+        requests_.push_back(std::move(request));
+        submit(firstIndex_ + requests_.size() - 1);
+    }
+}
+
+void UringReader::reap(bool wait) {
+    ring_->enter(wait ? 1 : 0);
+    ring_->completions([&](std::uint64_t index, int result) {
+        --inFlight_;
+        Request& request = requests_[index - firstIndex_];
+        if (result == -EINTR || result == -EAGAIN) {
+            submit(index);
+        } else if (result < 0) {
+            // Reported by 'next' once the consumer reaches this block.
+            request.done  = true;
+            request.error = std::error_code(-result, std::generic_category());
+        } else if (result == 0) {
+            // The file shrank: this is its end now.
+            request.done = true;
+            if (request.offset + request.filled < end_) {
+                end_ = request.offset + request.filled;
+            }
+        } else {
+            request.filled += std::uint32_t(result);
+            if (request.filled < request.length) {
+                submit(index);
+            } else {
+                request.done = true;
+                if (request.slot >= 0 && slots_->registered) {
+                    ++fixedReads_;
+                }
+            }
+        }
+    });
+}
+
+std::optional<Chunk> UringReader::next() {
+    fill();
+    if (requests_.empty()) {
+        return std::nullopt;
+    }
+    while (!requests_.front().done) {
+        reap(true);
+    }
+
+    Request request = std::move(requests_.front());
+    requests_.pop_front();
+    ++firstIndex_;
+    // Keep the queue full while the consumer works on this block.
+    fill();
+    ring_->enter(0);
+
+    if (request.error) {
+        if (request.slot >= 0) {
+            slots_->give(request.slot);
+        }
+        throw std::system_error(request.error, "io_uring read");
+    }
+    if (request.filled == 0) {
+        if (request.slot >= 0) {
+            slots_->give(request.slot);
+        }
+        return std::nullopt;
+    }
+    std::string_view data(request.data, request.filled);
+    if (request.slot >= 0) {
+        std::shared_ptr<char const> storage(
+            request.data,
+            [slots = slots_, slot = request.slot](char const*) {
+                slots->give(slot);
+            });
+        return Chunk(std::move(storage), data);
+    }
+    return Chunk(std::shared_ptr<char const>(std::move(request.buffer)), data);
+}
+
+} // namespace co_fun
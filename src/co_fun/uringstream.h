@@ -0,0 +1,146 @@
+// uringstream.h                                                      -*-C++-*-
+#ifndef INCLUDED_CO_FUN_URINGSTREAM
+#define INCLUDED_CO_FUN_URINGSTREAM
+
+//@PURPOSE: Stream a file through batched asynchronous reads on io_uring.
+//
+//@CLASSES:
+//  co_fun::UringReader: io_uring reader keeping a queue of reads in flight
+//  co_fun::UringOptions: block size and queue depth of a 'UringReader'
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: 'fileChunks(fd)' is a lazy 'ConsStream<Chunk>' of a file's
+// bytes, from its current position to its end, read with Linux io_uring.
+// A 'UringReader' keeps up to 'UringOptions::queueDepth' block reads in
+// flight at once, submitted in one system call, and forcing a cell waits
+// only for the completion of the block it needs, while the reads after it
+// carry on.  There is no reader thread: the thread walking the stream keeps
+// the device busy between the elements it evaluates.
+//
+// Reads go into buffers registered with the ring once, up front, so the
+// kernel does not map user pages for every read.  Each registered buffer is
+// page aligned, and so can serve a descriptor opened with 'O_DIRECT' when
+// the block size is a multiple of the device's block.  A chunk holds its
+// buffer until the consumer drops it; when the consumer holds them all, or
+// the buffers could not be registered, reads fall back to unregistered
+// buffers from a 'BufferPool'.
+//
+// io_uring is reached through its system calls directly, with no liburing.
+// Where it is unavailable -- an old kernel, a sandbox that forbids it, or a
+// descriptor that is not a regular file -- 'fileChunks' falls back to the
+// read-ahead thread of 'co_fun/fdstream.h'.  The file offset of the
+// descriptor is not moved by a 'UringReader'.
+//
+// A 'UringReader' may be used by one thread at a time.
+
+#include <co_fun/bufferpool.h>
+#include <co_fun/fdstream.h>
+#include <co_fun/stream.h>
+#include <co_fun/suspension.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <system_error>
+#include <utility>
+
+namespace co_fun {
+
+struct UringOptions {
+    // Bytes per read.
+    std::size_t blockSize = std::size_t(256) << 10;
+
+    // Reads kept in flight.  Two more buffers than this are registered,
+    // for the block a stream's consumer is on and the one after it.
+    unsigned queueDepth = 8;
+
+    // Register the read buffers with the ring.
+    bool registerBuffers = true;
+};
+
+class UringReader {
+    struct Ring;
+    struct Slots;
+
+    struct Request {
+        std::uint64_t         offset = 0;
+        std::uint32_t         length = 0;
+        std::uint32_t         filled = 0;
+        int                   slot   = -1;
+        char*                 data   = nullptr;
+        std::shared_ptr<char> buffer;
+        bool                  done = false;
+        std::error_code       error;
+    };
+
+    int                         fd_;
+    UringOptions                options_;
+    std::unique_ptr<Ring>       ring_;
+    std::shared_ptr<Slots>      slots_;
+    std::shared_ptr<BufferPool> pool_;
+    std::uint64_t               end_;
+    std::uint64_t               nextOffset_;
+    std::uint64_t               firstIndex_ = 0;
+    std::deque<Request>         requests_;
+    unsigned                    inFlight_   = 0;
+    std::size_t                 fixedReads_ = 0;
+
+    void submit(std::size_t index);
+    void fill();
+    void reap(bool wait);
+
+  public:
+    // Throws 'std::system_error' if the ring cannot be set up.
+    UringReader(int fd, UringOptions const& options);
+
+    UringReader(UringReader const&) = delete;
+    UringReader& operator=(UringReader const&) = delete;
+
+    // Waits for the reads still in flight.
+    ~UringReader();
+
+    // The next block of the file, or nothing at its end.  Throws
+    // 'std::system_error' if the read of that block failed.
+    std::optional<Chunk> next();
+
+    // Reads made into registered buffers.
+    std::size_t fixedReads() const { return fixedReads_; }
+
+    bool buffersRegistered() const;
+
+    // Whether this kernel lets us create a ring.
+    static bool available();
+};
+
+// ============================================================================
+//              INLINE FUNCTION AND FUNCTION TEMPLATE DEFINITIONS
+// ============================================================================
+
+template <typename Suspension = ThunkSuspension>
+ConsStream<Chunk, Suspension> chunks(std::shared_ptr<UringReader> reader) {
+    return detail::chunksFrom<Suspension>(std::move(reader));
+}
+
+// The chunks of the file open on 'fd', read through io_uring where it can
+// be, or else on a read-ahead thread.
+template <typename Suspension = ThunkSuspension>
+ConsStream<Chunk, Suspension> fileChunks(int                 fd,
+                                         UringOptions const& options = {}) {
+    std::shared_ptr<UringReader> reader;
+    try {
+        reader = std::make_shared<UringReader>(fd, options);
+    } catch (std::system_error const&) {
+        FdOptions fallback;
+        fallback.blockSize = options.blockSize;
+        fallback.readAhead = options.queueDepth;
+        return chunks<Suspension>(fd, fallback);
+    }
+    return chunks<Suspension>(std::move(reader));
+}
+
+} // namespace co_fun
+
+#endif
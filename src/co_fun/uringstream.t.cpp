@@ -0,0 +1,192 @@
+#include <co_fun/uringstream.h>
+#include <co_fun/tempfile.t.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace co_fun;
+
+namespace {
+// A temporary file holding 'contents', open for reading.
+class OpenFile {
+    test::TempFile file_;
+    int            fd_;
+
+  public:
+    explicit OpenFile(std::string_view contents)
+        : file_(contents), fd_(::open(file_.path().c_str(), O_RDONLY)) {
+        EXPECT_LE(0, fd_);
+    }
+
+    ~OpenFile() { ::close(fd_); }
+
+    int fd() const { return fd_; }
+};
+
+std::string numbers(int count) {
+    std::string text;
+    for (int i = 0; i < count; ++i) {
+        text += std::to_string(i) + "\n";
+    }
+    return text;
+}
+
+template <typename Stream>
+std::string concatenate(Stream stream) {
+    std::string result;
+    for (; !stream.isEmpty(); stream = stream.tail()) {
+        result.append(stream.head().view());
+    }
+    return result;
+}
+} // namespace
+
+TEST(Co_FunUringStreamTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunUringStreamTest, Read) {
+    if (!UringReader::available()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    std::string text = numbers(20000);
+    OpenFile    file(text);
+
+    UringOptions options;
+    options.blockSize  = 1000;
+    options.queueDepth = 3;
+    auto reader        = std::make_shared<UringReader>(file.fd(), options);
+
+    std::size_t count = 0;
+    std::string result;
+    for (auto s = chunks(reader); !s.isEmpty(); s = s.tail()) {
+        EXPECT_GE(1000u, s.head().size());
+        result.append(s.head().view());
+        ++count;
+    }
+    EXPECT_EQ(text, result);
+    EXPECT_EQ((text.size() + 999) / 1000, count);
+    if (reader->buffersRegistered()) {
+        EXPECT_EQ(count, reader->fixedReads());
+    }
+}
+
+TEST(Co_FunUringStreamTest, Empty) {
+    if (!UringReader::available()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    OpenFile file("");
+    EXPECT_TRUE(chunks(std::make_shared<UringReader>(file.fd(),
+                                                     UringOptions()))
+                    .isEmpty());
+}
+
+TEST(Co_FunUringStreamTest, FromCurrentOffset) {
+    if (!UringReader::available()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    OpenFile file("skip this|read this");
+    ::lseek(file.fd(), 10, SEEK_SET);
+    EXPECT_EQ("read this",
+              concatenate(chunks(
+                  std::make_shared<UringReader>(file.fd(), UringOptions()))));
+    EXPECT_EQ(10, ::lseek(file.fd(), 0, SEEK_CUR));
+}
+
+TEST(Co_FunUringStreamTest, HeldChunks) {
+    if (!UringReader::available()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    // Holding every chunk uses up the registered buffers; the rest of the
+    // reads go to the pool.
+    std::string text = numbers(5000);
+    OpenFile    file(text);
+
+    UringOptions options;
+    options.blockSize  = 512;
+    options.queueDepth = 2;
+    std::vector<Chunk> held;
+    for (auto s = chunks(std::make_shared<UringReader>(file.fd(), options));
+         !s.isEmpty();
+         s = s.tail()) {
+        held.push_back(s.head());
+    }
+    std::string result;
+    for (Chunk const& chunk : held) {
+        result.append(chunk.view());
+    }
+    EXPECT_EQ(text, result);
+}
+
+TEST(Co_FunUringStreamTest, UnregisteredBuffers) {
+    if (!UringReader::available()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    std::string text = numbers(1000);
+    OpenFile    file(text);
+
+    UringOptions options;
+    options.blockSize       = 256;
+    options.registerBuffers = false;
+    auto reader = std::make_shared<UringReader>(file.fd(), options);
+    EXPECT_FALSE(reader->buffersRegistered());
+    EXPECT_EQ(text, concatenate(chunks(reader)));
+    EXPECT_EQ(0u, reader->fixedReads());
+}
+
+TEST(Co_FunUringStreamTest, ReadError) {
+    if (!UringReader::available()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    test::TempFile file(numbers(2000));
+    int            fd = ::open(file.path().c_str(), O_WRONLY);
+    ASSERT_LE(0, fd);
+    {
+        // Every read fails; each is reported as its block is reached, and
+        // the reader still waits for the rest before it goes away.
+        UringOptions options;
+        options.blockSize  = 256;
+        options.queueDepth = 4;
+        UringReader reader(fd, options);
+        EXPECT_THROW(reader.next(), std::system_error);
+        EXPECT_THROW(reader.next(), std::system_error);
+    }
+    ::close(fd);
+}
+
+TEST(Co_FunUringStreamTest, NotRegularFile) {
+    int fds[2];
+    ASSERT_EQ(0, ::pipe(fds));
+    EXPECT_THROW(UringReader(fds[0], UringOptions()), std::system_error);
+
+    // fileChunks falls back to the read-ahead thread.
+    std::thread writer([&]() {
+        EXPECT_EQ(5, ::write(fds[1], "piped", 5));
+        ::close(fds[1]);
+    });
+    EXPECT_EQ("piped", concatenate(fileChunks(fds[0])));
+    writer.join();
+    ::close(fds[0]);
+}
+
+TEST(Co_FunUringStreamTest, Lines) {
+    OpenFile     file(numbers(3000));
+    UringOptions options;
+    options.blockSize = 100;
+    auto lines =
+        delimited(fileChunks<MemoSuspension>(file.fd(), options));
+    auto values =
+        fmap(lines, [](Chunk const& c) { return std::stol(std::string(c)); });
+    long sum = 0;
+    for (auto s = values; !s.isEmpty(); s = s.tail()) {
+        sum += s.head();
+    }
+    EXPECT_EQ(2999L * 3000 / 2, sum);
+}
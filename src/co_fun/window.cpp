@@ -0,0 +1,2 @@
+// window.cpp                                                         -*-C++-*-
+#include <co_fun/window.h>
@@ -0,0 +1,421 @@
+// window.h                                                           -*-C++-*-
+#ifndef INCLUDED_CO_FUN_WINDOW
+#define INCLUDED_CO_FUN_WINDOW
+
+//@PURPOSE: Provide count and time windows over a stream, without copying.
+//
+//@CLASSES:
+//  co_fun::Window: contiguous view of the elements of one window
+//  co_fun::TimeWindow: a window and the time interval it covers
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: 'window(stream, size, step)' is the stream of windows of
+// 'size' consecutive elements, each starting 'step' elements after the one
+// before: 'step == size' gives tumbling windows, 'step < size' overlapping
+// ones, and 'step > size' samples with gaps.  Only full windows are
+// produced.  A 'Window' is a view, with 'span()', 'size()' and iterators,
+// of elements held in a buffer shared by the windows; making the next
+// window appends the elements it adds and advances past those it drops,
+// so each element is copied into the buffer once, rather than each window
+// being a stream built with 'take' and 'drop'.
+//
+//..
+//  for (auto w = window(prices, 20, 1); !w.isEmpty(); w = w.tail()) {
+//      plot(w.head().span());
+//  }
+//..
+//
+// A buffer holds twice the window, and windows are contiguous in it; when
+// it fills, the live elements move to a buffer no window refers to.  A
+// window stays valid for as long as it is held, and a buffer is reused
+// once no window refers to it, so walking the windows by reassignment
+// allocates a few buffers, and holding windows costs a buffer for each
+// block of them held.
+//
+// 'windowFold(stream, size, step, init, add, evict)' is the stream of
+// aggregates of the same windows, kept up to date incrementally: 'add(acc,
+// x)' folds in an element entering the window and 'evict(acc, x)' takes
+// out one leaving it, so an aggregate with an inverse, such as a sum, costs
+// constant time per element whatever the window size.  'movingSum' and
+// 'movingAverage' are the common cases.
+//
+// 'slidingWindows(stream, width, slide, timeOf)' windows a stream by time:
+// window 'k' holds the elements whose 'timeOf' is in '[start, start +
+// width)', where the starts are multiples of 'slide' from the zero of the
+// time type, such as the clock's epoch.  'tumblingWindows(stream, width,
+// timeOf)' is the case 'slide == width'.  Windows with no elements are
+// skipped.  Elements are expected in time order; a late one joins the
+// window being filled, if that has begun, and is dropped otherwise.  Time
+// windows hold however many elements fall in them, in buffers that grow to
+// fit.
+//
+// As with 'filter', whether a window stream is empty is known when it is
+// made, so making one, or forcing a cell, reads the elements of the window
+// after it.  The cells of one window stream share a buffer, and must be
+// forced from one thread at a time.
+
+#include <co_fun/stream.h>
+#include <co_fun/suspension.h>
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace co_fun {
+
+template <typename Value>
+class Window {
+    std::shared_ptr<std::vector<Value> const> block_;
+    std::size_t                               offset_ = 0;
+    std::size_t                               size_   = 0;
+
+  public:
+    using value_type     = Value;
+    using const_iterator = typename std::span<Value const>::iterator;
+
+    Window() = default;
+
+    Window(std::shared_ptr<std::vector<Value> const> block,
+           std::size_t                               offset,
+           std::size_t                               size)
+        : block_(std::move(block)), offset_(offset), size_(size) {}
+
+    std::span<Value const> span() const {
+        return size_ ? std::span<Value const>(block_->data() + offset_, size_)
+                     : std::span<Value const>();
+    }
+
+    operator std::span<Value const>() const { return span(); }
+
+    std::size_t size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+
+    Value const& operator[](std::size_t i) const {
+        return (*block_)[offset_ + i];
+    }
+
+    Value const& front() const { return (*this)[0]; }
+
+    Value const& back() const { return (*this)[size_ - 1]; }
+
+    const_iterator begin() const { return span().begin(); }
+
+    const_iterator end() const { return span().end(); }
+};
+
+template <typename Value, typename Time>
+struct TimeWindow {
+    Time          start;
+    Time          end;
+    Window<Value> elements;
+};
+
+namespace detail {
+
+// The elements of the current window, in a block with room for those of
+// the next, which the windows handed out share.
+template <typename Value>
+class WindowStore {
+    using Block = std::shared_ptr<std::vector<Value>>;
+
+    static constexpr std::size_t maxSpare = 4;
+
+    std::size_t        capacity_;
+    std::vector<Block> spare_;
+    Block              block_;
+    std::size_t        begin_ = 0;
+
+    // A block of at least 'capacity' that no window refers to, or a new
+    // one.
+    Block freeBlock(std::size_t capacity) {
+        for (Block& spare : spare_) {
+            if (spare.use_count() == 1 && spare->capacity() >= capacity) {
+                Block block = std::move(spare);
+                spare       = std::move(spare_.back());
+                spare_.pop_back();
+                block->clear();
+                return block;
+            }
+        }
+        Block block = std::make_shared<std::vector<Value>>();
+        block->reserve(capacity);
+        return block;
+    }
+
+  public:
+    explicit WindowStore(std::size_t capacity)
+        : capacity_(capacity), block_(freeBlock(capacity)) {}
+
+    std::size_t size() const { return block_->size() - begin_; }
+
+    Value const& at(std::size_t i) const { return (*block_)[begin_ + i]; }
+
+    // Appending never moves the elements of a block, which windows see.
+    void push(Value const& value) {
+        if (block_->size() == block_->capacity()) {
+            // A window that outgrows the block doubles it.
+            std::size_t live = size();
+            if (2 * live > capacity_) {
+                capacity_ = 2 * live;
+            }
+            Block next = freeBlock(capacity_);
+            next->insert(
+                next->end(), block_->begin() + begin_, block_->end());
+            if (spare_.size() < maxSpare) {
+                spare_.push_back(std::move(block_));
+            }
+            block_ = std::move(next);
+            begin_ = 0;
+        }
+        block_->push_back(value);
+    }
+
+    void drop(std::size_t n) { begin_ += n < size() ? n : size(); }
+
+    Window<Value> view() const {
+        return Window<Value>(block_, begin_, size());
+    }
+};
+
+template <typename Value, typename Suspension>
+struct CountWindows {
+    std::size_t                         size;
+    std::size_t                         step;
+    std::shared_ptr<WindowStore<Value>> store;
+
+    // Skip 'skip' elements of 'in', then fill the store to a window.
+    // Returns false if 'in' runs out first.
+    bool fill(ConsStream<Value, Suspension>& in, std::size_t skip) const {
+        for (; skip > 0 && !in.isEmpty(); --skip) {
+            in = in.tail();
+        }
+        while (store->size() < size && !in.isEmpty()) {
+            store->push(in.head());
+            in = in.tail();
+        }
+        return store->size() == size;
+    }
+
+    // Elements skipped after the window's step leaves it empty.
+    std::size_t gap() const { return step > size ? step - size : 0; }
+
+    std::size_t advance() const { return step < size ? step : size; }
+};
+
+template <typename Value, typename Suspension>
+ConsStream<Window<Value>, Suspension>
+windowsFrom(CountWindows<Value, Suspension> const& windows,
+            ConsStream<Value, Suspension>          in,
+            std::size_t                            skip) {
+    if (!windows.fill(in, skip)) {
+        return ConsStream<Window<Value>, Suspension>();
+    }
+    return ConsStream<Window<Value>, Suspension>(
+        [windows, in, window = windows.store->view()]() {
+            windows.store->drop(windows.advance());
+            return ConsCell<Window<Value>, Suspension>(
+                window, windowsFrom(windows, in, windows.gap()));
+        });
+}
+
+template <typename Value,
+          typename Suspension,
+          typename Acc,
+          typename Add,
+          typename Evict>
+ConsStream<Acc, Suspension>
+foldFrom(CountWindows<Value, Suspension> const& windows,
+         ConsStream<Value, Suspension>          in,
+         std::size_t                            skip,
+         Acc                                    acc,
+         Add const&                             add,
+         Evict const&                           evict) {
+    std::size_t held = windows.store->size();
+    if (!windows.fill(in, skip)) {
+        return ConsStream<Acc, Suspension>();
+    }
+    for (std::size_t i = held; i < windows.size; ++i) {
+        acc = add(std::move(acc), windows.store->at(i));
+    }
+    return ConsStream<Acc, Suspension>([windows, in, acc, add, evict]() {
+        Acc         next  = acc;
+        std::size_t count = windows.advance();
+        for (std::size_t i = 0; i < count; ++i) {
+            next = evict(std::move(next), windows.store->at(i));
+        }
+        windows.store->drop(count);
+        return ConsCell<Acc, Suspension>(
+            acc,
+            foldFrom(windows, in, windows.gap(), std::move(next), add, evict));
+    });
+}
+
+template <typename Time, typename Duration>
+Time alignDown(Time t, Duration slide) {
+    Time start = Time{} + ((t - Time{}) / slide) * slide;
+    if (t < start) {
+        start = start - slide;
+    }
+    return start;
+}
+
+template <typename Value, typename Suspension, typename TimeOf>
+struct TimeWindows {
+    using Time     = std::decay_t<std::invoke_result_t<TimeOf, Value const&>>;
+    using Duration = decltype(std::declval<Time>() - std::declval<Time>());
+
+    Duration                            width;
+    Duration                            slide;
+    TimeOf                              timeOf;
+    std::shared_ptr<WindowStore<Value>> store;
+};
+
+template <typename Value, typename Suspension, typename TimeOf>
+auto timeWindowsFrom(TimeWindows<Value, Suspension, TimeOf> const& windows,
+                     ConsStream<Value, Suspension>                 in,
+                     typename TimeWindows<Value, Suspension, TimeOf>::Time
+                          start,
+                     bool started)
+    -> ConsStream<
+        TimeWindow<Value,
+                   typename TimeWindows<Value, Suspension, TimeOf>::Time>,
+        Suspension> {
+    using Time   = typename TimeWindows<Value, Suspension, TimeOf>::Time;
+    using Result = TimeWindow<Value, Time>;
+    WindowStore<Value>& store = *windows.store;
+
+    while (store.size() > 0 && windows.timeOf(store.at(0)) < start) {
+        store.drop(1);
+    }
+    // With nothing held, move to the first window holding the next element,
+    // which, if windows leave gaps, may have none.
+    while (store.size() == 0) {
+        if (in.isEmpty()) {
+            return ConsStream<Result, Suspension>();
+        }
+        Time t     = windows.timeOf(in.head());
+        Time first = alignDown(t - windows.width, windows.slide) +
+                     windows.slide;
+        if (!started || start < first) {
+            start   = first;
+            started = true;
+        }
+        if (t < start) {
+            in = in.tail();
+            continue;
+        }
+        break;
+    }
+    Time end = start + windows.width;
+    while (!in.isEmpty() && windows.timeOf(in.head()) < end) {
+        store.push(in.head());
+        in = in.tail();
+    }
+    return ConsStream<Result, Suspension>(
+        [windows, in, start, window = Result{start, end, store.view()}]() {
+            return ConsCell<Result, Suspension>(
+                window,
+                timeWindowsFrom(windows, in, start + windows.slide, true));
+        });
+}
+
+} // namespace detail
+
+// ============================================================================
+//              INLINE FUNCTION AND FUNCTION TEMPLATE DEFINITIONS
+// ============================================================================
+
+template <typename Value, typename Suspension>
+ConsStream<Window<Value>, Suspension>
+window(ConsStream<Value, Suspension> stream,
+       std::size_t                   size,
+       std::size_t                   step = 1) {
+    if (size == 0 || step == 0) {
+        throw std::invalid_argument("window: size and step must be positive");
+    }
+    detail::CountWindows<Value, Suspension> windows{
+        size,
+        step,
+        std::make_shared<detail::WindowStore<Value>>(
+            2 * size)};
+    return detail::windowsFrom(windows, std::move(stream), 0);
+}
+
+template <typename Value,
+          typename Suspension,
+          typename Acc,
+          typename Add,
+          typename Evict>
+ConsStream<Acc, Suspension> windowFold(ConsStream<Value, Suspension> stream,
+                                       std::size_t                   size,
+                                       std::size_t                   step,
+                                       Acc                           init,
+                                       Add                           add,
+                                       Evict                         evict) {
+    if (size == 0 || step == 0) {
+        throw std::invalid_argument(
+            "windowFold: size and step must be positive");
+    }
+    detail::CountWindows<Value, Suspension> windows{
+        size, step, std::make_shared<detail::WindowStore<Value>>(2 * size)};
+    return detail::foldFrom(
+        windows, std::move(stream), 0, std::move(init), add, evict);
+}
+
+template <typename Value, typename Suspension>
+ConsStream<Value, Suspension> movingSum(ConsStream<Value, Suspension> stream,
+                                        std::size_t                   size) {
+    return windowFold(
+        std::move(stream),
+        size,
+        1,
+        Value{},
+        [](Value acc, Value const& x) { return acc + x; },
+        [](Value acc, Value const& x) { return acc - x; });
+}
+
+template <typename Value, typename Suspension>
+ConsStream<double, Suspension>
+movingAverage(ConsStream<Value, Suspension> stream, std::size_t size) {
+    return fmap(movingSum(std::move(stream), size), [size](Value const& sum) {
+        return double(sum) / double(size);
+    });
+}
+
+template <typename Value, typename Suspension, typename TimeOf>
+auto slidingWindows(
+    ConsStream<Value, Suspension>                                    stream,
+    typename detail::TimeWindows<Value, Suspension, TimeOf>::Duration width,
+    typename detail::TimeWindows<Value, Suspension, TimeOf>::Duration slide,
+    TimeOf                                                           timeOf) {
+    using Windows = detail::TimeWindows<Value, Suspension, TimeOf>;
+    if (!(typename Windows::Duration{} < width) ||
+        !(typename Windows::Duration{} < slide)) {
+        throw std::invalid_argument(
+            "slidingWindows: width and slide must be positive");
+    }
+    Windows windows{width,
+                    slide,
+                    std::move(timeOf),
+                    std::make_shared<detail::WindowStore<Value>>(64)};
+    return detail::timeWindowsFrom(
+        windows, std::move(stream), typename Windows::Time{}, false);
+}
+
+template <typename Value, typename Suspension, typename TimeOf>
+auto tumblingWindows(
+    ConsStream<Value, Suspension>                                    stream,
+    typename detail::TimeWindows<Value, Suspension, TimeOf>::Duration width,
+    TimeOf                                                           timeOf) {
+    return slidingWindows(std::move(stream), width, width, std::move(timeOf));
+}
+
+} // namespace co_fun
+
+#endif
@@ -0,0 +1,222 @@
+#include <co_fun/window.h>
+#include <co_fun/stream.t.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <numeric>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace co_fun;
+
+namespace {
+using test::fromVector;
+using test::collect;
+
+struct Event {
+    int time;
+    int value;
+};
+
+int timeOf(Event const& e) { return e.time; }
+
+template <typename Stream>
+std::vector<std::vector<int>> windows(Stream stream) {
+    std::vector<std::vector<int>> result;
+    for (; !stream.isEmpty(); stream = stream.tail()) {
+        result.emplace_back(stream.head().begin(), stream.head().end());
+    }
+    return result;
+}
+
+// The values and bounds of each time window.
+template <typename Stream>
+std::vector<std::pair<int, std::vector<int>>> timed(Stream stream) {
+    std::vector<std::pair<int, std::vector<int>>> result;
+    for (; !stream.isEmpty(); stream = stream.tail()) {
+        auto const&      w = stream.head();
+        std::vector<int> values;
+        for (Event const& e : w.elements) {
+            values.push_back(e.value);
+        }
+        EXPECT_EQ(w.start + 10, w.end);
+        result.emplace_back(w.start, values);
+    }
+    return result;
+}
+} // namespace
+
+TEST(Co_FunWindowTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunWindowTest, Sliding) {
+    EXPECT_EQ((std::vector<std::vector<int>>{
+                  {1, 2, 3}, {2, 3, 4}, {3, 4, 5}, {4, 5, 6}}),
+              windows(window(rangeFrom(1, 6), 3, 1)));
+}
+
+TEST(Co_FunWindowTest, Tumbling) {
+    EXPECT_EQ((std::vector<std::vector<int>>{{1, 2, 3}, {4, 5, 6}}),
+              windows(window(rangeFrom(1, 7), 3, 3)));
+}
+
+TEST(Co_FunWindowTest, Hopping) {
+    EXPECT_EQ((std::vector<std::vector<int>>{{1, 2}, {5, 6}, {9, 10}}),
+              windows(window(rangeFrom(1, 11), 2, 4)));
+}
+
+TEST(Co_FunWindowTest, TooShort) {
+    EXPECT_TRUE(window(rangeFrom(1, 2), 3).isEmpty());
+    EXPECT_THROW(window(rangeFrom(1, 2), 0), std::invalid_argument);
+    EXPECT_THROW(window(rangeFrom(1, 2), 1, 0), std::invalid_argument);
+}
+
+TEST(Co_FunWindowTest, Span) {
+    Window<int>          w    = window(rangeFrom(1, 5), 4).head();
+    std::span<int const> span = w;
+    EXPECT_EQ(4u, span.size());
+    EXPECT_EQ(10, std::accumulate(span.begin(), span.end(), 0));
+    EXPECT_EQ(1, w.front());
+    EXPECT_EQ(4, w.back());
+    EXPECT_EQ(3, w[2]);
+}
+
+TEST(Co_FunWindowTest, HeldWindowsStayValid) {
+    std::vector<Window<int>> held;
+    auto                     s = window(rangeFrom(0, 999), 10, 1);
+    for (; !s.isEmpty(); s = s.tail()) {
+        held.push_back(s.head());
+    }
+    ASSERT_EQ(991u, held.size());
+    for (std::size_t i = 0; i < held.size(); ++i) {
+        for (std::size_t j = 0; j < 10; ++j) {
+            ASSERT_EQ(int(i + j), held[i][j]);
+        }
+    }
+}
+
+TEST(Co_FunWindowTest, ReusesBuffers) {
+    // Walked by reassignment, the windows cycle through a few buffers.
+    std::set<int const*> buffers;
+    int const*           previous = nullptr;
+    auto                 s        = window(rangeFrom(0, 99999), 8, 1);
+    for (; !s.isEmpty(); s = s.tail()) {
+        int const* data = s.head().span().data();
+        if (data != previous + 1) {
+            buffers.insert(data);
+        }
+        previous = data;
+    }
+    EXPECT_GE(4u, buffers.size());
+}
+
+TEST(Co_FunWindowTest, MovingSum) {
+    EXPECT_EQ((std::vector<int>{6, 9, 12, 15, 18, 21, 24, 27}),
+              collect(movingSum(rangeFrom(1, 10), 3)));
+    EXPECT_EQ((std::vector<double>{1.5, 2.5, 3.5}),
+              collect(movingAverage(rangeFrom(1, 4), 2)));
+}
+
+TEST(Co_FunWindowTest, FoldMatchesWindows) {
+    for (std::size_t size : {1, 3, 7}) {
+        for (std::size_t step : {1, 2, 3, 7, 10}) {
+            std::vector<long> expected;
+            auto              s = window(rangeFrom(1, 50), size, step);
+            for (; !s.isEmpty(); s = s.tail()) {
+                expected.push_back(
+                    std::accumulate(s.head().begin(), s.head().end(), 0L));
+            }
+            auto sums = windowFold(
+                rangeFrom(1, 50),
+                size,
+                step,
+                0L,
+                [](long acc, int x) { return acc + x; },
+                [](long acc, int x) { return acc - x; });
+            EXPECT_EQ(expected, collect(sums)) << size << " " << step;
+        }
+    }
+}
+
+TEST(Co_FunWindowTest, FoldEvaluatesEachElementOnce) {
+    int  adds   = 0;
+    int  evicts = 0;
+    auto sums   = windowFold(
+        rangeFrom(1, 1000),
+        100,
+        1,
+        0,
+        [&adds](int acc, int x) { return ++adds, acc + x; },
+        [&evicts](int acc, int x) { return ++evicts, acc - x; });
+    EXPECT_EQ(901u, collect(sums).size());
+    EXPECT_EQ(1000, adds);
+    EXPECT_EQ(901, evicts);
+}
+
+TEST(Co_FunWindowTest, TumblingTime) {
+    auto events = fromVector<Event>(
+        {{1, 10}, {3, 30}, {12, 120}, {15, 150}, {31, 310}});
+    EXPECT_EQ((std::vector<std::pair<int, std::vector<int>>>{
+                  {0, {10, 30}}, {10, {120, 150}}, {30, {310}}}),
+              timed(tumblingWindows(events, 10, timeOf)));
+}
+
+TEST(Co_FunWindowTest, SlidingTime) {
+    auto events = fromVector<Event>({{1, 1}, {3, 3}, {7, 7}, {12, 12}});
+    EXPECT_EQ((std::vector<std::pair<int, std::vector<int>>>{
+                  {-5, {1, 3}}, {0, {1, 3, 7}}, {5, {7, 12}}, {10, {12}}}),
+              timed(slidingWindows(events, 10, 5, timeOf)));
+}
+
+TEST(Co_FunWindowTest, GapsBetweenTimeWindows) {
+    // Windows of 10 every 20 leave out what falls between them.
+    auto events = fromVector<Event>({{1, 1}, {15, 15}, {22, 22}, {45, 45}});
+    EXPECT_EQ((std::vector<std::pair<int, std::vector<int>>>{
+                  {0, {1}}, {20, {22}}, {40, {45}}}),
+              timed(slidingWindows(events, 10, 20, timeOf)));
+}
+
+TEST(Co_FunWindowTest, LargeTimeWindows) {
+    std::vector<Event> many;
+    for (int i = 0; i < 10000; ++i) {
+        many.push_back({i / 1000 * 10, i});
+    }
+    auto w = tumblingWindows(fromVector(many), 10, timeOf);
+    int  n = 0;
+    for (; !w.isEmpty(); w = w.tail(), ++n) {
+        ASSERT_EQ(1000u, w.head().elements.size());
+        EXPECT_EQ(n * 1000, w.head().elements.front().value);
+        EXPECT_EQ(n * 1000 + 999, w.head().elements.back().value);
+    }
+    EXPECT_EQ(10, n);
+}
+
+TEST(Co_FunWindowTest, ChronoTime) {
+    using namespace std::chrono;
+    using Stamp = time_point<system_clock, milliseconds>;
+    std::vector<std::pair<Stamp, int>> ticks;
+    for (int i = 0; i < 10; ++i) {
+        ticks.emplace_back(Stamp(milliseconds(1000 + 250 * i)), i);
+    }
+    auto seconds = tumblingWindows(
+        fromVector(ticks), milliseconds(1000), [](auto const& t) {
+            return t.first;
+        });
+    std::vector<std::size_t> sizes;
+    for (; !seconds.isEmpty(); seconds = seconds.tail()) {
+        sizes.push_back(seconds.head().elements.size());
+        EXPECT_EQ(milliseconds(1000),
+                  seconds.head().end - seconds.head().start);
+    }
+    EXPECT_EQ((std::vector<std::size_t>{4, 4, 2}), sizes);
+}
+
+TEST(Co_FunWindowTest, BadTimeWindows) {
+    auto events = fromVector<Event>({{1, 1}});
+    EXPECT_THROW(tumblingWindows(events, 0, timeOf), std::invalid_argument);
+    EXPECT_THROW(slidingWindows(events, 10, -1, timeOf),
+                 std::invalid_argument);
+}
@@ -0,0 +1,233 @@
+// writesink.cpp                                                      -*-C++-*-
+#include <co_fun/writesink.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace co_fun {
+
+namespace {
+std::system_error systemError(char const* what) {
+    return std::system_error(errno, std::generic_category(), what);
+}
+
+constexpr std::size_t directAlignment = 4096;
+} // namespace
+
+WriteSink::WriteSink(int fd, bool owned, SinkOptions const& options)
+    : fd_(fd), owned_(owned), options_(options) {
+    if (options_.bufferSize == 0) {
+        options_.bufferSize = 1;
+    }
+    bool direct = options_.durability == SinkOptions::Durability::direct;
+    pool_       = std::make_shared<BufferPool>(
+        options_.bufferSize,
+        options_.flushBytes / options_.bufferSize + 2,
+        direct ? directAlignment : alignof(std::max_align_t));
+
+    off_t offset = ::lseek(fd_, 0, SEEK_CUR);
+    offset_      = offset > 0 ? std::uint64_t(offset) : 0;
+    syncRange_   = options_.durability == SinkOptions::Durability::syncRange &&
+                 offset >= 0;
+}
+
+WriteSink::WriteSink(int fd, SinkOptions const& options)
+    : WriteSink(fd, false, options) {
+    if (options.durability == SinkOptions::Durability::direct) {
+        throw std::invalid_argument("direct WriteSink must be opened by path");
+    }
+}
+
+WriteSink WriteSink::open(std::string const& path,
+                          SinkOptions const& options) {
+    int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    if (options.durability == SinkOptions::Durability::direct) {
+        flags |= O_DIRECT;
+    }
+    int fd = ::open(path.c_str(), flags, 0666);
+    if (fd < 0) {
+        throw systemError("open");
+    }
+    return WriteSink(fd, true, options);
+}
+
+WriteSink::WriteSink(WriteSink&& other) noexcept
+    : fd_(std::exchange(other.fd_, -1)),
+      owned_(std::exchange(other.owned_, false)),
+      options_(other.options_),
+      pool_(other.pool_),
+      blocks_(std::move(other.blocks_)),
+      used_(std::exchange(other.used_, 0)),
+      buffered_(std::exchange(other.buffered_, 0)),
+      oldest_(other.oldest_),
+      offset_(other.offset_),
+      written_(other.written_),
+      flushes_(other.flushes_),
+      lastSyncOffset_(other.lastSyncOffset_),
+      lastSyncLength_(other.lastSyncLength_),
+      syncRange_(other.syncRange_) {}
+
+WriteSink::~WriteSink() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+void WriteSink::write(std::string_view bytes) {
+    if (buffered_ == 0 && options_.flushInterval.count() != 0) {
+        oldest_ = Clock::now();
+    }
+    while (!bytes.empty()) {
+        if (blocks_.empty() || used_ == options_.bufferSize) {
+            blocks_.push_back(pool_->acquire());
+            used_ = 0;
+        }
+        std::size_t n = std::min(bytes.size(), options_.bufferSize - used_);
+        std::memcpy(blocks_.back().get() + used_, bytes.data(), n);
+        used_ += n;
+        buffered_ += n;
+        bytes.remove_prefix(n);
+    }
+    maybeFlush();
+}
+
+void WriteSink::maybeFlush() {
+    if (buffered_ >= options_.flushBytes ||
+        (options_.flushInterval.count() != 0 && buffered_ != 0 &&
+         Clock::now() - oldest_ >= options_.flushInterval)) {
+        flush();
+    }
+}
+
+void WriteSink::writeBlocks(std::size_t count, std::size_t lastLength) {
+    std::vector<iovec> iovecs(count);
+    std::uint64_t      total = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        iovecs[i].iov_base = blocks_[i].get();
+        iovecs[i].iov_len  = i + 1 == count ? lastLength : options_.bufferSize;
+        total += iovecs[i].iov_len;
+    }
+
+    iovec*      next = iovecs.data();
+    std::size_t left = count;
+    while (left != 0) {
+        int     batch = int(std::min<std::size_t>(left, IOV_MAX));
+        ssize_t n     = ::writev(fd_, next, batch);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN) {
+                pollfd wait{fd_, POLLOUT, 0};
+                ::poll(&wait, 1, -1);
+                continue;
+            }
+            throw systemError("writev");
+        }
+        // Step over what was written, which may end inside an iovec.
+        std::size_t done = std::size_t(n);
+        while (left != 0 && done >= next->iov_len) {
+            done -= next->iov_len;
+            ++next;
+            --left;
+        }
+        if (left != 0) {
+            next->iov_base = static_cast<char*>(next->iov_base) + done;
+            next->iov_len -= done;
+        }
+    }
+
+    syncWritten(offset_, total);
+    offset_ += total;
+    written_ += total;
+}
+
+void WriteSink::syncWritten(std::uint64_t offset, std::uint64_t length) {
+    if (!syncRange_ || length == 0) {
+        return;
+    }
+    // Start this flush on its way to the disk, then wait for the one
+    // before it, so at most two flushes' worth of pages are dirty.
+    if (::sync_file_range(fd_, off64_t(offset), off64_t(length),
+                          SYNC_FILE_RANGE_WRITE) != 0) {
+        syncRange_ = false;
+        return;
+    }
+    if (lastSyncLength_ != 0) {
+        ::sync_file_range(fd_, off64_t(lastSyncOffset_),
+                          off64_t(lastSyncLength_),
+                          SYNC_FILE_RANGE_WAIT_BEFORE |
+                              SYNC_FILE_RANGE_WRITE |
+                              SYNC_FILE_RANGE_WAIT_AFTER);
+    }
+    lastSyncOffset_ = offset;
+    lastSyncLength_ = length;
+}
+
+void WriteSink::flush() {
+    if (buffered_ == 0) {
+        return;
+    }
+    if (options_.durability == SinkOptions::Durability::direct) {
+        std::size_t whole = buffered_ / options_.bufferSize;
+        if (whole == 0) {
+            return;
+        }
+        writeBlocks(whole, options_.bufferSize);
+        blocks_.erase(blocks_.begin(), blocks_.begin() + whole);
+        buffered_ -= whole * options_.bufferSize;
+        if (blocks_.empty()) {
+            used_ = 0;
+        }
+    } else {
+        writeBlocks(blocks_.size(), used_);
+        blocks_.clear();
+        used_     = 0;
+        buffered_ = 0;
+    }
+    ++flushes_;
+}
+
+void WriteSink::close() {
+    if (fd_ < 0) {
+        return;
+    }
+    try {
+        flush();
+        if (buffered_ != 0) {
+            // The partial block of a direct sink cannot be written O_DIRECT.
+            int flags = ::fcntl(fd_, F_GETFL);
+            if (flags < 0 || ::fcntl(fd_, F_SETFL, flags & ~O_DIRECT) < 0) {
+                throw systemError("fcntl");
+            }
+            writeBlocks(blocks_.size(), used_);
+            blocks_.clear();
+            used_     = 0;
+            buffered_ = 0;
+            ++flushes_;
+        }
+    } catch (...) {
+        // The sink is closed even so; what was not written is lost.
+        int fd = std::exchange(fd_, -1);
+        if (owned_) {
+            ::close(fd);
+        }
+        throw;
+    }
+    int fd = std::exchange(fd_, -1);
+    if (owned_ && ::close(fd) != 0) {
+        throw systemError("close");
+    }
+}
+
+} // namespace co_fun
@@ -0,0 +1,193 @@
+// writesink.h                                                        -*-C++-*-
+#ifndef INCLUDED_CO_FUN_WRITESINK
+#define INCLUDED_CO_FUN_WRITESINK
+
+//@PURPOSE: Drain streams to a file descriptor with batched 'writev' calls.
+//
+//@CLASSES:
+//  co_fun::WriteSink: buffered writer of serialized elements to a descriptor
+//  co_fun::SinkOptions: buffer size, flush triggers and durability mode
+//
+//@AUTHOR: Steve Downey (sdowney)
+//
+//@DESCRIPTION: A 'WriteSink' serializes values into blocks from a
+// 'BufferPool' and writes the filled blocks with a single 'writev' when
+// 'SinkOptions::flushBytes' are buffered, or when a write finds the oldest
+// buffered byte older than 'SinkOptions::flushInterval'.  The interval is
+// checked as values are written: an idle sink keeps its bytes until the next
+// write, 'flush()' or 'close()'.
+//
+// 'drain(stream, sink)' writes every element of a stream, each followed by
+// a delimiter, or formatted by a function given the sink.  It walks the
+// stream by reassignment, so each cell is released as soon as it has been
+// written; a stream handed over with 'std::move', and not held elsewhere,
+// is written in constant memory however long it is.
+//
+//..
+//  WriteSink out(STDOUT_FILENO);
+//  drain(fmap(lines(file), toCsv), out);
+//  out.flush();
+//..
+//
+// Strings, string views, chunks, characters and numbers can be written
+// with 'operator<<'.
+//
+// 'SinkOptions::durability' selects how the bytes reach the disk:
+//: o 'none' leaves them to the page cache.
+//: o 'syncRange' starts writeback of each flush with 'sync_file_range', and
+//:   waits for the writeback of the flush before it, which keeps the dirty
+//:   pages of a long write bounded without a full 'fsync'.  It is ignored
+//:   for descriptors that are not files.
+//: o 'direct' is for files opened by 'WriteSink::open'.  They are opened
+//:   'O_DIRECT', the page cache is bypassed, and only whole page-aligned
+//:   blocks are written; the last partial block is written by 'close()'
+//:   after 'O_DIRECT' is turned off.  'bufferSize' must be a multiple of the
+//:   device block.
+//
+// Errors throw 'std::system_error' from 'write', 'flush' and 'close'.  The
+// destructor flushes, but ignores errors; call 'close()', or 'flush()', to
+// see them.  A 'WriteSink' may be used by one thread at a time.
+
+#include <co_fun/bufferpool.h>
+#include <co_fun/stream.h>
+
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace co_fun {
+
+struct SinkOptions {
+    enum class Durability { none, syncRange, direct };
+
+    // Bytes per pooled block.
+    std::size_t bufferSize = std::size_t(64) << 10;
+
+    // Flush once this many bytes are buffered.
+    std::size_t flushBytes = std::size_t(1) << 20;
+
+    // Flush when a write finds buffered bytes this old.  Zero never does.
+    std::chrono::milliseconds flushInterval{0};
+
+    Durability durability = Durability::none;
+};
+
+class WriteSink {
+    using Clock = std::chrono::steady_clock;
+
+    int                                fd_;
+    bool                               owned_;
+    SinkOptions                        options_;
+    std::shared_ptr<BufferPool>        pool_;
+    std::vector<std::shared_ptr<char>> blocks_;
+    std::size_t                        used_     = 0; // in the last block
+    std::size_t                        buffered_ = 0;
+    Clock::time_point                  oldest_;
+    std::uint64_t                      offset_  = 0;
+    std::uint64_t                      written_ = 0;
+    std::size_t                        flushes_ = 0;
+    std::uint64_t                      lastSyncOffset_ = 0;
+    std::uint64_t                      lastSyncLength_ = 0;
+    bool                               syncRange_      = false;
+
+    WriteSink(int fd, bool owned, SinkOptions const& options);
+
+    void writeBlocks(std::size_t count, std::size_t lastLength);
+    void syncWritten(std::uint64_t offset, std::uint64_t length);
+    void maybeFlush();
+
+  public:
+    // Write to 'fd', which is not owned.  'durability' must not be
+    // 'direct'.
+    explicit WriteSink(int fd, SinkOptions const& options = {});
+
+    // Create or truncate the file at 'path' and write to it.
+    static WriteSink open(std::string const& path,
+                          SinkOptions const& options = {});
+
+    WriteSink(WriteSink&& other) noexcept;
+    WriteSink& operator=(WriteSink&&) = delete;
+
+    ~WriteSink();
+
+    // Append 'bytes', flushing if that passes a flush trigger.
+    void write(std::string_view bytes);
+
+    // Write everything buffered.  In 'direct' mode a partial last block is
+    // kept back for 'close()'.
+    void flush();
+
+    // Flush everything, and close the descriptor if it is owned.  If the
+    // flush fails the descriptor is closed all the same, and the error
+    // rethrown.
+    void close();
+
+    std::uint64_t bytesWritten() const { return written_; }
+
+    std::size_t flushes() const { return flushes_; }
+
+    std::size_t buffered() const { return buffered_; }
+
+    BufferPool const& pool() const { return *pool_; }
+
+    WriteSink& operator<<(std::string_view bytes) {
+        write(bytes);
+        return *this;
+    }
+
+    WriteSink& operator<<(char c) {
+        write(std::string_view(&c, 1));
+        return *this;
+    }
+
+    template <typename Number,
+              typename = typename std::enable_if<
+                  std::is_arithmetic<Number>::value &&
+                  !std::is_same<Number, char>::value>::type>
+    WriteSink& operator<<(Number n) {
+        char digits[64];
+        auto result = std::to_chars(digits, digits + sizeof digits, n);
+        write(std::string_view(digits, std::size_t(result.ptr - digits)));
+        return *this;
+    }
+};
+
+// ============================================================================
+//              INLINE FUNCTION AND FUNCTION TEMPLATE DEFINITIONS
+// ============================================================================
+
+// Write 'format(sink, element)' for every element of 'stream', returning
+// the number of elements.
+template <typename Value, typename Suspension, typename Format>
+std::size_t drain(ConsStream<Value, Suspension> stream,
+                  WriteSink&                    sink,
+                  Format                        format) {
+    std::size_t count = 0;
+    for (; !stream.isEmpty(); stream = stream.tail(), ++count) {
+        format(sink, stream.head());
+    }
+    return count;
+}
+
+// Write every element of 'stream', each followed by 'delimiter'.
+template <typename Value, typename Suspension>
+std::size_t drain(ConsStream<Value, Suspension> stream,
+                  WriteSink&                    sink,
+                  char                          delimiter = '\n') {
+    return drain(std::move(stream),
+                 sink,
+                 [delimiter](WriteSink& out, Value const& value) {
+                     out << value << delimiter;
+                 });
+}
+
+} // namespace co_fun
+
+#endif
@@ -0,0 +1,228 @@
+#include <co_fun/writesink.h>
+#include <co_fun/tempfile.t.h>
+
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace co_fun;
+
+namespace {
+using test::TempFile;
+
+std::string readAll(int fd) {
+    std::string result;
+    char        buffer[4096];
+    ssize_t     n;
+    while ((n = ::read(fd, buffer, sizeof buffer)) > 0) {
+        result.append(buffer, std::size_t(n));
+    }
+    return result;
+}
+
+std::ptrdiff_t openDescriptors() {
+    return std::distance(std::filesystem::directory_iterator("/proc/self/fd"),
+                         std::filesystem::directory_iterator());
+}
+} // namespace
+
+TEST(Co_FunWriteSinkTest, TestGTest) { ASSERT_EQ(1, 1); }
+
+TEST(Co_FunWriteSinkTest, WritesToFile) {
+    TempFile file;
+    {
+        WriteSink out = WriteSink::open(file.path());
+        out << "hello" << ' ' << std::string("world") << '\n';
+        EXPECT_EQ(0u, out.bytesWritten());
+        out.close();
+        EXPECT_EQ(12u, out.bytesWritten());
+    }
+    EXPECT_EQ("hello world\n", file.contents());
+}
+
+TEST(Co_FunWriteSinkTest, WritesNumbers) {
+    TempFile file;
+    {
+        WriteSink out = WriteSink::open(file.path());
+        out << 42 << ',' << -7 << ',' << 3u << ',' << 2.5;
+    }
+    EXPECT_EQ("42,-7,3,2.5", file.contents());
+}
+
+TEST(Co_FunWriteSinkTest, WritesToPipe) {
+    int fds[2];
+    ASSERT_EQ(0, ::pipe(fds));
+    std::string received;
+    std::thread reader([&]() { received = readAll(fds[0]); });
+
+    SinkOptions options;
+    options.bufferSize = 100;
+    options.flushBytes = 1000;
+    std::string expected;
+    {
+        WriteSink out(fds[1], options);
+        for (int i = 0; i < 10000; ++i) {
+            out << i << '\n';
+            expected += std::to_string(i) + '\n';
+        }
+        out.close();
+        EXPECT_LT(10u, out.flushes());
+    }
+    ::close(fds[1]);
+    reader.join();
+    ::close(fds[0]);
+    EXPECT_EQ(expected, received);
+}
+
+TEST(Co_FunWriteSinkTest, FlushesOnBytes) {
+    TempFile    file;
+    SinkOptions options;
+    options.bufferSize = 16;
+    options.flushBytes = 64;
+    WriteSink out      = WriteSink::open(file.path(), options);
+
+    out << std::string(63, 'x');
+    EXPECT_EQ(0u, out.flushes());
+    EXPECT_EQ(63u, out.buffered());
+    out << 'x';
+    EXPECT_EQ(1u, out.flushes());
+    EXPECT_EQ(0u, out.buffered());
+    EXPECT_EQ(64u, out.bytesWritten());
+    EXPECT_EQ(std::string(64, 'x'), file.contents());
+}
+
+TEST(Co_FunWriteSinkTest, FlushesOnInterval) {
+    TempFile    file;
+    SinkOptions options;
+    options.flushInterval = std::chrono::milliseconds(20);
+    WriteSink out         = WriteSink::open(file.path(), options);
+
+    out << "first\n";
+    EXPECT_EQ(0u, out.flushes());
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    out << "second\n";
+    EXPECT_EQ(1u, out.flushes());
+    EXPECT_EQ("first\nsecond\n", file.contents());
+}
+
+TEST(Co_FunWriteSinkTest, DrainWithDelimiter) {
+    TempFile    file;
+    std::size_t count;
+    {
+        WriteSink out = WriteSink::open(file.path());
+        count         = drain(rangeFrom(1, 4), out);
+    }
+    EXPECT_EQ(4u, count);
+    EXPECT_EQ("1\n2\n3\n4\n", file.contents());
+}
+
+TEST(Co_FunWriteSinkTest, DrainWithFormat) {
+    TempFile file;
+    {
+        WriteSink out = WriteSink::open(file.path());
+        drain(rangeFrom(1, 3), out, [](WriteSink& sink, int i) {
+            sink << i << '=' << i * i << ';';
+        });
+    }
+    EXPECT_EQ("1=1;2=4;3=9;", file.contents());
+}
+
+TEST(Co_FunWriteSinkTest, DrainsInConstantMemory) {
+    TempFile    file;
+    SinkOptions options;
+    options.bufferSize = 4096;
+    options.flushBytes = 16384;
+    WriteSink out      = WriteSink::open(file.path(), options);
+
+    std::size_t count = drain(rangeFrom(1, 300000), out);
+    out.close();
+    EXPECT_EQ(300000u, count);
+    // The buffers in use never outgrow one flush, however long the stream.
+    EXPECT_GE(6u, out.pool().allocated());
+    EXPECT_LT(16u, out.flushes());
+}
+
+TEST(Co_FunWriteSinkTest, SyncRange) {
+    TempFile    file;
+    SinkOptions options;
+    options.bufferSize = 4096;
+    options.flushBytes = 8192;
+    options.durability = SinkOptions::Durability::syncRange;
+    std::string expected;
+    {
+        WriteSink out = WriteSink::open(file.path(), options);
+        for (int i = 0; i < 5000; ++i) {
+            out << i << '\n';
+            expected += std::to_string(i) + '\n';
+        }
+    }
+    EXPECT_EQ(expected, file.contents());
+}
+
+TEST(Co_FunWriteSinkTest, Direct) {
+    TempFile    file;
+    SinkOptions options;
+    options.bufferSize = 4096;
+    options.flushBytes = 8192;
+    options.durability = SinkOptions::Durability::direct;
+    std::string expected;
+    try {
+        WriteSink out = WriteSink::open(file.path(), options);
+        for (int i = 0; i < 5000; ++i) {
+            out << i << '\n';
+            expected += std::to_string(i) + '\n';
+        }
+        out.flush();
+        // Only whole blocks go out 'O_DIRECT'.
+        EXPECT_EQ(0u, out.bytesWritten() % 4096);
+        EXPECT_LT(0u, out.buffered());
+        out.close();
+        EXPECT_EQ(expected.size(), out.bytesWritten());
+    } catch (std::system_error const& error) {
+        if (error.code().value() == EINVAL) {
+            GTEST_SKIP() << "O_DIRECT is not supported here";
+        }
+        throw;
+    }
+    EXPECT_EQ(expected, file.contents());
+}
+
+TEST(Co_FunWriteSinkTest, DirectNeedsAPath) {
+    SinkOptions options;
+    options.durability = SinkOptions::Durability::direct;
+    EXPECT_THROW(WriteSink(STDOUT_FILENO, options), std::invalid_argument);
+}
+
+TEST(Co_FunWriteSinkTest, FailedCloseReleasesDescriptor) {
+    std::ptrdiff_t before = openDescriptors();
+    {
+        // Every write to /dev/full fails with ENOSPC.
+        WriteSink out = WriteSink::open("/dev/full");
+        out << "lost\n";
+        EXPECT_THROW(out.close(), std::system_error);
+        EXPECT_EQ(before, openDescriptors());
+    }
+    EXPECT_EQ(before, openDescriptors());
+}
+
+TEST(Co_FunWriteSinkTest, DestructorFlushes) {
+    TempFile file;
+    int      fd = ::open(file.path().c_str(), O_WRONLY);
+    ASSERT_LE(0, fd);
+    {
+        WriteSink out(fd);
+        out << "kept\n";
+    }
+    ::close(fd);
+    EXPECT_EQ("kept\n", file.contents());
+}
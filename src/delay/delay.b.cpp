@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+
+#include <delay/delay.h>
+
+#include <memory>
+#include <string>
+
+static void BM_DelayForce(benchmark::State& state) {
+  int sum = 0;
+  for (auto _ : state) {
+    Delay<int> d([&sum]() { return sum + 1; });
+    sum = d.get();
+  }
+  benchmark::DoNotOptimize(sum);
+}
+BENCHMARK(BM_DelayForce);
+
+// A capture the size of a typical stream cell's: a shared_ptr and a value
+// or two.
+static void BM_DelayForceCapture(benchmark::State& state) {
+  auto next = std::make_shared<int>(1);
+  long sum = 0;
+  for (auto _ : state) {
+    Delay<long> d([next, sum, a = 1L, b = 2L]() { return *next + sum + a + b; });
+    sum = d.get() & 0xff;
+  }
+  benchmark::DoNotOptimize(sum);
+}
+BENCHMARK(BM_DelayForceCapture);
+
+static void BM_DelayForcedGet(benchmark::State& state) {
+  Delay<int> d([]() { return 1; });
+  d.get();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(d.get());
+  }
+}
+BENCHMARK(BM_DelayForcedGet);
+
+static void BM_DelayCopyForced(benchmark::State& state) {
+  Delay<std::string> d([]() { return std::string("forced"); });
+  d.get();
+  for (auto _ : state) {
+    Delay<std::string> copy(d);
+    benchmark::DoNotOptimize(copy.get().size());
+  }
+}
+BENCHMARK(BM_DelayCopyForced);
+
+static void BM_DelayCopyUnforced(benchmark::State& state) {
+  Delay<int> d([]() { return 1; });
+  for (auto _ : state) {
+    Delay<int> copy(d);
+    benchmark::DoNotOptimize(&copy);
+  }
+}
+BENCHMARK(BM_DelayCopyUnforced);
+
+namespace {
+Delay<std::string> shared([]() { return std::string("shared"); });
+}
+
+// Every thread reads, and copies, one forced Delay.
+static void BM_DelayContendedGet(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(shared.get().size());
+  }
+}
+BENCHMARK(BM_DelayContendedGet)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_DelayContendedCopy(benchmark::State& state) {
+  for (auto _ : state) {
+    Delay<std::string> copy(shared);
+    benchmark::DoNotOptimize(copy.get().size());
+  }
+}
+BENCHMARK(BM_DelayContendedCopy)->ThreadRange(1, 8)->UseRealTime();
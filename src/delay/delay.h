@@ -5,80 +5,231 @@
 #include <optional>
 #include <functional>
 #include <atomic>
-#include <mutex>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 #include <iostream>
 
+// Evaluation is claimed by compare-and-swap on 'state_': the thread that
+// moves it from 'unevaluated' to 'evaluating' runs the function, and any
+// other thread forcing the same Delay waits on the atomic until the value
+// is published.  If the function throws, the Delay returns to
+// 'unevaluated' and the next get() tries again.  Reading or copying a
+// forced Delay is a single acquire load.
+//
+// The function is type erased into the same buffer that later holds the
+// value, so a Delay is one object with no allocation of its own for
+// captures up to 'inlineSize' bytes; bigger ones go to the heap.  The
+// function may be move-only, in which case copying the Delay before it is
+// forced throws std::logic_error.
+
 template <typename Value>
 class Delay {
-  using Func = std::function<Value()>;
   template <typename Action>
-  using isFuncConv = std::is_convertible<Action, Func>;
+  using isAction = std::conjunction<
+      std::negation<std::is_same<std::decay_t<Action>, Delay>>,
+      std::is_invocable_r<Value, std::decay_t<Action>&>>;
+
+  enum : int { unevaluated = 0, evaluating = 1, evaluated = 2 };
+
+  static constexpr std::size_t inlineSize = 48;
+  static constexpr std::size_t bufferSize =
+      sizeof(Value) > inlineSize ? sizeof(Value) : inlineSize;
+  static constexpr std::size_t bufferAlign =
+      alignof(Value) > alignof(std::max_align_t) ? alignof(Value)
+                                                 : alignof(std::max_align_t);
+
+  // The operations on an erased function in the buffer.  'copy' is null
+  // for a move-only function.
+  struct Ops {
+    Value (*invoke)(void*);
+    void (*copy)(void*, void const*);
+    void (*destroy)(void*);
+  };
+
+  template <typename F>
+  static constexpr bool fitsInline =
+      sizeof(F) <= bufferSize && alignof(F) <= bufferAlign;
+
+  template <typename F>
+  static Value invokeInline(void* p) {
+    return std::invoke(*static_cast<F*>(p));
+  }
+
+  template <typename F>
+  static void copyInline(void* dst, void const* src) {
+    ::new (dst) F(*static_cast<F const*>(src));
+  }
+
+  template <typename F>
+  static void destroyInline(void* p) {
+    static_cast<F*>(p)->~F();
+  }
+
+  template <typename F>
+  static Value invokeHeap(void* p) {
+    return std::invoke(**static_cast<F**>(p));
+  }
 
-  mutable Func func_;
+  template <typename F>
+  static void copyHeap(void* dst, void const* src) {
+    ::new (dst) F*(new F(**static_cast<F* const*>(src)));
+  }
+
+  template <typename F>
+  static void destroyHeap(void* p) {
+    delete *static_cast<F**>(p);
+  }
 
-  typedef typename std::aligned_storage<sizeof(Value),
-                                        std::alignment_of<Value>::value>::type
-      Storage;
-  mutable Storage value_;
-  mutable std::atomic_int evaled_;
-  mutable std::mutex lock_;
+  template <typename F>
+  static constexpr void (*copyFor())(void*, void const*) {
+    if constexpr (!std::is_copy_constructible_v<F>) {
+      return nullptr;
+    } else if constexpr (fitsInline<F>) {
+      return &copyInline<F>;
+    } else {
+      return &copyHeap<F>;
+    }
+  }
+
+  template <typename F>
+  static Ops const* opsFor() {
+    if constexpr (fitsInline<F>) {
+      static constexpr Ops ops{&invokeInline<F>, copyFor<F>(),
+                               &destroyInline<F>};
+      return &ops;
+    } else {
+      static constexpr Ops ops{&invokeHeap<F>, copyFor<F>(), &destroyHeap<F>};
+      return &ops;
+    }
+  }
+
+  alignas(bufferAlign) mutable std::byte buffer_[bufferSize];
+  mutable Ops const* ops_ = nullptr;
+  mutable std::atomic_int state_;
+
+  Value* address() const {
+    return std::launder(reinterpret_cast<Value*>(buffer_));
+  }
+
+  // Take the 'evaluating' state, or return false once the value is
+  // available.  Waits while another thread holds it.
+  bool claim() const {
+    int state = state_.load(std::memory_order_acquire);
+    for (;;) {
+      if (state == evaluated) {
+        return false;
+      }
+      if (state == unevaluated &&
+          state_.compare_exchange_weak(state, evaluating,
+                                       std::memory_order_acquire,
+                                       std::memory_order_acquire)) {
+        return true;
+      }
+      if (state == evaluating) {
+        state_.wait(evaluating, std::memory_order_acquire);
+        state = state_.load(std::memory_order_acquire);
+      }
+    }
+  }
+
+  void release(int state) const {
+    state_.store(state, std::memory_order_release);
+    state_.notify_all();
+  }
 
   void setValue() const {
-    std::unique_lock<std::mutex> guard(lock_);
-    if (!evaled_) {
-      ::new (&value_) Value(func_());
-      func_ = Func();
-      evaled_.store(1, std::memory_order_release);
+    if (!claim()) {
+      return;
     }
+    try {
+      if (!ops_) {
+        throw std::bad_function_call();
+      }
+      // The function and the value share the buffer, so the result is
+      // built aside and moved in once the function is gone.
+      Value result(ops_->invoke(buffer_));
+      ops_->destroy(buffer_);
+      ops_ = nullptr;
+      ::new (buffer_) Value(std::move(result));
+    } catch (...) {
+      release(unevaluated);
+      throw;
+    }
+    release(evaluated);
   }
 
 public:
-  Delay() = default;
-  Delay(const Delay& rhs) {
-    std::unique_lock<std::mutex>  guard(rhs.lock_);
-    int evaled = rhs.evaled_.load(std::memory_order_acquire);
-    if (!evaled) {
-      func_ = rhs.func_;
+  Delay() : state_(unevaluated) {
+  }
+
+  Delay(const Delay& rhs) : state_(unevaluated) {
+    if (rhs.claim()) {
+      // Unforced: hold off evaluation while the function is copied.
+      if (rhs.ops_ && !rhs.ops_->copy) {
+        rhs.release(unevaluated);
+        throw std::logic_error("copy of unforced Delay of move-only function");
+      }
+      try {
+        if (rhs.ops_) {
+          rhs.ops_->copy(buffer_, rhs.buffer_);
+          ops_ = rhs.ops_;
+        }
+      } catch (...) {
+        rhs.release(unevaluated);
+        throw;
+      }
+      rhs.release(unevaluated);
     } else {
-      ::new (&value_) Value(*reinterpret_cast<Value*>(std::addressof(rhs.value_)));
+      ::new (buffer_) Value(*rhs.address());
+      state_.store(evaluated, std::memory_order_relaxed);
     }
-    evaled_.store(evaled);
   }
 
-  Delay(Value const& value) : evaled_(true) {
-    ::new (&value_) Value(value);
+  Delay(Value const& value) : state_(evaluated) {
+    ::new (buffer_) Value(value);
   }
 
-  Delay(Value&& value) : evaled_(true) {
-    ::new (&value_) Value(std::move(value));
+  Delay(Value&& value) : state_(evaluated) {
+    ::new (buffer_) Value(std::move(value));
   }
 
   template <typename Action,
-            typename = typename std::enable_if<isFuncConv<Action>::value>::type>
-  Delay(Action&& A) : func_(std::forward<Action>(A)), evaled_(false) {
+            typename = typename std::enable_if<isAction<Action>::value>::type>
+  Delay(Action&& A) : state_(unevaluated) {
+    using F = std::decay_t<Action>;
+    if constexpr (fitsInline<F>) {
+      ::new (buffer_) F(std::forward<Action>(A));
+    } else {
+      ::new (buffer_) F*(new F(std::forward<Action>(A)));
+    }
+    ops_ = opsFor<F>();
   }
 
   ~Delay() {
-    if (evaled_) {
-      reinterpret_cast<Value*>(std::addressof(this->value_))->~Value();
+    if (state_.load(std::memory_order_relaxed) == evaluated) {
+      address()->~Value();
+    } else if (ops_) {
+      ops_->destroy(buffer_);
     }
   }
 
   Value const& get() const {
-    int evaled = evaled_.load(std::memory_order_acquire);
-    if (!evaled) {
+    if (state_.load(std::memory_order_acquire) != evaluated) [[unlikely]] {
       setValue();
     }
-    return *reinterpret_cast<Value*>(std::addressof(this->value_));
+    return *address();
   }
 
   operator Value const&() const {
     return get();
   }
 
-  bool isForced() {
-    return evaled_;
+  bool isForced() const {
+    return state_.load(std::memory_order_acquire) == evaluated;
   }
 };
 
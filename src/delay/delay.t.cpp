@@ -1,6 +1,13 @@
 #include <delay/delay.h>
 
 #include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 using ::testing::Test;
 
 namespace testing {
@@ -129,4 +136,119 @@ TEST_F(DelayTest, moveTest) {
   EXPECT_EQ(std::string("this is a test"), force(d3));
   EXPECT_EQ(std::string("another test"), force(d4));
 }
+
+TEST_F(DelayTest, concurrentForceTest) {
+  std::atomic<int> calls{0};
+  Delay<int> d([&calls]() {
+    ++calls;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    return 42;
+  });
+
+  std::vector<std::thread> threads;
+  std::atomic<int> sum{0};
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&d, &sum]() { sum += d.get(); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(1, calls.load());
+  EXPECT_EQ(4 * 42, sum.load());
+  EXPECT_TRUE(d.isForced());
+}
+
+TEST_F(DelayTest, exceptionRetryTest) {
+  int calls = 0;
+  Delay<int> d([&calls]() {
+    if (++calls == 1) {
+      throw std::runtime_error("first");
+    }
+    return calls;
+  });
+
+  EXPECT_THROW(d.get(), std::runtime_error);
+  EXPECT_FALSE(d.isForced());
+  EXPECT_EQ(2, d.get());
+  EXPECT_EQ(2, d.get());
+  EXPECT_EQ(2, calls);
+}
+
+TEST_F(DelayTest, copyTest) {
+  Delay<std::string> unforced = delay(stringTest, "copied");
+  Delay<std::string> copy1(unforced);
+  EXPECT_FALSE(copy1.isForced());
+  EXPECT_EQ(std::string("copied"), force(copy1));
+  EXPECT_FALSE(unforced.isForced());
+
+  force(unforced);
+  Delay<std::string> copy2(unforced);
+  EXPECT_TRUE(copy2.isForced());
+  EXPECT_EQ(std::string("copied"), force(copy2));
+}
+
+TEST_F(DelayTest, copyWhileForcingTest) {
+  std::atomic<bool> started{false};
+  Delay<int> d([&started]() {
+    started = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    return 7;
+  });
+
+  std::thread forcer([&d]() { d.get(); });
+  while (!started) {
+    std::this_thread::yield();
+  }
+  Delay<int> copy(d);
+  forcer.join();
+  EXPECT_TRUE(copy.isForced());
+  EXPECT_EQ(7, copy.get());
+}
+
+TEST_F(DelayTest, moveOnlyTest) {
+  auto p = std::make_unique<int>(11);
+  Delay<int> d([p = std::move(p)]() { return *p; });
+  EXPECT_THROW(Delay<int>{d}, std::logic_error);
+  EXPECT_EQ(11, d.get());
+
+  Delay<int> copy(d);
+  EXPECT_EQ(11, copy.get());
+}
+
+TEST_F(DelayTest, captureReleasedTest) {
+  auto shared = std::make_shared<int>(3);
+  {
+    Delay<int> d([shared]() { return *shared; });
+    EXPECT_EQ(2, shared.use_count());
+    EXPECT_EQ(3, d.get());
+    EXPECT_EQ(1, shared.use_count());
+  }
+  {
+    Delay<int> d([shared]() { return *shared; });
+    EXPECT_EQ(2, shared.use_count());
+  }
+  EXPECT_EQ(1, shared.use_count());
+}
+
+TEST_F(DelayTest, largeCaptureTest) {
+  struct Big {
+    char bytes[256];
+  };
+  Big big{};
+  big.bytes[255] = 9;
+  auto shared = std::make_shared<int>(1);
+  Delay<int> d([big, shared]() { return big.bytes[255] + *shared; });
+  Delay<int> copy(d);
+  EXPECT_EQ(3, shared.use_count());
+  EXPECT_EQ(10, d.get());
+  EXPECT_EQ(2, shared.use_count());
+  EXPECT_EQ(10, copy.get());
+  EXPECT_EQ(1, shared.use_count());
+}
+
+TEST_F(DelayTest, emptyTest) {
+  Delay<int> d;
+  EXPECT_THROW(d.get(), std::bad_function_call);
+  EXPECT_FALSE(d.isForced());
+}
 }
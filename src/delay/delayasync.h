@@ -1,12 +1,34 @@
-// delay.h                                                            -*-C++-*-
+// delayasync.h                                                       -*-C++-*-
 #ifndef INCLUDED_DELAYASYNC
 #define INCLUDED_DELAYASYNC
 
+// A DelayAsync is a shared handle to a suspended computation whose result
+// is published through a std::shared_future.  Copies share the
+// computation.  The first thread to force it claims it by compare-and-swap
+// and runs the function; any other thread waits on the future.  An
+// exception is stored and rethrown to every caller.
+//
+// Besides the blocking get(), a DelayAsync can be read without waiting:
+//   try_get()            the value if it is already available
+//   get_for(d)           wait at most 'd' for an evaluation running on
+//   get_until(t)         another thread, or until 't'
+//   onReady(f)           call 'f()' once the value or exception is ready
+// If nobody has started the evaluation, get_for and get_until run it on the
+// calling thread, without a time limit, since there is no one else to wait
+// for.  Callbacks run on the thread that completes the evaluation, or
+// immediately if it is already complete.  An exception thrown by a
+// callback is dropped, so it neither fails the thread that completed the
+// evaluation nor stops the other callbacks.
+
 #include <optional>
 #include <functional>
 #include <atomic>
+#include <chrono>
 #include <mutex>
 #include <future>
+#include <memory>
+#include <utility>
+#include <vector>
 #include <iostream>
 
 template <typename Value>
@@ -15,44 +37,141 @@ class DelayAsync {
   template <typename Action>
   using isFuncConv = std::is_convertible<Action, Func>;
 
-  std::shared_future<Value> future_;
-  mutable std::atomic_int evaled_;
+  enum : int { unevaluated = 0, evaluating = 1, evaluated = 2 };
+
+  struct State {
+    std::atomic_int state_{unevaluated};
+    Func func_;
+    std::promise<Value> promise_;
+    std::shared_future<Value> future_{promise_.get_future().share()};
+    std::mutex lock_;
+    std::vector<std::function<void()>> callbacks_;
+  };
+
+  std::shared_ptr<State> state_;
+
+  // Run the function if nobody has.  Returns false if the evaluation was
+  // already claimed.
+  bool run() const {
+    if (!state_) {
+      throw std::future_error(std::future_errc::no_state);
+    }
+    int expected = unevaluated;
+    if (!state_->state_.compare_exchange_strong(expected,
+                                                evaluating,
+                                                std::memory_order_acq_rel)) {
+      return false;
+    }
+    try {
+      state_->promise_.set_value(state_->func_());
+    } catch (...) {
+      state_->promise_.set_exception(std::current_exception());
+    }
+    state_->func_ = Func();
+
+    std::vector<std::function<void()>> callbacks;
+    {
+      std::lock_guard<std::mutex> guard(state_->lock_);
+      state_->state_.store(evaluated, std::memory_order_release);
+      callbacks.swap(state_->callbacks_);
+    }
+    for (auto& callback : callbacks) {
+      try {
+        callback();
+      } catch (...) {
+      }
+    }
+    return true;
+  }
 
 public:
   DelayAsync() = default;
-  DelayAsync(const DelayAsync& rhs) : future_(rhs.future_) {
+
+  DelayAsync(const DelayAsync& rhs) : state_(rhs.state_) {
+  }
+
+  DelayAsync(Value const& value) : state_(std::make_shared<State>()) {
+    state_->promise_.set_value(value);
+    state_->state_.store(evaluated, std::memory_order_relaxed);
+  }
+
+  DelayAsync(Value&& value) : state_(std::make_shared<State>()) {
+    state_->promise_.set_value(std::move(value));
+    state_->state_.store(evaluated, std::memory_order_relaxed);
   }
-  DelayAsync(Value const& value)
-      : future_(std::async(std::launch::deferred, [value]() { return value; })),
-        evaled_(true){};
-  DelayAsync(Value&& value)
-      : future_(std::async(std::launch::deferred,
-                           [value = std::move(value)]() { return value; })),
-        evaled_(true){};
 
   template <typename Action,
             typename = typename std::enable_if<isFuncConv<Action>::value>::type>
-  DelayAsync(Action&& A)
-      : future_(std::async(
-            std::launch::deferred,
-            [action = std::forward<Action>(A)]() { return action(); })),
-        evaled_(false) {
+  DelayAsync(Action&& A) : state_(std::make_shared<State>()) {
+    state_->func_ = std::forward<Action>(A);
   }
 
   ~DelayAsync() = default;
 
+  DelayAsync& operator=(const DelayAsync& rhs) = default;
+
   Value const& get() const {
-    evaled_ = true;
-    return future_.get();
+    run();
+    return state_->future_.get();
   }
 
   operator Value const&() const {
-    evaled_ = true;
-    return future_.get();
+    return get();
+  }
+
+  // The value if it has already been computed, otherwise nothing.  Never
+  // starts the evaluation.
+  std::optional<Value> try_get() const {
+    if (!isForced()) {
+      return std::nullopt;
+    }
+    return state_->future_.get();
+  }
+
+  template <typename Clock, typename Duration>
+  std::optional<Value>
+  get_until(std::chrono::time_point<Clock, Duration> const& deadline) const {
+    if (!run() && state_->future_.wait_until(deadline) !=
+                      std::future_status::ready) {
+      return std::nullopt;
+    }
+    return state_->future_.get();
+  }
+
+  template <typename Rep, typename Period>
+  std::optional<Value>
+  get_for(std::chrono::duration<Rep, Period> const& timeout) const {
+    return get_until(std::chrono::steady_clock::now() + timeout);
+  }
+
+  // Call 'callback()' when the value or exception is available.
+  template <typename Callback>
+  void onReady(Callback&& callback) const {
+    {
+      std::lock_guard<std::mutex> guard(state_->lock_);
+      if (state_->state_.load(std::memory_order_acquire) != evaluated) {
+        state_->callbacks_.emplace_back(std::forward<Callback>(callback));
+        return;
+      }
+    }
+    callback();
+  }
+
+  bool isForced() const {
+    return state_ &&
+           state_->state_.load(std::memory_order_acquire) == evaluated;
+  }
+
+  bool isEmpty() const {
+    return !state_;
+  }
+
+  bool operator==(DelayAsync const& rhs) const {
+    return state_ == rhs.state_;
   }
 
-  bool isForced() {
-    return evaled_;
+  bool operator!=(DelayAsync const& rhs) const {
+    return state_ != rhs.state_;
   }
 };
 
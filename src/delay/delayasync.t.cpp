@@ -1,6 +1,12 @@
 #include <delay/delayasync.h>
 
 #include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 using ::testing::Test;
 
 namespace testing {
@@ -129,4 +135,81 @@ TEST_F(DelayAsyncTest, moveTest) {
   EXPECT_EQ(std::string("this is a test"), force(d3));
   EXPECT_EQ(std::string("another test"), force(d4));
 }
+
+TEST_F(DelayAsyncTest, tryGetTest) {
+  DelayAsync<int> d(func);
+  EXPECT_FALSE(d.try_get());
+  EXPECT_EQ(0, func_called);
+
+  EXPECT_EQ(5, d.get());
+  EXPECT_EQ(5, d.try_get());
+  EXPECT_EQ(1, func_called);
+}
+
+TEST_F(DelayAsyncTest, getForTest) {
+  std::atomic<bool> started{false};
+  std::atomic<bool> release{false};
+  DelayAsync<int> d([&]() {
+    started = true;
+    started.notify_all();
+    release.wait(false);
+    return 7;
+  });
+
+  std::thread evaluator([&]() { d.get(); });
+  started.wait(false);
+
+  EXPECT_FALSE(d.get_for(std::chrono::milliseconds(5)));
+  EXPECT_FALSE(d.isForced());
+
+  release = true;
+  release.notify_all();
+  EXPECT_EQ(7, d.get_for(std::chrono::seconds(10)));
+  evaluator.join();
+}
+
+TEST_F(DelayAsyncTest, getUntilEvaluatesTest) {
+  DelayAsync<int> d(func);
+  auto past = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+  EXPECT_EQ(5, d.get_until(past));
+  EXPECT_EQ(1, func_called);
+}
+
+TEST_F(DelayAsyncTest, onReadyTest) {
+  DelayAsync<int> d(func);
+  std::vector<int> seen;
+  d.onReady([&]() { seen.push_back(1); });
+  d.onReady([&]() { seen.push_back(2); });
+  EXPECT_TRUE(seen.empty());
+
+  d.get();
+  EXPECT_EQ((std::vector<int>{1, 2}), seen);
+
+  d.onReady([&]() { seen.push_back(3); });
+  EXPECT_EQ((std::vector<int>{1, 2, 3}), seen);
+}
+
+TEST_F(DelayAsyncTest, throwingCallbackTest) {
+  DelayAsync<int> d(func);
+  std::vector<int> seen;
+  d.onReady([&]() { seen.push_back(1); });
+  d.onReady([]() { throw std::runtime_error("callback"); });
+  d.onReady([&]() { seen.push_back(3); });
+
+  EXPECT_EQ(5, d.get());
+  EXPECT_EQ((std::vector<int>{1, 3}), seen);
+  EXPECT_TRUE(d.isForced());
+}
+
+TEST_F(DelayAsyncTest, exceptionTest) {
+  DelayAsync<int> d([]() -> int { throw std::runtime_error("fail"); });
+  bool ready = false;
+  d.onReady([&]() { ready = true; });
+
+  EXPECT_THROW(d.get(), std::runtime_error);
+  EXPECT_TRUE(ready);
+  EXPECT_TRUE(d.isForced());
+  EXPECT_THROW(d.try_get(), std::runtime_error);
+  EXPECT_THROW(d.get(), std::runtime_error);
+}
 }
@@ -0,0 +1 @@
+#include <delay/lazycell.h>
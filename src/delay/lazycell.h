@@ -0,0 +1,146 @@
+// lazycell.h                                                         -*-C++-*-
+#ifndef INCLUDED_LAZYCELL
+#define INCLUDED_LAZYCELL
+
+// An intrusively reference counted, shared Delay.
+//
+// LazyRef<Value> is the handle a stream keeps to a cell.  The reference
+// count, the evaluation state and the value (or, before it is forced, the
+// function) all live in one LazyCell allocation, so following a handle is
+// one pointer chase, a handle is a single pointer, and there is no separate
+// control block.  Copies share the cell: it is forced at most once and
+// destroyed with its last handle.  There are no weak references.
+
+#include <delay/delay.h>
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+class LazyCount {
+  std::atomic<int> count_{1};
+
+public:
+  void acquire() {
+    count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Returns true if this was the last reference.
+  bool release() {
+    return count_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+  }
+
+  std::size_t load() const {
+    return std::size_t(count_.load(std::memory_order_relaxed));
+  }
+};
+
+template <typename Value>
+class LazyRef;
+
+template <typename Value>
+class LazyCell {
+  mutable LazyCount refs_;
+  Delay<Value> delay_;
+
+  friend class LazyRef<Value>;
+
+public:
+  template <typename... Args>
+  explicit LazyCell(Args&&... args) : delay_(std::forward<Args>(args)...) {
+  }
+
+  LazyCell(LazyCell const&) = delete;
+  LazyCell& operator=(LazyCell const&) = delete;
+
+  Value const& get() const {
+    return delay_.get();
+  }
+
+  bool isForced() const {
+    return delay_.isForced();
+  }
+};
+
+template <typename Value>
+class LazyRef {
+  LazyCell<Value>* cell_ = nullptr;
+
+  explicit LazyRef(LazyCell<Value>* cell) : cell_(cell) {
+  }
+
+  void release() {
+    if (cell_ && cell_->refs_.release()) {
+      delete cell_;
+    }
+  }
+
+  template <typename V, typename... Args>
+  friend LazyRef<V> makeLazy(Args&&... args);
+
+public:
+  LazyRef() = default;
+
+  LazyRef(LazyRef const& rhs) : cell_(rhs.cell_) {
+    if (cell_) {
+      cell_->refs_.acquire();
+    }
+  }
+
+  LazyRef(LazyRef&& rhs) noexcept : cell_(std::exchange(rhs.cell_, nullptr)) {
+  }
+
+  LazyRef& operator=(LazyRef rhs) noexcept {
+    std::swap(cell_, rhs.cell_);
+    return *this;
+  }
+
+  ~LazyRef() {
+    release();
+  }
+
+  explicit operator bool() const {
+    return cell_ != nullptr;
+  }
+
+  LazyCell<Value> const& operator*() const {
+    return *cell_;
+  }
+
+  LazyCell<Value> const* operator->() const {
+    return cell_;
+  }
+
+  Value const& get() const {
+    return cell_->get();
+  }
+
+  operator Value const&() const {
+    return get();
+  }
+
+  std::size_t useCount() const {
+    return cell_ ? cell_->refs_.load() : 0;
+  }
+
+  friend bool operator==(LazyRef const& lhs, LazyRef const& rhs) {
+    return lhs.cell_ == rhs.cell_;
+  }
+
+  friend bool operator!=(LazyRef const& lhs, LazyRef const& rhs) {
+    return lhs.cell_ != rhs.cell_;
+  }
+};
+
+template <typename Value>
+Value const& force(LazyCell<Value> const& cell) {
+  return cell.get();
+}
+
+// Allocate a cell whose Delay is constructed from 'args'.
+template <typename Value, typename... Args>
+LazyRef<Value> makeLazy(Args&&... args) {
+  return LazyRef<Value>(new LazyCell<Value>(std::forward<Args>(args)...));
+}
+
+#endif
@@ -0,0 +1,85 @@
+#include <delay/lazycell.h>
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(LazyCellTest, breathingTest) {
+  int calls = 0;
+  LazyRef<int> ref = makeLazy<int>([&calls]() { return ++calls; });
+  EXPECT_TRUE(static_cast<bool>(ref));
+  EXPECT_FALSE(ref->isForced());
+  EXPECT_EQ(1, force(*ref));
+  EXPECT_EQ(1, ref->get());
+  EXPECT_TRUE(ref->isForced());
+  EXPECT_EQ(1, calls);
+
+  LazyRef<int> empty;
+  EXPECT_FALSE(static_cast<bool>(empty));
+  EXPECT_EQ(0u, empty.useCount());
+}
+
+TEST(LazyCellTest, valueTest) {
+  LazyRef<std::string> ref = makeLazy<std::string>(std::string("value"));
+  EXPECT_TRUE(ref->isForced());
+  EXPECT_EQ(std::string("value"), ref->get());
+}
+
+TEST(LazyCellTest, sharingTest) {
+  auto token = std::make_shared<int>(0);
+  int calls = 0;
+  LazyRef<int> a = makeLazy<int>([token, &calls]() { return ++calls; });
+  EXPECT_EQ(1u, a.useCount());
+  {
+    LazyRef<int> b = a;
+    EXPECT_EQ(2u, a.useCount());
+    EXPECT_TRUE(a == b);
+    EXPECT_EQ(1, b->get());
+
+    LazyRef<int> c = std::move(b);
+    EXPECT_FALSE(static_cast<bool>(b));
+    EXPECT_EQ(2u, a.useCount());
+  }
+  EXPECT_EQ(1, a->get());
+  EXPECT_EQ(1, calls);
+  EXPECT_EQ(1u, a.useCount());
+
+  LazyRef<int> other = makeLazy<int>(2);
+  EXPECT_TRUE(a != other);
+  a = other;
+  EXPECT_EQ(2u, other.useCount());
+  EXPECT_EQ(2, a->get());
+}
+
+TEST(LazyCellTest, releaseTest) {
+  auto token = std::make_shared<int>(0);
+  {
+    LazyRef<int> ref = makeLazy<int>([token]() { return *token; });
+    EXPECT_EQ(2, token.use_count());
+  }
+  EXPECT_EQ(1, token.use_count());
+}
+
+TEST(LazyCellTest, concurrentTest) {
+  std::atomic<int> calls{0};
+  LazyRef<int> ref = makeLazy<int>([&calls]() { return ++calls; });
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([ref]() {
+      for (int j = 0; j < 1000; ++j) {
+        LazyRef<int> copy = ref;
+        EXPECT_EQ(1, copy->get());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(1, calls.load());
+  EXPECT_EQ(1u, ref.useCount());
+}
@@ -0,0 +1 @@
+#include <delay/readahead.h>
@@ -0,0 +1,136 @@
+// readahead.h                                                        -*-C++-*-
+#ifndef INCLUDED_READAHEAD
+#define INCLUDED_READAHEAD
+
+// A ConsStreamAsync whose cells are forced ahead of the consumer.
+//
+// readAhead(stream, k) returns a stream with the same elements as 'stream'.
+// A background producer thread walks the source, forcing at most 'k' cells
+// beyond the last one the consumer has reached, and sleeps when it is that
+// far ahead.  The consumer forces the same source cells; a cell that the
+// producer has already forced is returned immediately, and a cell that the
+// producer is forcing right now blocks on the Delay until it is done.  So
+// the consumer only waits when it has caught up with the producer, and the
+// latency of producing each element is overlapped with consuming the ones
+// before it.
+//
+// The producer stops at the end of the source, at the first cell that
+// throws (the consumer will see the exception when it forces that cell
+// itself), or when the last handle to the read-ahead stream is dropped.  In
+// the last case dropping the stream waits for the cell in flight, if any.
+
+#include <delay/streamasync.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+template <typename Value>
+class ReadAhead {
+  struct State {
+    std::mutex lock;
+    std::condition_variable wake;
+    ConsStreamAsync<Value> cursor;
+    std::size_t produced = 0;
+    std::size_t consumed = 0;
+    std::size_t depth;
+    bool stop = false;
+
+    State(ConsStreamAsync<Value> const& source, std::size_t k)
+        : cursor(source), depth(k) {
+    }
+  };
+
+  std::shared_ptr<State> state_;
+  std::thread producer_;
+
+  static void produce(std::shared_ptr<State> state) {
+    std::unique_lock<std::mutex> guard(state->lock);
+    for (;;) {
+      state->wake.wait(guard, [&state]() {
+        return state->stop ||
+               state->produced < state->consumed + state->depth;
+      });
+      if (state->stop) {
+        return;
+      }
+      ConsStreamAsync<Value> cell = state->cursor;
+      guard.unlock();
+
+      if (cell.isEmpty()) {
+        return;
+      }
+      ConsStreamAsync<Value> next;
+      try {
+        next = cell.tail();
+      } catch (...) {
+        return;
+      }
+
+      guard.lock();
+      state->cursor = next;
+      ++state->produced;
+    }
+  }
+
+public:
+  ReadAhead(ConsStreamAsync<Value> const& source, std::size_t depth)
+      : state_(std::make_shared<State>(source, depth)),
+        producer_(produce, state_) {
+  }
+
+  ReadAhead(ReadAhead const&) = delete;
+  ReadAhead& operator=(ReadAhead const&) = delete;
+
+  ~ReadAhead() {
+    {
+      std::lock_guard<std::mutex> guard(state_->lock);
+      state_->stop = true;
+      state_->cursor = ConsStreamAsync<Value>();
+    }
+    state_->wake.notify_one();
+    producer_.join();
+  }
+
+  // The consumer has reached one more cell; let the producer move on.
+  void advance() {
+    {
+      std::lock_guard<std::mutex> guard(state_->lock);
+      ++state_->consumed;
+    }
+    state_->wake.notify_one();
+  }
+
+  std::size_t produced() const {
+    std::lock_guard<std::mutex> guard(state_->lock);
+    return state_->produced;
+  }
+};
+
+template <typename Value>
+ConsStreamAsync<Value> readAheadFrom(
+    std::shared_ptr<ReadAhead<Value>> const& control,
+    ConsStreamAsync<Value> const& source) {
+  if (source.isEmpty()) {
+    return ConsStreamAsync<Value>();
+  }
+  return ConsStreamAsync<Value>([control, source]() {
+    control->advance();
+    return ConsCell<Value>(source.head(),
+                           readAheadFrom(control, source.tail()));
+  });
+}
+
+template <typename Value>
+ConsStreamAsync<Value> readAhead(ConsStreamAsync<Value> const& source,
+                                 std::size_t depth) {
+  if (source.isEmpty() || depth == 0) {
+    return source;
+  }
+  return readAheadFrom(std::make_shared<ReadAhead<Value>>(source, depth),
+                       source);
+}
+
+#endif
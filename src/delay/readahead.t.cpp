@@ -0,0 +1,106 @@
+#include <delay/readahead.h>
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using ::testing::Test;
+
+namespace testing {
+namespace {
+ConsStreamAsync<int> counted(std::atomic<int>& forced, int n, int limit) {
+  if (n > limit) {
+    return ConsStreamAsync<int>();
+  }
+  return ConsStreamAsync<int>([&forced, n, limit]() {
+    ++forced;
+    return ConsCell<int>(n, counted(forced, n + 1, limit));
+  });
+}
+
+// Wait for the producer thread to catch up to 'expected'.
+bool reaches(std::atomic<int> const& forced, int expected) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (forced.load() < expected) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+}
+
+TEST(ReadAheadTest, sameElements) {
+  std::vector<int> expected;
+  for (int i : take(iota(0), 100)) {
+    expected.push_back(i);
+  }
+
+  std::vector<int> result;
+  ConsStreamAsync<int> ahead = readAhead(take(iota(0), 100), 8);
+  for (int i : ahead) {
+    result.push_back(i);
+  }
+  EXPECT_EQ(expected, result);
+}
+
+TEST(ReadAheadTest, emptyAndZeroDepth) {
+  EXPECT_TRUE(readAhead(ConsStreamAsync<int>(), 4).isEmpty());
+
+  std::atomic<int> forced{0};
+  ConsStreamAsync<int> s = readAhead(counted(forced, 0, 10), 0);
+  EXPECT_EQ(0, forced.load());
+  EXPECT_EQ(0, s.head());
+  EXPECT_EQ(1, forced.load());
+}
+
+TEST(ReadAheadTest, producesAhead) {
+  std::atomic<int> forced{0};
+  ConsStreamAsync<int> s = readAhead(counted(forced, 0, 1000), 4);
+
+  EXPECT_TRUE(reaches(forced, 4));
+
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(i, s.head());
+    s = s.tail();
+  }
+  EXPECT_TRUE(reaches(forced, 14));
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_LE(forced.load(), 14);
+}
+
+TEST(ReadAheadTest, runsToEnd) {
+  std::atomic<int> forced{0};
+  ConsStreamAsync<int> s = readAhead(counted(forced, 1, 3), 16);
+  EXPECT_TRUE(reaches(forced, 3));
+  EXPECT_EQ(3, last(s));
+  EXPECT_EQ(3, forced.load());
+}
+
+TEST(ReadAheadTest, exceptionSeenByConsumer) {
+  ConsStreamAsync<int> bad = cons(
+      1, ConsStreamAsync<int>([]() -> ConsCell<int> {
+        throw std::runtime_error("bad cell");
+      }));
+  ConsStreamAsync<int> s = readAhead(bad, 4);
+  EXPECT_EQ(1, s.head());
+  EXPECT_THROW(s.tail().head(), std::runtime_error);
+}
+
+TEST(ReadAheadTest, dropStopsProducer) {
+  std::atomic<int> forced{0};
+  {
+    ConsStreamAsync<int> s = readAhead(counted(forced, 0, 1000000), 2);
+    EXPECT_EQ(0, s.head());
+  }
+  int stopped = forced.load();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(stopped, forced.load());
+  EXPECT_LE(stopped, 3);
+}
+}
@@ -800,6 +800,6 @@ public:
 };
 }
 
-template class ConsStreamIterator<int>;
-template class ConsStream<std::string>;
-template class ConsStream<NoDefault>;
+template class co_fun::ConsStreamIterator<int, DelaySuspension>;
+template class co_fun::ConsStream<std::string, DelaySuspension>;
+template class co_fun::ConsStream<NoDefault, DelaySuspension>;
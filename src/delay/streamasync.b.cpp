@@ -1,11 +1,52 @@
 #include <benchmark/benchmark.h>
 
 #include <delay/delayasync.h>
+#include <delay/lazycell.h>
 #include <delay/streamasync.h>
 
+#include <memory>
 #include <sstream>
 #include <string>
 
+// The cell layouts on their own: allocate, share, force and release.
+static void BM_CellSharedPtr(benchmark::State& state) {
+    long sum = 0;
+    while (state.KeepRunning()) {
+        auto cell = std::make_shared<Delay<long>>([sum]() { return sum + 1; });
+        auto copy = cell;
+        sum       = copy->get() & 0xff;
+    }
+    benchmark::DoNotOptimize(sum);
+}
+BENCHMARK(BM_CellSharedPtr);
+
+static void BM_CellLazyRef(benchmark::State& state) {
+    long sum = 0;
+    while (state.KeepRunning()) {
+        auto cell = makeLazy<long>([sum]() { return sum + 1; });
+        auto copy = cell;
+        sum       = copy->get() & 0xff;
+    }
+    benchmark::DoNotOptimize(sum);
+}
+BENCHMARK(BM_CellLazyRef);
+
+// Build and walk a stream: one cell allocation, force and release per
+// element.
+static void BM_WalkAsync(benchmark::State& state) {
+    auto x   = state.range(0);
+    long sum = 0;
+    while (state.KeepRunning()) {
+        ConsStreamAsync<long> s = rangeFrom(0l, x);
+        for (long v : s) {
+            sum += v;
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * x);
+}
+BENCHMARK(BM_WalkAsync)->Arg(64)->Arg(4096);
+
 static void BM_ConcatAsync(benchmark::State& state) {
     auto x = state.range(0);
     int  l = 0;
@@ -801,6 +801,6 @@ public:
 };
 }
 
-template class ConsStreamAsyncIterator<int>;
-template class ConsStreamAsync<std::string>;
-template class ConsStreamAsync<NoDefault>;
+// ConsStreamAsync is ConsStream, whose other instantiations are in
+// stream.t.cpp.
+template class co_fun::ConsStream<NoDefault, DelaySuspension>;
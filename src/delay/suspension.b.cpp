@@ -0,0 +1,85 @@
+#include <benchmark/benchmark.h>
+
+#include <co_fun/stream.h>
+#include <co_fun/suspension.h>
+#include <delay/suspension.h>
+
+#include <tuple>
+
+// The same workloads over each suspension policy.
+
+using co_fun::ConsStream;
+
+template <typename S>
+static void BM_PolicyWalk(benchmark::State& state) {
+    auto x   = state.range(0);
+    long sum = 0;
+    for (auto _ : state) {
+        ConsStream<long, S> s = co_fun::rangeFrom<long, S>(0, x);
+        for (long v : s) {
+            sum += v;
+        }
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * x);
+}
+
+template <typename S>
+static void BM_PolicyFilterMap(benchmark::State& state) {
+    auto x = state.range(0);
+    long l = 0;
+    for (auto _ : state) {
+        auto odd = filter([](long i) { return i % 2 == 1; },
+                          co_fun::iota<long, S>(0));
+        l        = last(take(fmap(odd, [](long i) { return i * i; }), x));
+    }
+    benchmark::DoNotOptimize(l);
+    state.SetItemsProcessed(state.iterations() * x);
+}
+
+template <typename S>
+static void BM_PolicyJoin(benchmark::State& state) {
+    auto   x = state.range(0);
+    size_t l = 0;
+    for (auto _ : state) {
+        auto nested = fmap(co_fun::iota<int, S>(0), [](int i) {
+            return co_fun::rangeFrom<int, S>(0, i);
+        });
+        l           = length(take(join(nested), x));
+    }
+    benchmark::DoNotOptimize(l);
+    state.SetItemsProcessed(state.iterations() * x);
+}
+
+template <typename S>
+static void BM_PolicyTriples(benchmark::State& state) {
+    auto x = state.range(0);
+    int  z = 0;
+    for (auto _ : state) {
+        auto triples = bind2(co_fun::iota<int, S>(1), [](int z) {
+            return bind2(co_fun::rangeFrom<int, S>(1, z), [z](int x) {
+                return bind2(co_fun::rangeFrom<int, S>(x, z), [x, z](int y) {
+                    return then2(
+                        co_fun::guard<S>(x * x + y * y == z * z),
+                        [x, y, z]() {
+                            return ConsStream<std::tuple<int, int, int>, S>(
+                                std::make_tuple(x, y, z));
+                        });
+                });
+            });
+        });
+        z            = std::get<2>(last(take(triples, x)));
+    }
+    benchmark::DoNotOptimize(z);
+}
+
+#define POLICY_BENCHMARKS(S)                                                   \
+    BENCHMARK_TEMPLATE(BM_PolicyWalk, S)->Arg(1024);                           \
+    BENCHMARK_TEMPLATE(BM_PolicyFilterMap, S)->Arg(1024);                      \
+    BENCHMARK_TEMPLATE(BM_PolicyJoin, S)->Arg(1024);                           \
+    BENCHMARK_TEMPLATE(BM_PolicyTriples, S)->Arg(10)
+
+POLICY_BENCHMARKS(co_fun::ThunkSuspension);
+POLICY_BENCHMARKS(co_fun::MemoSuspension);
+POLICY_BENCHMARKS(DelaySuspension);
+POLICY_BENCHMARKS(DelayAsyncSuspension);
@@ -0,0 +1 @@
+#include <delay/suspension.h>
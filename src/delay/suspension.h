@@ -0,0 +1,74 @@
+// suspension.h                                                       -*-C++-*-
+#ifndef INCLUDED_SUSPENSION
+#define INCLUDED_SUSPENSION
+
+// Suspension policies for co_fun::ConsStream over the delay library.
+//
+// DelaySuspension keeps each cell in a LazyRef: one intrusively counted
+// allocation holding a lock-free Delay.  It is safe to force a cell from
+// several threads, and is what ConsStream in delay/stream.h, and so
+// ConsStreamAsync in delay/streamasync.h, uses.
+//
+// DelayAsyncSuspension keeps each cell in a DelayAsync, a shared handle to
+// a computation published through a std::shared_future.  It pays for a
+// separate shared state and a future per cell, and is here to be measured
+// against the others in suspension.b.cpp rather than for any stream to use.
+//
+// See co_fun/suspension.h for what a policy provides.
+
+#include <delay/delayasync.h>
+#include <delay/lazycell.h>
+
+#include <utility>
+
+struct DelaySuspension {
+  template <typename T>
+  using Cell = LazyRef<T>;
+
+  template <typename T, typename F>
+  static Cell<T> suspend(F&& f) {
+    return makeLazy<T>(std::forward<F>(f));
+  }
+
+  template <typename T>
+  static T const& force(Cell<T> const& cell) {
+    return cell.get();
+  }
+
+  template <typename T>
+  static bool isEmpty(Cell<T> const& cell) {
+    return !cell;
+  }
+
+  template <typename T>
+  static bool isForced(Cell<T> const& cell) {
+    return cell->isForced();
+  }
+};
+
+struct DelayAsyncSuspension {
+  template <typename T>
+  using Cell = DelayAsync<T>;
+
+  template <typename T, typename F>
+  static Cell<T> suspend(F&& f) {
+    return Cell<T>(std::forward<F>(f));
+  }
+
+  template <typename T>
+  static T const& force(Cell<T> const& cell) {
+    return cell.get();
+  }
+
+  template <typename T>
+  static bool isEmpty(Cell<T> const& cell) {
+    return cell.isEmpty();
+  }
+
+  template <typename T>
+  static bool isForced(Cell<T> const& cell) {
+    return cell.isForced();
+  }
+};
+
+#endif
@@ -0,0 +1,93 @@
+#include <delay/suspension.h>
+
+#include <co_fun/stream.h>
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using co_fun::ConsStream;
+
+namespace {
+template <typename Suspension>
+class SuspensionTest : public ::testing::Test {};
+
+using Policies = ::testing::Types<DelaySuspension, DelayAsyncSuspension>;
+} // namespace
+
+TYPED_TEST_SUITE(SuspensionTest, Policies);
+
+TYPED_TEST(SuspensionTest, cellTest) {
+  using S = TypeParam;
+  int calls = 0;
+  auto cell = S::template suspend<int>([&calls]() { return ++calls; });
+  EXPECT_FALSE(S::isEmpty(cell));
+  EXPECT_FALSE(S::isForced(cell));
+  auto copy = cell;
+  EXPECT_TRUE(copy == cell);
+  EXPECT_EQ(1, S::force(copy));
+  EXPECT_TRUE(S::isForced(cell));
+  int const& converted = cell;
+  EXPECT_EQ(1, converted);
+  EXPECT_EQ(1, calls);
+
+  typename S::template Cell<int> empty;
+  EXPECT_TRUE(S::isEmpty(empty));
+}
+
+TYPED_TEST(SuspensionTest, streamTest) {
+  using S = TypeParam;
+  ConsStream<int, S> inf = co_fun::iota<int, S>(0);
+  ConsStream<int, S> first = take(inf, 5);
+  EXPECT_EQ(0, inf.countForced());
+
+  std::vector<int> v;
+  for (int i : first) {
+    v.push_back(i);
+  }
+  EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 4}), v);
+  EXPECT_EQ(5, inf.countForced());
+
+  auto evens = filter([](int i) { return i % 2 == 0; }, inf);
+  auto squares = fmap(take(evens, 4), [](int i) { return i * i; });
+  EXPECT_EQ(36, last(squares));
+
+  auto nested = fmap(co_fun::rangeFrom<int, S>(1, 3),
+                     [](int i) { return co_fun::rangeFrom<int, S>(1, i); });
+  EXPECT_EQ(6u, length(concat(nested)));
+  EXPECT_EQ(6u, length(join(nested)));
+  EXPECT_EQ(30,
+            foldr([](int i, int j) { return i + j; },
+                  0,
+                  fmap(take(inf, 5), [](int i) { return 2 * i + 2; })));
+}
+
+TYPED_TEST(SuspensionTest, sharedAcrossThreadsTest) {
+  using S = TypeParam;
+  std::atomic<int> calls{0};
+  ConsStream<int, S> counted = fmap(co_fun::rangeFrom<int, S>(1, 1000),
+                                    [&calls](int i) {
+                                      ++calls;
+                                      return i;
+                                    });
+
+  std::vector<std::thread> threads;
+  std::vector<long> sums(4, 0);
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&sums, counted, t]() mutable {
+      for (int i : counted) {
+        sums[t] += i;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (long sum : sums) {
+    EXPECT_EQ(500500, sum);
+  }
+  EXPECT_EQ(1000, calls.load());
+}